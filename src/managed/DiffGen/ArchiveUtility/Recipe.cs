@@ -21,6 +21,8 @@ namespace ArchiveUtility
         ZlibDecompression,
         ZstdCompression,
         ZstdDecompression,
+        BsPatchZstdDecompression,
+        ZstdSeekableDecompression,
     }
 
     [SuppressMessage("Microsoft.StyleCop.CSharp.ReadabilityRules", "SA1121", Justification = "We want to be explicit about bit-width using these aliases.")]
@@ -48,6 +50,8 @@ namespace ArchiveUtility
             case RecipeType.ZlibCompression: return "zlib_compression";
             case RecipeType.ZstdCompression: return "zstd_compression";
             case RecipeType.ZstdDecompression: return "zstd_decompression";
+            case RecipeType.BsPatchZstdDecompression: return "bspatch_zstd_decompression";
+            case RecipeType.ZstdSeekableDecompression: return "zstd_seekable_decompression";
             }
 
             throw new Exception($"Unexpected recype type: {type}");
@@ -71,7 +75,10 @@ namespace ArchiveUtility
             ItemIngredients = items;
         }
 
-        public bool IsDeltaRecipe() => Name.Equals("bspatch_decompression") || Name.Equals("zstd_decompression");
+        public bool IsDeltaRecipe() =>
+            Name.Equals("bspatch_decompression") ||
+            Name.Equals("bspatch_zstd_decompression") ||
+            Name.Equals("zstd_decompression");
 
         public bool HasDeltaBasis() => IsDeltaRecipe() && (ItemIngredients.Count == 2 && ItemIngredients[1].Length > 0);
 
@@ -0,0 +1,101 @@
+/**
+ * @file allocation_counter.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+#ifdef WIN32
+	#define allocation_size _msize
+#else
+	#define allocation_size malloc_usable_size
+#endif
+
+namespace
+{
+std::atomic<bool> g_counting{false};
+std::atomic<int64_t> g_allocation_count{0};
+std::atomic<int64_t> g_allocated_bytes{0};
+std::atomic<int64_t> g_live_bytes{0};
+std::atomic<int64_t> g_peak_bytes{0};
+
+void *counted_allocate(size_t size)
+{
+	void *ptr = std::malloc(size ? size : 1);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	if (g_counting.load(std::memory_order_relaxed))
+	{
+		auto bytes = static_cast<int64_t>(allocation_size(ptr));
+		g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+		g_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		auto live = g_live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		auto peak = g_peak_bytes.load(std::memory_order_relaxed);
+		while ((live > peak) && !g_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	return ptr;
+}
+
+void counted_free(void *ptr)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+
+	// Memory allocated before counting started also lowers the live total, so
+	// the peak is relative to where the run began.
+	if (g_counting.load(std::memory_order_relaxed))
+	{
+		g_live_bytes.fetch_sub(static_cast<int64_t>(allocation_size(ptr)), std::memory_order_relaxed);
+	}
+
+	std::free(ptr);
+}
+} // namespace
+
+// Aligned forms aren't replaced; nothing in the tree allocates over-aligned types.
+void *operator new(size_t size) { return counted_allocate(size); }
+void *operator new[](size_t size) { return counted_allocate(size); }
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { counted_free(ptr); }
+
+namespace archive_diff::benchmarks
+{
+void allocation_counter::Start()
+{
+	g_allocation_count = 0;
+	g_allocated_bytes  = 0;
+	g_live_bytes       = 0;
+	g_peak_bytes       = 0;
+	g_counting         = true;
+}
+
+void allocation_counter::Stop(Result &result)
+{
+	g_counting = false;
+
+	result.num_allocs            = g_allocation_count;
+	result.max_bytes_used        = g_peak_bytes;
+	result.total_allocated_bytes = g_allocated_bytes;
+	result.net_heap_growth       = g_live_bytes;
+
+	m_last_peak_bytes = g_peak_bytes;
+}
+} // namespace archive_diff::benchmarks
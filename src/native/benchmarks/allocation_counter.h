@@ -0,0 +1,33 @@
+/**
+ * @file allocation_counter.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+namespace archive_diff::benchmarks
+{
+// Counts the allocations made through the global operator new while a benchmark's
+// memory run is going on. google-benchmark reports these as allocs/iter and
+// max_bytes_used; the peak of the last run is kept so the baseline can record it.
+// Allocations made with malloc directly, such as zstd's and zlib's, aren't seen.
+class allocation_counter : public benchmark::MemoryManager
+{
+	public:
+	virtual void Start() override;
+	virtual void Stop(Result &result) override;
+
+	// Older google-benchmark releases only call the pointer form.
+	virtual void Stop(Result *result) { Stop(*result); }
+
+	int64_t get_last_peak_bytes() const { return m_last_peak_bytes; }
+
+	private:
+	int64_t m_last_peak_bytes{};
+};
+} // namespace archive_diff::benchmarks
@@ -0,0 +1,155 @@
+/**
+ * @file baseline_reporter.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "baseline_reporter.h"
+#include "benchmark_data.h"
+
+#include <stdio.h>
+
+#include <fstream>
+
+#include <json/json.h>
+
+namespace archive_diff::benchmarks
+{
+void baseline_reporter::ReportRuns(const std::vector<Run> &runs)
+{
+	ConsoleReporter::ReportRuns(runs);
+
+	for (const auto &run : runs)
+	{
+		// Aggregates of repetitions and runs skipped with an error have nothing to compare.
+		if ((run.run_type != Run::RT_Iteration) || (run.iterations <= 0) || (run.real_accumulated_time <= 0))
+		{
+			continue;
+		}
+
+		result entry;
+		entry.m_real_time_ns = run.real_accumulated_time * 1e9 / static_cast<double>(run.iterations);
+
+		auto counter = run.counters.find(c_mb_per_second_counter);
+		if (counter != run.counters.end())
+		{
+			entry.m_mb_per_second = counter->second.value;
+		}
+
+		entry.m_allocations_per_iteration = run.allocs_per_iter;
+		entry.m_peak_bytes                = m_allocations.get_last_peak_bytes();
+
+		m_results[run.benchmark_name()] = entry;
+	}
+}
+
+void baseline_reporter::print_summary() const
+{
+	printf("\n%-64s %12s %14s %14s\n", "Benchmark", "MB/s", "allocs/iter", "peak KiB");
+	for (const auto &[name, entry] : m_results)
+	{
+		printf(
+			"%-64s %12.1f %14.1f %14lld\n",
+			name.c_str(),
+			entry.m_mb_per_second,
+			entry.m_allocations_per_iteration,
+			static_cast<long long>(entry.m_peak_bytes / 1024));
+	}
+}
+
+bool baseline_reporter::save(const std::string &path) const
+{
+	Json::Value benchmarks(Json::objectValue);
+	for (const auto &[name, entry] : m_results)
+	{
+		Json::Value value;
+		value["real_time_ns"]              = entry.m_real_time_ns;
+		value["mb_per_second"]             = entry.m_mb_per_second;
+		value["allocations_per_iteration"] = entry.m_allocations_per_iteration;
+		value["peak_bytes"]                = static_cast<Json::Int64>(entry.m_peak_bytes);
+		benchmarks[name]                   = value;
+	}
+
+	Json::Value root;
+	root["benchmarks"] = benchmarks;
+
+	std::ofstream stream(path, std::ios::out | std::ios::binary);
+	if (!stream)
+	{
+		printf("Couldn't open %s to save the baseline.\n", path.c_str());
+		return false;
+	}
+
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "\t";
+	stream << Json::writeString(builder, root) << std::endl;
+
+	printf("Saved baseline of %zu benchmarks to %s\n", m_results.size(), path.c_str());
+	return true;
+}
+
+bool baseline_reporter::compare(const std::string &path, double threshold_percent, size_t *regressions) const
+{
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream)
+	{
+		printf("Couldn't open baseline %s\n", path.c_str());
+		return false;
+	}
+
+	Json::Value root;
+	Json::CharReaderBuilder builder;
+	std::string parse_errors;
+	if (!Json::parseFromStream(builder, stream, &root, &parse_errors) || !root["benchmarks"].isObject())
+	{
+		printf("Baseline %s isn't valid. %s\n", path.c_str(), parse_errors.c_str());
+		return false;
+	}
+
+	const auto &baseline = root["benchmarks"];
+
+	printf("\nCompared with %s (regression threshold %.1f%%):\n", path.c_str(), threshold_percent);
+	printf("%-64s %12s %12s %9s %14s\n", "Benchmark", "base ms", "current ms", "change", "allocs change");
+
+	*regressions = 0;
+	for (const auto &[name, entry] : m_results)
+	{
+		if (!baseline.isMember(name))
+		{
+			printf("%-64s not in baseline\n", name.c_str());
+			continue;
+		}
+
+		const auto &base      = baseline[name];
+		auto base_time_ns     = base["real_time_ns"].asDouble();
+		auto base_allocations = base["allocations_per_iteration"].asDouble();
+
+		auto change = base_time_ns > 0 ? (entry.m_real_time_ns - base_time_ns) * 100.0 / base_time_ns : 0.0;
+		bool regressed = change > threshold_percent;
+		if (regressed)
+		{
+			(*regressions)++;
+		}
+
+		printf(
+			"%-64s %12.3f %12.3f %+8.1f%% %+14.1f%s\n",
+			name.c_str(),
+			base_time_ns / 1e6,
+			entry.m_real_time_ns / 1e6,
+			change,
+			entry.m_allocations_per_iteration - base_allocations,
+			regressed ? "  REGRESSION" : "");
+	}
+
+	for (const auto &name : baseline.getMemberNames())
+	{
+		if (m_results.find(name) == m_results.end())
+		{
+			printf("%-64s not run\n", name.c_str());
+		}
+	}
+
+	printf("%zu regression(s)\n", *regressions);
+	return true;
+}
+} // namespace archive_diff::benchmarks
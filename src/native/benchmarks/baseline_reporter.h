@@ -0,0 +1,53 @@
+/**
+ * @file baseline_reporter.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "allocation_counter.h"
+
+namespace archive_diff::benchmarks
+{
+// Console output as usual, while keeping the numbers of each benchmark so they can be
+// saved as a baseline or checked against one saved earlier.
+//
+// Baselines are JSON:
+// {"benchmarks": {"<name>": {"real_time_ns": ..., "mb_per_second": ...,
+//                            "allocations_per_iteration": ..., "peak_bytes": ...}}}
+class baseline_reporter : public benchmark::ConsoleReporter
+{
+	public:
+	baseline_reporter(const allocation_counter &allocations) : m_allocations(allocations) {}
+
+	virtual void ReportRuns(const std::vector<Run> &runs) override;
+
+	void print_summary() const;
+
+	bool save(const std::string &path) const;
+
+	// Prints how each benchmark moved against the baseline and counts the ones that became slower
+	// by more than threshold_percent. Benchmarks missing on either side are listed, not counted.
+	// Returns false if the baseline can't be read.
+	bool compare(const std::string &path, double threshold_percent, size_t *regressions) const;
+
+	private:
+	struct result
+	{
+		double m_real_time_ns{};
+		double m_mb_per_second{};
+		double m_allocations_per_iteration{};
+		int64_t m_peak_bytes{};
+	};
+
+	const allocation_counter &m_allocations;
+	std::map<std::string, result> m_results;
+};
+} // namespace archive_diff::benchmarks
@@ -0,0 +1,244 @@
+/**
+ * @file benchmark_apply.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_apply.h"
+#include "benchmark_data.h"
+
+#include <stdio.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <language_support/include_filesystem.h>
+
+#include <errors/user_exception.h>
+
+#include <diffs/api/legacy_adudiffapply.h>
+#include <diffs/core/item_definition_helpers.h>
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+#include <diffs/recipes/compressed/zstd_decompression_recipe.h>
+#include <diffs/serialization/standard/deserializer.h>
+#include <diffs/serialization/standard/serializer.h>
+
+#include <io/file/binary_file_writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+using namespace archive_diff;
+using namespace archive_diff::benchmarks;
+
+using item_definition = diffs::core::item_definition;
+
+const uint64_t c_apply_source_size = 8 * c_megabyte;
+const uint64_t c_apply_new_size    = 4 * c_megabyte;
+const uint64_t c_apply_chunk_size  = 64 * 1024;
+const uint64_t c_apply_raw_size    = 64 * 1024;
+
+// Chunks of the source are moved around the target by stepping through them with a stride
+// that shares no factor with the chunk count.
+const size_t c_apply_chunk_stride = 7;
+
+struct apply_case
+{
+	std::string m_source_path;
+	std::string m_diff_path;
+};
+
+static fs::path get_work_directory()
+{
+	auto path = fs::temp_directory_path() / "adu_diffs_benchmarks";
+	fs::create_directories(path);
+	return path;
+}
+
+static item_definition define_data(std::vector<char> &data, uint64_t offset, uint64_t length)
+{
+	return diffs::core::create_definition_from_span(std::span<char>{data.data() + offset, length});
+}
+
+// A diff shaped like a typical update: most of the target is the source rearranged and
+// the rest is new content carried in the inline assets, mostly zstd compressed.
+static apply_case make_synthetic_case()
+{
+	auto source     = get_random_data(c_apply_source_size, 2);
+	auto new_data   = get_compressible_data(c_apply_new_size, 3);
+	auto raw_data   = get_random_data(c_apply_raw_size, 4);
+	auto compressed = zstd_compress(new_data);
+
+	auto inline_assets = std::make_shared<std::vector<char>>(*compressed);
+	inline_assets->insert(inline_assets->end(), raw_data->begin(), raw_data->end());
+
+	diffs::serialization::standard::deserializer builder;
+
+	auto source_reader = make_reader(source);
+	auto source_item   = diffs::core::create_definition_from_reader(source_reader);
+	builder.set_source_item(source_item);
+
+	auto inline_assets_reader = make_reader(inline_assets);
+	builder.set_inline_assets(inline_assets_reader);
+	auto inline_assets_item = diffs::core::create_definition_from_reader(inline_assets_reader);
+
+	std::vector<char> target;
+	std::vector<item_definition> pieces;
+
+	auto chunk_count = c_apply_source_size / c_apply_chunk_size;
+	for (uint64_t i = 0; i < chunk_count; i++)
+	{
+		auto offset = ((i * c_apply_chunk_stride) % chunk_count) * c_apply_chunk_size;
+		auto chunk  = define_data(*source, offset, c_apply_chunk_size);
+		builder.add_recipe(diffs::recipes::basic::slice_recipe::c_recipe_name, chunk, {offset}, {source_item});
+		pieces.push_back(chunk);
+
+		target.insert(target.end(), source->begin() + offset, source->begin() + offset + c_apply_chunk_size);
+	}
+
+	auto compressed_item = define_data(*compressed, 0, compressed->size());
+	builder.add_recipe(
+		diffs::recipes::basic::slice_recipe::c_recipe_name, compressed_item, {0}, {inline_assets_item});
+
+	auto new_item = define_data(*new_data, 0, new_data->size());
+	builder.add_recipe(
+		diffs::recipes::compressed::zstd_decompression_recipe::c_recipe_name, new_item, {}, {compressed_item});
+	pieces.push_back(new_item);
+	target.insert(target.end(), new_data->begin(), new_data->end());
+
+	auto raw_item = define_data(*raw_data, 0, raw_data->size());
+	builder.add_recipe(
+		diffs::recipes::basic::slice_recipe::c_recipe_name, raw_item, {compressed->size()}, {inline_assets_item});
+	pieces.push_back(raw_item);
+	target.insert(target.end(), raw_data->begin(), raw_data->end());
+
+	auto target_item = define_data(target, 0, target.size());
+	builder.add_recipe(diffs::recipes::basic::chain_recipe::c_recipe_name, target_item, {}, pieces);
+	builder.set_target_item(target_item);
+
+	apply_case synthetic;
+	synthetic.m_source_path = (get_work_directory() / "synthetic_source").string();
+	synthetic.m_diff_path   = (get_work_directory() / "synthetic.diff").string();
+
+	{
+		std::ofstream source_file(synthetic.m_source_path, std::ios::out | std::ios::binary);
+		source_file.write(source->data(), source->size());
+	}
+
+	std::shared_ptr<io::writer> writer = std::make_shared<io::file::binary_file_writer>(synthetic.m_diff_path);
+	io::sequential::basic_writer_wrapper seq(writer);
+
+	auto archive = builder.get_archive();
+	diffs::serialization::standard::serializer serializer(archive);
+	serializer.write(seq);
+
+	return synthetic;
+}
+
+static void apply_diff(benchmark::State &state, const apply_case &to_apply, const std::string &name)
+{
+	auto target_path = (get_work_directory() / (name + ".target")).string();
+
+	for (auto _ : state)
+	{
+		auto handle      = adu_diff_apply_create_session();
+		auto error_count = adu_diff_apply(
+			handle, to_apply.m_source_path.c_str(), to_apply.m_diff_path.c_str(), target_path.c_str());
+
+		if (error_count != 0)
+		{
+			std::string message = adu_diff_apply_get_error_text(handle, 0);
+			adu_diff_apply_close_session(handle);
+			state.SkipWithError(message.c_str());
+			break;
+		}
+
+		adu_diff_apply_close_session(handle);
+	}
+
+	std::error_code ec;
+	auto target_size = fs::file_size(target_path, ec);
+	if (!ec)
+	{
+		set_mb_per_second(state, target_size);
+		fs::remove(target_path, ec);
+	}
+}
+
+static void apply_synthetic(benchmark::State &state)
+{
+	static std::unique_ptr<apply_case> synthetic;
+	if (!synthetic)
+	{
+		try
+		{
+			synthetic = std::make_unique<apply_case>(make_synthetic_case());
+		}
+		catch (errors::user_exception &e)
+		{
+			state.SkipWithError(e.get_message());
+			return;
+		}
+	}
+
+	apply_diff(state, *synthetic, "synthetic");
+}
+BENCHMARK(apply_synthetic)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+namespace archive_diff::benchmarks
+{
+size_t register_sample_apply_benchmarks(const std::string &sample_root)
+{
+	std::error_code ec;
+	if (!fs::is_directory(sample_root, ec))
+	{
+		printf("No sample diffs at %s\n", sample_root.c_str());
+		return 0;
+	}
+
+	size_t registered{};
+	for (const auto &entry : fs::directory_iterator(sample_root))
+	{
+		if (!entry.is_directory())
+		{
+			continue;
+		}
+
+		apply_case sample;
+		for (const auto &file : fs::directory_iterator(entry.path()))
+		{
+			if (!file.is_regular_file())
+			{
+				continue;
+			}
+
+			auto path = file.path();
+			if (path.stem() == "source")
+			{
+				sample.m_source_path = path.string();
+			}
+			else if ((path.filename() == "diff") || (path.extension() == ".diff"))
+			{
+				sample.m_diff_path = path.string();
+			}
+		}
+
+		auto name = entry.path().filename().string();
+		if (sample.m_source_path.empty() || sample.m_diff_path.empty())
+		{
+			printf("Skipping sample %s, it needs a source and a diff generated from it.\n", name.c_str());
+			continue;
+		}
+
+		benchmark::RegisterBenchmark(
+			("apply_sample/" + name).c_str(),
+			[sample, name](benchmark::State &state) { apply_diff(state, sample, "sample_" + name); })
+			->Unit(benchmark::kMillisecond)
+			->UseRealTime();
+		registered++;
+	}
+
+	return registered;
+}
+} // namespace archive_diff::benchmarks
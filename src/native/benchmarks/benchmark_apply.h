@@ -0,0 +1,17 @@
+/**
+ * @file benchmark_apply.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <string>
+
+namespace archive_diff::benchmarks
+{
+// Registers apply_sample/<case> for each case directory under sample_root holding a
+// source (source.*) and a diff generated from it (diff or *.diff). Cases without a
+// diff are listed and skipped. Returns the number of cases registered.
+size_t register_sample_apply_benchmarks(const std::string &sample_root);
+} // namespace archive_diff::benchmarks
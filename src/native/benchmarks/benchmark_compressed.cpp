@@ -0,0 +1,287 @@
+/**
+ * @file benchmark_compressed.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_compressed.h"
+#include "benchmark_data.h"
+
+#include <memory>
+#include <vector>
+
+#include <language_support/include_filesystem.h>
+
+#include <io/buffer/writer.h>
+#include <io/compressed/bsdiff_compressor.h>
+#include <io/compressed/bspatch_decompression_reader.h>
+#include <io/compressed/zlib_compression_writer.h>
+#include <io/compressed/zlib_decompression_reader.h>
+#include <io/compressed/zstd_compression_writer.h>
+#include <io/compressed/zstd_decompression_reader.h>
+#include <io/file/io_device.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <test_utility/random_data_file.h>
+
+using namespace archive_diff;
+using namespace archive_diff::benchmarks;
+
+using bsdiff_patch_format = io::compressed::bsdiff_patch_format;
+using init_type           = io::compressed::zlib_helpers::init_type;
+
+const uint64_t c_compressed_data_size = 16 * c_megabyte;
+const size_t c_decompress_buffer_size  = 64 * 1024;
+const uint64_t c_zstd_level            = 3;
+
+// bsdiff sorts the whole old file, so its data is kept smaller to keep setup short.
+const uint64_t c_bsdiff_data_size   = 4 * c_megabyte;
+const size_t c_bsdiff_edit_interval = 4096;
+
+static std::shared_ptr<std::vector<char>> zlib_compress(
+	const std::shared_ptr<std::vector<char>> &data, init_type init)
+{
+	auto compressed                    = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zlib_compression_writer compression_writer(seq_writer, 9, init);
+		auto reader = make_reader(data);
+		compression_writer.write(reader);
+	}
+	return compressed;
+}
+
+// Counts the compressed output without storing it.
+class counting_sink_writer : public io::sequential::writer
+{
+	public:
+	virtual void write(std::string_view buffer) override { m_written += buffer.size(); }
+	virtual void flush() override {}
+	virtual uint64_t tellp() override { return m_written; }
+
+	private:
+	uint64_t m_written{};
+};
+
+template <typename ReaderT>
+static void read_sequential_through(ReaderT &reader, uint64_t size, std::vector<char> &buffer)
+{
+	uint64_t total_read = 0;
+	while (total_read < size)
+	{
+		auto actual = reader.read_some(std::span<char>{buffer.data(), buffer.size()});
+		if (actual == 0)
+		{
+			break;
+		}
+		total_read += actual;
+	}
+	benchmark::DoNotOptimize(buffer.data());
+}
+
+static std::shared_ptr<std::vector<char>> zstd_compress_with_workers(
+	const std::shared_ptr<std::vector<char>> &data, const io::compressed::zstd_compression_workers &workers)
+{
+	auto compressed                    = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_compression_writer compression_writer(seq_writer, c_zstd_level, data->size(), workers);
+		auto reader = make_reader(data);
+		compression_writer.write(reader);
+	}
+	return compressed;
+}
+
+// Compressing with zstd workers; range(0) is the worker count. Job size and overlap log are
+// left to zstd, which doesn't pick them by worker count, so every count must write the same
+// bytes. Each case checks that against one worker's output, kept in single_worker_output,
+// before it is timed.
+static void zstd_compression_of(
+	benchmark::State &state,
+	const std::shared_ptr<std::vector<char>> &data,
+	std::shared_ptr<std::vector<char>> &single_worker_output)
+{
+	io::compressed::zstd_compression_workers workers;
+	workers.m_worker_count = static_cast<uint32_t>(state.range(0));
+
+	if (!single_worker_output)
+	{
+		single_worker_output = zstd_compress_with_workers(data, io::compressed::zstd_compression_workers{});
+	}
+	if (*zstd_compress_with_workers(data, workers) != *single_worker_output)
+	{
+		state.SkipWithError("Output differs from the output with one worker.");
+		return;
+	}
+
+	auto reader = make_reader(data);
+
+	uint64_t compressed_size{};
+	for (auto _ : state)
+	{
+		auto sink                                           = std::make_shared<counting_sink_writer>();
+		std::shared_ptr<io::sequential::writer> sink_writer = sink;
+		{
+			io::compressed::zstd_compression_writer writer(sink_writer, c_zstd_level, data->size(), workers);
+			writer.write(reader);
+		}
+		compressed_size = sink->tellp();
+	}
+
+	set_mb_per_second(state, data->size());
+	state.counters["compressed_bytes"] = static_cast<double>(compressed_size);
+}
+
+static void zstd_compression(benchmark::State &state)
+{
+	static std::shared_ptr<std::vector<char>> single_worker_output;
+	zstd_compression_of(state, get_compressible_data(c_compressed_data_size), single_worker_output);
+}
+BENCHMARK(zstd_compression)->ArgName("workers")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void zstd_decompression(benchmark::State &state)
+{
+	auto data       = get_compressible_data(c_compressed_data_size);
+	auto compressed = make_reader(zstd_compress(data));
+
+	std::vector<char> buffer(c_decompress_buffer_size);
+	for (auto _ : state)
+	{
+		io::compressed::zstd_decompression_reader reader(compressed, data->size());
+		read_sequential_through(reader, data->size(), buffer);
+	}
+
+	set_mb_per_second(state, data->size());
+}
+BENCHMARK(zstd_decompression);
+
+static void zlib_decompression(benchmark::State &state, init_type init)
+{
+	auto data       = get_compressible_data(c_compressed_data_size);
+	auto compressed = make_reader(zlib_compress(data, init));
+
+	std::vector<char> buffer(c_decompress_buffer_size);
+	for (auto _ : state)
+	{
+		io::compressed::zlib_decompression_reader reader(compressed, data->size(), init);
+		read_sequential_through(reader, data->size(), buffer);
+	}
+
+	set_mb_per_second(state, data->size());
+}
+BENCHMARK_CAPTURE(zlib_decompression, raw, init_type::raw);
+BENCHMARK_CAPTURE(zlib_decompression, gz, init_type::gz);
+
+static void bspatch_decompression(benchmark::State &state, bsdiff_patch_format format)
+{
+	auto old_data = get_random_data(c_bsdiff_data_size);
+	auto new_data = std::make_shared<std::vector<char>>(
+		test_utility::create_edited_copy(*old_data, c_bsdiff_edit_interval, 1));
+
+	auto old_reader = make_reader(old_data);
+	auto new_reader = make_reader(new_data);
+
+	auto diff_data                          = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> diff_writer = std::make_shared<io::buffer::writer>(diff_data);
+	io::compressed::bsdiff_compressor::delta_compress(old_reader, new_reader, diff_writer, format);
+	auto diff_reader = make_reader(diff_data);
+
+	std::vector<char> buffer(c_decompress_buffer_size);
+	for (auto _ : state)
+	{
+		io::compressed::bspatch_decompression_reader reader(diff_reader, new_data->size(), old_reader, format);
+		read_sequential_through(reader, new_data->size(), buffer);
+	}
+
+	set_mb_per_second(state, new_data->size());
+}
+BENCHMARK_CAPTURE(bspatch_decompression, bz2, bsdiff_patch_format::bz2)->UseRealTime();
+BENCHMARK_CAPTURE(bspatch_decompression, zstd, bsdiff_patch_format::zstd)->UseRealTime();
+
+// Making the patch that bspatch_decompression applies.
+static void bsdiff_compression(benchmark::State &state, bsdiff_patch_format format)
+{
+	auto old_data = get_random_data(c_bsdiff_data_size);
+	auto new_data = std::make_shared<std::vector<char>>(
+		test_utility::create_edited_copy(*old_data, c_bsdiff_edit_interval, 1));
+
+	auto old_reader = make_reader(old_data);
+	auto new_reader = make_reader(new_data);
+
+	uint64_t patch_size{};
+	for (auto _ : state)
+	{
+		auto diff_data                          = std::make_shared<std::vector<char>>();
+		std::shared_ptr<io::writer> diff_writer = std::make_shared<io::buffer::writer>(diff_data);
+		io::compressed::bsdiff_compressor::delta_compress(old_reader, new_reader, diff_writer, format);
+		patch_size = diff_data->size();
+	}
+
+	set_mb_per_second(state, new_data->size());
+	state.counters["patch_bytes"] = static_cast<double>(patch_size);
+}
+BENCHMARK_CAPTURE(bsdiff_compression, bz2, bsdiff_patch_format::bz2)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(bsdiff_compression, zstd, bsdiff_patch_format::zstd)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+namespace archive_diff::benchmarks
+{
+size_t register_file_compression_benchmarks(const std::vector<std::string> &paths)
+{
+	size_t registered{};
+	for (const auto &path : paths)
+	{
+		std::error_code ec;
+		if (!fs::is_regular_file(path, ec))
+		{
+			printf("Skipping %s, it isn't a file.\n", path.c_str());
+			continue;
+		}
+
+		// Read when the benchmark first runs, so files that are filtered out aren't loaded.
+		auto data                 = std::make_shared<std::shared_ptr<std::vector<char>>>();
+		auto single_worker_output = std::make_shared<std::shared_ptr<std::vector<char>>>();
+		benchmark::RegisterBenchmark(
+			("zstd_compression_file/" + fs::path(path).filename().string()).c_str(),
+			[path, data, single_worker_output](benchmark::State &state) {
+				if (!*data)
+				{
+					*data = std::make_shared<std::vector<char>>();
+					io::file::io_device::make_reader(path).read_all(**data);
+				}
+				zstd_compression_of(state, *data, *single_worker_output);
+			})
+			->ArgName("workers")
+			->Arg(1)
+			->Arg(2)
+			->Arg(4)
+			->Arg(8)
+			->UseRealTime();
+		registered++;
+	}
+
+	return registered;
+}
+
+std::vector<std::string> get_default_compression_files(const std::string &data_root)
+{
+	// The uncompressed samples the io tests use; their compressed forms aren't worth timing.
+	const char *c_sample_names[] = {"sample.zst.uncompressed", "remainder.dat"};
+
+	std::vector<std::string> paths;
+	for (auto name : c_sample_names)
+	{
+		auto path = fs::path(data_root) / name;
+
+		std::error_code ec;
+		if (fs::is_regular_file(path, ec))
+		{
+			paths.push_back(path.string());
+		}
+	}
+	return paths;
+}
+} // namespace archive_diff::benchmarks
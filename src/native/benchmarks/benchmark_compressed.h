@@ -0,0 +1,22 @@
+/**
+ * @file benchmark_compressed.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace archive_diff::benchmarks
+{
+// Registers zstd_compression_file/<name> for each file in paths, compressing it in memory
+// with 1, 2, 4 and 8 zstd workers. Paths that aren't files are listed and skipped.
+// Returns the number of files registered.
+size_t register_file_compression_benchmarks(const std::vector<std::string> &paths);
+
+// The samples under data_root that are compressed when no files are given; those that
+// aren't there are left out.
+std::vector<std::string> get_default_compression_files(const std::string &data_root);
+} // namespace archive_diff::benchmarks
@@ -0,0 +1,93 @@
+/**
+ * @file benchmark_data.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_data.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+#include <io/buffer/io_device.h>
+#include <io/buffer/writer.h>
+#include <io/compressed/zstd_compression_writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <test_utility/random_data_file.h>
+
+namespace archive_diff::benchmarks
+{
+void set_mb_per_second(benchmark::State &state, uint64_t bytes_per_iteration)
+{
+	state.counters[c_mb_per_second_counter] = benchmark::Counter(
+		static_cast<double>(bytes_per_iteration) / c_megabyte, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+template <typename GenerateT>
+static std::shared_ptr<std::vector<char>> get_cached_data(
+	const char *kind, uint64_t size, uint32_t seed, GenerateT generate)
+{
+	static std::mutex mutex;
+	static std::map<std::tuple<std::string, uint64_t, uint32_t>, std::shared_ptr<std::vector<char>>> cache;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto key   = std::make_tuple(std::string(kind), size, seed);
+	auto found = cache.find(key);
+	if (found != cache.end())
+	{
+		return found->second;
+	}
+
+	auto data  = std::make_shared<std::vector<char>>(generate(size, seed));
+	cache[key] = data;
+	return data;
+}
+
+std::shared_ptr<std::vector<char>> get_random_data(uint64_t size, uint32_t seed)
+{
+	return get_cached_data("random", size, seed, test_utility::create_random_data);
+}
+
+std::shared_ptr<std::vector<char>> get_compressible_data(uint64_t size, uint32_t seed)
+{
+	return get_cached_data("compressible", size, seed, test_utility::create_compressible_data);
+}
+
+io::reader make_reader(const std::shared_ptr<std::vector<char>> &data)
+{
+	return io::buffer::io_device::make_reader(data, io::buffer::io_device::size_kind::vector_size);
+}
+
+std::shared_ptr<std::vector<char>> zstd_compress(const std::shared_ptr<std::vector<char>> &data)
+{
+	auto compressed                    = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_compression_writer compression_writer(seq_writer, 3, data->size());
+		auto reader = make_reader(data);
+		compression_writer.write(reader);
+	}
+	return compressed;
+}
+
+void read_through(io::reader &reader, std::vector<char> &buffer)
+{
+	uint64_t offset = 0;
+	while (offset < reader.size())
+	{
+		auto actual = reader.read_some(offset, buffer);
+		if (actual == 0)
+		{
+			break;
+		}
+		offset += actual;
+	}
+	benchmark::DoNotOptimize(buffer.data());
+}
+} // namespace archive_diff::benchmarks
@@ -0,0 +1,40 @@
+/**
+ * @file benchmark_data.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <io/reader.h>
+
+namespace archive_diff::benchmarks
+{
+const uint64_t c_megabyte = 1024 * 1024;
+
+// The counter the baseline records throughput from.
+inline const std::string c_mb_per_second_counter{"MB/s"};
+
+// Reports bytes_per_iteration as MB/s of real time.
+void set_mb_per_second(benchmark::State &state, uint64_t bytes_per_iteration);
+
+// Generated data is shared by the benchmarks that use the same size and seed,
+// so that setup isn't repeated for every argument.
+std::shared_ptr<std::vector<char>> get_random_data(uint64_t size, uint32_t seed = 0);
+std::shared_ptr<std::vector<char>> get_compressible_data(uint64_t size, uint32_t seed = 0);
+
+io::reader make_reader(const std::shared_ptr<std::vector<char>> &data);
+
+// Reads the whole reader in buffer_size pieces, the way a writer pulling an item does.
+void read_through(io::reader &reader, std::vector<char> &buffer);
+
+// zstd level 3, the level diffs use for their inline assets.
+std::shared_ptr<std::vector<char>> zstd_compress(const std::shared_ptr<std::vector<char>> &data);
+} // namespace archive_diff::benchmarks
@@ -0,0 +1,108 @@
+/**
+ * @file benchmark_hashing.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_data.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include <hashing/hasher.h>
+
+using namespace archive_diff;
+using namespace archive_diff::benchmarks;
+
+using backend = hashing::hasher::backend;
+
+const uint64_t c_hash_data_size = 16 * c_megabyte;
+
+// Hashing a whole item, as when verifying the source, the diff or the written target.
+static void hash_data(benchmark::State &state, hashing::algorithm alg, backend hash_backend)
+{
+	if (!hashing::hasher::is_backend_supported(hash_backend))
+	{
+		state.SkipWithError("The backend isn't supported on this machine.");
+		return;
+	}
+
+	auto data = get_random_data(c_hash_data_size);
+
+	for (auto _ : state)
+	{
+		hashing::hasher hasher(alg, hash_backend);
+		hasher.hash_data(std::span<char>{data->data(), data->size()});
+		benchmark::DoNotOptimize(hasher.get_hash());
+	}
+
+	set_mb_per_second(state, c_hash_data_size);
+}
+BENCHMARK_CAPTURE(hash_data, md5, hashing::algorithm::md5, backend::library);
+BENCHMARK_CAPTURE(hash_data, sha256_library, hashing::algorithm::sha256, backend::library);
+BENCHMARK_CAPTURE(hash_data, sha256_sha_ni, hashing::algorithm::sha256, backend::sha_ni);
+
+// Hashing one item fed in range(0) byte pieces, as readers and writers pass data through.
+static void hash_stream(benchmark::State &state, backend hash_backend)
+{
+	if (!hashing::hasher::is_backend_supported(hash_backend))
+	{
+		state.SkipWithError("The backend isn't supported on this machine.");
+		return;
+	}
+
+	auto data       = get_random_data(c_hash_data_size);
+	auto piece_size = static_cast<size_t>(state.range(0));
+
+	hashing::hasher hasher(hashing::algorithm::sha256, hash_backend);
+	for (auto _ : state)
+	{
+		hasher.reset();
+		for (size_t offset = 0; offset < data->size(); offset += piece_size)
+		{
+			hasher.hash_data(data->data() + offset, std::min(piece_size, data->size() - offset));
+		}
+		benchmark::DoNotOptimize(hasher.get_hash_binary());
+	}
+
+	set_mb_per_second(state, c_hash_data_size);
+}
+BENCHMARK_CAPTURE(hash_stream, library, backend::library)->ArgName("piece")->Arg(4 * 1024)->Arg(64 * 1024);
+BENCHMARK_CAPTURE(hash_stream, sha_ni, backend::sha_ni)->ArgName("piece")->Arg(4 * 1024)->Arg(64 * 1024);
+
+// Hashing many small items of range(0) bytes at once, as when building the chunk definitions
+// of a diff or verifying small slices.
+static void hash_many_chunks(benchmark::State &state, backend hash_backend)
+{
+	if (!hashing::hasher::is_backend_supported(hash_backend))
+	{
+		state.SkipWithError("The backend isn't supported on this machine.");
+		return;
+	}
+
+	auto data       = get_random_data(c_hash_data_size);
+	auto chunk_size = static_cast<size_t>(state.range(0));
+
+	std::vector<std::string_view> chunks;
+	for (uint64_t offset = 0; offset + chunk_size <= c_hash_data_size; offset += chunk_size)
+	{
+		chunks.emplace_back(data->data() + offset, chunk_size);
+	}
+
+	for (auto _ : state)
+	{
+		auto hashes = hashing::hasher::hash_many(hashing::algorithm::sha256, chunks, hash_backend);
+		benchmark::DoNotOptimize(hashes.data());
+	}
+
+	set_mb_per_second(state, c_hash_data_size);
+	state.SetItemsProcessed(state.iterations() * chunks.size());
+}
+BENCHMARK_CAPTURE(hash_many_chunks, library, backend::library)->ArgName("chunk")->Arg(512)->Arg(4096)->Arg(65536);
+BENCHMARK_CAPTURE(hash_many_chunks, sha_ni, backend::sha_ni)->ArgName("chunk")->Arg(512)->Arg(4096)->Arg(65536);
+BENCHMARK_CAPTURE(hash_many_chunks, avx2_multi_buffer, backend::avx2_multi_buffer)
+	->ArgName("chunk")
+	->Arg(512)
+	->Arg(4096)
+	->Arg(65536);
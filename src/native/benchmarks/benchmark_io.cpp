@@ -0,0 +1,80 @@
+/**
+ * @file benchmark_io.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_data.h"
+
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <io/compressed/writer_to_reader_channel.h>
+
+using namespace archive_diff;
+using namespace archive_diff::benchmarks;
+
+const uint64_t c_io_data_size     = 16 * c_megabyte;
+const size_t c_io_read_buffer_size = 64 * 1024;
+
+// A target put together from many pieces of the source, the way chain recipes over slices read.
+static void chained_reader_read(benchmark::State &state)
+{
+	auto piece_size = static_cast<uint64_t>(state.range(0));
+	auto source     = make_reader(get_random_data(c_io_data_size));
+
+	std::vector<io::reader> pieces;
+	for (uint64_t offset = 0; offset < c_io_data_size; offset += piece_size)
+	{
+		pieces.push_back(source.slice(offset, piece_size));
+	}
+	auto chained = io::reader::chain(pieces);
+
+	std::vector<char> buffer(c_io_read_buffer_size);
+	for (auto _ : state)
+	{
+		read_through(chained, buffer);
+	}
+
+	set_mb_per_second(state, c_io_data_size);
+}
+BENCHMARK(chained_reader_read)->Arg(4 * 1024)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+// Moves data from a writing thread to the reading one, as when an item is produced by a recipe
+// that only writes and consumed by one that reads.
+static void writer_to_reader_channel_transfer(benchmark::State &state)
+{
+	auto capacity = static_cast<size_t>(state.range(0));
+	auto data     = get_random_data(c_io_read_buffer_size);
+
+	const size_t c_write_size = 16 * 1024;
+
+	std::vector<char> buffer(c_io_read_buffer_size);
+	for (auto _ : state)
+	{
+		io::compressed::writer_to_reader_channel channel(c_io_data_size, capacity);
+
+		std::thread writer(
+			[&]()
+			{
+				for (uint64_t written = 0; written < c_io_data_size; written += c_write_size)
+				{
+					channel.write(std::string_view{data->data(), c_write_size});
+				}
+				channel.flush();
+			});
+
+		uint64_t total_read = 0;
+		while (total_read < c_io_data_size)
+		{
+			total_read += channel.read_some(buffer);
+		}
+		writer.join();
+
+		benchmark::DoNotOptimize(buffer.data());
+	}
+
+	set_mb_per_second(state, c_io_data_size);
+}
+BENCHMARK(writer_to_reader_channel_transfer)->Arg(64 * 1024)->Arg(1024 * 1024)->UseRealTime();
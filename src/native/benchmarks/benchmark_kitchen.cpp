@@ -0,0 +1,333 @@
+/**
+ * @file benchmark_kitchen.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "benchmark_data.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <diffs/core/kitchen.h>
+#include <diffs/core/prepared_item.h>
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+#include <diffs/serialization/standard/deserializer.h>
+#include <diffs/serialization/standard/serializer.h>
+
+#include <hashing/hasher.h>
+
+#include <io/all_zeros_io_device.h>
+#include <io/basic_reader_factory.h>
+#include <io/buffer/writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+using namespace archive_diff;
+using namespace archive_diff::benchmarks;
+
+using item_definition = diffs::core::item_definition;
+
+const uint64_t c_kitchen_chunk_size = 4096;
+const size_t c_chunks_per_group     = 64;
+
+// Items only need distinct, well distributed hashes; the data behind them is never read.
+static item_definition make_item(uint64_t length, const std::string &label)
+{
+	hashing::hasher hasher(hashing::algorithm::sha256);
+	hasher.hash_data(label);
+	return item_definition{length}.with_hash(hasher.get_hash());
+}
+
+struct planning_diff
+{
+	std::shared_ptr<std::vector<char>> m_serialized;
+	item_definition m_source_item;
+};
+
+// A diff shaped like a large rootfs diff: the target is a chain of groups, each group
+// is a chain of chunks and each chunk is sliced out of the source.
+static const planning_diff &get_planning_diff(size_t chunk_count, bool write_recipe_index)
+{
+	static std::map<std::pair<size_t, bool>, planning_diff> diffs;
+
+	auto key   = std::pair{chunk_count, write_recipe_index};
+	auto found = diffs.find(key);
+	if (found != diffs.end())
+	{
+		return found->second;
+	}
+
+	diffs::serialization::standard::deserializer builder;
+
+	auto source_item = make_item(chunk_count * c_kitchen_chunk_size, "source");
+	builder.set_source_item(source_item);
+
+	std::vector<item_definition> groups;
+	std::vector<item_definition> chunks;
+	for (size_t i = 0; i < chunk_count; i++)
+	{
+		auto chunk = make_item(c_kitchen_chunk_size, "chunk " + std::to_string(i));
+		builder.add_recipe(
+			diffs::recipes::basic::slice_recipe::c_recipe_name, chunk, {i * c_kitchen_chunk_size}, {source_item});
+		chunks.push_back(chunk);
+
+		if ((chunks.size() == c_chunks_per_group) || (i + 1 == chunk_count))
+		{
+			auto group = make_item(chunks.size() * c_kitchen_chunk_size, "group " + std::to_string(groups.size()));
+			builder.add_recipe(diffs::recipes::basic::chain_recipe::c_recipe_name, group, {}, chunks);
+			groups.push_back(group);
+			chunks.clear();
+		}
+	}
+
+	auto target = make_item(chunk_count * c_kitchen_chunk_size, "target");
+	builder.add_recipe(diffs::recipes::basic::chain_recipe::c_recipe_name, target, {}, groups);
+	builder.set_target_item(target);
+
+	planning_diff diff;
+	diff.m_serialized  = std::make_shared<std::vector<char>>();
+	diff.m_source_item = source_item;
+
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(diff.m_serialized);
+	io::sequential::basic_writer_wrapper seq(writer);
+
+	auto archive = builder.get_archive();
+	diffs::serialization::standard::serializer serializer(archive);
+	serializer.set_write_recipe_index(write_recipe_index);
+	serializer.write(seq);
+
+	return diffs[key] = diff;
+}
+
+// With a recipe index only the header is read here; recipes are loaded as they're looked up.
+static void deserialize_planning_diff(benchmark::State &state)
+{
+	auto chunk_count        = static_cast<size_t>(state.range(0));
+	auto write_recipe_index = state.range(1) != 0;
+
+	const auto &diff = get_planning_diff(chunk_count, write_recipe_index);
+	auto diff_reader = make_reader(diff.m_serialized);
+
+	for (auto _ : state)
+	{
+		diffs::serialization::standard::deserializer deserializer;
+		deserializer.read(diff_reader);
+		benchmark::DoNotOptimize(deserializer.get_archive());
+	}
+
+	state.SetItemsProcessed(state.iterations() * chunk_count);
+}
+BENCHMARK(deserialize_planning_diff)
+	->ArgNames({"chunks", "index"})
+	->ArgsProduct({{4096, 32768}, {0, 1}})
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+// Selecting and preparing recipes for every item of the target, without reading any data.
+// With a recipe index, loading the recipes that are looked up is part of what's measured.
+static void kitchen_process_requested_items(benchmark::State &state)
+{
+	auto chunk_count        = static_cast<size_t>(state.range(0));
+	auto thread_count       = static_cast<uint32_t>(state.range(1));
+	auto write_recipe_index = state.range(2) != 0;
+
+	const auto &diff = get_planning_diff(chunk_count, write_recipe_index);
+	auto diff_reader = make_reader(diff.m_serialized);
+
+	auto source_reader = io::all_zeros_io_device::make_reader(diff.m_source_item.size());
+	std::shared_ptr<io::reader_factory> source_factory = std::make_shared<io::basic_reader_factory>(source_reader);
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		diffs::serialization::standard::deserializer deserializer;
+		deserializer.read(diff_reader);
+		auto archive = deserializer.get_archive();
+
+		auto kitchen = diffs::core::kitchen::create();
+		kitchen->set_preparation_thread_count(thread_count);
+		archive->stock_kitchen(kitchen.get());
+
+		auto source_prepared = std::make_shared<diffs::core::prepared_item>(
+			diff.m_source_item, diffs::core::prepared_item::reader_kind{source_factory});
+		kitchen->store_item(source_prepared);
+		state.ResumeTiming();
+
+		kitchen->request_item(archive->get_archive_item());
+		if (!kitchen->process_requested_items())
+		{
+			state.SkipWithError("The target couldn't be planned.");
+			break;
+		}
+
+		state.PauseTiming();
+		kitchen->cancel_slicing();
+		kitchen.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * chunk_count);
+}
+BENCHMARK(kitchen_process_requested_items)
+	->ArgNames({"chunks", "threads", "index"})
+	->ArgsProduct({{4096, 32768}, {1, 4}, {0, 1}})
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+struct planning_cookbook
+{
+	std::shared_ptr<diffs::core::cookbook> m_cookbook;
+	item_definition m_source_item;
+	item_definition m_target_item;
+	// Has no recipe, so the target can't be planned until one is added for it.
+	item_definition m_missing_chunk;
+};
+
+// The recipes of get_planning_diff() in a cookbook, so planning can be measured without
+// deserializing. With 'missing_chunk', the recipe for the last chunk is left out.
+static const planning_cookbook &get_planning_cookbook(size_t chunk_count, bool missing_chunk)
+{
+	static std::map<std::pair<size_t, bool>, planning_cookbook> cookbooks;
+
+	auto found = cookbooks.find(std::pair{chunk_count, missing_chunk});
+	if (found != cookbooks.end())
+	{
+		return found->second;
+	}
+
+	planning_cookbook result;
+	result.m_cookbook    = std::make_shared<diffs::core::cookbook>();
+	result.m_source_item = make_item(chunk_count * c_kitchen_chunk_size, "source");
+
+	auto add_recipe = [&](std::shared_ptr<diffs::core::recipe> recipe) { result.m_cookbook->add_recipe(recipe); };
+
+	std::vector<item_definition> groups;
+	std::vector<item_definition> chunks;
+	for (size_t i = 0; i < chunk_count; i++)
+	{
+		auto chunk = make_item(c_kitchen_chunk_size, "chunk " + std::to_string(i));
+		if (missing_chunk && (i + 1 == chunk_count))
+		{
+			result.m_missing_chunk = chunk;
+		}
+		else
+		{
+			add_recipe(std::make_shared<diffs::recipes::basic::slice_recipe>(
+				chunk,
+				std::vector<uint64_t>{i * c_kitchen_chunk_size},
+				std::vector<item_definition>{result.m_source_item}));
+		}
+		chunks.push_back(chunk);
+
+		if ((chunks.size() == c_chunks_per_group) || (i + 1 == chunk_count))
+		{
+			auto group = make_item(chunks.size() * c_kitchen_chunk_size, "group " + std::to_string(groups.size()));
+			add_recipe(std::make_shared<diffs::recipes::basic::chain_recipe>(group, std::vector<uint64_t>{}, chunks));
+			groups.push_back(group);
+			chunks.clear();
+		}
+	}
+
+	result.m_target_item = make_item(chunk_count * c_kitchen_chunk_size, "target");
+	add_recipe(
+		std::make_shared<diffs::recipes::basic::chain_recipe>(result.m_target_item, std::vector<uint64_t>{}, groups));
+
+	return cookbooks[std::pair{chunk_count, missing_chunk}] = result;
+}
+
+// Selecting recipes for every item of the target from a cookbook of a million or so recipes.
+static void kitchen_plan_cookbook(benchmark::State &state)
+{
+	auto chunk_count = static_cast<size_t>(state.range(0));
+
+	const auto &cookbook = get_planning_cookbook(chunk_count, false);
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto kitchen         = diffs::core::kitchen::create();
+		auto kitchen_recipes = cookbook.m_cookbook;
+		kitchen->add_cookbook(kitchen_recipes);
+		std::set<item_definition> mocked_items{cookbook.m_source_item};
+		state.ResumeTiming();
+
+		kitchen->request_item(cookbook.m_target_item);
+		if (!kitchen->process_requested_items(true, mocked_items))
+		{
+			state.SkipWithError("The target couldn't be planned.");
+			break;
+		}
+
+		state.PauseTiming();
+		kitchen.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * chunk_count);
+}
+BENCHMARK(kitchen_plan_cookbook)
+	->ArgNames({"chunks"})
+	->Arg(16384)
+	->Arg(1 << 20)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+// Asking again for a target that couldn't be planned while recipes for unrelated items are
+// added. Only the items those recipes could make reachable are searched again.
+static void kitchen_replan_unreachable(benchmark::State &state)
+{
+	auto chunk_count = static_cast<size_t>(state.range(0));
+
+	const auto &cookbook = get_planning_cookbook(chunk_count, true);
+
+	auto kitchen         = diffs::core::kitchen::create();
+	auto kitchen_recipes = cookbook.m_cookbook;
+	kitchen->add_cookbook(kitchen_recipes);
+	std::set<item_definition> mocked_items{cookbook.m_source_item};
+
+	kitchen->request_item(cookbook.m_target_item);
+	if (kitchen->process_requested_items(true, mocked_items))
+	{
+		state.SkipWithError("The target was planned without the missing chunk.");
+		return;
+	}
+
+	size_t added{};
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto unrelated = make_item(c_kitchen_chunk_size, "unrelated " + std::to_string(added++));
+		std::shared_ptr<diffs::core::recipe> recipe = std::make_shared<diffs::recipes::basic::slice_recipe>(
+			unrelated, std::vector<uint64_t>{0}, std::vector<item_definition>{cookbook.m_source_item});
+		state.ResumeTiming();
+
+		kitchen->add_recipe(recipe);
+		if (kitchen->process_requested_items(true, mocked_items))
+		{
+			state.SkipWithError("The target was planned without the missing chunk.");
+			break;
+		}
+	}
+
+	// Once the chunk has a recipe, the target is planned from what was already selected.
+	std::shared_ptr<diffs::core::recipe> chunk_recipe = std::make_shared<diffs::recipes::basic::slice_recipe>(
+		cookbook.m_missing_chunk,
+		std::vector<uint64_t>{0},
+		std::vector<item_definition>{cookbook.m_source_item});
+	kitchen->add_recipe(chunk_recipe);
+	if (!kitchen->process_requested_items(true, mocked_items))
+	{
+		state.SkipWithError("The target couldn't be planned after adding the missing chunk.");
+	}
+}
+BENCHMARK(kitchen_replan_unreachable)
+	->ArgNames({"chunks"})
+	->Arg(16384)
+	->Arg(1 << 20)
+	->Unit(benchmark::kMicrosecond)
+	->UseRealTime();
@@ -0,0 +1,117 @@
+/**
+ * @file main.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <stdio.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "allocation_counter.h"
+#include "baseline_reporter.h"
+#include "benchmark_apply.h"
+#include "benchmark_compressed.h"
+
+using namespace archive_diff::benchmarks;
+
+const double c_default_regression_threshold = 5.0;
+
+void usage()
+{
+	printf("Usage: benchmarks [google-benchmark options] [options]\n");
+	printf("    --sample_root <dir>             Cases for apply_sample, default %s\n", BENCHMARKS_DEFAULT_SAMPLE_ROOT);
+	printf("    --data_root <dir>               Default files for zstd_compression_file, default %s\n",
+		BENCHMARKS_DEFAULT_DATA_ROOT);
+	printf("    --compress_file <path>          Adds zstd_compression_file for the file instead; may be repeated.\n");
+	printf("    --save_baseline <path>          Save the results as a baseline.\n");
+	printf("    --compare_baseline <path>       Compare with a saved baseline, failing on regressions.\n");
+	printf("    --regression_threshold <pct>    Slowdown counted as a regression, default %.1f%%\n",
+		c_default_regression_threshold);
+}
+
+int main(int argc, char **argv)
+{
+	benchmark::Initialize(&argc, argv);
+
+	std::string sample_root = BENCHMARKS_DEFAULT_SAMPLE_ROOT;
+	std::string data_root   = BENCHMARKS_DEFAULT_DATA_ROOT;
+	std::vector<std::string> compress_paths;
+	std::string save_path;
+	std::string compare_path;
+	double regression_threshold = c_default_regression_threshold;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool has_value = (i + 1) < argc;
+
+		if (has_value && (strcmp(argv[i], "--sample_root") == 0))
+		{
+			sample_root = argv[++i];
+		}
+		else if (has_value && (strcmp(argv[i], "--data_root") == 0))
+		{
+			data_root = argv[++i];
+		}
+		else if (has_value && (strcmp(argv[i], "--compress_file") == 0))
+		{
+			compress_paths.push_back(argv[++i]);
+		}
+		else if (has_value && (strcmp(argv[i], "--save_baseline") == 0))
+		{
+			save_path = argv[++i];
+		}
+		else if (has_value && (strcmp(argv[i], "--compare_baseline") == 0))
+		{
+			compare_path = argv[++i];
+		}
+		else if (has_value && (strcmp(argv[i], "--regression_threshold") == 0))
+		{
+			regression_threshold = std::strtod(argv[++i], nullptr);
+		}
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	register_sample_apply_benchmarks(sample_root);
+	if (compress_paths.empty())
+	{
+		compress_paths = get_default_compression_files(data_root);
+	}
+	register_file_compression_benchmarks(compress_paths);
+
+	allocation_counter allocations;
+	benchmark::RegisterMemoryManager(&allocations);
+
+	baseline_reporter reporter(allocations);
+	benchmark::RunSpecifiedBenchmarks(&reporter);
+	benchmark::RegisterMemoryManager(nullptr);
+	benchmark::Shutdown();
+
+	reporter.print_summary();
+
+	if (!save_path.empty() && !reporter.save(save_path))
+	{
+		return 1;
+	}
+
+	if (!compare_path.empty())
+	{
+		size_t regressions{};
+		if (!reporter.compare(compare_path, regression_threshold, &regressions))
+		{
+			return 1;
+		}
+		return regressions == 0 ? 0 : 1;
+	}
+
+	return 0;
+}
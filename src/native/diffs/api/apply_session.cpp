@@ -37,10 +37,14 @@ uint32_t apply_session::add_archive(const std::string &path)
 
 	API_CALL_PROLOG();
 
+	diff_reader = profile_reader(diff_reader, core::apply_profiler::read_origin::diff);
+
 	std::string reason_standard;
 	if (diffs::serialization::standard::deserializer::is_this_format(diff_reader, &reason_standard))
 	{
+		// The inline assets and remainder are checked as they are read instead of hashed up front.
 		diffs::serialization::standard::deserializer deserializer;
+		deserializer.set_deferred_verification(true);
 		deserializer.read(diff_reader);
 		archive = deserializer.get_archive();
 	}
@@ -70,9 +74,35 @@ uint32_t apply_session::add_file_to_pantry(const std::string &path)
 {
 	API_CALL_PROLOG();
 
-	auto reader = io::file::io_device::make_reader(path);
+	auto file_reader = io::file::io_device::make_reader(path);
+	auto reader      = profile_reader(file_reader, core::apply_profiler::read_origin::source);
+
+	core::item_definition item;
+	if (m_source_hash_cache)
+	{
+		item = m_source_hash_cache->get_definition(path, reader);
 
-	auto item = diffs::core::create_definition_from_reader(reader);
+		// Failing to persist the cache only costs a rehash next time; it isn't worth failing the apply.
+		try
+		{
+			if (m_source_hash_cache->has_unsaved_changes())
+			{
+				m_source_hash_cache->save(m_source_hash_cache_path);
+			}
+		}
+		catch (errors::user_exception &e)
+		{
+			ADU_LOG("Failed to save source hash cache {}. Msg: {}", m_source_hash_cache_path, e.get_message());
+		}
+		catch (std::exception &e)
+		{
+			ADU_LOG("Failed to save source hash cache {}. Msg: {}", m_source_hash_cache_path, e.what());
+		}
+	}
+	else
+	{
+		item = diffs::core::create_definition_from_reader(reader);
+	}
 
 	ADU_LOG("adding file to pantry: {}", item);
 
@@ -86,6 +116,54 @@ uint32_t apply_session::add_file_to_pantry(const std::string &path)
 	API_CALL_EPILOG();
 }
 
+uint32_t apply_session::add_file_to_pantry(const std::string &path, const core::item_definition &known_item)
+{
+	API_CALL_PROLOG();
+
+	auto file_reader = io::file::io_device::make_reader(path);
+	auto reader      = profile_reader(file_reader, core::apply_profiler::read_origin::source);
+
+	if (reader.size() != known_item.size())
+	{
+		std::string msg = fmt::format(
+			"File size doesn't match known item. Path: {}, Size: {}, Known item: {}", path, reader.size(), known_item);
+		throw errors::user_exception(errors::error_code::diff_verify_source_size_mismatch, msg);
+	}
+
+	// The content isn't hashed here, and nothing taken from the file is checked as it is read.
+	// Only the items written by extract_item_to_path() are checked against their own hashes,
+	// so a file that doesn't match known_item is caught there. The caller has to ask for that.
+	if (!m_kitchen->get_verify_written_items())
+	{
+		throw errors::user_exception(
+			errors::error_code::api_verification_not_enabled,
+			"add_file_to_pantry: A file with a known item needs set_verify_written_items(true) first.");
+	}
+
+	ADU_LOG("adding file to pantry with known item: {}", known_item);
+	m_has_unhashed_pantry_items = true;
+
+	std::shared_ptr<io::reader_factory> reader_factory = std::make_shared<io::basic_reader_factory>(reader);
+
+	auto prep =
+		std::make_shared<core::prepared_item>(known_item, diffs::core::prepared_item::reader_kind{reader_factory});
+
+	m_kitchen->store_item(prep);
+
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::set_source_hash_cache_path(const std::string &path)
+{
+	API_CALL_PROLOG();
+
+	m_source_hash_cache_path = path;
+	m_source_hash_cache      = std::make_unique<core::source_hash_cache>();
+	m_source_hash_cache->load(path);
+
+	API_CALL_EPILOG();
+}
+
 uint32_t apply_session::clear_requested_items()
 {
 	API_CALL_PROLOG();
@@ -145,10 +223,9 @@ uint32_t apply_session::extract_item_to_path(const core::item_definition &item,
 {
 	API_CALL_PROLOG();
 
-	auto prepared_item = m_kitchen->fetch_item(item);
-
-	std::shared_ptr<io::writer> writer = std::make_shared<io::file::binary_file_writer>(path);
-	prepared_item->write(writer);
+	io::file::binary_file_writer writer(path, !m_dense_output);
+	m_kitchen->write_item(writer, item);
+	writer.flush();
 
 	API_CALL_EPILOG();
 }
@@ -163,4 +240,94 @@ uint32_t apply_session::save_selected_recipes(const std::string &path)
 	API_CALL_EPILOG();
 }
 
+uint32_t apply_session::set_thread_count(uint32_t thread_count)
+{
+	API_CALL_PROLOG();
+	m_kitchen->set_preparation_thread_count(thread_count);
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::set_slice_memory_budget(uint64_t budget_bytes)
+{
+	API_CALL_PROLOG();
+	m_kitchen->set_slice_memory_budget(budget_bytes);
+	API_CALL_EPILOG();
+}
+
+uint64_t apply_session::get_peak_resident_slice_bytes() const { return m_kitchen->get_peak_resident_slice_bytes(); }
+
+uint64_t apply_session::get_peak_intermediate_bytes() const { return m_kitchen->get_peak_intermediate_bytes(); }
+
+uint32_t apply_session::set_verify_written_items(bool verify)
+{
+	API_CALL_PROLOG();
+	if (!verify && m_has_unhashed_pantry_items)
+	{
+		throw errors::user_exception(
+			errors::error_code::api_verification_not_enabled,
+			"set_verify_written_items: Files were added with known items, which rely on verification.");
+	}
+	m_kitchen->set_verify_written_items(verify);
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::set_write_pipeline_depth(uint32_t buffer_count)
+{
+	API_CALL_PROLOG();
+	m_kitchen->set_write_pipeline_depth(buffer_count);
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::set_dense_output(bool dense)
+{
+	API_CALL_PROLOG();
+	m_dense_output = dense;
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::set_read_ahead_window_size(uint64_t window_size)
+{
+	API_CALL_PROLOG();
+	m_kitchen->set_read_ahead_window_size(window_size);
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::enable_profiling(bool trace)
+{
+	API_CALL_PROLOG();
+	m_kitchen->set_profiler(std::make_shared<core::apply_profiler>(trace));
+	API_CALL_EPILOG();
+}
+
+uint32_t apply_session::write_profile(const std::string &summary_path, const std::string &trace_path)
+{
+	API_CALL_PROLOG();
+
+	auto profiler = m_kitchen->get_profiler();
+	if (!profiler)
+	{
+		throw errors::user_exception(
+			errors::error_code::api_profiling_not_enabled, "write_profile: Profiling wasn't enabled.");
+	}
+
+	profiler->write_summary(summary_path);
+	if (!trace_path.empty())
+	{
+		profiler->write_chrome_trace(trace_path);
+	}
+
+	API_CALL_EPILOG();
+}
+
+io::reader apply_session::profile_reader(io::reader &reader, core::apply_profiler::read_origin origin)
+{
+	auto profiler = m_kitchen->get_profiler();
+	if (!profiler)
+	{
+		return reader;
+	}
+
+	return profiler->wrap_reader(reader, origin);
+}
+
 } // namespace archive_diff::diffs::api
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <memory>
 
 #include <diffs/core/kitchen.h>
+#include <diffs/core/source_hash_cache.h>
 
 #include "aduapi_types.h"
 #include "session_base.h"
@@ -41,6 +42,12 @@ class apply_session : public session_base
 	uint32_t add_archive(const std::string &path);
 	uint32_t request_item(const core::item_definition &item);
 	uint32_t add_file_to_pantry(const std::string &path);
+
+	// Trusts known_item for the file's content instead of hashing it; only the size is checked.
+	// Written item verification must be turned on first and can't be turned off afterwards.
+	uint32_t add_file_to_pantry(const std::string &path, const core::item_definition &known_item);
+
+	uint32_t set_source_hash_cache_path(const std::string &path);
 	uint32_t clear_requested_items();
 	uint32_t process_requested_items();
 	uint32_t process_requested_items(
@@ -49,9 +56,38 @@ class apply_session : public session_base
 	uint32_t cancel_slicing();
 	uint32_t extract_item_to_path(const core::item_definition &item, const std::string &path);
 	uint32_t save_selected_recipes(const std::string &path);
+	uint32_t set_thread_count(uint32_t thread_count);
+	uint32_t set_slice_memory_budget(uint64_t budget_bytes);
+	uint64_t get_peak_resident_slice_bytes() const;
+	uint64_t get_peak_intermediate_bytes() const;
+	uint32_t set_verify_written_items(bool verify);
+	uint32_t set_write_pipeline_depth(uint32_t buffer_count);
+
+	// Extracted files are written sparse by default, leaving zero ranges as holes when the
+	// target is a regular file. Dense output writes every byte, as raw block devices need.
+	uint32_t set_dense_output(bool dense);
+
+	// How far ahead of the target being written the source and diff are read ahead; see
+	// core::read_ahead. 0 turns read-ahead off.
+	uint32_t set_read_ahead_window_size(uint64_t window_size);
+
+	// Records where apply time goes from here on; see core::apply_profiler. Archives and
+	// files added before this is called aren't counted in the bytes read.
+	uint32_t enable_profiling(bool trace);
+
+	// Writes the profile summary as JSON, and the Chrome trace when trace_path isn't empty.
+	uint32_t write_profile(const std::string &summary_path, const std::string &trace_path);
 
 	private:
+	io::reader profile_reader(io::reader &reader, core::apply_profiler::read_origin origin);
+
 	std::mutex m_mutex;
 	std::shared_ptr<core::kitchen> m_kitchen{core::kitchen::create()};
+
+	std::string m_source_hash_cache_path;
+	std::unique_ptr<core::source_hash_cache> m_source_hash_cache;
+
+	bool m_has_unhashed_pantry_items{false};
+	bool m_dense_output{false};
 };
 } // namespace archive_diff::diffs::api
\ No newline at end of file
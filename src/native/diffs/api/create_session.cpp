@@ -100,6 +100,16 @@ uint32_t create_session::add_payload(const char *payload_name, const diffc_item_
 	API_CALL_EPILOG();
 }
 
+uint32_t create_session::set_write_recipe_index(bool value)
+{
+	API_CALL_PROLOG();
+
+	std::lock_guard<std::mutex> lock_guard(m_archive_mutex);
+	m_write_recipe_index = value;
+
+	API_CALL_EPILOG();
+}
+
 uint32_t create_session::write_diff(const char *path)
 {
 	API_CALL_PROLOG();
@@ -112,6 +122,7 @@ uint32_t create_session::write_diff(const char *path)
 	auto archive = m_deserializer.get_archive();
 
 	diffs::serialization::standard::serializer serializer(archive);
+	serializer.set_write_recipe_index(m_write_recipe_index);
 	serializer.write(seq);
 
 	API_CALL_EPILOG();
@@ -53,6 +53,7 @@ class create_session : public session_base
 		const diffc_item_definition **item_ingredients,
 		size_t item_ingredient_count);
 
+	uint32_t set_write_recipe_index(bool value);
 	uint32_t write_diff(const char *path);
 
 	apply_session *new_apply_session() const;
@@ -60,6 +61,7 @@ class create_session : public session_base
 	private:
 	std::mutex m_archive_mutex;
 	diffs::serialization::standard::deserializer m_deserializer;
+	bool m_write_recipe_index{false};
 };
 } // namespace api
 } // namespace archive_diff::diffs
\ No newline at end of file
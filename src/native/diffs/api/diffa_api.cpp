@@ -13,6 +13,7 @@
 #include "apply_session.h"
 
 #include <diffs/core/item_definition.h>
+#include <io/compressed/bspatch_job_pool.h>
 #include <aduapi_type_conversion.h>
 
 ADUAPI_LINKAGESPEC diffa_handle CDECL diffa_open_session()
@@ -27,6 +28,16 @@ ADUAPI_LINKAGESPEC void CDECL diffa_close_session(diffa_handle handle)
 	delete session;
 }
 
+ADUAPI_LINKAGESPEC void CDECL diffa_set_max_concurrent_bspatch_jobs(uint32_t job_count)
+{
+	archive_diff::io::compressed::bspatch_job_pool::get().set_max_concurrent_jobs(job_count);
+}
+
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_concurrent_bspatch_jobs()
+{
+	return archive_diff::io::compressed::bspatch_job_pool::get().get_peak_concurrent_jobs();
+}
+
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_add_archive(diffa_handle handle, const char *path)
 {
 	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
@@ -50,6 +61,23 @@ ADUAPI_LINKAGESPEC uint32_t CDECL diffa_add_file_to_pantry(diffa_handle handle,
 	return session->add_file_to_pantry(path);
 }
 
+ADUAPI_LINKAGESPEC uint32_t CDECL
+diffa_add_file_to_pantry_with_item(diffa_handle handle, const char *path, const diffc_item_definition *item)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	auto converted_item = diffc_item_definition_to_core_item_definition(*item);
+
+	return session->add_file_to_pantry(path, converted_item);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_source_hash_cache_path(diffa_handle handle, const char *path)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_source_hash_cache_path(path);
+}
+
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_clear_requested_items(diffa_handle handle)
 {
 	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
@@ -79,6 +107,77 @@ ADUAPI_LINKAGESPEC uint32_t CDECL diffa_save_selected_recipes(diffa_handle handl
 	return session->save_selected_recipes(path);
 }
 
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_thread_count(diffa_handle handle, uint32_t thread_count)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_thread_count(thread_count);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_slice_memory_budget(diffa_handle handle, uint64_t budget_bytes)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_slice_memory_budget(budget_bytes);
+}
+
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_resident_slice_bytes(diffa_handle handle)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->get_peak_resident_slice_bytes();
+}
+
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_intermediate_bytes(diffa_handle handle)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->get_peak_intermediate_bytes();
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_verify_written_items(diffa_handle handle, bool verify)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_verify_written_items(verify);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_write_pipeline_depth(diffa_handle handle, uint32_t buffer_count)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_write_pipeline_depth(buffer_count);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_dense_output(diffa_handle handle, bool dense)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_dense_output(dense);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_read_ahead_window_size(diffa_handle handle, uint64_t window_size)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->set_read_ahead_window_size(window_size);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_enable_profiling(diffa_handle handle, bool trace)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->enable_profiling(trace);
+}
+
+ADUAPI_LINKAGESPEC uint32_t CDECL
+diffa_write_profile(diffa_handle handle, const char *summary_path, const char *trace_path)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+
+	return session->write_profile(summary_path, trace_path ? trace_path : "");
+}
+
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_resume_slicing(diffa_handle handle)
 {
 	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
@@ -23,9 +23,16 @@ typedef void *diffa_handle;
 ADUAPI_LINKAGESPEC diffa_handle CDECL diffa_open_session();
 ADUAPI_LINKAGESPEC void CDECL diffa_close_session(diffa_handle handle);
 
+// bspatch jobs run on a pool shared by the whole process, so these apply to every session.
+ADUAPI_LINKAGESPEC void CDECL diffa_set_max_concurrent_bspatch_jobs(uint32_t job_count);
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_concurrent_bspatch_jobs();
+
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_add_archive(diffa_handle handle, const char *path);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_request_item(diffa_handle handle, const diffc_item_definition *item);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_add_file_to_pantry(diffa_handle handle, const char *path);
+ADUAPI_LINKAGESPEC uint32_t CDECL
+diffa_add_file_to_pantry_with_item(diffa_handle handle, const char *path, const diffc_item_definition *item);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_source_hash_cache_path(diffa_handle handle, const char *path);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_clear_requested_items(diffa_handle handle);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_process_requested_items(diffa_handle handle);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_process_requested_items_ex(
@@ -34,6 +41,17 @@ ADUAPI_LINKAGESPEC uint32_t CDECL diffa_process_requested_items_ex(
 	const diffc_item_definition **mocked_items,
 	size_t mocked_item_count);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_save_selected_recipes(diffa_handle handle, const char *path);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_thread_count(diffa_handle handle, uint32_t thread_count);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_slice_memory_budget(diffa_handle handle, uint64_t budget_bytes);
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_resident_slice_bytes(diffa_handle handle);
+ADUAPI_LINKAGESPEC uint64_t CDECL diffa_get_peak_intermediate_bytes(diffa_handle handle);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_verify_written_items(diffa_handle handle, bool verify);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_write_pipeline_depth(diffa_handle handle, uint32_t buffer_count);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_dense_output(diffa_handle handle, bool dense);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_set_read_ahead_window_size(diffa_handle handle, uint64_t window_size);
+ADUAPI_LINKAGESPEC uint32_t CDECL diffa_enable_profiling(diffa_handle handle, bool trace);
+ADUAPI_LINKAGESPEC uint32_t CDECL
+diffa_write_profile(diffa_handle handle, const char *summary_path, const char *trace_path);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_resume_slicing(diffa_handle handle);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffa_cancel_slicing(diffa_handle handle);
 ADUAPI_LINKAGESPEC uint32_t CDECL
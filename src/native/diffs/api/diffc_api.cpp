@@ -80,6 +80,12 @@ diffc_add_payload(diffc_handle handle, const char *name, const diffc_item_defini
 	return session->add_payload(name, item);
 }
 
+ADUAPI_LINKAGESPEC uint32_t CDECL diffc_set_write_recipe_index(diffc_handle handle, bool value)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::create_session *>(handle);
+	return session->set_write_recipe_index(value);
+}
+
 ADUAPI_LINKAGESPEC uint32_t CDECL diffc_write_diff(diffc_handle handle, const char *path)
 {
 	auto session = reinterpret_cast<archive_diff::diffs::api::create_session *>(handle);
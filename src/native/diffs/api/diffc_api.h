@@ -44,6 +44,7 @@ ADUAPI_LINKAGESPEC uint32_t CDECL diffc_add_nested_archive(diffc_handle, const c
 ADUAPI_LINKAGESPEC uint32_t CDECL
 diffc_add_payload(diffc_handle handle, const char *name, const diffc_item_definition &item);
 
+ADUAPI_LINKAGESPEC uint32_t CDECL diffc_set_write_recipe_index(diffc_handle handle, bool value);
 ADUAPI_LINKAGESPEC uint32_t CDECL diffc_write_diff(diffc_handle handle, const char *path);
 
 ADUAPI_LINKAGESPEC diffa_handle CDECL diffc_new_diffa_session(diffc_handle handle);
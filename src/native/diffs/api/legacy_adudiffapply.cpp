@@ -12,14 +12,14 @@
 
 ADUAPI_LINKAGESPEC adu_apply_handle CDECL adu_diff_apply_create_session()
 {
-	auto session = std::make_unique<archive_diff::diffs::api::apply_session>();
+	auto session = std::make_unique<archive_diff::diffs::api::legacy_apply_session>();
 
 	return reinterpret_cast<adu_apply_handle>(session.release());
 }
 
 ADUAPI_LINKAGESPEC void CDECL adu_diff_apply_close_session(adu_apply_handle handle)
 {
-	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
 
 	delete session;
 }
@@ -30,27 +30,70 @@ adu_diff_apply_set_log_path([[maybe_unused]] adu_apply_handle handle, [[maybe_un
 	return 0;
 }
 
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_write_pipeline_depth(adu_apply_handle handle, uint32_t buffer_count)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_write_pipeline_depth(buffer_count);
+	return 0;
+}
+
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_dense_output(adu_apply_handle handle, bool dense)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_dense_output(dense);
+	return 0;
+}
+
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_read_ahead_window_size(adu_apply_handle handle, uint64_t window_size)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_read_ahead_window_size(window_size);
+	return 0;
+}
+
+ADUAPI_LINKAGESPEC int CDECL
+adu_diff_apply_set_profile_paths(adu_apply_handle handle, const char *summary_path, const char *trace_path)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_profile_paths(summary_path ? summary_path : "", trace_path ? trace_path : "");
+	return 0;
+}
+
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_source_hash_cache_path(adu_apply_handle handle, const char *path)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_source_hash_cache_path(path ? path : "");
+	return 0;
+}
+
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_trust_diff_source_item(adu_apply_handle handle, bool trust)
+{
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
+	session->set_trust_diff_source_item(trust);
+	return 0;
+}
+
 ADUAPI_LINKAGESPEC int CDECL
 adu_diff_apply(adu_apply_handle handle, const char *source_path, const char *diff_path, const char *target_path)
 {
-	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
 	return session->apply(source_path, diff_path, target_path);
 }
 
 ADUAPI_LINKAGESPEC uint32_t CDECL adu_diff_apply_get_error_count(adu_apply_handle handle)
 {
-	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
 	return session->get_error_count();
 }
 
 ADUAPI_LINKAGESPEC const char *CDECL adu_diff_apply_get_error_text(adu_apply_handle handle, uint32_t index)
 {
-	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
 	return session->get_error_text(index);
 }
 
 ADUAPI_LINKAGESPEC uint32_t CDECL adu_diff_apply_get_error_code(adu_apply_handle handle, uint32_t index)
 {
-	auto session = reinterpret_cast<archive_diff::diffs::api::apply_session *>(handle);
+	auto session = reinterpret_cast<archive_diff::diffs::api::legacy_apply_session *>(handle);
 	return session->get_error_code(index);
 }
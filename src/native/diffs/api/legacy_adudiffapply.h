@@ -19,6 +19,13 @@ typedef void *adu_apply_handle;
 ADUAPI_LINKAGESPEC adu_apply_handle CDECL adu_diff_apply_create_session();
 ADUAPI_LINKAGESPEC void CDECL adu_diff_apply_close_session(adu_apply_handle handle);
 ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_log_path(adu_apply_handle handle, const char *log_path);
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_write_pipeline_depth(adu_apply_handle handle, uint32_t buffer_count);
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_dense_output(adu_apply_handle handle, bool dense);
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_read_ahead_window_size(adu_apply_handle handle, uint64_t window_size);
+ADUAPI_LINKAGESPEC int CDECL
+adu_diff_apply_set_profile_paths(adu_apply_handle handle, const char *summary_path, const char *trace_path);
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_source_hash_cache_path(adu_apply_handle handle, const char *path);
+ADUAPI_LINKAGESPEC int CDECL adu_diff_apply_set_trust_diff_source_item(adu_apply_handle handle, bool trust);
 ADUAPI_LINKAGESPEC int CDECL
 adu_diff_apply(adu_apply_handle handle, const char *source_path, const char *diff_path, const char *target_path);
 ADUAPI_LINKAGESPEC uint32_t CDECL adu_diff_apply_get_error_count(adu_apply_handle handle);
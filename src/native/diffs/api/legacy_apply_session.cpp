@@ -7,6 +7,7 @@
 
 #include "legacy_apply_session.h"
 
+#include <errors/adu_log.h>
 #include <errors/user_exception.h>
 
 #include <io/file/io_device.h>
@@ -18,8 +19,9 @@
 
 #include <diffs/core/archive.h>
 #include <diffs/core/item_definition_helpers.h>
+#include <diffs/core/source_hash_cache.h>
 
-uint32_t archive_diff::diffs::api::apply_session::apply(
+uint32_t archive_diff::diffs::api::legacy_apply_session::apply(
 	const char *source_path, const char *diff_path, const char *target_path)
 {
 	clear_errors();
@@ -30,12 +32,28 @@ uint32_t archive_diff::diffs::api::apply_session::apply(
 
 		auto kitchen = core::kitchen::create();
 
+		std::shared_ptr<core::apply_profiler> profiler;
+		if (!m_profile_summary_path.empty())
+		{
+			profiler = std::make_shared<core::apply_profiler>(!m_profile_trace_path.empty());
+			kitchen->set_profiler(profiler);
+			diff_reader = profiler->wrap_reader(diff_reader, core::apply_profiler::read_origin::diff);
+		}
+
+		// This entry point has no options, so always check the target as it is written.
+		// The hash is computed alongside the write and costs no extra pass over the data.
+		kitchen->set_verify_written_items(true);
+		kitchen->set_write_pipeline_depth(m_write_pipeline_depth);
+		kitchen->set_read_ahead_window_size(m_read_ahead_window_size);
+
 		std::shared_ptr<core::archive> archive;
 
 		std::string reason_standard;
 		if (archive_diff::diffs::serialization::standard::deserializer::is_this_format(diff_reader, &reason_standard))
 		{
+			// The inline assets and remainder are checked as they are read instead of hashed up front.
 			archive_diff::diffs::serialization::standard::deserializer deserializer;
+			deserializer.set_deferred_verification(true);
 			deserializer.read(diff_reader);
 			archive = deserializer.get_archive();
 		}
@@ -50,14 +68,19 @@ uint32_t archive_diff::diffs::api::apply_session::apply(
 		archive->stock_kitchen(kitchen.get());
 
 		auto source_reader = archive_diff::io::file::io_device::make_reader(source_path);
-		auto source_item   = archive_diff::diffs::core::create_definition_from_reader(source_reader);
+		if (profiler)
+		{
+			source_reader = profiler->wrap_reader(source_reader, core::apply_profiler::read_origin::source);
+		}
+
+		auto source_item = get_source_item(source_path, source_reader, archive->get_source_item());
 		std::shared_ptr<archive_diff::io::reader_factory> source_factory =
 			std::make_shared<archive_diff::io::basic_reader_factory>(source_reader);
 		auto source_prepped_item = std::make_shared<archive_diff::diffs::core::prepared_item>(
 			source_item, archive_diff::diffs::core::prepared_item::reader_kind{source_factory});
 		kitchen->store_item(source_prepped_item);
 
-		archive_diff::io::file::binary_file_writer writer(target_path);
+		archive_diff::io::file::binary_file_writer writer(target_path, !m_dense_output);
 
 		kitchen->request_item(archive_item);
 		if (!kitchen->process_requested_items())
@@ -68,6 +91,16 @@ uint32_t archive_diff::diffs::api::apply_session::apply(
 		kitchen->resume_slicing();
 		kitchen->write_item(writer, archive_item);
 		kitchen->cancel_slicing();
+		writer.flush();
+
+		if (profiler)
+		{
+			profiler->write_summary(m_profile_summary_path);
+			if (!m_profile_trace_path.empty())
+			{
+				profiler->write_chrome_trace(m_profile_trace_path);
+			}
+		}
 
 		return 0;
 	}
@@ -84,3 +117,51 @@ uint32_t archive_diff::diffs::api::apply_session::apply(
 
 	return get_error_count();
 }
+
+archive_diff::diffs::core::item_definition archive_diff::diffs::api::legacy_apply_session::get_source_item(
+	const std::string &source_path, io::reader &source_reader, const core::item_definition &diff_source_item)
+{
+	// Diffs that don't record their source item leave nothing to trust, so fall back to hashing.
+	if (m_trust_diff_source_item && !diff_source_item.get_hashes().empty())
+	{
+		if (source_reader.size() != diff_source_item.size())
+		{
+			std::string msg = fmt::format(
+				"Source size doesn't match the diff. Path: {}, Size: {}, Diff source item: {}",
+				source_path,
+				source_reader.size(),
+				diff_source_item);
+			throw errors::user_exception(errors::error_code::diff_verify_source_size_mismatch, msg);
+		}
+
+		return diff_source_item;
+	}
+
+	if (m_source_hash_cache_path.empty())
+	{
+		return core::create_definition_from_reader(source_reader);
+	}
+
+	core::source_hash_cache cache;
+	cache.load(m_source_hash_cache_path);
+	auto source_item = cache.get_definition(source_path, source_reader);
+
+	// Failing to persist the cache only costs a rehash next time; it isn't worth failing the apply.
+	try
+	{
+		if (cache.has_unsaved_changes())
+		{
+			cache.save(m_source_hash_cache_path);
+		}
+	}
+	catch (errors::user_exception &e)
+	{
+		ADU_LOG("Failed to save source hash cache {}. Msg: {}", m_source_hash_cache_path, e.get_message());
+	}
+	catch (std::exception &e)
+	{
+		ADU_LOG("Failed to save source hash cache {}. Msg: {}", m_source_hash_cache_path, e.what());
+	}
+
+	return source_item;
+}
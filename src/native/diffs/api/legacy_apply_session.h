@@ -9,6 +9,11 @@
 
 #include <errors/user_exception.h>
 
+#include <diffs/core/item_definition.h>
+#include <diffs/core/read_ahead.h>
+
+#include <io/reader.h>
+
 #include <string>
 #include <vector>
 
@@ -18,10 +23,52 @@ namespace archive_diff::diffs
 {
 namespace api
 {
-class apply_session : public session_base
+// Not named apply_session: that class lives in the same namespace and library, and sharing the
+// name would give both the same inline members and constructors with different layouts.
+class legacy_apply_session : public session_base
 {
 	public:
 	uint32_t apply(const char *source_path, const char *diff_path, const char *target_path);
+
+	// Number of buffers handed to the target writer thread; 0 writes on the applying thread.
+	void set_write_pipeline_depth(uint32_t buffer_count) { m_write_pipeline_depth = buffer_count; }
+
+	// By default zero ranges of a regular file target are left as holes. Dense output writes
+	// every byte, for targets such as raw block devices.
+	void set_dense_output(bool dense) { m_dense_output = dense; }
+
+	// How far ahead of the target being written the source and diff are read ahead; see
+	// core::read_ahead. 0 turns read-ahead off.
+	void set_read_ahead_window_size(uint64_t window_size) { m_read_ahead_window_size = window_size; }
+
+	// When summary_path isn't empty, apply() profiles itself and writes the summary there once
+	// the target is written, along with a Chrome trace when trace_path isn't empty.
+	void set_profile_paths(const std::string &summary_path, const std::string &trace_path)
+	{
+		m_profile_summary_path = summary_path;
+		m_profile_trace_path   = trace_path;
+	}
+
+	// When path isn't empty, the source's definition is looked up in the source hash cache
+	// stored there, and the source is only hashed when the cache has no valid entry for it.
+	void set_source_hash_cache_path(const std::string &path) { m_source_hash_cache_path = path; }
+
+	// Uses the source item recorded in the diff instead of hashing the source; only the size
+	// is checked. The target is always verified as it is written, so a source with the wrong
+	// content still fails the apply, just later.
+	void set_trust_diff_source_item(bool trust) { m_trust_diff_source_item = trust; }
+
+	private:
+	core::item_definition get_source_item(
+		const std::string &source_path, io::reader &source_reader, const core::item_definition &diff_source_item);
+
+	uint32_t m_write_pipeline_depth{0};
+	bool m_dense_output{false};
+	uint64_t m_read_ahead_window_size{core::read_ahead::c_default_window_size};
+	std::string m_profile_summary_path;
+	std::string m_profile_trace_path;
+	std::string m_source_hash_cache_path;
+	bool m_trust_diff_source_item{false};
 };
 } // namespace api
 } // namespace archive_diff::diffs
\ No newline at end of file
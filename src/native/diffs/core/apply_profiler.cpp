@@ -0,0 +1,386 @@
+/**
+ * @file apply_profiler.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "apply_profiler.h"
+
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include <errors/user_exception.h>
+#include <io/io_device.h>
+#include <io/sequential/reader.h>
+
+namespace archive_diff::diffs::core
+{
+namespace
+{
+uint64_t to_ns(apply_profiler::clock::duration duration)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+double to_ms(uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+const char *get_origin_name(apply_profiler::read_origin origin)
+{
+	switch (origin)
+	{
+	case apply_profiler::read_origin::source:
+		return "source";
+	case apply_profiler::read_origin::diff:
+		return "diff";
+	case apply_profiler::read_origin::temp:
+		return "temp";
+	}
+	return "unknown";
+}
+
+const std::string c_decompression_suffix{"_decompression"};
+const std::string c_write_item_event{"write_item"};
+
+// The timed read running on this thread, so that a read nested inside it can take its
+// time out of the outer read's self time.
+struct timed_frame
+{
+	timed_frame *m_parent{};
+	uint64_t m_child_ns{};
+};
+
+thread_local timed_frame *t_current_frame{};
+} // namespace
+
+class apply_profiler::counting_io_device : public io::io_device
+{
+	public:
+	counting_io_device(const io::reader &reader, std::atomic<uint64_t> &bytes_read) :
+		m_reader(reader), m_bytes_read(bytes_read)
+	{}
+
+	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override
+	{
+		auto actual = m_reader.read_some(offset, buffer);
+		m_bytes_read += actual;
+		return actual;
+	}
+
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override
+	{
+		auto borrowed = m_reader.borrow_some(offset, length);
+		if (borrowed.has_value())
+		{
+			m_bytes_read += borrowed->size();
+		}
+		return borrowed;
+	}
+
+	virtual void hint(uint64_t offset, uint64_t length, io::access_hint hint) override
+	{
+		m_reader.hint(offset, length, hint);
+	}
+
+	virtual uint64_t size() const override { return m_reader.size(); }
+
+	private:
+	io::reader m_reader;
+	std::atomic<uint64_t> &m_bytes_read;
+};
+
+class apply_profiler::timed_reader : public io::sequential::reader
+{
+	public:
+	timed_reader(
+		apply_profiler &profiler,
+		const std::string &recipe_name,
+		recipe_stats &stats,
+		std::unique_ptr<io::sequential::reader> &&reader) :
+		m_profiler(profiler), m_recipe_name(recipe_name), m_stats(stats), m_reader(std::move(reader))
+	{}
+
+	virtual void skip(uint64_t to_skip) override
+	{
+		timed([&]() { m_reader->skip(to_skip); return size_t{0}; });
+	}
+
+	virtual size_t read_some(std::span<char> buffer) override
+	{
+		return timed([&]() { return m_reader->read_some(buffer); });
+	}
+
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t length) override
+	{
+		std::optional<std::span<const char>> borrowed;
+		timed(
+			[&]()
+			{
+				borrowed = m_reader->borrow_some(length);
+				return borrowed.has_value() ? borrowed->size() : size_t{0};
+			});
+		return borrowed;
+	}
+
+	virtual uint64_t tellg() const override { return m_reader->tellg(); }
+	virtual uint64_t size() const override { return m_reader->size(); }
+
+	private:
+	template <typename FunctionT>
+	size_t timed(FunctionT function)
+	{
+		timed_frame frame{t_current_frame};
+		t_current_frame = &frame;
+
+		struct restore_frame
+		{
+			timed_frame &m_frame;
+			~restore_frame() { t_current_frame = m_frame.m_parent; }
+		} restore{frame};
+
+		auto start  = clock::now();
+		auto actual = function();
+		auto end    = clock::now();
+
+		auto elapsed_ns = to_ns(end - start);
+		if (frame.m_parent)
+		{
+			frame.m_parent->m_child_ns += elapsed_ns;
+		}
+
+		m_stats.m_produce_ns += elapsed_ns;
+		m_stats.m_produce_self_ns += elapsed_ns - std::min(elapsed_ns, frame.m_child_ns);
+		m_stats.m_bytes_produced += actual;
+
+		if (m_profiler.m_trace_enabled)
+		{
+			m_profiler.add_trace_event(&m_recipe_name, "produce", start, end);
+		}
+
+		return actual;
+	}
+
+	apply_profiler &m_profiler;
+	const std::string &m_recipe_name;
+	recipe_stats &m_stats;
+	std::unique_ptr<io::sequential::reader> m_reader;
+};
+
+class apply_profiler::timed_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	timed_reader_factory(
+		apply_profiler &profiler,
+		const std::string &recipe_name,
+		recipe_stats &stats,
+		const std::shared_ptr<io::sequential::reader_factory> &factory) :
+		m_profiler(profiler), m_recipe_name(recipe_name), m_stats(stats), m_factory(factory)
+	{}
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override
+	{
+		m_stats.m_reader_count++;
+		return std::make_unique<timed_reader>(
+			m_profiler, m_recipe_name, m_stats, m_factory->make_sequential_reader());
+	}
+
+	private:
+	apply_profiler &m_profiler;
+	const std::string &m_recipe_name;
+	recipe_stats &m_stats;
+	std::shared_ptr<io::sequential::reader_factory> m_factory;
+};
+
+apply_profiler::apply_profiler(bool trace_enabled) : m_trace_enabled(trace_enabled), m_start(clock::now()) {}
+
+apply_profiler::recipe_stats &apply_profiler::get_recipe_stats(
+	const std::string &recipe_name, const std::string **stored_name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto found = m_recipe_stats.find(recipe_name);
+	if (found == m_recipe_stats.end())
+	{
+		found = m_recipe_stats.emplace(recipe_name, std::make_unique<recipe_stats>()).first;
+	}
+
+	*stored_name = &found->first;
+	return *found->second;
+}
+
+void apply_profiler::add_trace_event(
+	const std::string *name, const char *category, clock::time_point start, clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_trace_events.size() >= c_max_trace_events)
+	{
+		m_dropped_trace_events++;
+		return;
+	}
+
+	auto thread_id = std::this_thread::get_id();
+	auto found     = m_thread_ids.find(thread_id);
+	if (found == m_thread_ids.end())
+	{
+		found = m_thread_ids.emplace(thread_id, static_cast<uint32_t>(m_thread_ids.size() + 1)).first;
+	}
+
+	m_trace_events.push_back(trace_event{name, category, to_ns(start - m_start), to_ns(end - start), found->second});
+}
+
+void apply_profiler::record_prepare(const std::string &recipe_name, clock::time_point start, clock::time_point end)
+{
+	const std::string *name;
+	auto &stats = get_recipe_stats(recipe_name, &name);
+	stats.m_prepare_count++;
+	stats.m_prepare_ns += to_ns(end - start);
+
+	if (m_trace_enabled)
+	{
+		add_trace_event(name, "prepare", start, end);
+	}
+}
+
+void apply_profiler::record_write(uint64_t bytes, clock::time_point start, clock::time_point end)
+{
+	m_write_count++;
+	m_write_ns += to_ns(end - start);
+	m_bytes_written += bytes;
+
+	if (m_trace_enabled)
+	{
+		add_trace_event(&c_write_item_event, "write", start, end);
+	}
+}
+
+io::reader apply_profiler::wrap_reader(const io::reader &reader, read_origin origin)
+{
+	std::shared_ptr<io::io_device> device =
+		std::make_shared<counting_io_device>(reader, m_bytes_read[static_cast<size_t>(origin)]);
+	return io::reader{io::io_device_view{device}};
+}
+
+std::shared_ptr<io::sequential::reader_factory> apply_profiler::wrap_sequential_reader_factory(
+	const std::shared_ptr<io::sequential::reader_factory> &factory, const std::string &recipe_name)
+{
+	const std::string *name;
+	auto &stats = get_recipe_stats(recipe_name, &name);
+	return std::make_shared<timed_reader_factory>(*this, *name, stats, factory);
+}
+
+uint64_t apply_profiler::get_bytes_read(read_origin origin) const
+{
+	return m_bytes_read[static_cast<size_t>(origin)];
+}
+
+uint64_t apply_profiler::get_bytes_produced(const std::string &recipe_name) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto found = m_recipe_stats.find(recipe_name);
+	return found == m_recipe_stats.end() ? 0 : found->second->m_bytes_produced.load();
+}
+
+Json::Value apply_profiler::get_summary() const
+{
+	Json::Value summary;
+	summary["elapsed_ms"] = to_ms(to_ns(clock::now() - m_start));
+
+	Json::Value recipes(Json::objectValue);
+	Json::Value decompression(Json::objectValue);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (const auto &[name, stats] : m_recipe_stats)
+		{
+			Json::Value value;
+			value["prepare_count"]   = static_cast<Json::UInt64>(stats->m_prepare_count);
+			value["prepare_ms"]      = to_ms(stats->m_prepare_ns);
+			value["reader_count"]    = static_cast<Json::UInt64>(stats->m_reader_count);
+			value["produce_ms"]      = to_ms(stats->m_produce_ns);
+			value["produce_self_ms"] = to_ms(stats->m_produce_self_ns);
+			value["bytes_produced"]  = static_cast<Json::UInt64>(stats->m_bytes_produced);
+			recipes[name]            = value;
+
+			// Decompression recipes are named for their algorithm: zstd_decompression, ...
+			if ((name.size() > c_decompression_suffix.size()) && name.ends_with(c_decompression_suffix))
+			{
+				auto algorithm = name.substr(0, name.size() - c_decompression_suffix.size());
+
+				Json::Value algorithm_value;
+				algorithm_value["ms"]             = to_ms(stats->m_produce_self_ns);
+				algorithm_value["bytes_produced"] = static_cast<Json::UInt64>(stats->m_bytes_produced);
+				decompression[algorithm]          = algorithm_value;
+			}
+		}
+
+		summary["trace_events"]         = static_cast<Json::UInt64>(m_trace_events.size());
+		summary["dropped_trace_events"] = static_cast<Json::UInt64>(m_dropped_trace_events);
+	}
+	summary["recipes"]       = recipes;
+	summary["decompression"] = decompression;
+
+	Json::Value bytes_read;
+	for (auto origin : {read_origin::source, read_origin::diff, read_origin::temp})
+	{
+		bytes_read[get_origin_name(origin)] = static_cast<Json::UInt64>(get_bytes_read(origin));
+	}
+	summary["bytes_read"] = bytes_read;
+
+	Json::Value write;
+	write["count"]         = static_cast<Json::UInt64>(m_write_count);
+	write["ms"]            = to_ms(m_write_ns);
+	write["bytes_written"] = static_cast<Json::UInt64>(m_bytes_written);
+	summary["write"]       = write;
+
+	return summary;
+}
+
+static std::ofstream open_report(const std::string &path)
+{
+	std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream)
+	{
+		std::string msg = "apply_profiler: Couldn't open " + path;
+		throw errors::user_exception(errors::error_code::diffs_apply_profiler_failed_open, msg);
+	}
+	return stream;
+}
+
+void apply_profiler::write_summary(const std::string &path) const
+{
+	auto stream = open_report(path);
+	stream << get_summary().toStyledString();
+}
+
+void apply_profiler::write_chrome_trace(const std::string &path) const
+{
+	if (!m_trace_enabled)
+	{
+		throw errors::user_exception(
+			errors::error_code::diffs_apply_profiler_trace_not_enabled,
+			"apply_profiler: Tracing wasn't enabled for this profiler.");
+	}
+
+	auto stream = open_report(path);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Complete ("X") events, with timestamps and durations in microseconds.
+	stream << "{\"traceEvents\":[\n";
+	for (size_t i = 0; i < m_trace_events.size(); i++)
+	{
+		const auto &event = m_trace_events[i];
+		stream << fmt::format(
+			"{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}{}\n",
+			*event.m_name,
+			event.m_category,
+			static_cast<double>(event.m_start_ns) / 1000,
+			static_cast<double>(event.m_duration_ns) / 1000,
+			event.m_thread,
+			(i + 1 == m_trace_events.size()) ? "" : ",");
+	}
+	stream << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+} // namespace archive_diff::diffs::core
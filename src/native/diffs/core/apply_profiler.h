@@ -0,0 +1,117 @@
+/**
+ * @file apply_profiler.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <json/json.h>
+
+#include <io/reader.h>
+#include <io/sequential/reader_factory.h>
+
+namespace archive_diff::diffs::core
+{
+// Records where the time of an apply goes. Unlike ADU_LOG it's available in release builds,
+// and costs nothing unless a profiler is given to the kitchen.
+//
+// Per recipe type it keeps the time spent preparing items and the time spent producing their
+// data. Producing time is kept both inclusive and as self time, which leaves out reads of
+// ingredients made on the same thread; for the decompression recipes the self time is the
+// cost of the algorithm. Reads are counted by where they come from: the source, the diff or
+// temp files. With tracing on, every timed span is also kept as a Chrome trace event.
+class apply_profiler
+{
+	public:
+	using clock = std::chrono::steady_clock;
+
+	enum class read_origin
+	{
+		source,
+		diff,
+		temp,
+	};
+
+	apply_profiler(bool trace_enabled = false);
+
+	bool is_trace_enabled() const { return m_trace_enabled; }
+
+	void record_prepare(const std::string &recipe_name, clock::time_point start, clock::time_point end);
+	void record_write(uint64_t bytes, clock::time_point start, clock::time_point end);
+
+	// Reads made through the returned reader, or slices of it, count against origin.
+	io::reader wrap_reader(const io::reader &reader, read_origin origin);
+
+	// Reads made through readers from the returned factory count as producing data for recipe_name.
+	std::shared_ptr<io::sequential::reader_factory> wrap_sequential_reader_factory(
+		const std::shared_ptr<io::sequential::reader_factory> &factory, const std::string &recipe_name);
+
+	uint64_t get_bytes_read(read_origin origin) const;
+	uint64_t get_bytes_produced(const std::string &recipe_name) const;
+
+	Json::Value get_summary() const;
+	void write_summary(const std::string &path) const;
+
+	// Writes the trace events in the Chrome trace event format, which chrome://tracing and
+	// Perfetto open. Throws if tracing isn't enabled.
+	void write_chrome_trace(const std::string &path) const;
+
+	// Beyond this many, trace events are counted as dropped rather than kept.
+	static const size_t c_max_trace_events = 1000000;
+
+	private:
+	class counting_io_device;
+	class timed_reader;
+	class timed_reader_factory;
+
+	struct recipe_stats
+	{
+		std::atomic<uint64_t> m_prepare_count{};
+		std::atomic<uint64_t> m_prepare_ns{};
+		std::atomic<uint64_t> m_reader_count{};
+		std::atomic<uint64_t> m_produce_ns{};
+		std::atomic<uint64_t> m_produce_self_ns{};
+		std::atomic<uint64_t> m_bytes_produced{};
+	};
+
+	struct trace_event
+	{
+		const std::string *m_name{};
+		const char *m_category{};
+		uint64_t m_start_ns{};
+		uint64_t m_duration_ns{};
+		uint32_t m_thread{};
+	};
+
+	// Also returns the copy of the name the profiler keeps, which trace events and readers
+	// can point at for as long as the profiler lives.
+	recipe_stats &get_recipe_stats(const std::string &recipe_name, const std::string **stored_name);
+	void add_trace_event(
+		const std::string *name, const char *category, clock::time_point start, clock::time_point end);
+
+	const bool m_trace_enabled;
+	const clock::time_point m_start;
+
+	mutable std::mutex m_mutex;
+	std::map<std::string, std::unique_ptr<recipe_stats>> m_recipe_stats;
+	std::map<std::thread::id, uint32_t> m_thread_ids;
+	std::vector<trace_event> m_trace_events;
+	uint64_t m_dropped_trace_events{};
+
+	std::atomic<uint64_t> m_bytes_read[3]{};
+
+	std::atomic<uint64_t> m_write_count{};
+	std::atomic<uint64_t> m_write_ns{};
+	std::atomic<uint64_t> m_bytes_written{};
+};
+} // namespace archive_diff::diffs::core
@@ -15,6 +15,11 @@ void archive::stock_kitchen(kitchen *kitchen)
 	kitchen->add_cookbook(m_cookbook);
 	kitchen->add_pantry(m_pantry);
 
+	for (auto &verification : m_deferred_verifications)
+	{
+		kitchen->add_deferred_verification(verification);
+	}
+
 	for (auto &nested : m_nested_archives)
 	{
 		nested.second->stock_kitchen(kitchen);
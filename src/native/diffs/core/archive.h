@@ -6,6 +6,7 @@
  */
 #pragma once
 
+#include <functional>
 #include <map>
 
 #include <optional>
@@ -38,6 +39,15 @@ class archive
 	const std::shared_ptr<cookbook> &get_cookbook() const { return m_cookbook; }
 	const std::shared_ptr<pantry> &get_pantry() const { return m_pantry; }
 
+	// Checks of content the archive stores without having hashed it when it was read, each
+	// throwing if the content doesn't match its definition. Kitchens stocked from the archive
+	// run them once an item is written; see kitchen::add_deferred_verification().
+	void add_deferred_verification(std::function<void()> verification)
+	{
+		m_deferred_verifications.push_back(std::move(verification));
+	}
+	size_t get_deferred_verification_count() const { return m_deferred_verifications.size(); }
+
 	void stock_kitchen(kitchen *kitchen);
 
 	void store_item(std::shared_ptr<prepared_item> &item) { m_pantry->add(item); }
@@ -68,6 +78,9 @@ class archive
 		const std::vector<item_definition> &item_ingredients);
 	bool try_get_supported_recipe_type_id(const std::string &name, uint32_t *recipe_type_id) const;
 	uint32_t add_supported_recipe_type(const std::string &recipe_name);
+	using recipe_template_map = std::map<uint32_t, std::shared_ptr<recipe_template>>;
+	const recipe_template_map &get_recipe_templates() const { return m_supported_recipe_templates; }
+
 	void set_recipe_template_for_recipe_type(
 		const std::string recipe_name, std::shared_ptr<recipe_template> &recipe_template);
 	size_t get_supported_recipe_type_count() const { return m_supported_recipe_templates.size(); }
@@ -81,12 +94,14 @@ class archive
 
 	std::map<item_definition, std::shared_ptr<archive>> m_nested_archives{};
 
-	std::map<uint32_t, std::shared_ptr<recipe_template>> m_supported_recipe_templates;
+	recipe_template_map m_supported_recipe_templates;
 	std::map<std::string, uint32_t> m_recipe_type_name_to_type_id;
 	std::map<uint32_t, std::string> m_recipe_type_id_to_type_name;
 
 	std::map<std::string, item_definition> m_payload;
 	item_definition m_archive_item;
 	item_definition m_source_item;
+
+	std::vector<std::function<void()>> m_deferred_verifications;
 };
 } // namespace archive_diff::diffs::core
\ No newline at end of file
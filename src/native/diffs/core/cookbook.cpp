@@ -29,6 +29,21 @@ void cookbook::add_recipe(std::shared_ptr<recipe> &recipe)
 
 bool cookbook::find_recipes_for_item(const item_definition &item, const recipe_set **recipes)
 {
+	if (m_source)
+	{
+		m_source->load_recipes_for_item(item, *this);
+	}
+
 	return m_lookup.find(item, recipes);
 }
+
+const recipe_set_lookup cookbook::get_all_recipes()
+{
+	if (m_source)
+	{
+		m_source->load_all_recipes(*this);
+	}
+
+	return m_recipes;
+}
 } // namespace archive_diff::diffs::core
\ No newline at end of file
@@ -7,10 +7,12 @@
 #pragma once
 
 #include <map>
+#include <memory>
 
 #include "item_definition.h"
 #include "recipe_set.h"
 #include "recipe_lookup.h"
+#include "recipe_source.h"
 
 namespace archive_diff::diffs::core
 {
@@ -19,10 +21,14 @@ class cookbook
 	public:
 	void add_recipe(std::shared_ptr<recipe> &recipe);
 	bool find_recipes_for_item(const item_definition &item, const recipe_set **recipes);
-	const recipe_set_lookup get_all_recipes() const { return m_recipes; }
+	const recipe_set_lookup get_all_recipes();
+
+	// Recipes from the source are added as items are looked up, rather than up front.
+	void set_recipe_source(std::shared_ptr<recipe_source> source) { m_source = std::move(source); }
 
 	private:
 	recipe_lookup m_lookup;
 	recipe_set_lookup m_recipes;
+	std::shared_ptr<recipe_source> m_source;
 };
 } // namespace archive_diff::diffs::core
\ No newline at end of file
@@ -0,0 +1,227 @@
+/**
+ * @file test_apply_profiler.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#include <json/json.h>
+
+#include <errors/user_exception.h>
+#include <io/buffer/io_device.h>
+
+#include <diffs/core/apply_profiler.h>
+
+#include <language_support/include_filesystem.h>
+
+using namespace archive_diff;
+
+using read_origin = diffs::core::apply_profiler::read_origin;
+
+const size_t c_profiled_content_size = 64 * 1024;
+
+static std::shared_ptr<std::vector<char>> make_content()
+{
+	auto content = std::make_shared<std::vector<char>>(c_profiled_content_size);
+	for (size_t i = 0; i < c_profiled_content_size; i++)
+	{
+		(*content)[i] = static_cast<char>((i * 13) ^ (i >> 8));
+	}
+	return content;
+}
+
+// Stands in for a decompressor, taking a while for every read.
+class slow_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	class slow_reader : public io::sequential::reader
+	{
+		public:
+		slow_reader(std::shared_ptr<std::vector<char>> &content) : m_content(content) {}
+
+		virtual void skip(uint64_t to_skip) override { m_offset += to_skip; }
+
+		virtual size_t read_some(std::span<char> buffer) override
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+			auto to_read = std::min<size_t>(buffer.size(), m_content->size() - m_offset);
+			memcpy(buffer.data(), m_content->data() + m_offset, to_read);
+			m_offset += to_read;
+			return to_read;
+		}
+
+		virtual uint64_t tellg() const override { return m_offset; }
+		virtual uint64_t size() const override { return m_content->size(); }
+
+		private:
+		std::shared_ptr<std::vector<char>> m_content;
+		uint64_t m_offset{};
+	};
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override
+	{
+		return std::make_unique<slow_reader>(m_content);
+	}
+
+	std::shared_ptr<std::vector<char>> m_content{make_content()};
+};
+
+// Stands in for a recipe that only passes its ingredient along.
+class forwarding_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	class forwarding_reader : public io::sequential::reader
+	{
+		public:
+		forwarding_reader(std::unique_ptr<io::sequential::reader> &&reader) : m_reader(std::move(reader)) {}
+
+		virtual void skip(uint64_t to_skip) override { m_reader->skip(to_skip); }
+		virtual size_t read_some(std::span<char> buffer) override { return m_reader->read_some(buffer); }
+		virtual uint64_t tellg() const override { return m_reader->tellg(); }
+		virtual uint64_t size() const override { return m_reader->size(); }
+
+		private:
+		std::unique_ptr<io::sequential::reader> m_reader;
+	};
+
+	forwarding_reader_factory(std::shared_ptr<io::sequential::reader_factory> &ingredient) :
+		m_ingredient(ingredient)
+	{}
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override
+	{
+		return std::make_unique<forwarding_reader>(m_ingredient->make_sequential_reader());
+	}
+
+	private:
+	std::shared_ptr<io::sequential::reader_factory> m_ingredient;
+};
+
+static void read_all(io::sequential::reader &reader)
+{
+	std::vector<char> buffer(4096);
+	while (reader.read_some(buffer) != 0)
+	{
+	}
+}
+
+TEST(apply_profiler, counts_reads_by_origin)
+{
+	diffs::core::apply_profiler profiler;
+
+	auto content = make_content();
+	auto reader  = io::buffer::io_device::make_reader(content, io::buffer::io_device::size_kind::vector_size);
+	auto source  = profiler.wrap_reader(reader, read_origin::source);
+	auto diff    = profiler.wrap_reader(reader, read_origin::diff);
+
+	std::vector<char> buffer(1000);
+	source.read(0, buffer);
+	ASSERT_EQ(0, memcmp(content->data(), buffer.data(), buffer.size()));
+
+	// Slices and borrowed reads count too.
+	auto slice = source.slice(2000, 500);
+	slice.read(0, std::span<char>{buffer.data(), 500});
+	ASSERT_EQ(0, memcmp(content->data() + 2000, buffer.data(), 500));
+
+	auto borrowed = diff.borrow_some(0, 300);
+	ASSERT_TRUE(borrowed.has_value());
+
+	ASSERT_EQ(1500, profiler.get_bytes_read(read_origin::source));
+	ASSERT_EQ(300, profiler.get_bytes_read(read_origin::diff));
+	ASSERT_EQ(0, profiler.get_bytes_read(read_origin::temp));
+
+	auto summary = profiler.get_summary();
+	ASSERT_EQ(1500, summary["bytes_read"]["source"].asUInt64());
+}
+
+TEST(apply_profiler, self_time_leaves_out_ingredients)
+{
+	diffs::core::apply_profiler profiler;
+
+	std::shared_ptr<io::sequential::reader_factory> slow = std::make_shared<slow_reader_factory>();
+	auto profiled_slow = profiler.wrap_sequential_reader_factory(slow, "zstd_decompression");
+
+	std::shared_ptr<io::sequential::reader_factory> forwarding =
+		std::make_shared<forwarding_reader_factory>(profiled_slow);
+	auto profiled_forwarding = profiler.wrap_sequential_reader_factory(forwarding, "passthrough");
+
+	auto reader = profiled_forwarding->make_sequential_reader();
+	read_all(*reader);
+
+	ASSERT_EQ(c_profiled_content_size, profiler.get_bytes_produced("zstd_decompression"));
+	ASSERT_EQ(c_profiled_content_size, profiler.get_bytes_produced("passthrough"));
+
+	auto summary     = profiler.get_summary();
+	auto &decompress = summary["recipes"]["zstd_decompression"];
+	auto &passing    = summary["recipes"]["passthrough"];
+
+	ASSERT_EQ(1, decompress["reader_count"].asUInt64());
+	ASSERT_GE(passing["produce_ms"].asDouble(), decompress["produce_ms"].asDouble());
+	ASSERT_LT(passing["produce_self_ms"].asDouble(), decompress["produce_self_ms"].asDouble());
+
+	// Decompression recipes are also listed by algorithm.
+	ASSERT_TRUE(summary["decompression"].isMember("zstd"));
+	ASSERT_FALSE(summary["decompression"].isMember("passthrough"));
+	ASSERT_EQ(c_profiled_content_size, summary["decompression"]["zstd"]["bytes_produced"].asUInt64());
+}
+
+TEST(apply_profiler, chrome_trace)
+{
+	diffs::core::apply_profiler untraced;
+	bool caught = false;
+	try
+	{
+		untraced.write_chrome_trace("unused.json");
+	}
+	catch (errors::user_exception &e)
+	{
+		caught = true;
+		ASSERT_EQ(errors::error_code::diffs_apply_profiler_trace_not_enabled, e.get_error());
+	}
+	ASSERT_TRUE(caught);
+
+	diffs::core::apply_profiler profiler(true);
+
+	std::shared_ptr<io::sequential::reader_factory> slow = std::make_shared<slow_reader_factory>();
+	auto reader = profiler.wrap_sequential_reader_factory(slow, "bspatch_decompression")->make_sequential_reader();
+	read_all(*reader);
+
+	auto start = diffs::core::apply_profiler::clock::now();
+	profiler.record_prepare("bspatch_decompression", start, start + std::chrono::microseconds(10));
+	profiler.record_write(c_profiled_content_size, start, start + std::chrono::microseconds(20));
+
+	auto trace_path = fs::temp_directory_path() / "apply_profiler.chrome_trace.json";
+	profiler.write_chrome_trace(trace_path.string());
+
+	Json::Value trace;
+	{
+		std::ifstream stream(trace_path);
+		Json::CharReaderBuilder builder;
+		std::string errors;
+		ASSERT_TRUE(Json::parseFromStream(builder, stream, &trace, &errors)) << errors;
+	}
+	fs::remove(trace_path);
+
+	auto &events = trace["traceEvents"];
+	ASSERT_GT(events.size(), 2);
+
+	std::set<std::string> categories;
+	for (const auto &event : events)
+	{
+		ASSERT_EQ("X", event["ph"].asString());
+		categories.insert(event["cat"].asString());
+	}
+	ASSERT_EQ((std::set<std::string>{"prepare", "produce", "write"}), categories);
+
+	auto summary = profiler.get_summary();
+	ASSERT_EQ(events.size(), summary["trace_events"].asUInt64());
+	ASSERT_EQ(1, summary["write"]["count"].asUInt64());
+}
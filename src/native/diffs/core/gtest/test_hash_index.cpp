@@ -0,0 +1,160 @@
+/**
+ * @file test_hash_index.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <string>
+
+#include <diffs/core/hash_index.h>
+#include <hashing/hasher.h>
+
+using digest_key      = archive_diff::diffs::core::digest_key;
+using item_definition = archive_diff::diffs::core::item_definition;
+
+static archive_diff::hashing::hash hash_of(archive_diff::hashing::algorithm algorithm, const std::string &data)
+{
+	archive_diff::hashing::hasher hasher(algorithm);
+	hasher.hash_data(data);
+	return hasher.get_hash();
+}
+
+static digest_key make_key(uint64_t size, const std::string &data)
+{
+	digest_key key;
+	EXPECT_TRUE(digest_key::try_make(size, hash_of(archive_diff::hashing::algorithm::sha256, data), &key));
+	return key;
+}
+
+TEST(hash_index, digest_index_find_and_insert)
+{
+	archive_diff::diffs::core::digest_index<int> index;
+
+	ASSERT_EQ(nullptr, index.find(make_key(1, "missing")));
+
+	// Enough entries to grow the table several times.
+	const int c_entry_count = 5000;
+	for (int i = 0; i < c_entry_count; i++)
+	{
+		ASSERT_TRUE(index.insert(make_key(i, std::to_string(i)), i));
+	}
+	ASSERT_EQ(c_entry_count, index.size());
+
+	for (int i = 0; i < c_entry_count; i++)
+	{
+		auto found = index.find(make_key(i, std::to_string(i)));
+		ASSERT_NE(nullptr, found);
+		ASSERT_EQ(i, *found);
+	}
+
+	// Same digest with a different size is a different key.
+	ASSERT_FALSE(index.contains(make_key(1, "0")));
+
+	// insert() leaves an existing value alone, operator[] gives access to it.
+	ASSERT_FALSE(index.insert(make_key(7, "7"), 100));
+	ASSERT_EQ(7, index[make_key(7, "7")]);
+	index[make_key(7, "7")] = 100;
+	ASSERT_EQ(100, *index.find(make_key(7, "7")));
+	ASSERT_EQ(c_entry_count, index.size());
+
+	index.clear();
+	ASSERT_EQ(0, index.size());
+	ASSERT_FALSE(index.contains(make_key(7, "7")));
+}
+
+TEST(hash_index, digest_key_keeps_algorithm)
+{
+	auto md5 = hash_of(archive_diff::hashing::algorithm::md5, "abc");
+
+	digest_key md5_key;
+	ASSERT_TRUE(digest_key::try_make(3, md5, &md5_key));
+
+	// An md5 digest padded with zeroes must not match a sha256 digest with the same leading bytes.
+	auto fake_sha256        = md5;
+	fake_sha256.m_algorithm = archive_diff::hashing::algorithm::sha256;
+
+	digest_key fake_sha256_key;
+	ASSERT_TRUE(digest_key::try_make(3, fake_sha256, &fake_sha256_key));
+
+	archive_diff::diffs::core::digest_index<int> index;
+	index.insert(md5_key, 1);
+	ASSERT_FALSE(index.contains(fake_sha256_key));
+
+	// Too large to hold inline.
+	archive_diff::hashing::hash oversized = md5;
+	oversized.m_hash_data.resize(digest_key::c_max_digest_size + 1);
+	digest_key oversized_key;
+	ASSERT_FALSE(digest_key::try_make(3, oversized, &oversized_key));
+}
+
+TEST(hash_index, item_definition_index_matches_equality)
+{
+	auto sha256 = hash_of(archive_diff::hashing::algorithm::sha256, "abc");
+	auto md5    = hash_of(archive_diff::hashing::algorithm::md5, "abc");
+
+	item_definition sha256_only = item_definition{3}.with_hash(sha256);
+	item_definition both        = sha256_only.with_hash(md5);
+	item_definition named       = sha256_only.with_name("abc.txt");
+
+	archive_diff::diffs::core::item_definition_index<std::string> index;
+	index.insert(sha256_only, "sha256");
+	index.insert(both, "both");
+	index.insert(item_definition{3}, "no hashes");
+
+	ASSERT_EQ(3, index.size());
+	ASSERT_EQ("sha256", *index.find(sha256_only));
+	ASSERT_EQ("both", *index.find(both));
+	ASSERT_EQ("no hashes", *index.find(item_definition{3}));
+
+	// Names aren't part of item_definition equality.
+	ASSERT_EQ("sha256", *index.find(named));
+
+	ASSERT_FALSE(index.contains(item_definition{4}.with_hash(sha256)));
+}
+
+// Sends every key to one of a few slots, so probe runs are long and wrap around the table.
+struct clustered_hash
+{
+	uint64_t operator()(int key) const { return static_cast<uint64_t>(key % 3) * 5 + 13; }
+};
+
+TEST(hash_index, erase_keeps_probe_runs)
+{
+	archive_diff::diffs::core::hash_index<int, int, clustered_hash> index;
+
+	const int c_entry_count = 40;
+	for (int i = 0; i < c_entry_count; i++)
+	{
+		ASSERT_TRUE(index.insert(i, i * 10));
+	}
+
+	for (int i = 0; i < c_entry_count; i += 2)
+	{
+		ASSERT_TRUE(index.erase(i));
+	}
+	ASSERT_FALSE(index.erase(0));
+	ASSERT_EQ(c_entry_count / 2, index.size());
+
+	for (int i = 0; i < c_entry_count; i++)
+	{
+		if (i % 2 == 0)
+		{
+			ASSERT_FALSE(index.contains(i));
+		}
+		else
+		{
+			ASSERT_NE(nullptr, index.find(i));
+			ASSERT_EQ(i * 10, *index.find(i));
+		}
+	}
+
+	for (int i = 0; i < c_entry_count; i += 2)
+	{
+		ASSERT_TRUE(index.insert(i, i));
+	}
+	ASSERT_EQ(c_entry_count, index.size());
+	ASSERT_EQ(4, *index.find(4));
+	ASSERT_EQ(50, *index.find(5));
+}
@@ -6,8 +6,15 @@
  */
 #include <test_utility/gtest_includes.h>
 
+#include <thread>
+#include <vector>
+
 #include <diffs/core/item_definition.h>
 #include <hashing/hasher.h>
+#include <io/buffer/io_device.h>
+#include <io/buffer/writer.h>
+#include <io/sequential/basic_reader_wrapper.h>
+#include <io/sequential/basic_writer_wrapper.h>
 
 TEST(item_definition, operator_less_than_overload_starting_equivalent_items)
 {
@@ -275,3 +282,120 @@ TEST(item_definition, size)
 		}
 	}
 }
+
+TEST(item_definition, interned_items_share_identity)
+{
+	using item_definition = archive_diff::diffs::core::item_definition;
+
+	archive_diff::hashing::hasher sha256(archive_diff::hashing::algorithm::sha256);
+	sha256.hash_data(std::string_view{"interned"});
+	auto hash = sha256.get_hash();
+
+	auto first  = item_definition{8}.with_hash(hash);
+	auto second = item_definition{8}.with_hash(hash);
+
+	ASSERT_EQ(first, second);
+	ASSERT_EQ(first.get_fingerprint(), second.get_fingerprint());
+	ASSERT_EQ(std::string_view(hash.m_hash_data.data(), hash.m_hash_data.size()),
+		first.get_hash_data(archive_diff::hashing::algorithm::sha256));
+	ASSERT_TRUE(first.get_hash_data(archive_diff::hashing::algorithm::md5).empty());
+
+	// Names are kept, but don't take part in equality.
+	auto named = first.with_name("name1");
+	ASSERT_EQ(first, named);
+	ASSERT_EQ(first.get_fingerprint(), named.get_fingerprint());
+	ASSERT_TRUE(named.has_matching_name("name1"));
+	ASSERT_FALSE(first.has_matching_name("name1"));
+	ASSERT_EQ(1, named.get_names().size());
+
+	// The hashes can still be enumerated.
+	auto hashes = named.get_hashes();
+	ASSERT_EQ(1, hashes.size());
+	ASSERT_EQ(hash.m_hash_data, hashes.begin()->second.m_hash_data);
+
+	ASSERT_NE(first, item_definition{9}.with_hash(hash));
+	ASSERT_EQ(item_definition{}, item_definition{0});
+}
+
+TEST(item_definition, with_hash_rejects_bad_hashes)
+{
+	using item_definition = archive_diff::diffs::core::item_definition;
+
+	archive_diff::hashing::hasher sha256(archive_diff::hashing::algorithm::sha256);
+	auto hash = sha256.get_hash();
+
+	auto truncated = hash;
+	truncated.m_hash_data.resize(16);
+	ASSERT_THROW((void)item_definition{1}.with_hash(truncated), archive_diff::errors::user_exception);
+
+	auto different = hash;
+	different.m_hash_data[0] ^= 1;
+	auto item = item_definition{1}.with_hash(hash);
+	ASSERT_THROW((void)item.with_hash(different), archive_diff::errors::user_exception);
+	ASSERT_EQ(item, item.with_hash(hash));
+}
+
+TEST(item_definition, write_and_read)
+{
+	using item_definition = archive_diff::diffs::core::item_definition;
+
+	archive_diff::hashing::hasher sha256(archive_diff::hashing::algorithm::sha256);
+	archive_diff::hashing::hasher md5(archive_diff::hashing::algorithm::md5);
+	auto item = item_definition{1234}.with_hash(sha256.get_hash()).with_hash(md5.get_hash());
+
+	auto options = item_definition::serialization_options::include_hashes;
+
+	auto buffer                                      = std::make_shared<std::vector<char>>();
+	std::shared_ptr<archive_diff::io::writer> writer = std::make_shared<archive_diff::io::buffer::writer>(buffer);
+	{
+		archive_diff::io::sequential::basic_writer_wrapper seq(writer);
+		item.write(seq, options);
+	}
+
+	// length, count, then two (algorithm, digest) pairs
+	ASSERT_EQ(8 + 1 + (4 + 32) + (4 + 16), buffer->size());
+
+	auto reader = archive_diff::io::buffer::io_device::make_reader(
+		buffer, archive_diff::io::buffer::io_device::size_kind::vector_size);
+	auto read_item = item_definition::read(reader, options);
+
+	ASSERT_EQ(item, read_item);
+	ASSERT_EQ(2, read_item.get_hash_count());
+}
+
+TEST(item_definition, concurrent_interning)
+{
+	using item_definition = archive_diff::diffs::core::item_definition;
+
+	std::vector<archive_diff::hashing::hash> hashes;
+	for (int i = 0; i < 64; i++)
+	{
+		archive_diff::hashing::hasher sha256(archive_diff::hashing::algorithm::sha256);
+		sha256.hash_data(std::to_string(i));
+		hashes.push_back(sha256.get_hash());
+	}
+
+	// Threads keep creating and dropping the same items, racing interning against release.
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&]() {
+			for (int round = 0; round < 200; round++)
+			{
+				for (size_t i = 0; i < hashes.size(); i++)
+				{
+					auto item = item_definition{i + 1}.with_hash(hashes[i]);
+					ASSERT_EQ(i + 1, item.size());
+					ASSERT_TRUE(item.has_matching_hash(hashes[i]));
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	ASSERT_EQ(item_definition{1}.with_hash(hashes[0]), item_definition{1}.with_hash(hashes[0]));
+}
@@ -4,3 +4,118 @@
  * @copyright Copyright (c) Microsoft Corporation.
  * Licensed under the MIT License.
  */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+
+#include <io/buffer/reader_factory.h>
+#include <io/buffer/writer.h>
+
+#include <diffs/core/kitchen.h>
+#include <diffs/core/prepared_item.h>
+
+#include "common.h"
+
+static std::shared_ptr<archive_diff::diffs::core::prepared_item> make_prepared_alphabet(
+	const item_definition &item, std::shared_ptr<std::vector<char>> &data)
+{
+	data = std::make_shared<std::vector<char>>(c_alphabet, c_alphabet + c_letters_in_alphabet);
+
+	using device = archive_diff::io::buffer::io_device;
+	std::shared_ptr<archive_diff::io::reader_factory> factory =
+		std::make_shared<archive_diff::io::buffer::reader_factory>(data, device::size_kind::vector_size);
+	return std::make_shared<archive_diff::diffs::core::prepared_item>(
+		item, archive_diff::diffs::core::prepared_item::reader_kind{factory});
+}
+
+static archive_diff::errors::error_code write_verified(
+	std::shared_ptr<archive_diff::diffs::core::prepared_item> &prepared)
+{
+	auto result_data = std::make_shared<std::vector<char>>();
+	std::shared_ptr<archive_diff::io::writer> writer =
+		std::make_shared<archive_diff::io::buffer::writer>(result_data);
+
+	try
+	{
+		prepared->write(writer, true);
+	}
+	catch (archive_diff::errors::user_exception &e)
+	{
+		return e.get_error();
+	}
+
+	EXPECT_EQ(
+		std::string_view(c_alphabet, c_letters_in_alphabet),
+		std::string_view(result_data->data(), result_data->size()));
+	return archive_diff::errors::error_code::none;
+}
+
+TEST(prepared_item, write_verified_match)
+{
+	auto item = create_definition_from_data(std::string_view{c_alphabet, c_letters_in_alphabet});
+
+	std::shared_ptr<std::vector<char>> data;
+	auto prepared = make_prepared_alphabet(item, data);
+
+	ASSERT_EQ(archive_diff::errors::error_code::none, write_verified(prepared));
+}
+
+TEST(prepared_item, write_verified_hash_mismatch)
+{
+	// Same length, different content.
+	std::string other(c_letters_in_alphabet, 'z');
+	auto item = create_definition_from_data(std::string_view{other.data(), other.size()});
+
+	std::shared_ptr<std::vector<char>> data;
+	auto prepared = make_prepared_alphabet(item, data);
+
+	ASSERT_EQ(archive_diff::errors::error_code::diffs_prepared_item_written_hash_mismatch, write_verified(prepared));
+}
+
+TEST(prepared_item, write_verified_size_mismatch)
+{
+	auto item = create_definition_from_data(std::string_view{c_alphabet, c_letters_in_alphabet - 1});
+
+	std::shared_ptr<std::vector<char>> data;
+	auto prepared = make_prepared_alphabet(item, data);
+
+	ASSERT_EQ(archive_diff::errors::error_code::diffs_prepared_item_written_size_mismatch, write_verified(prepared));
+}
+
+TEST(prepared_item, kitchen_write_item_verified)
+{
+	std::string other(c_letters_in_alphabet, 'z');
+	auto bad_item = create_definition_from_data(std::string_view{other.data(), other.size()});
+
+	std::shared_ptr<std::vector<char>> data;
+	auto prepared = make_prepared_alphabet(bad_item, data);
+
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	kitchen->store_item(prepared);
+	kitchen->request_item(bad_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	// Without verification the mismatch goes unnoticed.
+	auto result_data = std::make_shared<std::vector<char>>();
+	archive_diff::io::buffer::writer writer(result_data);
+	kitchen->write_item(writer, bad_item);
+	ASSERT_EQ(c_letters_in_alphabet, result_data->size());
+
+	kitchen->set_verify_written_items(true);
+
+	result_data->clear();
+	archive_diff::io::buffer::writer verified_writer(result_data);
+
+	bool caught_exception{false};
+	try
+	{
+		kitchen->write_item(verified_writer, bad_item);
+	}
+	catch (archive_diff::errors::user_exception &e)
+	{
+		if (e.get_error() == archive_diff::errors::error_code::diffs_prepared_item_written_hash_mismatch)
+		{
+			caught_exception = true;
+		}
+	}
+	ASSERT_TRUE(caught_exception);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_read_ahead.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <io/buffer/io_device.h>
+
+#include <diffs/core/read_ahead.h>
+
+using namespace archive_diff;
+
+using access_hint = io::access_hint;
+using range       = diffs::core::read_ahead::range;
+
+struct recorded_hint
+{
+	const void *m_source{};
+	uint64_t m_offset{};
+	uint64_t m_length{};
+	access_hint m_hint{};
+
+	bool operator==(const recorded_hint &) const = default;
+};
+
+// A buffer device that records the hints it's given, in order, into a list shared by all devices.
+class hint_recording_io_device : public io::buffer::io_device
+{
+	public:
+	hint_recording_io_device(
+		std::shared_ptr<std::vector<char>> &buffer, std::shared_ptr<std::vector<recorded_hint>> &hints) :
+		io::buffer::io_device(buffer, size_kind::vector_size), m_hints(hints)
+	{}
+
+	virtual void hint(uint64_t offset, uint64_t length, access_hint hint) override
+	{
+		m_hints->push_back(recorded_hint{this, offset, length, hint});
+	}
+
+	private:
+	std::shared_ptr<std::vector<recorded_hint>> m_hints;
+};
+
+struct recorded_source
+{
+	recorded_source(std::shared_ptr<std::vector<recorded_hint>> &hints)
+	{
+		auto buffer = std::make_shared<std::vector<char>>(1024);
+		m_device    = std::make_shared<hint_recording_io_device>(buffer, hints);
+	}
+
+	range make_range(uint64_t offset, uint64_t length, uint64_t needed_from, uint64_t needed_until)
+	{
+		return range{io::reader{m_device}, m_device.get(), offset, length, needed_from, needed_until};
+	}
+
+	io::shared_io_device m_device;
+};
+
+TEST(read_ahead, merges_overlapping_ranges)
+{
+	auto hints = std::make_shared<std::vector<recorded_hint>>();
+	recorded_source source(hints);
+
+	diffs::core::read_ahead ahead({source.make_range(0, 100, 0, 50), source.make_range(50, 100, 40, 80)}, 200);
+	ASSERT_EQ(1, ahead.get_range_count());
+
+	ahead.advance(0);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{source.m_device.get(), 0, 150, access_hint::will_need})},
+	          *hints);
+
+	// Still read by the second range, so it isn't released when the first one is done.
+	ahead.advance(79);
+	ASSERT_EQ(1, hints->size());
+
+	ahead.advance(80);
+	ASSERT_EQ(2, hints->size());
+	ASSERT_EQ((recorded_hint{source.m_device.get(), 0, 150, access_hint::dont_need}), hints->back());
+
+	ahead.finish();
+	ASSERT_EQ(2, hints->size());
+}
+
+TEST(read_ahead, hints_within_window_of_output)
+{
+	auto hints = std::make_shared<std::vector<recorded_hint>>();
+	recorded_source first(hints);
+	recorded_source second(hints);
+
+	diffs::core::read_ahead ahead(
+		{second.make_range(500, 10, 50, 60), first.make_range(0, 10, 0, 10), first.make_range(200, 10, 100, 110)}, 20);
+	ASSERT_EQ(3, ahead.get_range_count());
+
+	ahead.advance(0);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{first.m_device.get(), 0, 10, access_hint::will_need})}, *hints);
+
+	ahead.advance(29);
+	ASSERT_EQ(2, hints->size());
+	ASSERT_EQ((recorded_hint{first.m_device.get(), 0, 10, access_hint::dont_need}), hints->back());
+
+	hints->clear();
+	ahead.advance(30);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{second.m_device.get(), 500, 10, access_hint::will_need})},
+	          *hints);
+
+	hints->clear();
+	ahead.finish();
+	std::vector<recorded_hint> expected{
+		recorded_hint{second.m_device.get(), 500, 10, access_hint::dont_need},
+		recorded_hint{first.m_device.get(), 200, 10, access_hint::dont_need}};
+	ASSERT_EQ(expected, *hints);
+}
+
+TEST(read_ahead, splits_ranges_larger_than_window)
+{
+	auto hints = std::make_shared<std::vector<recorded_hint>>();
+	recorded_source source(hints);
+
+	diffs::core::read_ahead ahead({source.make_range(0, 100, 0, 100)}, 25);
+	ASSERT_EQ(4, ahead.get_range_count());
+
+	ahead.advance(0);
+	std::vector<recorded_hint> expected{
+		recorded_hint{source.m_device.get(), 0, 25, access_hint::will_need},
+		recorded_hint{source.m_device.get(), 25, 25, access_hint::will_need}};
+	ASSERT_EQ(expected, *hints);
+
+	ahead.advance(50);
+	ASSERT_EQ(4, hints->size());
+	ASSERT_EQ((recorded_hint{source.m_device.get(), 75, 25, access_hint::will_need}), hints->back());
+
+	hints->clear();
+	ahead.finish();
+	ASSERT_EQ(4, hints->size());
+	for (auto &hint : *hints)
+	{
+		ASSERT_EQ(access_hint::dont_need, hint.m_hint);
+	}
+}
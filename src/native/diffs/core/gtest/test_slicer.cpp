@@ -0,0 +1,133 @@
+/**
+ * @file test_slicer.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+#include <test_utility/random_data_file.h>
+
+#include <io/buffer/reader_factory.h>
+
+#include <diffs/core/slicer.h>
+
+using item_definition = archive_diff::diffs::core::item_definition;
+
+const size_t c_slice_count = 64;
+const size_t c_slice_size  = 4 * 1024;
+
+struct slicer_test_data
+{
+	std::shared_ptr<std::vector<char>> m_data;
+	std::shared_ptr<archive_diff::diffs::core::prepared_item> m_prepared;
+	std::vector<item_definition> m_slices;
+};
+
+static slicer_test_data create_slicer_test_data()
+{
+	slicer_test_data test_data;
+
+	test_data.m_data = std::make_shared<std::vector<char>>(
+		archive_diff::test_utility::create_random_data(c_slice_count * c_slice_size, 0));
+
+	auto whole_item =
+		create_definition_from_data(std::string_view{test_data.m_data->data(), test_data.m_data->size()});
+
+	using device = archive_diff::io::buffer::io_device;
+	std::shared_ptr<archive_diff::io::reader_factory> factory =
+		std::make_shared<archive_diff::io::buffer::reader_factory>(test_data.m_data, device::size_kind::vector_size);
+	test_data.m_prepared = std::make_shared<archive_diff::diffs::core::prepared_item>(
+		whole_item, archive_diff::diffs::core::prepared_item::reader_kind{factory});
+
+	for (size_t i = 0; i < c_slice_count; i++)
+	{
+		test_data.m_slices.push_back(
+			create_definition_from_data(std::string_view{test_data.m_data->data() + i * c_slice_size, c_slice_size}));
+	}
+
+	return test_data;
+}
+
+static void fetch_and_verify_slice(
+	archive_diff::diffs::core::slicer &slicer, slicer_test_data &test_data, size_t slice_index)
+{
+	auto prepared = slicer.fetch_slice(test_data.m_slices[slice_index]);
+	auto reader   = prepared->make_reader();
+
+	std::vector<char> result;
+	reader.read_all(result);
+
+	ASSERT_EQ(c_slice_size, result.size());
+	ASSERT_EQ(0, std::memcmp(result.data(), test_data.m_data->data() + slice_index * c_slice_size, c_slice_size));
+}
+
+TEST(slicer, memory_budget_in_order)
+{
+	auto test_data = create_slicer_test_data();
+
+	archive_diff::diffs::core::slicer slicer;
+	slicer.set_memory_budget(4 * c_slice_size);
+
+	for (size_t i = 0; i < c_slice_count; i++)
+	{
+		slicer.request_slice(test_data.m_prepared, i * c_slice_size, test_data.m_slices[i]);
+	}
+
+	slicer.resume_slicing();
+
+	for (size_t i = 0; i < c_slice_count; i++)
+	{
+		fetch_and_verify_slice(slicer, test_data, i);
+	}
+
+	ASSERT_LE(slicer.get_peak_resident_slice_bytes(), 4 * c_slice_size);
+	ASSERT_GT(slicer.get_peak_resident_slice_bytes(), 0);
+}
+
+TEST(slicer, memory_budget_spills_when_consumer_waits)
+{
+	auto test_data = create_slicer_test_data();
+
+	archive_diff::diffs::core::slicer slicer;
+	slicer.set_memory_budget(4 * c_slice_size);
+
+	for (size_t i = 0; i < c_slice_count; i++)
+	{
+		slicer.request_slice(test_data.m_prepared, i * c_slice_size, test_data.m_slices[i]);
+	}
+
+	slicer.resume_slicing();
+
+	// Consuming in reverse forces slices to be held until the last one is produced,
+	// which can only happen by spilling.
+	for (size_t i = c_slice_count; i > 0; i--)
+	{
+		fetch_and_verify_slice(slicer, test_data, i - 1);
+	}
+
+	ASSERT_LE(slicer.get_peak_resident_slice_bytes(), 4 * c_slice_size);
+	ASSERT_GE(slicer.get_spilled_slice_bytes(), (c_slice_count - 4) * c_slice_size);
+}
+
+TEST(slicer, no_memory_budget)
+{
+	auto test_data = create_slicer_test_data();
+
+	archive_diff::diffs::core::slicer slicer;
+
+	for (size_t i = 0; i < c_slice_count; i++)
+	{
+		slicer.request_slice(test_data.m_prepared, i * c_slice_size, test_data.m_slices[i]);
+	}
+
+	slicer.resume_slicing();
+
+	for (size_t i = c_slice_count; i > 0; i--)
+	{
+		fetch_and_verify_slice(slicer, test_data, i - 1);
+	}
+
+	ASSERT_EQ(0, slicer.get_spilled_slice_bytes());
+	ASSERT_EQ(c_slice_count * c_slice_size, slicer.get_peak_resident_slice_bytes());
+}
@@ -0,0 +1,143 @@
+/**
+ * @file test_source_hash_cache.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+
+#include <fstream>
+
+#include <language_support/include_filesystem.h>
+
+#include <io/file/io_device.h>
+
+#include <diffs/core/source_hash_cache.h>
+
+#include "common.h"
+
+using source_hash_cache = archive_diff::diffs::core::source_hash_cache;
+
+static void write_test_file(const fs::path &path, const std::string &content)
+{
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	stream.write(content.data(), content.size());
+}
+
+static item_definition get_definition(source_hash_cache &cache, const fs::path &path)
+{
+	auto reader = archive_diff::io::file::io_device::make_reader(path.string());
+	return cache.get_definition(path.string(), reader);
+}
+
+TEST(source_hash_cache, get_definition_caches_result)
+{
+	auto path = fs::temp_directory_path() / "source_hash_cache.get_definition_caches_result";
+	write_test_file(path, c_alphabet);
+
+	source_hash_cache cache;
+	auto item = get_definition(cache, path);
+
+	auto expected = create_definition_from_data(std::string_view{c_alphabet, c_letters_in_alphabet});
+	ASSERT_EQ(expected, item);
+	ASSERT_EQ(1, cache.size());
+
+	auto identity = source_hash_cache::identify(path.string());
+	ASSERT_TRUE(identity.has_value());
+
+	auto cached = cache.find(identity.value());
+	ASSERT_TRUE(cached.has_value());
+	ASSERT_EQ(expected, cached.value());
+
+	// A cached entry is trusted as-is, so a planted definition is returned without rehashing.
+	auto other_hash = create_definition_from_data(std::string_view{c_alphabet, 1}).get_hashes().begin()->second;
+	cache.store(identity.value(), item_definition{c_letters_in_alphabet}.with_hash(other_hash));
+	auto from_cache = get_definition(cache, path);
+	ASSERT_NE(expected, from_cache);
+
+	fs::remove(path);
+}
+
+TEST(source_hash_cache, changed_file_is_rehashed)
+{
+	auto path = fs::temp_directory_path() / "source_hash_cache.changed_file_is_rehashed";
+	write_test_file(path, c_alphabet);
+
+	source_hash_cache cache;
+	auto original          = get_definition(cache, path);
+	auto original_identity = source_hash_cache::identify(path.string());
+
+	std::string changed{c_alphabet};
+	changed += c_alphabet;
+	write_test_file(path, changed);
+
+	auto changed_identity = source_hash_cache::identify(path.string());
+	ASSERT_TRUE(changed_identity.has_value());
+	ASSERT_FALSE(cache.find(changed_identity.value()).has_value());
+
+	auto item = get_definition(cache, path);
+	ASSERT_EQ(create_definition_from_data(changed), item);
+	ASSERT_NE(original, item);
+
+	// The stale entry for the path was replaced, not kept alongside the new one.
+	ASSERT_EQ(1, cache.size());
+	ASSERT_FALSE(cache.find(original_identity.value()).has_value());
+
+	fs::remove(path);
+}
+
+TEST(source_hash_cache, save_and_load)
+{
+	auto path       = fs::temp_directory_path() / "source_hash_cache.save_and_load";
+	auto cache_path = fs::temp_directory_path() / "source_hash_cache.save_and_load.cache";
+	write_test_file(path, c_alphabet);
+
+	item_definition item;
+	{
+		source_hash_cache cache;
+		ASSERT_FALSE(cache.has_unsaved_changes());
+		item = get_definition(cache, path);
+		ASSERT_TRUE(cache.has_unsaved_changes());
+		cache.save(cache_path.string());
+		ASSERT_FALSE(cache.has_unsaved_changes());
+	}
+
+	source_hash_cache loaded;
+	loaded.load(cache_path.string());
+	ASSERT_EQ(1, loaded.size());
+	ASSERT_FALSE(loaded.has_unsaved_changes());
+
+	auto identity = source_hash_cache::identify(path.string());
+	auto cached   = loaded.find(identity.value());
+	ASSERT_TRUE(cached.has_value());
+	ASSERT_EQ(item, cached.value());
+
+	// A cache hit, or storing what is already there, leaves nothing to save.
+	ASSERT_EQ(item, get_definition(loaded, path));
+	loaded.store(identity.value(), item);
+	ASSERT_FALSE(loaded.has_unsaved_changes());
+
+	fs::remove(path);
+	fs::remove(cache_path);
+}
+
+TEST(source_hash_cache, load_ignores_bad_file)
+{
+	auto cache_path = fs::temp_directory_path() / "source_hash_cache.load_ignores_bad_file";
+
+	source_hash_cache cache;
+	cache.load(cache_path.string() + ".missing");
+	ASSERT_EQ(0, cache.size());
+
+	write_test_file(cache_path, c_alphabet);
+	cache.load(cache_path.string());
+	ASSERT_EQ(0, cache.size());
+
+	// Valid magic, but truncated after the entry count.
+	write_test_file(cache_path, std::string{"SHC1\x05\0\0\0\0\0\0\0", 12});
+	cache.load(cache_path.string());
+	ASSERT_EQ(0, cache.size());
+
+	fs::remove(cache_path);
+}
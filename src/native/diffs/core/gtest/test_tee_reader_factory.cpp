@@ -0,0 +1,155 @@
+/**
+ * @file test_tee_reader_factory.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <io/buffer/io_device.h>
+#include <io/sequential/basic_reader_wrapper.h>
+
+#include <diffs/core/tee_reader_factory.h>
+
+using namespace archive_diff;
+
+const size_t c_content_size = 200 * 1024;
+const size_t c_window_size  = 16 * 1024;
+
+// Stands in for a decompressor; counts how often the content is produced.
+class counting_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	counting_reader_factory() : m_content(std::make_shared<std::vector<char>>(c_content_size))
+	{
+		for (size_t i = 0; i < c_content_size; i++)
+		{
+			(*m_content)[i] = static_cast<char>((i * 7) ^ (i >> 9));
+		}
+	}
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override
+	{
+		m_readers_made++;
+		auto reader = io::buffer::io_device::make_reader(m_content, io::buffer::io_device::size_kind::vector_size);
+		return std::make_unique<io::sequential::basic_reader_wrapper>(reader);
+	}
+
+	std::shared_ptr<std::vector<char>> m_content;
+	size_t m_readers_made{};
+};
+
+static std::shared_ptr<diffs::core::tee_reader_factory> make_tee(
+	std::shared_ptr<counting_reader_factory> &source, size_t consumer_count)
+{
+	std::shared_ptr<io::sequential::reader_factory> source_factory = source;
+	return std::make_shared<diffs::core::tee_reader_factory>(
+		source_factory, c_content_size, consumer_count, c_window_size);
+}
+
+static std::vector<char> read_all(io::sequential::reader &reader)
+{
+	std::vector<char> data;
+	reader.read_all_remaining(data);
+	return data;
+}
+
+TEST(tee_reader_factory, consumers_in_step)
+{
+	auto source = std::make_shared<counting_reader_factory>();
+	auto tee    = make_tee(source, 3);
+
+	std::vector<std::unique_ptr<io::sequential::reader>> consumers;
+	std::vector<std::vector<char>> results(3);
+	for (size_t i = 0; i < 3; i++)
+	{
+		consumers.emplace_back(tee->make_sequential_reader());
+	}
+
+	const size_t c_read_size = 1000;
+	for (size_t offset = 0; offset < c_content_size; offset += c_read_size)
+	{
+		auto to_read = std::min(c_read_size, c_content_size - offset);
+		for (size_t i = 0; i < 3; i++)
+		{
+			results[i].resize(offset + to_read);
+			consumers[i]->read(std::span<char>{results[i].data() + offset, to_read});
+		}
+	}
+
+	for (auto &result : results)
+	{
+		ASSERT_EQ(*source->m_content, result);
+	}
+
+	ASSERT_EQ(1, source->m_readers_made);
+	ASSERT_EQ(1, tee->get_source_reader_count());
+	ASSERT_EQ(0, tee->get_spilled_size());
+	ASSERT_LE(tee->get_peak_window_size(), c_window_size);
+}
+
+TEST(tee_reader_factory, consumers_far_apart)
+{
+	auto source = std::make_shared<counting_reader_factory>();
+	auto tee    = make_tee(source, 2);
+
+	// The second consumer doesn't exist until the first has read everything.
+	auto first = tee->make_sequential_reader();
+	ASSERT_EQ(*source->m_content, read_all(*first));
+	first.reset();
+
+	// The window overflows by at most one chunk, which is smaller than the window.
+	ASSERT_LE(tee->get_peak_window_size(), 2 * c_window_size);
+	ASSERT_GE(tee->get_spilled_size(), c_content_size - c_window_size);
+
+	auto second = tee->make_sequential_reader();
+	second->skip(10);
+	auto remaining = read_all(*second);
+	ASSERT_EQ(std::vector<char>(source->m_content->begin() + 10, source->m_content->end()), remaining);
+
+	ASSERT_EQ(1, source->m_readers_made);
+}
+
+TEST(tee_reader_factory, extra_consumer_reproduces)
+{
+	auto source = std::make_shared<counting_reader_factory>();
+	auto tee    = make_tee(source, 1);
+
+	auto first = tee->make_sequential_reader();
+	ASSERT_EQ(*source->m_content, read_all(*first));
+	first.reset();
+
+	// Nothing was kept for a consumer that wasn't expected.
+	ASSERT_EQ(0, tee->get_spilled_size());
+
+	auto extra = tee->make_sequential_reader();
+	ASSERT_EQ(*source->m_content, read_all(*extra));
+	ASSERT_EQ(2, source->m_readers_made);
+}
+
+TEST(tee_reader_factory, make_reader_uses_spill)
+{
+	auto source = std::make_shared<counting_reader_factory>();
+	auto tee    = make_tee(source, 2);
+
+	auto first = tee->make_sequential_reader();
+	std::vector<char> start(1000);
+	first->read(std::span<char>{start.data(), start.size()});
+
+	auto reader = tee->make_reader();
+	ASSERT_EQ(c_content_size, reader.size());
+	ASSERT_EQ(c_content_size, tee->get_spilled_size());
+
+	std::vector<char> staged;
+	reader.read_all(staged);
+	ASSERT_EQ(*source->m_content, staged);
+
+	// Consumers carry on from the staged content.
+	auto rest = read_all(*first);
+	ASSERT_EQ(std::vector<char>(source->m_content->begin() + 1000, source->m_content->end()), rest);
+
+	auto second = tee->make_sequential_reader();
+	ASSERT_EQ(*source->m_content, read_all(*second));
+
+	ASSERT_EQ(1, source->m_readers_made);
+}
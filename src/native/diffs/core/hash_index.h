@@ -0,0 +1,261 @@
+/**
+ * @file hash_index.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <hashing/hash.h>
+
+#include "item_definition.h"
+
+namespace archive_diff::diffs::core
+{
+// Lookup key of an item size and one of its hashes. The digest is held inline so building
+// a key and comparing two keys never touches the heap.
+struct digest_key
+{
+	static const size_t c_max_digest_size = 32;
+
+	// Returns false if the hash is too large to be held inline.
+	static bool try_make(uint64_t size, hashing::algorithm algorithm, std::string_view digest, digest_key *key)
+	{
+		if (digest.size() > c_max_digest_size)
+		{
+			return false;
+		}
+
+		key->m_size        = size;
+		key->m_algorithm   = algorithm;
+		key->m_digest_size = static_cast<uint8_t>(digest.size());
+		key->m_digest.fill(0);
+		std::memcpy(key->m_digest.data(), digest.data(), digest.size());
+		return true;
+	}
+	static bool try_make(uint64_t size, const hashing::hash &hash, digest_key *key)
+	{
+		return try_make(
+			size, hash.m_algorithm, std::string_view{hash.m_hash_data.data(), hash.m_hash_data.size()}, key);
+	}
+
+	bool operator==(const digest_key &rhs) const = default;
+
+	uint64_t m_size{};
+	hashing::algorithm m_algorithm{hashing::algorithm::invalid};
+	uint8_t m_digest_size{};
+	std::array<char, c_max_digest_size> m_digest{};
+};
+
+namespace hash_index_detail
+{
+inline uint64_t mix_size(uint64_t size)
+{
+	// splitmix64 finalizer, so items differing only by size spread across the table.
+	size += 0x9e3779b97f4a7c15ull;
+	size = (size ^ (size >> 30)) * 0xbf58476d1ce4e5b9ull;
+	size = (size ^ (size >> 27)) * 0x94d049bb133111ebull;
+	return size ^ (size >> 31);
+}
+
+inline uint64_t leading_digest_bytes(const char *digest, size_t digest_size)
+{
+	uint64_t value{};
+	std::memcpy(&value, digest, std::min(sizeof(value), digest_size));
+	return value;
+}
+} // namespace hash_index_detail
+
+// The digest is already uniformly distributed, so its first eight bytes are the hash.
+struct digest_key_hash
+{
+	uint64_t operator()(const digest_key &key) const
+	{
+		return hash_index_detail::leading_digest_bytes(key.m_digest.data(), key.m_digest_size) ^
+		       hash_index_detail::mix_size(key.m_size);
+	}
+};
+
+// The fingerprint is consistent with item_definition::operator==.
+struct item_definition_hash
+{
+	uint64_t operator()(const item_definition &item) const { return item.get_fingerprint(); }
+};
+
+// Flat open-addressing (linear probing) table.
+// Unlike std::map, inserting or erasing may move existing values, so pointers returned by
+// find() are only valid until the next insertion or erase.
+template <typename KeyT, typename ValueT, typename HashT>
+class hash_index
+{
+	public:
+	const ValueT *find(const KeyT &key) const
+	{
+		if (m_count == 0)
+		{
+			return nullptr;
+		}
+
+		auto mask = m_slots.size() - 1;
+		for (auto index = static_cast<size_t>(HashT{}(key)) & mask;; index = (index + 1) & mask)
+		{
+			auto &slot = m_slots[index];
+			if (!slot.m_occupied)
+			{
+				return nullptr;
+			}
+
+			if (slot.m_key == key)
+			{
+				return &slot.m_value;
+			}
+		}
+	}
+
+	ValueT *find(const KeyT &key)
+	{
+		return const_cast<ValueT *>(static_cast<const hash_index *>(this)->find(key));
+	}
+
+	bool contains(const KeyT &key) const { return find(key) != nullptr; }
+
+	// Returns the value for key, default constructing it first if it isn't present.
+	ValueT &operator[](const KeyT &key) { return *try_emplace(key).first; }
+
+	// Like std::map::insert, an existing value is left alone. Returns true if the value was added.
+	bool insert(const KeyT &key, const ValueT &value)
+	{
+		auto [slot_value, added] = try_emplace(key);
+		if (added)
+		{
+			*slot_value = value;
+		}
+		return added;
+	}
+
+	// Returns true if the key was present. Entries later in the same probe run are moved back
+	// into the freed slot, so lookups never have to skip over removed entries.
+	bool erase(const KeyT &key)
+	{
+		if (m_count == 0)
+		{
+			return false;
+		}
+
+		auto mask = m_slots.size() - 1;
+		auto hole = static_cast<size_t>(HashT{}(key)) & mask;
+		while (true)
+		{
+			if (!m_slots[hole].m_occupied)
+			{
+				return false;
+			}
+
+			if (m_slots[hole].m_key == key)
+			{
+				break;
+			}
+
+			hole = (hole + 1) & mask;
+		}
+
+		for (auto next = (hole + 1) & mask; m_slots[next].m_occupied; next = (next + 1) & mask)
+		{
+			// An entry may only move back if that doesn't put it before the slot it hashes to.
+			auto home = static_cast<size_t>(HashT{}(m_slots[next].m_key)) & mask;
+			if (((next - home) & mask) >= ((next - hole) & mask))
+			{
+				m_slots[hole] = std::move(m_slots[next]);
+				hole          = next;
+			}
+		}
+
+		m_slots[hole] = slot{};
+		m_count--;
+
+		return true;
+	}
+
+	size_t size() const { return m_count; }
+
+	void clear()
+	{
+		m_slots.clear();
+		m_count = 0;
+	}
+
+	private:
+	struct slot
+	{
+		bool m_occupied{};
+		KeyT m_key{};
+		ValueT m_value{};
+	};
+
+	std::pair<ValueT *, bool> try_emplace(const KeyT &key)
+	{
+		if (auto existing = find(key))
+		{
+			return {existing, false};
+		}
+
+		// Keep the load factor at or below 3/4.
+		if ((m_count + 1) * 4 > m_slots.size() * 3)
+		{
+			grow();
+		}
+
+		auto &slot      = m_slots[find_empty_slot(key)];
+		slot.m_occupied = true;
+		slot.m_key      = key;
+		m_count++;
+
+		return {&slot.m_value, true};
+	}
+
+	size_t find_empty_slot(const KeyT &key) const
+	{
+		auto mask  = m_slots.size() - 1;
+		auto index = static_cast<size_t>(HashT{}(key)) & mask;
+		while (m_slots[index].m_occupied)
+		{
+			index = (index + 1) & mask;
+		}
+		return index;
+	}
+
+	void grow()
+	{
+		const size_t c_min_capacity = 16;
+
+		std::vector<slot> old_slots;
+		old_slots.swap(m_slots);
+		m_slots.resize(std::max(c_min_capacity, old_slots.size() * 2));
+
+		for (auto &old_slot : old_slots)
+		{
+			if (!old_slot.m_occupied)
+			{
+				continue;
+			}
+
+			m_slots[find_empty_slot(old_slot.m_key)] = std::move(old_slot);
+		}
+	}
+
+	std::vector<slot> m_slots;
+	size_t m_count{};
+};
+
+template <typename ValueT>
+using digest_index = hash_index<digest_key, ValueT, digest_key_hash>;
+
+template <typename ValueT>
+using item_definition_index = hash_index<item_definition, ValueT, item_definition_hash>;
+} // namespace archive_diff::diffs::core
@@ -6,7 +6,11 @@
  */
 #include "item_definition.h"
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 #include <sstream>
+#include <unordered_set>
 
 #include <io/sequential/basic_reader_wrapper.h>
 
@@ -14,153 +18,341 @@
 
 namespace archive_diff::diffs::core
 {
-bool item_definition::operator<(const item_definition &rhs) const
+const item_definition::record item_definition::c_empty_record{};
+
+namespace
+{
+uint64_t leading_digest_bytes(std::string_view digest)
 {
-	if (m_length != rhs.m_length)
+	uint64_t value{};
+	std::memcpy(&value, digest.data(), std::min(sizeof(value), digest.size()));
+	return value;
+}
+} // namespace
+
+// Records are interned in a sharded set so unrelated items rarely contend on a lock.
+// The table is never destroyed, as items may outlive static destruction.
+struct item_definition_interning
+{
+	using record = item_definition::record;
+
+	struct identity_hash
 	{
-		return m_length < rhs.m_length;
-	}
+		size_t operator()(const record *target) const { return static_cast<size_t>(target->m_identity); }
+	};
 
-	if (m_hashes.size() != rhs.m_hashes.size())
+	struct identity_equal
 	{
-		return m_hashes.size() < rhs.m_hashes.size();
-	}
+		bool operator()(const record *left, const record *right) const
+		{
+			if ((left->m_identity != right->m_identity) || (left->m_length != right->m_length))
+			{
+				return false;
+			}
+
+			if (!item_definition::have_same_hashes(*left, *right))
+			{
+				return false;
+			}
+
+			if (left->m_names == right->m_names)
+			{
+				return true;
+			}
+
+			if (!left->m_names || !right->m_names)
+			{
+				return false;
+			}
+
+			return *left->m_names == *right->m_names;
+		}
+	};
 
-	for (auto algorithm : hashing::all_algorithms)
+	struct shard
 	{
-		bool left_has_hash  = m_hashes.count(algorithm) > 0;
-		bool right_has_hash = rhs.m_hashes.count(algorithm) > 0;
+		std::mutex m_mutex;
+		std::unordered_set<const record *, identity_hash, identity_equal> m_records;
+	};
 
-		if (!left_has_hash && !right_has_hash)
+	static const size_t c_shard_count = 16;
+
+	static shard &get_shard(const record *target)
+	{
+		static auto shards = new std::array<shard, c_shard_count>();
+		return (*shards)[target->m_identity % c_shard_count];
+	}
+
+	static void compute_identity(record *target)
+	{
+		auto fingerprint = item_definition::mix_fingerprint(target->m_length);
+		for (size_t slot = 0; slot < item_definition::c_hash_algorithms.size(); slot++)
 		{
-			continue;
+			if (target->m_digest_sizes[slot] == 0)
+			{
+				continue;
+			}
+
+			std::string_view digest{target->m_digests[slot].data(), target->m_digest_sizes[slot]};
+			fingerprint = item_definition::mix_fingerprint(fingerprint ^ (leading_digest_bytes(digest) + slot));
 		}
+		target->m_fingerprint = fingerprint;
 
-		if (!right_has_hash) // hash appears in left only
+		auto identity = fingerprint;
+		if (target->m_names)
 		{
-			return false;
+			for (auto &name : *target->m_names)
+			{
+				identity = item_definition::mix_fingerprint(identity ^ std::hash<std::string>{}(name));
+			}
 		}
-		else if (!left_has_hash) // hash appears in right only
+		target->m_identity = identity;
+	}
+};
+
+item_definition::item_definition(uint64_t length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+
+	auto candidate      = std::make_unique<record>();
+	candidate->m_length = length;
+	*this               = intern(std::move(candidate));
+}
+
+std::unique_ptr<item_definition::record> item_definition::copy_record() const
+{
+	auto &source = get_record();
+
+	auto copy            = std::make_unique<record>();
+	copy->m_length       = source.m_length;
+	copy->m_digests      = source.m_digests;
+	copy->m_digest_sizes = source.m_digest_sizes;
+	copy->m_names        = source.m_names;
+	return copy;
+}
+
+item_definition item_definition::intern(std::unique_ptr<record> candidate)
+{
+	item_definition_interning::compute_identity(candidate.get());
+
+	if ((candidate->m_length == 0) && !candidate->m_names
+	    && std::all_of(candidate->m_digest_sizes.begin(), candidate->m_digest_sizes.end(), [](auto size) {
+			   return size == 0;
+		   }))
+	{
+		return item_definition{};
+	}
+
+	auto &shard = item_definition_interning::get_shard(candidate.get());
+	std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+	auto find_itr = shard.m_records.find(candidate.get());
+	if (find_itr != shard.m_records.end())
+	{
+		// A record whose count has dropped to zero is being released; it can't be revived.
+		auto existing   = *find_itr;
+		auto references = existing->m_references.load(std::memory_order_relaxed);
+		while (references != 0)
 		{
-			return true;
+			if (existing->m_references.compare_exchange_weak(
+					references, references + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return adopt(existing);
+			}
 		}
 
-		auto left_hash  = &m_hashes.find(algorithm)->second;
-		auto right_hash = &rhs.m_hashes.find(algorithm)->second;
+		shard.m_records.erase(find_itr);
+	}
 
-		// ok, both have this hash, compare the bytes
-		if (left_hash->m_hash_data.size() != right_hash->m_hash_data.size())
+	auto interned = candidate.release();
+	shard.m_records.insert(interned);
+	return adopt(interned);
+}
+
+void item_definition::release(const record *target)
+{
+	{
+		auto &shard = item_definition_interning::get_shard(target);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+		// The entry may already have been replaced by an equal record.
+		auto find_itr = shard.m_records.find(target);
+		if ((find_itr != shard.m_records.end()) && (*find_itr == target))
 		{
-			throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
+			shard.m_records.erase(find_itr);
 		}
+	}
 
-		auto cmp =
-			std::memcmp(left_hash->m_hash_data.data(), right_hash->m_hash_data.data(), right_hash->m_hash_data.size());
+	delete target;
+}
 
-		if (cmp != 0)
+bool item_definition::have_same_hashes(const record &left, const record &right)
+{
+	if (left.m_digest_sizes != right.m_digest_sizes)
+	{
+		return false;
+	}
+
+	for (size_t slot = 0; slot < c_hash_algorithms.size(); slot++)
+	{
+		if (0 != std::memcmp(left.m_digests[slot].data(), right.m_digests[slot].data(), left.m_digest_sizes[slot]))
 		{
-			return cmp < 0;
+			return false;
 		}
 	}
 
-	return false;
+	return true;
 }
 
-bool item_definition::operator==(const item_definition &rhs) const
+bool item_definition::operator<(const item_definition &rhs) const
 {
-	if (m_length != rhs.m_length)
+	auto &left  = get_record();
+	auto &right = rhs.get_record();
+
+	if (left.m_length != right.m_length)
 	{
-		return false;
+		return left.m_length < right.m_length;
 	}
 
-	if (m_hashes.size() != rhs.m_hashes.size())
+	auto left_count  = get_hash_count();
+	auto right_count = rhs.get_hash_count();
+	if (left_count != right_count)
 	{
-		return false;
+		return left_count < right_count;
 	}
 
-	for (auto algorithm : hashing::all_algorithms)
+	for (size_t slot = 0; slot < c_hash_algorithms.size(); slot++)
 	{
-		bool left_has_hash  = m_hashes.count(algorithm) > 0;
-		bool right_has_hash = rhs.m_hashes.count(algorithm) > 0;
+		bool left_has_hash  = left.m_digest_sizes[slot] > 0;
+		bool right_has_hash = right.m_digest_sizes[slot] > 0;
 
 		if (!left_has_hash && !right_has_hash)
 		{
 			continue;
 		}
 
-		if (!right_has_hash || !left_has_hash)
+		if (!right_has_hash) // hash appears in left only
 		{
 			return false;
 		}
-
-		auto left_hash  = &m_hashes.find(algorithm)->second;
-		auto right_hash = &rhs.m_hashes.find(algorithm)->second;
-
-		// ok, both have this hash, compare the bytes
-		if (left_hash->m_hash_data.size() != right_hash->m_hash_data.size())
+		else if (!left_has_hash) // hash appears in right only
 		{
-			throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
+			return true;
 		}
 
-		auto cmp =
-			std::memcmp(left_hash->m_hash_data.data(), right_hash->m_hash_data.data(), right_hash->m_hash_data.size());
+		// ok, both have this hash, compare the bytes
+		auto cmp = std::memcmp(left.m_digests[slot].data(), right.m_digests[slot].data(), left.m_digest_sizes[slot]);
 
 		if (cmp != 0)
 		{
-			return false;
+			return cmp < 0;
 		}
 	}
 
-	return true;
+	return false;
 }
 
-[[nodiscard]] item_definition item_definition::with_name(const std::string &name) const
+size_t item_definition::get_hash_count() const
 {
-	item_definition new_item(*this);
-	new_item.m_names.insert(name);
-	return new_item;
+	auto &sizes = get_record().m_digest_sizes;
+	return static_cast<size_t>(std::count_if(sizes.begin(), sizes.end(), [](auto size) { return size > 0; }));
 }
 
-[[nodiscard]] item_definition item_definition::with_hash(const hashing::hash &hash) const
+item_definition::item_hashes_map item_definition::get_hashes() const
 {
-	auto algorithm = hash.m_algorithm;
+	item_hashes_map hashes;
 
-	if (m_hashes.count(algorithm))
+	for (auto algorithm : c_hash_algorithms)
 	{
-		auto find_itr   = m_hashes.find(algorithm);
-		auto &hash_data = find_itr->second.m_hash_data;
-
-		if (hash_data.size() != hash.m_hash_data.size())
+		auto hash_data = get_hash_data(algorithm);
+		if (!hash_data.empty())
 		{
-			throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
+			hashes.insert(std::pair{algorithm, hashing::hash::import_hash_value(algorithm, hash_data)});
 		}
+	}
+
+	return hashes;
+}
+
+const item_definition::item_names_set &item_definition::get_names() const
+{
+	static const item_names_set c_no_names;
 
-		if (0 != std::memcmp(hash_data.data(), hash.m_hash_data.data(), hash_data.size()))
+	auto &names = get_record().m_names;
+	return names ? *names : c_no_names;
+}
+
+[[nodiscard]] item_definition item_definition::with_name(const std::string &name) const
+{
+	if (has_matching_name(name))
+	{
+		return *this;
+	}
+
+	auto new_names = std::make_shared<item_names_set>(get_names());
+	new_names->insert(name);
+
+	auto candidate     = copy_record();
+	candidate->m_names = std::move(new_names);
+	return intern(std::move(candidate));
+}
+
+bool item_definition::set_hash(record &target, hashing::algorithm algorithm, std::string_view hash_data)
+{
+	auto slot = get_hash_slot(algorithm);
+	if (slot == c_no_hash_slot)
+	{
+		throw errors::user_exception(
+			errors::error_code::diff_bad_hash_type,
+			"item_definition: Unexpected hash type: " + std::to_string(static_cast<int>(algorithm)));
+	}
+
+	if (hash_data.size() != hashing::get_byte_count_for_algorithm(algorithm))
+	{
+		throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
+	}
+
+	auto &digest = target.m_digests[slot];
+	if (target.m_digest_sizes[slot] != 0)
+	{
+		if (0 != std::memcmp(digest.data(), hash_data.data(), hash_data.size()))
 		{
 			throw errors::user_exception(errors::error_code::item_definition_hash_same_type_different_value);
 		}
 
+		return false;
+	}
+
+	std::memcpy(digest.data(), hash_data.data(), hash_data.size());
+	target.m_digest_sizes[slot] = static_cast<uint8_t>(hash_data.size());
+	return true;
+}
+
+[[nodiscard]] item_definition item_definition::with_hash(const hashing::hash &hash) const
+{
+	auto candidate = copy_record();
+
+	if (!set_hash(*candidate, hash.m_algorithm, std::string_view{hash.m_hash_data.data(), hash.m_hash_data.size()}))
+	{
 		// don't need to add a duplicate
-		return item_definition(*this);
+		return *this;
 	}
 
-	item_definition new_item(*this);
-	new_item.m_hashes.insert(std::pair{hash.m_algorithm, hash});
-	return new_item;
+	return intern(std::move(candidate));
 }
 
 bool item_definition::has_matching_hash(hashing::hash &hash) const
 {
-	auto algorithm = hash.m_algorithm;
+	auto hash_data = get_hash_data(hash.m_algorithm);
 
-	if (m_hashes.count(algorithm) == 0)
+	if (hash_data.empty())
 	{
 		return false;
 	}
 
-	auto find_itr   = m_hashes.find(algorithm);
-	auto &hash_data = find_itr->second.m_hash_data;
-
 	if (hash_data.size() != hash.m_hash_data.size())
 	{
 		throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
@@ -173,41 +365,23 @@ item_definition::match_result item_definition::match(const item_definition &rhs)
 {
 	auto result = match_result::uncertain;
 
-	if (m_length != rhs.m_length)
+	auto &left  = get_record();
+	auto &right = rhs.get_record();
+
+	if (left.m_length != right.m_length)
 	{
 		return match_result::no_match;
 	}
 
-	for (auto algorithm : hashing::all_algorithms)
+	for (size_t slot = 0; slot < c_hash_algorithms.size(); slot++)
 	{
-		bool left_has_hash  = m_hashes.count(algorithm) > 0;
-		bool right_has_hash = rhs.m_hashes.count(algorithm) > 0;
-
-		if (!left_has_hash && !right_has_hash)
-		{
-			continue;
-		}
-
-		if (!right_has_hash)
-		{
-			continue;
-		}
-		else if (!left_has_hash)
+		// Only hashes both items have can be compared.
+		if ((left.m_digest_sizes[slot] == 0) || (right.m_digest_sizes[slot] == 0))
 		{
 			continue;
 		}
 
-		auto left_hash  = &m_hashes.find(algorithm)->second;
-		auto right_hash = &rhs.m_hashes.find(algorithm)->second;
-
-		// ok, both have this hash, compare the bytes
-		if (left_hash->m_hash_data.size() != right_hash->m_hash_data.size())
-		{
-			throw errors::user_exception(errors::error_code::item_definition_hash_size_mismatch);
-		}
-
-		auto cmp =
-			std::memcmp(left_hash->m_hash_data.data(), right_hash->m_hash_data.data(), right_hash->m_hash_data.size());
+		auto cmp = std::memcmp(left.m_digests[slot].data(), right.m_digests[slot].data(), left.m_digest_sizes[slot]);
 
 		if (cmp != 0)
 		{
@@ -237,23 +411,24 @@ Json::Value item_definition::to_json() const
 {
 	Json::Value value;
 
-	value["Length"] = m_length;
+	value["Length"] = size();
 
-	if (m_names.size())
+	auto &names = get_names();
+	if (names.size())
 	{
-		Json::Value names;
-		for (const auto &name : m_names)
+		Json::Value names_json;
+		for (const auto &name : names)
 		{
-			names.append(name);
+			names_json.append(name);
 		}
 
-		value["Names"] = names;
+		value["Names"] = names_json;
 	}
 
-	if (m_hashes.size())
+	if (has_any_hashes())
 	{
 		Json::Value hashes;
-		for (const auto &[hash_type, hash] : m_hashes)
+		for (const auto &[hash_type, hash] : get_hashes())
 		{
 			hashes[hash.get_type_string()] = hash.to_json();
 		}
@@ -264,6 +439,12 @@ Json::Value item_definition::to_json() const
 	return value;
 }
 
+static void write_hash(io::sequential::writer &writer, hashing::algorithm algorithm, std::string_view hash_data)
+{
+	writer.write_uint32_t(static_cast<uint32_t>(algorithm));
+	writer.write(hash_data);
+}
+
 void item_definition::write(io::sequential::writer &writer, serialization_options options) const
 {
 	bool include_hashes           = (options & serialization_options::include_hashes) > 0;
@@ -271,9 +452,10 @@ void item_definition::write(io::sequential::writer &writer, serialization_option
 	bool zero_size_has_no_details = (options & serialization_options::zero_size_has_no_details) > 0;
 	bool include_only_sha256_hash = (options & serialization_options::include_only_sha256_hash) > 0;
 
-	writer.write_uint64_t(m_length);
+	auto length = size();
+	writer.write_uint64_t(length);
 
-	if ((m_length == 0) && zero_size_has_no_details)
+	if ((length == 0) && zero_size_has_no_details)
 	{
 		return;
 	}
@@ -282,24 +464,26 @@ void item_definition::write(io::sequential::writer &writer, serialization_option
 	{
 		if (include_only_sha256_hash)
 		{
-			auto itr = m_hashes.find(hashing::algorithm::sha256);
+			auto hash_data = get_hash_data(hashing::algorithm::sha256);
 
-			if (itr == m_hashes.cend())
+			if (hash_data.empty())
 			{
 				throw errors::user_exception(errors::error_code::item_definition_no_sha256_hash);
 			}
 
-			auto &hash = itr->second;
-			hash.write(writer);
+			write_hash(writer, hashing::algorithm::sha256, hash_data);
 		}
 		else
 		{
 			// we really shouldn't expect a lot of hashes!
-			writer.write_uint8_t(static_cast<uint8_t>(m_hashes.size()));
-			for (auto &hash_entry : m_hashes)
+			writer.write_uint8_t(static_cast<uint8_t>(get_hash_count()));
+			for (auto algorithm : c_hash_algorithms)
 			{
-				auto &hash = hash_entry.second;
-				hash.write(writer);
+				auto hash_data = get_hash_data(algorithm);
+				if (!hash_data.empty())
+				{
+					write_hash(writer, algorithm, hash_data);
+				}
 			}
 		}
 	}
@@ -310,6 +494,27 @@ void item_definition::write(io::sequential::writer &writer, serialization_option
 	}
 }
 
+// Reads a serialized hashing::hash straight into the record, avoiding a temporary hash object.
+void item_definition::read_hash(io::sequential::reader &reader, record &target)
+{
+	hashing::algorithm algorithm;
+	reader.read_uint32_t(reinterpret_cast<uint32_t *>(&algorithm));
+
+	auto hash_data_bytes = hashing::get_byte_count_for_algorithm(algorithm);
+	auto slot            = get_hash_slot(algorithm);
+	if ((slot == c_no_hash_slot) || (hash_data_bytes > c_max_digest_size))
+	{
+		throw errors::user_exception(
+			errors::error_code::diff_bad_hash_type,
+			"item_definition::read: Unexpected hash type: " + std::to_string(static_cast<int>(algorithm)));
+	}
+
+	std::array<char, c_max_digest_size> hash_data{};
+	reader.read(std::span{hash_data.data(), hash_data_bytes});
+
+	set_hash(target, algorithm, std::string_view{hash_data.data(), hash_data_bytes});
+}
+
 item_definition item_definition::read(io::sequential::reader &reader, serialization_options options)
 {
 	bool include_hashes           = (options & serialization_options::include_hashes) > 0;
@@ -320,21 +525,20 @@ item_definition item_definition::read(io::sequential::reader &reader, serializat
 	uint64_t length;
 	reader.read_uint64_t(&length);
 
-	item_definition item{length};
-
 	if ((length == 0) && zero_size_has_no_details)
 	{
-		return item;
+		return item_definition{};
 	}
 
+	// Gather everything first so the item is interned once.
+	auto candidate      = std::make_unique<record>();
+	candidate->m_length = length;
+
 	if (include_hashes)
 	{
 		if (include_only_sha256_hash)
 		{
-			hashing::hash hash;
-			hash.read(reader);
-
-			item = item.with_hash(hash);
+			read_hash(reader, *candidate);
 		}
 		else
 		{
@@ -343,10 +547,7 @@ item_definition item_definition::read(io::sequential::reader &reader, serializat
 
 			for (uint8_t i = 0; i < hash_count; i++)
 			{
-				hashing::hash hash;
-				hash.read(reader);
-
-				item = item.with_hash(hash);
+				read_hash(reader, *candidate);
 			}
 		}
 	}
@@ -356,7 +557,7 @@ item_definition item_definition::read(io::sequential::reader &reader, serializat
 		// TODO: Implement
 	}
 
-	return item;
+	return intern(std::move(candidate));
 }
 
 item_definition item_definition::read(io::reader &reader, serialization_options options)
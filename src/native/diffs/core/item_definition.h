@@ -9,12 +9,22 @@
 #include <json/json.h>
 #include <fmt/format.h>
 
+#include <array>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <set>
+#include <string_view>
 
 #include <hashing/hash.h>
 
 namespace archive_diff::diffs::core
 {
+// An immutable handle to an interned item. Items with the same length, hashes and names
+// share one record, so copying an item_definition only copies a pointer and bumps a
+// reference count. Digests are held inline in the record and a fingerprint of the length
+// and hashes is computed once, making equality and hashing cheap. Names are kept out of
+// line since most items don't have any.
 class item_definition
 {
 	public:
@@ -40,12 +50,45 @@ class item_definition
 	};
 
 	public:
-	item_definition() : item_definition(0) {};
-	item_definition(uint64_t length) { m_length = length; }
+	item_definition() = default;
+	item_definition(uint64_t length);
+
+	item_definition(const item_definition &other) : m_record(other.m_record) { add_reference(m_record); }
+	item_definition(item_definition &&other) noexcept : m_record(other.m_record) { other.m_record = nullptr; }
+	~item_definition() { remove_reference(m_record); }
+
+	item_definition &operator=(const item_definition &other)
+	{
+		add_reference(other.m_record);
+		remove_reference(m_record);
+		m_record = other.m_record;
+		return *this;
+	}
+	item_definition &operator=(item_definition &&other) noexcept
+	{
+		std::swap(m_record, other.m_record);
+		return *this;
+	}
 
 	bool operator<(const item_definition &rhs) const;
 	bool operator!=(const item_definition &rhs) const { return !(*this == rhs); }
-	bool operator==(const item_definition &rhs) const;
+	bool operator==(const item_definition &rhs) const
+	{
+		if (m_record == rhs.m_record)
+		{
+			return true;
+		}
+
+		auto &left  = get_record();
+		auto &right = rhs.get_record();
+
+		if ((left.m_fingerprint != right.m_fingerprint) || (left.m_length != right.m_length))
+		{
+			return false;
+		}
+
+		return have_same_hashes(left, right);
+	}
 
 	[[nodiscard]] item_definition with_name(const std::string &name) const;
 	[[nodiscard]] item_definition with_hash(const hashing::hash &hash) const;
@@ -53,15 +96,33 @@ class item_definition
 	using item_names_set  = std::set<std::string>;
 	using item_hashes_map = std::map<hashing::algorithm, hashing::hash>;
 
-	const item_hashes_map &get_hashes() const { return m_hashes; }
-	const item_names_set &get_names() const { return m_names; }
+	// Builds the hashes on demand; prefer get_hash_data() on hot paths.
+	item_hashes_map get_hashes() const;
+	const item_names_set &get_names() const;
+
+	// The digest for the algorithm, or an empty view if the item has no hash of that type.
+	std::string_view get_hash_data(hashing::algorithm algo) const
+	{
+		auto slot = get_hash_slot(algo);
+		if (slot == c_no_hash_slot)
+		{
+			return {};
+		}
+
+		auto &record = get_record();
+		return std::string_view{record.m_digests[slot].data(), record.m_digest_sizes[slot]};
+	}
 
 	bool has_matching_hash(hashing::hash &hash) const;
-	bool has_matching_name(const std::string &name) const { return m_names.count(name) > 0; }
-	bool has_hash_for_alg(hashing::algorithm algo) const { return m_hashes.count(algo) > 0; }
-	bool has_any_hashes() const { return !m_hashes.empty(); }
+	bool has_matching_name(const std::string &name) const { return get_names().count(name) > 0; }
+	bool has_hash_for_alg(hashing::algorithm algo) const { return !get_hash_data(algo).empty(); }
+	bool has_any_hashes() const { return get_hash_count() > 0; }
+	size_t get_hash_count() const;
+
+	uint64_t size() const { return get_record().m_length; }
 
-	uint64_t size() const { return m_length; }
+	// Computed from the length and hashes only, so equal items have equal fingerprints.
+	uint64_t get_fingerprint() const { return get_record().m_fingerprint; }
 
 	enum class match_result
 	{
@@ -90,10 +151,87 @@ class item_definition
 	static item_definition read(io::sequential::reader &reader, serialization_options options);
 	static item_definition read(io::reader &reader, serialization_options options);
 
+	// The algorithms an item can hold a hash for, in the order used by operator<.
+	static constexpr std::array<hashing::algorithm, 2> c_hash_algorithms{
+		hashing::algorithm::md5, hashing::algorithm::sha256};
+	static constexpr size_t c_max_digest_size = 32;
+
 	private:
-	uint64_t m_length{};
-	item_hashes_map m_hashes{};
-	item_names_set m_names{};
+	static constexpr size_t c_no_hash_slot = c_hash_algorithms.size();
+
+	static constexpr size_t get_hash_slot(hashing::algorithm algo)
+	{
+		for (size_t slot = 0; slot < c_hash_algorithms.size(); slot++)
+		{
+			if (c_hash_algorithms[slot] == algo)
+			{
+				return slot;
+			}
+		}
+		return c_no_hash_slot;
+	}
+
+	static constexpr uint64_t mix_fingerprint(uint64_t value)
+	{
+		value += 0x9e3779b97f4a7c15ull;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+
+	struct record
+	{
+		mutable std::atomic<uint32_t> m_references{1};
+
+		uint64_t m_length{};
+		std::array<std::array<char, c_max_digest_size>, c_hash_algorithms.size()> m_digests{};
+		std::array<uint8_t, c_hash_algorithms.size()> m_digest_sizes{};
+		std::shared_ptr<const item_names_set> m_names;
+
+		// Filled in when the record is interned.
+		uint64_t m_fingerprint{mix_fingerprint(0)};
+		uint64_t m_identity{};
+	};
+
+	// Items of length zero without hashes or names don't need a record.
+	static const record c_empty_record;
+
+	// Takes over a reference the caller already holds.
+	static item_definition adopt(const record *adopted)
+	{
+		item_definition item;
+		item.m_record = adopted;
+		return item;
+	}
+
+	const record &get_record() const { return m_record ? *m_record : c_empty_record; }
+
+	std::unique_ptr<record> copy_record() const;
+	// Returns false if the record already has this hash.
+	static bool set_hash(record &target, hashing::algorithm algorithm, std::string_view hash_data);
+	static void read_hash(io::sequential::reader &reader, record &target);
+	static item_definition intern(std::unique_ptr<record> candidate);
+	static bool have_same_hashes(const record &left, const record &right);
+
+	static void add_reference(const record *target)
+	{
+		if (target)
+		{
+			target->m_references.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	static void remove_reference(const record *target)
+	{
+		if (target && (target->m_references.fetch_sub(1, std::memory_order_acq_rel) == 1))
+		{
+			release(target);
+		}
+	}
+	static void release(const record *target);
+
+	friend struct item_definition_interning;
+
+	const record *m_record{};
 };
 
 item_definition::serialization_options operator|(
@@ -39,22 +39,7 @@ item_definition create_definition_from_reader(io::reader &reader)
 {
 	hashing::hasher hasher(hashing::algorithm::sha256);
 
-	const size_t block_size = 8 * 1024;
-
-	char data[block_size];
-
-	auto remaining = reader.size();
-	uint64_t offset{0};
-
-	while (remaining)
-	{
-		auto to_read = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(data)));
-		reader.read(offset, std::span{data, to_read});
-		hasher.hash_data(std::string_view{data, to_read});
-
-		remaining -= to_read;
-		offset += to_read;
-	}
+	reader.for_each_block(0, reader.size(), [&](std::string_view block) { hasher.hash_data(block); });
 
 	auto hash = hasher.get_hash();
 	return diffs::core::item_definition(reader.size()).with_hash(hash);
@@ -64,20 +49,7 @@ item_definition create_definition_from_sequential_reader(io::sequential::reader
 {
 	hashing::hasher hasher(hashing::algorithm::sha256);
 
-	const size_t block_size = 8 * 1024;
-
-	char data[block_size];
-
-	auto remaining = reader->size();
-
-	while (remaining)
-	{
-		auto to_read = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(data)));
-		reader->read(std::span{data, to_read});
-		hasher.hash_data(std::string_view{data, to_read});
-
-		remaining -= to_read;
-	}
+	reader->for_each_block(reader->size(), [&](std::string_view block) { hasher.hash_data(block); });
 
 	auto hash = hasher.get_hash();
 	return diffs::core::item_definition(reader->size()).with_hash(hash);
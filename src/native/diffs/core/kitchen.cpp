@@ -14,6 +14,16 @@
 #include <io/sequential/basic_writer_wrapper.h>
 
 #include <io/file/temp_file.h>
+#include <io/pipelined_writer.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <set>
+#include <thread>
+#include <tuple>
 
 #include <fmt/format.h>
 
@@ -21,27 +31,33 @@ namespace archive_diff::diffs::core
 {
 //
 // Places a recipe in the cookbook
-// Invalidates 'unreachable' items.
+// Invalidates 'unreachable' items the recipe may make reachable.
 //
 // Acquires and holds m_item_request_mutex
 void kitchen::add_recipe(std::shared_ptr<recipe> &recipe)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
-	m_unreachable_items.clear();
+	invalidate_unreachable(recipe->get_result_item_definition());
 
 	m_cookbook->add_recipe(recipe);
 }
 
 //
 // Adds a pantry to m_all_pantries
-// Invalidates 'unreachable' items.
+// Invalidates 'unreachable' items the pantry's items may make reachable.
 //
 // Acquires and holds m_item_request_mutex
 //
 void kitchen::add_pantry(std::shared_ptr<pantry> &pantry)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
-	m_unreachable_items.clear();
+	if (!m_unreachable_items.empty())
+	{
+		for (auto &[item, prepared] : pantry->get_items())
+		{
+			invalidate_unreachable(item);
+		}
+	}
 
 	m_all_pantries.push_back(pantry);
 }
@@ -55,7 +71,9 @@ void kitchen::add_pantry(std::shared_ptr<pantry> &pantry)
 void kitchen::add_cookbook(std::shared_ptr<cookbook> &cookbook)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
+	// A cookbook may load its recipes lazily, so they aren't enumerated here.
 	m_unreachable_items.clear();
+	m_unreachable_dependents.clear();
 
 	m_all_cookbooks.push_back(cookbook);
 }
@@ -87,6 +105,9 @@ void kitchen::request_item(const item_definition &item)
 // them into m_ready_items. any items that are not able to be prepared
 // will be within m_unreachable_items.
 //
+// m_unreachable_items is kept from earlier calls; anything that changed
+// since then has already invalidated the entries it affects.
+//
 // After this call has finished, the user may expect to get results from
 // can_fetch_item(); any entries in m_ready_items will yield 'true',
 // while any entries in m_unreachable_items will yield 'false.'
@@ -101,15 +122,25 @@ bool kitchen::process_requested_items(bool select_recipes_only, std::set<core::i
 
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
 
-	m_unreachable_items.clear();
+	if (!m_unreachable_items.empty())
+	{
+		for (auto &mocked : mocked_items)
+		{
+			invalidate_unreachable(mocked);
+		}
+	}
+
+	// We only select recipes while walking the requests and then prepare the selected
+	// graph afterwards, so we know how many consumers each item has before preparing it.
+	bool prepare_selected = !select_recipes_only;
+
+	std::vector<item_definition> selected_items;
 
 	for (auto itr = m_requested_items.begin(); itr != m_requested_items.end();)
 	{
-		std::set<item_definition> already_using;
-		if (!make_dependency_ready(*itr, select_recipes_only, mocked_items, already_using))
+		if (!make_dependency_ready(*itr, mocked_items))
 		{
 			all_requests_fulfilled = false;
-			m_unreachable_items.insert(*itr);
 
 			// for (auto &cookbook : m_all_cookbooks)
 			//{
@@ -120,10 +151,20 @@ bool kitchen::process_requested_items(bool select_recipes_only, std::set<core::i
 		}
 		else
 		{
+			m_planned_requests.insert(*itr);
+			if (prepare_selected)
+			{
+				selected_items.push_back(*itr);
+			}
 			itr = m_requested_items.erase(itr);
 		}
 	}
 
+	if (prepare_selected)
+	{
+		prepare_selected_items(selected_items, mocked_items);
+	}
+
 	return all_requests_fulfilled;
 }
 
@@ -133,113 +174,572 @@ bool kitchen::process_requested_items()
 	return process_requested_items(false, mocked_items);
 }
 
-bool kitchen::make_dependency_ready(
-	const item_definition &item,
-	bool select_recipes_only,
-	std::set<item_definition> &mocked_items,
-	std::set<item_definition> &already_using)
+// True if looking 'item' up in a pantry or cookbook could find something added as 'added'.
+static bool could_be_found_as(
+	const item_definition &item, const item_definition &added, const item_definition::item_names_set &added_names)
 {
-	if (mocked_items.contains(item))
+	if (item.size() == added.size())
 	{
-		return true;
+		for (auto algorithm : item_definition::c_hash_algorithms)
+		{
+			auto hash_data = item.get_hash_data(algorithm);
+			if (!hash_data.empty() && (hash_data == added.get_hash_data(algorithm)))
+			{
+				return true;
+			}
+		}
 	}
 
-	if (m_selected_recipes.contains(item))
+	for (auto &name : added_names)
 	{
-		return true;
+		if (item.has_matching_name(name))
+		{
+			return true;
+		}
 	}
 
-	if (m_ready_items.contains(item))
+	return false;
+}
+
+void kitchen::invalidate_unreachable(const item_definition &added)
+{
+	if (m_unreachable_items.empty())
 	{
-		return true;
+		return;
 	}
 
-	if (m_unreachable_items.contains(item))
+	std::vector<item_definition> to_invalidate;
+
+	// Lookups by hash only find items of the same size, and those are adjacent in the set.
+	// Lookups by name can find an item of any size.
+	auto &added_names = added.get_names();
+	auto itr = added_names.empty() ? m_unreachable_items.lower_bound(item_definition{added.size()})
+	                               : m_unreachable_items.begin();
+	for (; itr != m_unreachable_items.end(); itr++)
 	{
-		ADU_LOG("Item already determined unreachable: {}", item);
-		return false;
+		if (added_names.empty() && (itr->size() != added.size()))
+		{
+			break;
+		}
+
+		if (could_be_found_as(*itr, added, added_names))
+		{
+			to_invalidate.push_back(*itr);
+		}
 	}
 
-	for (auto &pantry : m_all_pantries)
+	while (!to_invalidate.empty())
 	{
-		std::shared_ptr<prepared_item> from_pantry;
-		if (pantry->find(item, &from_pantry))
+		auto item = std::move(to_invalidate.back());
+		to_invalidate.pop_back();
+
+		m_unreachable_items.erase(item);
+
+		// Extracting the entry also stops the walk if the dependents form a cycle.
+		auto dependents = m_unreachable_dependents.extract(item);
+		if (dependents)
 		{
-			m_ready_items.insert(std::pair{item, from_pantry});
-			return true;
+			to_invalidate.insert(to_invalidate.end(), dependents.mapped().begin(), dependents.mapped().end());
 		}
 	}
+}
 
-	// Only check this after we've looked in the pantry to allow us to
-	// use the pantry multiple times when only selecting recipes.
-	if (already_using.contains(item))
+bool kitchen::make_dependency_ready(const item_definition &item, std::set<item_definition> &mocked_items)
+{
+	enum class item_status
 	{
+		ready,
+		unreachable,
+		unplanned,
+	};
+
+	std::vector<planning_frame> stack;
+	std::map<item_definition, size_t> planning_depths;
+	// Items that failed while an item they needed was being planned, with the depth of the
+	// shallowest such item. They're resolved once that item is.
+	std::map<item_definition, size_t> waiting_items;
+
+	// Doesn't plan anything; *cycle_depth is set when an unreachable result may change once
+	// the item at that depth has been planned.
+	auto get_status = [&](const item_definition &to_check, size_t *cycle_depth) {
+		if (mocked_items.contains(to_check) || m_selected_recipes.contains(to_check)
+		    || m_ready_items.contains(to_check))
+		{
+			return item_status::ready;
+		}
+
+		if (m_unreachable_items.contains(to_check))
+		{
+			ADU_LOG("Item already determined unreachable: {}", to_check);
+			return item_status::unreachable;
+		}
+
+		for (auto &pantry : m_all_pantries)
+		{
+			std::shared_ptr<prepared_item> from_pantry;
+			if (pantry->find(to_check, &from_pantry))
+			{
+				m_ready_items.insert(to_check, from_pantry);
+				return item_status::ready;
+			}
+		}
+
+		// Only check these after we've looked in the pantry to allow us to
+		// use the pantry multiple times when only selecting recipes.
+		if (auto planning = planning_depths.find(to_check); planning != planning_depths.end())
+		{
+			*cycle_depth = planning->second;
+			return item_status::unreachable;
+		}
+
+		if (auto waiting = waiting_items.find(to_check); waiting != waiting_items.end())
+		{
+			*cycle_depth = waiting->second;
+			return item_status::unreachable;
+		}
+
+		return item_status::unplanned;
+	};
+
+	auto push_frame = [&](const item_definition &to_plan) {
+		planning_frame frame;
+		frame.m_item = to_plan;
+
+		for (auto &cookbook : m_all_cookbooks)
+		{
+			const recipe_set *recipes_for_item;
+			if (cookbook->find_recipes_for_item(to_plan, &recipes_for_item))
+			{
+				frame.m_recipes.insert(frame.m_recipes.end(), recipes_for_item->begin(), recipes_for_item->end());
+			}
+		}
+
+		planning_depths[to_plan] = stack.size();
+		stack.push_back(std::move(frame));
+	};
+
+	auto fail_recipe = [](planning_frame &frame, const item_definition &ingredient, size_t cycle_depth) {
+		ADU_LOG("Found impossible item {}, for: {}", ingredient, frame.m_item);
+
+		frame.m_cycle_depth = std::min(frame.m_cycle_depth, cycle_depth);
+		frame.m_missing_ingredients.push_back(ingredient);
+		frame.m_recipe_index++;
+		frame.m_ingredient_index = 0;
+	};
+
+	size_t top_cycle_depth = std::numeric_limits<size_t>::max();
+	switch (get_status(item, &top_cycle_depth))
+	{
+	case item_status::ready:
+		return true;
+	case item_status::unreachable:
 		return false;
+	case item_status::unplanned:
+		break;
 	}
-	else
+
+	push_frame(item);
+
+	while (true)
+	{
+		auto &frame = stack.back();
+
+		if (frame.m_recipe_index < frame.m_recipes.size())
+		{
+			auto &recipe      = frame.m_recipes[frame.m_recipe_index];
+			auto &ingredients = recipe->get_item_ingredients();
+
+			if (frame.m_ingredient_index < ingredients.size())
+			{
+				auto &ingredient   = ingredients[frame.m_ingredient_index];
+				size_t cycle_depth = std::numeric_limits<size_t>::max();
+
+				switch (get_status(ingredient, &cycle_depth))
+				{
+				case item_status::ready:
+					frame.m_ingredient_index++;
+					break;
+				case item_status::unreachable:
+					fail_recipe(frame, ingredient, cycle_depth);
+					break;
+				case item_status::unplanned:
+					push_frame(ingredient);
+					break;
+				}
+				continue;
+			}
+
+			auto plan = plan_recipe(*recipe);
+			if (!frame.m_cheapest || (plan.m_total_cost < frame.m_cheapest_plan.m_total_cost))
+			{
+				frame.m_cheapest      = recipe;
+				frame.m_cheapest_plan = std::move(plan);
+			}
+
+			frame.m_recipe_index++;
+			frame.m_ingredient_index = 0;
+			continue;
+		}
+
+		// Every recipe for the item has been tried.
+		auto finished = std::move(frame);
+		stack.pop_back();
+		planning_depths.erase(finished.m_item);
+
+		auto depth = stack.size();
+		bool made  = finished.m_cheapest != nullptr;
+
+		if (made)
+		{
+			m_selected_recipes[finished.m_item] = finished.m_cheapest;
+			m_planned_staging.insert(
+				finished.m_cheapest_plan.m_staged_ingredients.begin(),
+				finished.m_cheapest_plan.m_staged_ingredients.end());
+			m_planned_items[finished.m_item] = std::move(finished.m_cheapest_plan);
+
+			// Items that failed because this one was being planned may be reachable now.
+			for (auto &waiting : finished.m_waiting_on_this)
+			{
+				waiting_items.erase(waiting);
+			}
+		}
+		else
+		{
+			ADU_LOG("Couldn't make dependency: {}", finished.m_item);
+
+			for (auto &ingredient : finished.m_missing_ingredients)
+			{
+				m_unreachable_dependents[ingredient].push_back(finished.m_item);
+			}
+
+			finished.m_waiting_on_this.push_back(finished.m_item);
+
+			if (finished.m_cycle_depth >= depth)
+			{
+				// Nothing planned above this item was needed, so it and everything waiting on it
+				// can't be made until something is added to the kitchen.
+				finished.m_cycle_depth = std::numeric_limits<size_t>::max();
+				for (auto &waiting : finished.m_waiting_on_this)
+				{
+					waiting_items.erase(waiting);
+					m_unreachable_items.insert(waiting);
+				}
+			}
+			else
+			{
+				auto &waiting_on = stack[finished.m_cycle_depth].m_waiting_on_this;
+				for (auto &waiting : finished.m_waiting_on_this)
+				{
+					waiting_items[waiting] = finished.m_cycle_depth;
+					waiting_on.push_back(waiting);
+				}
+			}
+		}
+
+		if (stack.empty())
+		{
+			return made;
+		}
+
+		auto &parent = stack.back();
+		if (made)
+		{
+			parent.m_ingredient_index++;
+		}
+		else
+		{
+			fail_recipe(parent, finished.m_item, finished.m_cycle_depth);
+		}
+	}
+}
+
+kitchen::planned_item kitchen::plan_recipe(const recipe &recipe)
+{
+	auto cost  = recipe.get_cost();
+	auto &item = recipe.get_result_item_definition();
+
+	planned_item plan;
+	plan.m_recipe_cost = cost.m_cpu_per_byte * item.size();
+
+	if (cost.m_temp_storage)
 	{
-		already_using.insert(item);
+		plan.m_recipe_cost += recipe_cost::c_temp_storage_per_byte * item.size();
+		plan.m_temp_bytes += item.size();
 	}
 
-	for (auto &cookbook : m_all_cookbooks)
+	bool streamed_ingredient{false};
+
+	for (auto &ingredient : recipe.get_item_ingredients())
 	{
-		const recipe_set *recipes_for_item;
-		if (!cookbook->find_recipes_for_item(item, &recipes_for_item))
+		auto ingredient_plan = get_planned_item(ingredient);
+		plan.m_total_cost += ingredient_plan.m_total_cost;
+		plan.m_temp_bytes += ingredient_plan.m_temp_bytes;
+
+		if (!ingredient_plan.m_stream)
+		{
+			continue;
+		}
+
+		if (!cost.m_random_access_ingredients)
 		{
+			streamed_ingredient = true;
 			continue;
 		}
 
-		for (auto &recipe : *recipes_for_item)
+		if (!m_planned_staging.contains(ingredient))
 		{
-			bool found_impossible_ingredient{false};
-			item_definition impossible_item;
+			plan.m_recipe_cost += recipe_cost::c_temp_storage_per_byte * ingredient.size();
+			plan.m_temp_bytes += ingredient.size();
+			plan.m_staged_ingredients.push_back(ingredient);
+		}
+	}
 
-			std::vector<std::shared_ptr<prepared_item>> prepared_ingredients;
+	plan.m_total_cost += plan.m_recipe_cost;
 
-			auto &ingredients = recipe->get_item_ingredients();
+	if (!cost.m_temp_storage)
+	{
+		plan.m_stream = (cost.m_production == recipe_cost::production::decompress) || streamed_ingredient;
+	}
+
+	return plan;
+}
+
+kitchen::planned_item kitchen::get_planned_item(const item_definition &item)
+{
+	auto found = m_planned_items.find(item);
+	if (found != m_planned_items.end())
+	{
+		return found->second;
+	}
+
+	// Items that are already available cost nothing more to use. Mocked items are
+	// assumed to be readable.
+	planned_item available;
+
+	auto ready = m_ready_items.find(item);
+	if ((ready != nullptr) && *ready)
+	{
+		available.m_stream = !(*ready)->can_make_reader();
+	}
+	return available;
+}
+
+struct preparation_node
+{
+	std::shared_ptr<recipe> m_recipe;
+	size_t m_pending_ingredients{0};
+	std::vector<item_definition> m_dependents;
+
+	// How many times the item is read: once for each use as an ingredient and once more
+	// if it was requested.
+	size_t m_consumers{0};
+
+	// Uses as an ingredient by items that haven't been prepared yet.
+	size_t m_unprepared_consumers{0};
+	bool m_requested{false};
+};
+
+void kitchen::prepare_selected_items(
+	const std::vector<item_definition> &items, std::set<item_definition> &mocked_items)
+{
+	// Build the graph of items that still need to be prepared. Edges point from
+	// an ingredient to the items that consume it.
+	std::map<item_definition, preparation_node> graph;
+	std::vector<item_definition> to_visit{items};
+
+	while (!to_visit.empty())
+	{
+		auto item = to_visit.back();
+		to_visit.pop_back();
+
+		if (mocked_items.contains(item) || m_ready_items.contains(item) || graph.contains(item))
+		{
+			continue;
+		}
+
+		if (!m_selected_recipes.contains(item))
+		{
+			throw errors::user_exception(
+				errors::error_code::diffs_kitchen_no_selected_recipes,
+				fmt::format("kitchen::prepare_selected_items: No selected recipe for: {}", item));
+		}
+
+		auto &node    = graph[item];
+		node.m_recipe = m_selected_recipes[item];
+
+		for (auto &ingredient : node.m_recipe->get_item_ingredients())
+		{
+			to_visit.push_back(ingredient);
+		}
+	}
+
+	for (auto &[item, node] : graph)
+	{
+		for (auto &ingredient : node.m_recipe->get_item_ingredients())
+		{
+			auto ingredient_itr = graph.find(ingredient);
+			if (ingredient_itr == graph.end())
+			{
+				continue;
+			}
+
+			node.m_pending_ingredients++;
+			ingredient_itr->second.m_dependents.push_back(item);
+			ingredient_itr->second.m_consumers++;
+			ingredient_itr->second.m_unprepared_consumers++;
+		}
+	}
+
+	if (graph.empty())
+	{
+		return;
+	}
+
+	for (auto &item : items)
+	{
+		auto requested_itr = graph.find(item);
+		if (requested_itr != graph.end())
+		{
+			requested_itr->second.m_consumers++;
+			requested_itr->second.m_requested = true;
+		}
+	}
+
+	uint64_t shared_reader_window_size = m_shared_reader_window_size;
+	bool release_dead_items            = m_release_dead_items;
+
+	std::mutex schedule_mutex;
+	std::condition_variable schedule_cv;
+	std::deque<item_definition> ready_to_prepare;
+	size_t remaining = graph.size();
+	std::exception_ptr failure;
+
+	for (auto &[item, node] : graph)
+	{
+		if (node.m_pending_ingredients == 0)
+		{
+			ready_to_prepare.push_back(item);
+		}
+	}
+
+	auto worker = [&]() {
+		while (true)
+		{
+			item_definition item;
+			std::shared_ptr<recipe> recipe;
+			size_t consumers{};
+			std::vector<std::shared_ptr<prepared_item>> prepared_ingredients;
 
-			for (auto &ingredient : ingredients)
 			{
-				if (!make_dependency_ready(ingredient, select_recipes_only, mocked_items, already_using))
+				std::unique_lock<std::mutex> lock(schedule_mutex);
+				schedule_cv.wait(lock, [&] { return !ready_to_prepare.empty() || remaining == 0 || failure; });
+
+				if (remaining == 0 || failure)
 				{
-					impossible_item = ingredient;
+					return;
+				}
 
-					ADU_LOG("Found impossible item {}, for: {}", ingredient, item);
+				item = ready_to_prepare.front();
+				ready_to_prepare.pop_front();
 
-					found_impossible_ingredient = true;
-					break;
+				recipe    = graph[item].m_recipe;
+				consumers = graph[item].m_consumers;
+				for (auto &ingredient : recipe->get_item_ingredients())
+				{
+					prepared_ingredients.push_back(m_ready_items[ingredient]);
 				}
-				prepared_ingredients.push_back(m_ready_items[ingredient]);
 			}
 
-			if (found_impossible_ingredient)
+			try
 			{
-				for (auto &ingredient : ingredients)
+				auto from_recipe = prepare_from_recipe(recipe, prepared_ingredients);
+
+				// Done before any consumer is prepared, as those may start reading right away.
+				if ((consumers > 1) && (shared_reader_window_size > 0))
 				{
-					if (ingredient == impossible_item)
+					from_recipe->share_sequential_reader(consumers, shared_reader_window_size);
+				}
+
+				std::lock_guard<std::mutex> lock(schedule_mutex);
+				m_ready_items.insert(item, from_recipe);
+				remaining--;
+
+				for (auto &dependent : graph[item].m_dependents)
+				{
+					if (--graph[dependent].m_pending_ingredients == 0)
 					{
-						break;
+						ready_to_prepare.push_back(dependent);
 					}
-					already_using.erase(ingredient);
 				}
-				continue;
-			}
 
-			m_selected_recipes[item] = recipe;
+				// Consumers hold on to what they need, so once the last one is prepared
+				// the kitchen no longer has to.
+				for (auto &ingredient : recipe->get_item_ingredients())
+				{
+					auto ingredient_itr = graph.find(ingredient);
+					if (ingredient_itr == graph.end())
+					{
+						continue;
+					}
 
-			if (!select_recipes_only)
+					auto &ingredient_node = ingredient_itr->second;
+					if ((--ingredient_node.m_unprepared_consumers == 0) && !ingredient_node.m_requested
+					    && release_dead_items)
+					{
+						release_item(ingredient);
+					}
+				}
+			}
+			catch (...)
 			{
-				auto from_recipe = recipe->prepare(this, prepared_ingredients);
-				m_ready_items.insert(std::pair{item, from_recipe});
+				std::lock_guard<std::mutex> lock(schedule_mutex);
+				failure = std::current_exception();
 			}
 
-			return true;
+			schedule_cv.notify_all();
 		}
+	};
+
+	auto thread_count = std::min<size_t>(m_preparation_thread_count, graph.size());
+	ADU_LOG("kitchen::prepare_selected_items: Preparing {} items using {} threads.", graph.size(), thread_count);
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < thread_count; i++)
+	{
+		workers.emplace_back(worker);
 	}
 
-	ADU_LOG("Couldn't make dependency: {}", item);
+	// The calling thread works through the graph as well.
+	worker();
 
-	return false;
+	for (auto &thread : workers)
+	{
+		thread.join();
+	}
+
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+}
+
+void kitchen::release_item(const item_definition &item)
+{
+	m_ready_items.erase(item);
+
+	std::lock_guard<std::mutex> lock(m_pantry_mutex);
+
+	auto staged_itr = m_staged_items.find(item);
+	if (staged_itr == m_staged_items.end())
+	{
+		return;
+	}
+
+	if (auto staged = staged_itr->second.lock())
+	{
+		m_pantry->remove(staged);
+	}
+	m_staged_items.erase(staged_itr);
 }
 
 // Looks at m_ready_items. If the item is present, will  return the contained
@@ -250,14 +750,15 @@ std::shared_ptr<prepared_item> kitchen::fetch_item(const item_definition &item)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
 
-	if (m_ready_items.count(item) == 0)
+	auto ready_item = m_ready_items.find(item);
+	if (ready_item == nullptr)
 	{
 		throw errors::user_exception(
 			errors::error_code::diffs_kitchen_item_not_ready_to_fetch,
 			fmt::format("kitchen::fetch_item: Item not ready: {}", item));
 	}
 
-	return m_ready_items[item];
+	return *ready_item;
 }
 
 // Looks at m_ready_items. If the item is present, will return true,
@@ -267,7 +768,7 @@ std::shared_ptr<prepared_item> kitchen::fetch_item(const item_definition &item)
 bool kitchen::can_fetch_item(const item_definition &item)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
-	return m_ready_items.count(item) > 0;
+	return m_ready_items.contains(item);
 }
 
 //
@@ -300,13 +801,13 @@ bool kitchen::can_fetch_selected_recipe(const item_definition &item)
 }
 
 // Places an item in m_ready_items
-// Invalidates 'unreachable' items.
+// Invalidates 'unreachable' items the item may make reachable.
 //
 // Acquires and holds m_item_request_mutex
 void kitchen::store_item(std::shared_ptr<prepared_item> &prepared)
 {
 	std::lock_guard<std::mutex> lock(m_item_request_mutex);
-	m_unreachable_items.clear();
+	invalidate_unreachable(prepared->get_item_definition());
 
 	m_pantry->add(prepared);
 }
@@ -343,44 +844,253 @@ void kitchen::write_item(io::writer &writer, const item_definition &item)
 	auto prep_result = fetch_item(item);
 	ADU_LOG("prep_result: {}", *prep_result);
 
-	auto sequential_reader = prep_result->make_sequential_reader();
+	std::optional<read_ahead> ahead;
+	if (uint64_t window_size = m_read_ahead_window_size; window_size != 0)
+	{
+		ahead.emplace(get_planned_reads(item), window_size);
+		ahead->advance(0);
+	}
 
-	auto remaining = sequential_reader->size();
+	auto start = apply_profiler::clock::now();
+	write_prepared_item(writer, prep_result, ahead ? &ahead.value() : nullptr);
+	if (ahead)
+	{
+		ahead->finish();
+	}
+	run_deferred_verifications();
+	if (m_profiler)
+	{
+		m_profiler->record_write(item.size(), start, apply_profiler::clock::now());
+	}
+}
 
-	const size_t block_size = 8 * 1024;
-	char data[block_size];
-	uint64_t offset{0};
+void kitchen::write_prepared_item(
+	io::writer &writer, std::shared_ptr<prepared_item> &prep_result, read_ahead *ahead)
+{
 
-	while (remaining)
+	// Non-owning, the caller keeps the writer alive for the duration of the call.
+	std::shared_ptr<io::writer> writer_ptr(std::shared_ptr<io::writer>{}, &writer);
+
+	std::shared_ptr<io::pipelined_writer> pipelined;
+	if (size_t pipeline_depth = m_write_pipeline_depth; pipeline_depth != 0)
 	{
-		auto to_read = static_cast<size_t>(std::min<uint64_t>(block_size, remaining));
-		sequential_reader->read(std::span<char>{data, to_read});
-		writer.write(offset, std::string_view{data, to_read});
+		pipelined = std::make_shared<io::pipelined_writer>(
+			writer_ptr, io::pipelined_writer::c_default_buffer_size, pipeline_depth);
+		writer_ptr = pipelined;
+	}
+
+	// Reads follow what's been produced, rather than what the pipeline has written out.
+	if (ahead)
+	{
+		writer_ptr = std::make_shared<read_ahead_writer>(writer_ptr, *ahead);
+	}
 
-		remaining -= to_read;
-		offset += to_read;
+	prep_result->write(writer_ptr, m_verify_written_items);
+	if (pipelined)
+	{
+		pipelined->flush();
 	}
 }
 
+void kitchen::add_deferred_verification(std::function<void()> verification)
+{
+	std::lock_guard<std::mutex> lock(m_deferred_verification_mutex);
+	m_deferred_verifications.push_back(std::move(verification));
+}
+
+void kitchen::run_deferred_verifications()
+{
+	std::vector<std::function<void()>> verifications;
+	{
+		std::lock_guard<std::mutex> lock(m_deferred_verification_mutex);
+		verifications = m_deferred_verifications;
+	}
+
+	// Verifications remember their result, so running them again after each item is cheap.
+	for (auto &verification : verifications)
+	{
+		verification();
+	}
+}
+
+std::vector<read_ahead::range> kitchen::get_planned_reads(const item_definition &item)
+{
+	std::lock_guard<std::mutex> lock(m_item_request_mutex);
+
+	// Bytes [m_offset, m_offset + m_length) of m_item are read while the output's
+	// [m_needed_from, m_needed_until) is produced.
+	struct pending_read
+	{
+		item_definition m_item;
+		uint64_t m_offset{};
+		uint64_t m_length{};
+		uint64_t m_needed_from{};
+		uint64_t m_needed_until{};
+	};
+
+	std::vector<read_ahead::range> ranges;
+	std::map<item_definition, std::optional<io::reader>> stored_readers;
+	std::set<std::tuple<item_definition, uint64_t, uint64_t>> visited;
+
+	std::vector<pending_read> to_visit{pending_read{item, 0, item.size(), 0, item.size()}};
+	while (!to_visit.empty())
+	{
+		auto read = std::move(to_visit.back());
+		to_visit.pop_back();
+
+		if ((read.m_length == 0) || !visited.insert(std::tuple{read.m_item, read.m_offset, read.m_length}).second)
+		{
+			continue;
+		}
+
+		auto selected = m_selected_recipes.find(read.m_item);
+		if (selected == m_selected_recipes.end())
+		{
+			auto ready = m_ready_items.find(read.m_item);
+			if ((ready == nullptr) || !*ready)
+			{
+				continue;
+			}
+
+			auto stored = stored_readers.find(read.m_item);
+			if (stored == stored_readers.end())
+			{
+				stored = stored_readers.emplace(read.m_item, (*ready)->try_make_stored_reader()).first;
+			}
+
+			if (stored->second.has_value())
+			{
+				ranges.push_back(read_ahead::range{
+					.m_reader       = stored->second.value(),
+					.m_source       = ready->get(),
+					.m_offset       = read.m_offset,
+					.m_length       = read.m_length,
+					.m_needed_from  = read.m_needed_from,
+					.m_needed_until = read.m_needed_until});
+			}
+			continue;
+		}
+
+		// Where in the output a byte of this item is produced, assuming it's produced evenly.
+		auto scale       = static_cast<double>(read.m_needed_until - read.m_needed_from) / read.m_length;
+		auto output_from = [&](uint64_t item_offset) {
+			return read.m_needed_from + static_cast<uint64_t>((item_offset - read.m_offset) * scale);
+		};
+
+		auto &ingredients = selected->second->get_item_ingredients();
+		auto reads        = selected->second->get_ingredient_reads();
+		for (size_t i = 0; i < ingredients.size(); i++)
+		{
+			auto &ingredient_read = reads[i];
+
+			// Only the part of the result within this read matters.
+			auto result_end = ingredient_read.m_result_offset + ingredient_read.m_result_length;
+			auto begin      = std::max(ingredient_read.m_result_offset, read.m_offset);
+			auto end        = std::min(result_end, read.m_offset + read.m_length);
+			if (begin >= end)
+			{
+				continue;
+			}
+
+			pending_read ingredient{
+				.m_item         = ingredients[i],
+				.m_offset       = ingredient_read.m_offset,
+				.m_length       = ingredient_read.m_length,
+				.m_needed_from  = output_from(begin),
+				.m_needed_until = output_from(end)};
+
+			if (ingredient_read.m_in_order)
+			{
+				ingredient.m_offset += begin - ingredient_read.m_result_offset;
+				ingredient.m_length  = std::min(end - begin, ingredient_read.m_length);
+			}
+
+			to_visit.push_back(std::move(ingredient));
+		}
+	}
+
+	return ranges;
+}
+
 void kitchen::save_selected_recipes(std::shared_ptr<io::writer> &writer) const
 {
 	io::sequential::basic_writer_wrapper seq_writer(writer);
 
+	// Recipes were also selected for ingredients of the alternatives that weren't chosen;
+	// only the ones the requested items need are part of the plan.
+	std::set<item_definition> in_plan;
+	std::vector<item_definition> to_visit(m_planned_requests.begin(), m_planned_requests.end());
+	while (!to_visit.empty())
+	{
+		auto item = to_visit.back();
+		to_visit.pop_back();
+
+		auto selected = m_selected_recipes.find(item);
+		if ((selected == m_selected_recipes.end()) || !in_plan.insert(item).second)
+		{
+			continue;
+		}
+
+		auto &ingredients = selected->second->get_item_ingredients();
+		to_visit.insert(to_visit.end(), ingredients.begin(), ingredients.end());
+	}
+
 	Json::Value recipe_list;
-	Json::Value recipes;
+	Json::Value recipes(Json::arrayValue);
+	double total_cost{};
 
 	for (const auto &[result, recipe] : m_selected_recipes)
 	{
-		recipes.append(recipe->to_json());
+		if (!in_plan.contains(result))
+		{
+			continue;
+		}
+
+		auto recipe_json = recipe->to_json();
+
+		auto planned = m_planned_items.find(result);
+		if (planned != m_planned_items.end())
+		{
+			Json::Value estimate;
+			estimate["Recipe"]    = planned->second.m_recipe_cost;
+			estimate["Total"]     = planned->second.m_total_cost;
+			estimate["TempBytes"] = static_cast<Json::UInt64>(planned->second.m_temp_bytes);
+
+			recipe_json["EstimatedCost"] = estimate;
+
+			if (m_planned_requests.contains(result))
+			{
+				total_cost += planned->second.m_total_cost;
+			}
+		}
+
+		recipes.append(recipe_json);
 	}
 
-	recipe_list["Recipes"] = recipes;
+	recipe_list["Recipes"]            = recipes;
+	recipe_list["EstimatedTotalCost"] = total_cost;
 
 	auto json_text = recipe_list.toStyledString();
 
 	seq_writer.write_text(json_text);
 }
 
+std::shared_ptr<prepared_item> kitchen::prepare_from_recipe(
+	const std::shared_ptr<recipe> &recipe, std::vector<std::shared_ptr<prepared_item>> &ingredients)
+{
+	if (!m_profiler)
+	{
+		return recipe->prepare(this, ingredients);
+	}
+
+	auto start       = apply_profiler::clock::now();
+	auto from_recipe = recipe->prepare(this, ingredients);
+	m_profiler->record_prepare(recipe->get_recipe_name(), start, apply_profiler::clock::now());
+
+	from_recipe->profile_sequential_reader(*m_profiler, recipe->get_recipe_name());
+	return from_recipe;
+}
+
 std::shared_ptr<prepared_item> kitchen::prepare_as_reader(std::shared_ptr<prepared_item> &to_prepare)
 {
 	if (to_prepare->can_make_reader())
@@ -391,15 +1101,19 @@ std::shared_ptr<prepared_item> kitchen::prepare_as_reader(std::shared_ptr<prepar
 
 	auto required_item = to_prepare->get_item_definition();
 
-	for (const auto &pantry : m_all_pantries)
 	{
-		std::shared_ptr<prepared_item> pantry_item;
+		std::lock_guard<std::mutex> lock(m_pantry_mutex);
 
-		if (pantry->find(required_item, &pantry_item))
+		for (const auto &pantry : m_all_pantries)
 		{
-			if (pantry_item->can_make_reader())
+			std::shared_ptr<prepared_item> pantry_item;
+
+			if (pantry->find(required_item, &pantry_item))
 			{
-				return pantry_item;
+				if (pantry_item->can_make_reader())
+				{
+					return pantry_item;
+				}
 			}
 		}
 	}
@@ -433,29 +1147,61 @@ std::shared_ptr<prepared_item> kitchen::store_item_as_buffer(std::shared_ptr<pre
 
 	auto reader = io::buffer::io_device::make_reader(result_buffer, io::buffer::io_device::size_kind::vector_size);
 
-	auto buffer_prepared_item = std::make_shared<prepared_item>(required_item, reader);
-	m_pantry->add(buffer_prepared_item);
-
-	return buffer_prepared_item;
+	return add_staged_item(required_item, reader);
 }
 
 std::shared_ptr<prepared_item> kitchen::store_item_as_temp_file(std::shared_ptr<prepared_item> &to_prepare)
 {
-	auto temp_file  = std::make_shared<io::file::temp_file>();
-	auto seq_reader = to_prepare->make_sequential_reader();
-
 	auto required_item = to_prepare->get_item_definition();
 
-	io::shared_writer writer = std::make_shared<io::file::temp_file_writer>(temp_file);
-	io::sequential::basic_writer_wrapper wrapper(writer);
-	wrapper.write(*seq_reader);
+	io::reader reader;
+	if (to_prepare->is_shared_sequential_reader())
+	{
+		// Stages into the shared reader's own spill file, rather than reading it as one
+		// more consumer and writing a second copy.
+		reader = to_prepare->make_reader();
+	}
+	else
+	{
+		auto temp_file  = std::make_shared<io::file::temp_file>();
+		auto seq_reader = to_prepare->make_sequential_reader();
+
+		io::shared_writer writer = std::make_shared<io::file::temp_file_writer>(temp_file);
+		io::sequential::basic_writer_wrapper wrapper(writer);
+		wrapper.write(*seq_reader);
+
+		reader = io::file::temp_file_io_device::make_reader(temp_file);
+	}
+
+	if (m_profiler)
+	{
+		reader = m_profiler->wrap_reader(reader, apply_profiler::read_origin::temp);
+	}
 
-	auto reader = io::file::temp_file_io_device::make_reader(temp_file);
+	return add_staged_item(required_item, reader);
+}
 
-	auto temp_file_prepared_item = std::make_shared<prepared_item>(required_item, reader);
-	m_pantry->add(temp_file_prepared_item);
+std::shared_ptr<prepared_item> kitchen::add_staged_item(const item_definition &item, io::reader &reader)
+{
+	auto usage = m_intermediate_usage;
+	auto size  = item.size();
+
+	usage->add(size);
+	std::shared_ptr<prepared_item> staged(
+		new prepared_item(item, reader),
+		[usage, size](prepared_item *to_delete)
+		{
+			usage->remove(size);
+			delete to_delete;
+		});
+
+	{
+		std::lock_guard<std::mutex> lock(m_pantry_mutex);
+		m_pantry->add(staged);
+		m_staged_items[item] = staged;
+	}
 
-	return temp_file_prepared_item;
+	return staged;
 }
 
 } // namespace archive_diff::diffs::core
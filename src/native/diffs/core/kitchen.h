@@ -6,19 +6,26 @@
  */
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <memory>
 
 #include <optional>
 
+#include "apply_profiler.h"
+#include "hash_index.h"
 #include "item_definition.h"
 #include "prepared_item.h"
 #include "pantry.h"
+#include "read_ahead.h"
 #include "cookbook.h"
 #include "slicer.h"
 #include "recipe.h"
 #include "recipe_template.h"
+#include "tee_reader_factory.h"
 
 namespace archive_diff::diffs::core
 {
@@ -36,7 +43,7 @@ class kitchen : public std::enable_shared_from_this<kitchen>
 
 	//
 	// Places an item in the pantry
-	// Invalidates 'unreachable' items.
+	// Invalidates 'unreachable' items the item may make reachable.
 	//
 	// Acquires and holds m_item_request_mutex
 	void store_item(std::shared_ptr<prepared_item> &prepared);
@@ -50,14 +57,14 @@ class kitchen : public std::enable_shared_from_this<kitchen>
 
 	//
 	// Places a recipe in the cookbook
-	// Invalidates 'unreachable' items.
+	// Invalidates 'unreachable' items the recipe may make reachable.
 	//
 	// Acquires and holds m_item_request_mutex
 	void add_recipe(std::shared_ptr<recipe> &recipe);
 
 	//
 	// Adds a pantry to m_all_pantries
-	// Invalidates 'unreachable' items.
+	// Invalidates 'unreachable' items the pantry's items may make reachable.
 	//
 	// Acquires and holds m_item_request_mutex
 	//
@@ -84,6 +91,37 @@ class kitchen : public std::enable_shared_from_this<kitchen>
 	// Acquires and holds m_item_request_mutex
 	void request_item(const item_definition &item);
 
+	//
+	// Sets the number of threads used to prepare items when processing
+	// requested items. A value of 0 or 1 prepares every item on the calling
+	// thread, in dependency order.
+	//
+	// Recipes are first selected for every requested item and the resulting
+	// dependency graph is then prepared. When more than one thread is requested
+	// the graph is prepared by a pool of worker threads; independent ingredient
+	// subtrees are prepared concurrently.
+	void set_preparation_thread_count(uint32_t thread_count) { m_preparation_thread_count = thread_count; }
+	uint32_t get_preparation_thread_count() const { return m_preparation_thread_count; }
+
+	// Items made from a sequential reader that more than one recipe in the plan consumes are
+	// produced once and shared through a window of this many bytes; see tee_reader_factory.
+	// A value of 0 disables sharing, so each consumer produces the item again.
+	void set_shared_reader_window_size(uint64_t window_size) { m_shared_reader_window_size = window_size; }
+	uint64_t get_shared_reader_window_size() const { return m_shared_reader_window_size; }
+
+	// When set, an item prepared only as an ingredient is dropped from the kitchen, along with
+	// any copy staged for it, once every recipe in the plan that consumes it has been prepared.
+	// Its storage is then freed as soon as the items consuming it are, rather than when the
+	// kitchen goes away. Requested items and items from pantries are kept. Dropped items are
+	// prepared again if a later request needs them.
+	void set_release_dead_items(bool release) { m_release_dead_items = release; }
+	bool get_release_dead_items() const { return m_release_dead_items; }
+
+	// Bytes held by copies the kitchen staged into temp files or buffers that are still alive,
+	// and the most that were alive at once.
+	uint64_t get_live_intermediate_bytes() const { return m_intermediate_usage->m_live_bytes; }
+	uint64_t get_peak_intermediate_bytes() const { return m_intermediate_usage->m_peak_bytes; }
+
 	// Standard usage, equivalent to passing select_recipes_only = false
 	bool process_requested_items();
 
@@ -152,8 +190,49 @@ class kitchen : public std::enable_shared_from_this<kitchen>
 	void pause_slicing() { m_slicer.pause_slicing(); }
 	void cancel_slicing() { m_slicer.cancel_slicing(); }
 
+	// Caps the memory used by the slice store; see slicer::set_memory_budget()
+	void set_slice_memory_budget(uint64_t budget_bytes) { m_slicer.set_memory_budget(budget_bytes); }
+	uint64_t get_peak_resident_slice_bytes() const { return m_slicer.get_peak_resident_slice_bytes(); }
+
+	// When set, write_item() hashes the item as it is written and throws if the
+	// result doesn't match the item definition; see prepared_item::write().
+	void set_verify_written_items(bool verify) { m_verify_written_items = verify; }
+	bool get_verify_written_items() const { return m_verify_written_items; }
+
+	// Stored content can be trusted when it is stocked and checked as it is used instead, as a
+	// diff's inline assets are; verification throws if the content doesn't match. write_item()
+	// runs every verification once the item is written, so an item made from bad content never
+	// appears to have been written successfully.
+	void add_deferred_verification(std::function<void()> verification);
+
+	// When non-zero, write_item() hands output to a dedicated writer thread through this
+	// many buffers, so producing the item overlaps with writing it; see io::pipelined_writer.
+	void set_write_pipeline_depth(size_t buffer_count) { m_write_pipeline_depth = buffer_count; }
+	size_t get_write_pipeline_depth() const { return m_write_pipeline_depth; }
+
+	// When non-zero, write_item() hints that the stored bytes the plan reads are needed once the
+	// output gets within this many bytes of where they're read, and that they aren't needed once
+	// the output is past them; see read_ahead.
+	void set_read_ahead_window_size(uint64_t window_size) { m_read_ahead_window_size = window_size; }
+	uint64_t get_read_ahead_window_size() const { return m_read_ahead_window_size; }
+
 	void write_item(io::writer &writer, const item_definition &item);
 
+	// The ranges of stored items, such as the source and the diff's inline assets, that are
+	// read to produce item with the selected recipes. Each has the span of item's output
+	// produced while it's read.
+	//
+	// Acquires and holds m_item_request_mutex
+	std::vector<read_ahead::range> get_planned_reads(const item_definition &item);
+
+	// When set, recipe preparation, the data recipes produce, temp file reads and write_item()
+	// are recorded in the profiler. Set it before items are prepared.
+	void set_profiler(std::shared_ptr<apply_profiler> profiler) { m_profiler = profiler; }
+	std::shared_ptr<apply_profiler> get_profiler() const { return m_profiler; }
+
+	// Writes the recipes selected for the requested items and their ingredients as JSON.
+	// Each entry has the planner's estimate for its item under "EstimatedCost", and
+	// "EstimatedTotalCost" sums the estimates for the requested items.
 	void save_selected_recipes(std::shared_ptr<io::writer> &writer) const;
 
 	// Alternative to slicing, it takes the item and makes it ready for a slice directly
@@ -161,24 +240,135 @@ class kitchen : public std::enable_shared_from_this<kitchen>
 	std::shared_ptr<prepared_item> prepare_as_reader(std::shared_ptr<prepared_item> &to_prepare);
 
 	private:
-	bool make_dependency_ready(
-		const item_definition &item,
-		bool select_recipes_only,
-		std::set<item_definition> &mocked_items,
-		std::set<item_definition> &already_using);
+	// When several recipes can make an item, the one with the lowest planned_item::m_total_cost
+	// is selected. Ingredients are planned before the recipes that use them.
+	//
+	// The search walks an explicit stack of planning_frame entries rather than recursing, so
+	// deep nests of recipes don't exhaust the thread's stack. Items found to be unreachable
+	// are kept in m_unreachable_items across calls until invalidate_unreachable() is called
+	// for something they could be made from.
+	//
+	// Only recipes are selected here; process_requested_items() prepares the selected items
+	// afterwards.
+	bool make_dependency_ready(const item_definition &item, std::set<item_definition> &mocked_items);
+
+	// The estimated cost of making an item from its selected recipe; see recipe_cost.
+	struct planned_item
+	{
+		// The recipe's own share, including staging its ingredients when that is needed.
+		double m_recipe_cost{};
+		// Also includes making the ingredients.
+		double m_total_cost{};
+		uint64_t m_temp_bytes{};
+		// Only available as a stream, so it must be staged to be read at random offsets.
+		bool m_stream{};
+		// Streamed ingredients this recipe stages; they're staged only once per plan.
+		std::vector<item_definition> m_staged_ingredients;
+	};
+
+	// An item being planned by make_dependency_ready().
+	struct planning_frame
+	{
+		item_definition m_item;
+		std::vector<std::shared_ptr<recipe>> m_recipes;
+		size_t m_recipe_index{};
+		size_t m_ingredient_index{};
+
+		std::shared_ptr<recipe> m_cheapest;
+		planned_item m_cheapest_plan;
+
+		// The shallowest frame on the stack that a failed recipe needed. If it is this frame
+		// or none, a failure doesn't depend on the items being planned above it.
+		size_t m_cycle_depth{std::numeric_limits<size_t>::max()};
+		// The first ingredient each failed recipe couldn't get.
+		std::vector<item_definition> m_missing_ingredients;
+		// Items that failed only because this frame's item was being planned.
+		std::vector<item_definition> m_waiting_on_this;
+	};
+
+	// Forgets that items are unreachable if a pantry or cookbook lookup for them could find
+	// 'added', along with every item that was unreachable because of them.
+	// m_item_request_mutex must be held by the caller.
+	void invalidate_unreachable(const item_definition &added);
+
+	// Ingredients must already be ready, mocked or planned.
+	// m_item_request_mutex must be held by the caller.
+	planned_item plan_recipe(const recipe &recipe);
+	planned_item get_planned_item(const item_definition &item);
+
+	// Prepares every item reachable from 'items' using the recipes within m_selected_recipes,
+	// spreading the work across m_preparation_thread_count threads. Sequential items with
+	// more than one consumer in the graph are shared between their consumers.
+	// m_item_request_mutex must be held by the caller.
+	void prepare_selected_items(const std::vector<item_definition> &items, std::set<item_definition> &mocked_items);
+
+	// Drops the kitchen's references to an item and to any copy staged for it.
+	// m_item_request_mutex must be held by the caller.
+	void release_item(const item_definition &item);
+
+	// recipe->prepare(), recorded in m_profiler when there is one.
+	std::shared_ptr<prepared_item> prepare_from_recipe(
+		const std::shared_ptr<recipe> &recipe, std::vector<std::shared_ptr<prepared_item>> &ingredients);
+
+	void write_prepared_item(io::writer &writer, std::shared_ptr<prepared_item> &prep_result, read_ahead *ahead);
+	void run_deferred_verifications();
 
 	private:
 	std::shared_ptr<prepared_item> store_item_as_buffer(std::shared_ptr<prepared_item> &to_prepare);
 	std::shared_ptr<prepared_item> store_item_as_temp_file(std::shared_ptr<prepared_item> &to_prepare);
 
+	// Wraps a staged copy of an item so its lifetime is tracked in m_intermediate_usage, and
+	// places it in the root pantry.
+	std::shared_ptr<prepared_item> add_staged_item(const item_definition &item, io::reader &reader);
+
+	struct intermediate_usage
+	{
+		void add(uint64_t bytes)
+		{
+			auto live = m_live_bytes.fetch_add(bytes) + bytes;
+			auto peak = m_peak_bytes.load();
+			while ((peak < live) && !m_peak_bytes.compare_exchange_weak(peak, live))
+			{
+			}
+		}
+		void remove(uint64_t bytes) { m_live_bytes.fetch_sub(bytes); }
+
+		std::atomic<uint64_t> m_live_bytes{0};
+		std::atomic<uint64_t> m_peak_bytes{0};
+	};
+
+	// Shared with the staged items, which may outlive the kitchen.
+	std::shared_ptr<intermediate_usage> m_intermediate_usage = std::make_shared<intermediate_usage>();
+
 	std::atomic<bool> m_ready_for_requests{false};
 
 	std::set<item_definition> m_unreachable_items{};
-	std::map<item_definition, std::shared_ptr<prepared_item>> m_ready_items{};
+	// For each item an unreachable item's recipes were missing, the items that were missing it.
+	std::map<item_definition, std::vector<item_definition>> m_unreachable_dependents{};
+	item_definition_index<std::shared_ptr<prepared_item>> m_ready_items{};
 	std::map<item_definition, std::shared_ptr<recipe>> m_selected_recipes{};
+	std::map<item_definition, planned_item> m_planned_items{};
+	std::set<item_definition> m_planned_staging{};
+	std::set<item_definition> m_planned_requests{};
 	std::set<item_definition> m_requested_items;
 	std::mutex m_item_request_mutex;
 
+	// Guards m_pantry and m_staged_items while items are being prepared on worker threads
+	std::mutex m_pantry_mutex;
+	std::map<item_definition, std::weak_ptr<prepared_item>> m_staged_items;
+
+	std::atomic<uint32_t> m_preparation_thread_count{1};
+	std::atomic<bool> m_verify_written_items{false};
+	std::atomic<size_t> m_write_pipeline_depth{0};
+
+	std::mutex m_deferred_verification_mutex;
+	std::vector<std::function<void()>> m_deferred_verifications;
+	std::atomic<uint64_t> m_shared_reader_window_size{tee_reader_factory::c_default_window_size};
+	std::atomic<bool> m_release_dead_items{true};
+	std::atomic<uint64_t> m_read_ahead_window_size{read_ahead::c_default_window_size};
+
+	std::shared_ptr<apply_profiler> m_profiler;
+
 	slicer m_slicer;
 
 	std::shared_ptr<pantry> m_pantry     = std::make_shared<pantry>();
@@ -29,6 +29,19 @@ class pantry
 		m_items.insert(std::pair{result, prepared});
 	}
 
+	// Only removes the item if it is the one stored for its definition.
+	void remove(const std::shared_ptr<prepared_item> &prepared)
+	{
+		auto &result = prepared->get_item_definition();
+		m_lookup.remove(result, prepared);
+
+		auto itr = m_items.find(result);
+		if ((itr != m_items.end()) && (itr->second == prepared))
+		{
+			m_items.erase(itr);
+		}
+	}
+
 	bool find(const std::string &name, std::shared_ptr<prepared_item> *result) { return m_lookup.find(name, result); }
 
 	using item_definition_store = std::map<item_definition, std::shared_ptr<prepared_item>>;
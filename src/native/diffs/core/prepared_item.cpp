@@ -6,6 +6,7 @@
  */
 #include "prepared_item.h"
 
+#include <io/all_zeros_io_device.h>
 #include <io/sequential/basic_reader_wrapper.h>
 #include <io/sequential/chain_reader.h>
 #include <io/hashed/hashed_sequential_writer.h>
@@ -14,7 +15,9 @@
 
 #include <language_support/overload_pattern.h>
 
+#include "apply_profiler.h"
 #include "kitchen.h"
+#include "tee_reader_factory.h"
 
 namespace archive_diff::diffs::core
 {
@@ -42,6 +45,49 @@ bool prepared_item::can_make_reader() const
 		m_kind);
 }
 
+std::optional<io::reader> prepared_item::try_make_stored_reader() const
+{
+	return std::visit(
+		overload{
+			[](reader_kind &kind) -> std::optional<io::reader> { return kind.m_factory->make_reader(); },
+			[](slice_kind &kind) -> std::optional<io::reader>
+			{
+				auto whole = kind.m_item->try_make_stored_reader();
+				if (!whole.has_value())
+				{
+					return std::nullopt;
+				}
+				return whole->slice(kind.m_offset, kind.m_length);
+			},
+			[](auto &) -> std::optional<io::reader> { return std::nullopt; },
+		},
+		m_kind);
+}
+
+bool prepared_item::is_all_zeros() const
+{
+	return std::visit(
+		overload{
+			[](reader_kind &kind) { return kind.m_all_zeros; },
+			[](sequential_reader_kind &) { return false; },
+			[](slice_kind &kind) { return kind.m_item->is_all_zeros(); },
+			[](chain_kind &kind)
+			{
+				for (auto &item : kind.m_items)
+				{
+					if (!item->is_all_zeros())
+					{
+						return false;
+					}
+				}
+
+				return true;
+			},
+			[](fetch_slice_kind &) { return false; },
+		},
+		m_kind);
+}
+
 io::reader prepared_item::make_reader()
 {
 	return std::visit(
@@ -49,6 +95,11 @@ io::reader prepared_item::make_reader()
 			[](reader_kind &kind) { return kind.m_factory->make_reader(); },
 			[](sequential_reader_kind &kind)
 			{
+				if (auto tee = std::dynamic_pointer_cast<tee_reader_factory>(kind.m_factory))
+				{
+					return tee->make_reader();
+				}
+
 				auto temp_file = std::make_shared<io::file::temp_file>();
 
 				auto seq_reader = kind.m_factory->make_sequential_reader();
@@ -113,6 +164,40 @@ bool prepared_item::can_slice([[maybe_unused]] uint64_t offset, [[maybe_unused]]
 	return can_make_reader();
 }
 
+void prepared_item::share_sequential_reader(size_t consumer_count, uint64_t window_size)
+{
+	if (!std::holds_alternative<sequential_reader_kind>(m_kind) || is_shared_sequential_reader())
+	{
+		return;
+	}
+
+	auto &kind = std::get<sequential_reader_kind>(m_kind);
+	kind.m_factory =
+		std::make_shared<tee_reader_factory>(kind.m_factory, m_item_definition.size(), consumer_count, window_size);
+}
+
+void prepared_item::profile_sequential_reader(apply_profiler &profiler, const std::string &recipe_name)
+{
+	if (!std::holds_alternative<sequential_reader_kind>(m_kind))
+	{
+		return;
+	}
+
+	auto &kind     = std::get<sequential_reader_kind>(m_kind);
+	kind.m_factory = profiler.wrap_sequential_reader_factory(kind.m_factory, recipe_name);
+}
+
+bool prepared_item::is_shared_sequential_reader() const
+{
+	if (!std::holds_alternative<sequential_reader_kind>(m_kind))
+	{
+		return false;
+	}
+
+	auto &kind = std::get<sequential_reader_kind>(m_kind);
+	return std::dynamic_pointer_cast<tee_reader_factory>(kind.m_factory) != nullptr;
+}
+
 std::unique_ptr<io::sequential::reader> prepared_item::make_sequential_reader() const
 {
 	return std::visit(
@@ -194,18 +279,78 @@ void prepared_item::write_chain([[maybe_unused]] std::shared_ptr<io::writer> &wr
 	}
 }
 
-void prepared_item::write([[maybe_unused]] std::shared_ptr<io::writer> &writer)
+void prepared_item::write(std::shared_ptr<io::writer> &writer) { write(writer, false); }
+
+void prepared_item::write(std::shared_ptr<io::writer> &writer, bool verify_hash)
 {
+	if (is_all_zeros())
+	{
+		write_zeros(writer, verify_hash);
+		return;
+	}
+
 	auto reader = make_sequential_reader();
-#if 0
+
+	if (!verify_hash)
+	{
+		io::sequential::basic_writer_wrapper seq_writer(writer);
+		seq_writer.write(*reader);
+		return;
+	}
+
 	auto hasher = std::make_shared<hashing::hasher>(hashing::algorithm::sha256);
-	io::hashed::hashed_sequential_writer hashed_writer(writer, hasher);
+	uint64_t written{};
+	{
+		io::hashed::hashed_sequential_writer hashed_writer(writer, hasher);
+		hashed_writer.write(*reader);
+		written = hashed_writer.tellp();
+	}
 
-	hashed_writer.write(*reader);
-#else
-	io::sequential::basic_writer_wrapper seq_writer(writer);
-	seq_writer.write(*reader);
-#endif
+	verify_written(written, *hasher);
+}
+
+void prepared_item::write_zeros(std::shared_ptr<io::writer> &writer, bool verify_hash)
+{
+	writer->write_zeros(0, size());
+
+	if (!verify_hash)
+	{
+		return;
+	}
+
+	// Nothing was read, so hash the zeros the item is known to hold.
+	hashing::hasher hasher(hashing::algorithm::sha256);
+	auto zeros = io::all_zeros_io_device::make_reader(size());
+	zeros.for_each_block(0, zeros.size(), [&](std::string_view block) { hasher.hash_data(block); });
+
+	verify_written(size(), hasher);
+}
+
+void prepared_item::verify_written(uint64_t written, hashing::hasher &hasher) const
+{
+	if (written != m_item_definition.size())
+	{
+		auto msg = fmt::format(
+			"prepared_item::write: Wrote {} bytes, but expected {} for {}",
+			written,
+			m_item_definition.size(),
+			m_item_definition);
+		throw errors::user_exception(errors::error_code::diffs_prepared_item_written_size_mismatch, msg);
+	}
+
+	if (!m_item_definition.has_hash_for_alg(hashing::algorithm::sha256))
+	{
+		ADU_LOG("prepared_item::write: No sha256 hash to verify for {}", m_item_definition);
+		return;
+	}
+
+	auto hash = hasher.get_hash();
+	if (!m_item_definition.has_matching_hash(hash))
+	{
+		auto msg = fmt::format(
+			"prepared_item::write: Written content has hash {}, which doesn't match {}", hash, m_item_definition);
+		throw errors::user_exception(errors::error_code::diffs_prepared_item_written_hash_mismatch, msg);
+	}
 }
 
 std::string prepared_item::to_string() const
@@ -6,6 +6,7 @@
  */
 #pragma once
 
+#include <hashing/hasher.h>
 #include <io/basic_reader_factory.h>
 #include <io/reader_factory.h>
 #include <io/sequential/reader_factory.h>
@@ -17,6 +18,7 @@
 namespace archive_diff::diffs::core
 {
 class kitchen;
+class apply_profiler;
 
 class prepared_item
 {
@@ -25,6 +27,8 @@ class prepared_item
 	{
 		std::shared_ptr<io::reader_factory> m_factory;
 		std::vector<std::shared_ptr<prepared_item>> m_ingredients;
+		// Set when the factory is known to only produce zeros; see is_all_zeros().
+		bool m_all_zeros{};
 	};
 
 	struct sequential_reader_kind
@@ -83,17 +87,41 @@ class prepared_item
 	bool can_make_reader() const;
 	io::reader make_reader();
 
+	// A reader over the item when it's held by a reader, or is a slice of one, so nothing
+	// is produced or staged to make it. Used to pass hints to the devices holding the item.
+	std::optional<io::reader> try_make_stored_reader() const;
+
 	void write(std::shared_ptr<io::writer> &writer);
 
+	// Same as write(), but if verify_hash is set the content is hashed as it is
+	// written and checked against the item definition once the stream ends.
+	// Throws on a length or sha256 mismatch.
+	// Items known to be all zeros are handed to io::writer::write_zeros() without being read.
+	void write(std::shared_ptr<io::writer> &writer, bool verify_hash);
+
+	// True for zeros readers and for slices and chains made only of them.
+	bool is_all_zeros() const;
+
 	// If we could construct this prepared item, we should always be able to create a sequential reader
 	std::unique_ptr<io::sequential::reader> make_sequential_reader() const;
 
 	bool can_slice(uint64_t offset, uint64_t length) const;
 
+	// Lets consumer_count consumers read this item while it's only produced once; see
+	// tee_reader_factory. Only items made from a sequential reader are affected.
+	void share_sequential_reader(size_t consumer_count, uint64_t window_size);
+	bool is_shared_sequential_reader() const;
+
+	// Has the time spent reading this item counted against recipe_name. Only items made from
+	// a sequential reader are affected; the others are read through their ingredients.
+	void profile_sequential_reader(apply_profiler &profiler, const std::string &recipe_name);
+
 	std::string to_string() const;
 
 	private:
 	void write_chain(std::shared_ptr<io::writer> &writer);
+	void write_zeros(std::shared_ptr<io::writer> &writer, bool verify_hash);
+	void verify_written(uint64_t written, hashing::hasher &hasher) const;
 
 	item_definition m_item_definition;
 	mutable std::variant<reader_kind, sequential_reader_kind, slice_kind, chain_kind, fetch_slice_kind> m_kind;
@@ -10,6 +10,7 @@
 
 #include <hashing/hash.h>
 
+#include "hash_index.h"
 #include "item_definition.h"
 #include "prepared_item.h"
 
@@ -22,19 +23,25 @@ class prepared_item_lookup
 	public:
 	bool find(const core::item_definition &item, std::shared_ptr<prepared_item> *result) const
 	{
-		for (auto &hash : item.get_hashes())
+		for (auto algorithm : item_definition::c_hash_algorithms)
 		{
-			std::pair<uint64_t, hashing::hash> key{item.size(), hash.second};
+			auto hash_data = item.get_hash_data(algorithm);
 
-			auto find_itr = m_hash_lookup.find(key);
-			if (find_itr == m_hash_lookup.cend())
+			digest_key key;
+			if (hash_data.empty() || !digest_key::try_make(item.size(), algorithm, hash_data, &key))
+			{
+				continue;
+			}
+
+			auto found = m_hash_lookup.find(key);
+			if (found == nullptr)
 			{
 				continue;
 			}
 
 			if (result)
 			{
-				*result = find_itr->second;
+				*result = *found;
 			}
 			return true;
 		}
@@ -67,10 +74,15 @@ class prepared_item_lookup
 
 	void add(const core::item_definition &item, const std::shared_ptr<prepared_item> &value)
 	{
-		for (auto &hash : item.get_hashes())
+		for (auto algorithm : item_definition::c_hash_algorithms)
 		{
-			std::pair<uint64_t, hashing::hash> key{item.size(), hash.second};
-			m_hash_lookup.insert(std::pair{key, value});
+			auto hash_data = item.get_hash_data(algorithm);
+
+			digest_key key;
+			if (!hash_data.empty() && digest_key::try_make(item.size(), algorithm, hash_data, &key))
+			{
+				m_hash_lookup.insert(key, value);
+			}
 		}
 
 		for (auto &name : item.get_names())
@@ -79,8 +91,38 @@ class prepared_item_lookup
 		}
 	}
 
+	// Removes the lookups for item that lead to value.
+	void remove(const core::item_definition &item, const std::shared_ptr<prepared_item> &value)
+	{
+		for (auto algorithm : item_definition::c_hash_algorithms)
+		{
+			auto hash_data = item.get_hash_data(algorithm);
+
+			digest_key key;
+			if (hash_data.empty() || !digest_key::try_make(item.size(), algorithm, hash_data, &key))
+			{
+				continue;
+			}
+
+			auto found = m_hash_lookup.find(key);
+			if ((found != nullptr) && (*found == value))
+			{
+				m_hash_lookup.erase(key);
+			}
+		}
+
+		for (auto &name : item.get_names())
+		{
+			auto find_itr = m_name_lookup.find(name);
+			if ((find_itr != m_name_lookup.end()) && (find_itr->second == value))
+			{
+				m_name_lookup.erase(find_itr);
+			}
+		}
+	}
+
 	private:
-	std::map<std::pair<uint64_t, hashing::hash>, std::shared_ptr<prepared_item>> m_hash_lookup;
+	digest_index<std::shared_ptr<prepared_item>> m_hash_lookup;
 	std::map<std::string, std::shared_ptr<prepared_item>> m_name_lookup;
 };
 } // namespace archive_diff::diffs::core
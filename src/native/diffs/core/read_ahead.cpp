@@ -0,0 +1,125 @@
+/**
+ * @file read_ahead.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "read_ahead.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace archive_diff::diffs::core
+{
+read_ahead::read_ahead(std::vector<range> ranges, uint64_t window_size) : m_window_size(window_size)
+{
+	std::sort(ranges.begin(), ranges.end(), [](const range &left, const range &right) {
+		if (left.m_source != right.m_source)
+		{
+			return std::less<const void *>{}(left.m_source, right.m_source);
+		}
+		return left.m_offset < right.m_offset;
+	});
+
+	std::vector<range> merged;
+	for (auto &to_merge : ranges)
+	{
+		if (to_merge.m_length == 0)
+		{
+			continue;
+		}
+
+		if (!merged.empty())
+		{
+			auto &last = merged.back();
+			if ((last.m_source == to_merge.m_source) && (to_merge.m_offset <= last.m_offset + last.m_length))
+			{
+				auto end            = std::max(last.m_offset + last.m_length, to_merge.m_offset + to_merge.m_length);
+				last.m_length       = end - last.m_offset;
+				last.m_needed_from  = std::min(last.m_needed_from, to_merge.m_needed_from);
+				last.m_needed_until = std::max(last.m_needed_until, to_merge.m_needed_until);
+				continue;
+			}
+		}
+
+		merged.push_back(std::move(to_merge));
+	}
+
+	// Without knowing where in its span each part of a large range is read, assume it's
+	// read evenly across the span.
+	for (auto &whole : merged)
+	{
+		if ((m_window_size == 0) || (whole.m_length <= m_window_size))
+		{
+			m_ranges.push_back(std::move(whole));
+			continue;
+		}
+
+		auto piece_count = (whole.m_length + m_window_size - 1) / m_window_size;
+		auto span        = static_cast<double>(whole.m_needed_until - whole.m_needed_from);
+		for (uint64_t piece = 0; piece < piece_count; piece++)
+		{
+			auto offset = piece * m_window_size;
+
+			range part         = whole;
+			part.m_offset      = whole.m_offset + offset;
+			part.m_length      = std::min(m_window_size, whole.m_length - offset);
+			part.m_needed_from =
+				whole.m_needed_from + static_cast<uint64_t>(span * static_cast<double>(piece) / piece_count);
+			m_ranges.push_back(std::move(part));
+		}
+	}
+
+	m_by_needed_from.resize(m_ranges.size());
+	std::iota(m_by_needed_from.begin(), m_by_needed_from.end(), 0);
+	m_by_needed_until = m_by_needed_from;
+
+	std::stable_sort(m_by_needed_from.begin(), m_by_needed_from.end(), [&](size_t left, size_t right) {
+		return m_ranges[left].m_needed_from < m_ranges[right].m_needed_from;
+	});
+	std::stable_sort(m_by_needed_until.begin(), m_by_needed_until.end(), [&](size_t left, size_t right) {
+		return m_ranges[left].m_needed_until < m_ranges[right].m_needed_until;
+	});
+}
+
+void read_ahead::advance(uint64_t position)
+{
+	m_position = std::max(m_position, position);
+
+	auto horizon = m_position + m_window_size;
+	for (; m_next_needed < m_by_needed_from.size(); m_next_needed++)
+	{
+		auto &next = m_ranges[m_by_needed_from[m_next_needed]];
+		if (next.m_needed_from > horizon)
+		{
+			break;
+		}
+		issue_hint(next, io::access_hint::will_need);
+	}
+
+	for (; m_next_released < m_by_needed_until.size(); m_next_released++)
+	{
+		auto &next = m_ranges[m_by_needed_until[m_next_released]];
+		if (next.m_needed_until > m_position)
+		{
+			break;
+		}
+		issue_hint(next, io::access_hint::dont_need);
+	}
+}
+
+void read_ahead::finish()
+{
+	m_next_needed = m_by_needed_from.size();
+
+	for (; m_next_released < m_by_needed_until.size(); m_next_released++)
+	{
+		issue_hint(m_ranges[m_by_needed_until[m_next_released]], io::access_hint::dont_need);
+	}
+}
+
+void read_ahead::issue_hint(const range &to_hint, io::access_hint hint)
+{
+	to_hint.m_reader.hint(to_hint.m_offset, to_hint.m_length, hint);
+}
+} // namespace archive_diff::diffs::core
@@ -0,0 +1,94 @@
+/**
+ * @file read_ahead.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <io/reader.h>
+#include <io/writer.h>
+
+#include <memory>
+#include <vector>
+
+namespace archive_diff::diffs::core
+{
+// Passes hints about the ranges a plan reads to the devices holding them while an item is
+// written, so storage is busy fetching what comes next and the cache doesn't fill up with
+// what's already been used.
+//
+// Each range is read while a span of the output is produced. A range is hinted as needed
+// once the output gets within the window of where it's first read, and as not needed once
+// the output is past the last place it's read. Overlapping ranges of the same source are
+// merged first, so nothing is dropped while something else still reads it. Merged ranges
+// larger than the window are hinted a window at a time, spread over their span of output.
+class read_ahead
+{
+	public:
+	static const uint64_t c_default_window_size = 16 * 1024 * 1024;
+
+	struct range
+	{
+		io::reader m_reader;
+		// Ranges with the same source are read from the same storage.
+		const void *m_source{};
+		uint64_t m_offset{};
+		uint64_t m_length{};
+		// The span of output produced while the range is read.
+		uint64_t m_needed_from{};
+		uint64_t m_needed_until{};
+	};
+
+	read_ahead(std::vector<range> ranges, uint64_t window_size);
+
+	// Issues the hints for the output having been produced up to position.
+	void advance(uint64_t position);
+
+	// The output has been produced; every range left is hinted as not needed.
+	void finish();
+
+	size_t get_range_count() const { return m_ranges.size(); }
+
+	private:
+	void issue_hint(const range &to_hint, io::access_hint hint);
+
+	uint64_t m_window_size{};
+	uint64_t m_position{};
+
+	std::vector<range> m_ranges;
+	// Indexes into m_ranges, by m_needed_from and by m_needed_until.
+	std::vector<size_t> m_by_needed_from;
+	std::vector<size_t> m_by_needed_until;
+	size_t m_next_needed{};
+	size_t m_next_released{};
+};
+
+// Writes to another writer and advances a read_ahead past everything written.
+class read_ahead_writer : public io::writer
+{
+	public:
+	read_ahead_writer(std::shared_ptr<io::writer> &inner, read_ahead &read_ahead) :
+		m_inner(inner), m_read_ahead(read_ahead)
+	{}
+
+	virtual void write(uint64_t offset, std::string_view buffer) override
+	{
+		m_inner->write(offset, buffer);
+		m_read_ahead.advance(offset + buffer.size());
+	}
+
+	virtual void write_zeros(uint64_t offset, uint64_t length) override
+	{
+		m_inner->write_zeros(offset, length);
+		m_read_ahead.advance(offset + length);
+	}
+
+	virtual void flush() override { m_inner->flush(); }
+	virtual uint64_t size() const override { return m_inner->size(); }
+
+	private:
+	std::shared_ptr<io::writer> m_inner;
+	read_ahead &m_read_ahead;
+};
+} // namespace archive_diff::diffs::core
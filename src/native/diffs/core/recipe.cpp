@@ -28,6 +28,20 @@ recipe::recipe(
 
 recipe::~recipe() {}
 
+std::vector<recipe::ingredient_read> recipe::get_ingredient_reads() const
+{
+	std::vector<ingredient_read> reads;
+	for (auto &ingredient : m_item_ingredients)
+	{
+		reads.push_back(ingredient_read{
+			.m_offset        = 0,
+			.m_length        = ingredient.size(),
+			.m_result_offset = 0,
+			.m_result_length = m_result_item_definition.size()});
+	}
+	return reads;
+}
+
 bool operator<(const std::shared_ptr<recipe> &lhs, const std::shared_ptr<recipe> &rhs)
 {
 	auto lhs_name = lhs->get_recipe_name();
@@ -8,6 +8,7 @@
 
 #include "item_definition.h"
 #include "prepared_item.h"
+#include "recipe_cost.h"
 
 #include <json/json.h>
 
@@ -31,6 +32,25 @@ class recipe
 	const std::vector<item_definition> &get_item_ingredients() const { return m_item_ingredients; }
 	virtual std::string get_recipe_name() const = 0;
 	virtual Json::Value to_json() const;
+
+	// Used to choose between recipes for the same item. The default is a plain copy.
+	virtual recipe_cost get_cost() const { return recipe_cost{}; }
+
+	// The bytes of an item ingredient the recipe reads, and the part of the result it
+	// produces while reading them. Used by the kitchen to read ahead of the recipe.
+	struct ingredient_read
+	{
+		uint64_t m_offset{};
+		uint64_t m_length{};
+		uint64_t m_result_offset{};
+		uint64_t m_result_length{};
+		// Byte n of the ingredient range is read as byte n of the result range is produced.
+		bool m_in_order{};
+	};
+
+	// One entry for each item ingredient. By default the whole ingredient is read while any
+	// of the result is produced.
+	virtual std::vector<ingredient_read> get_ingredient_reads() const;
 	std::string to_string() const;
 
 	const item_definition &get_result_item_definition() const { return m_result_item_definition; }
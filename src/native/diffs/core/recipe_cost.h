@@ -0,0 +1,44 @@
+/**
+ * @file recipe_cost.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace archive_diff::diffs::core
+{
+// How expensive a recipe is to use, so the kitchen can pick the cheapest of the recipes
+// that make an item. Costs are in rough nanoseconds per byte on a typical device; only
+// their relative sizes matter.
+struct recipe_cost
+{
+	enum class production
+	{
+		// The result is copied out of the ingredients and can be read wherever they can.
+		copy,
+		// The result is decoded from the ingredients and is only available as a stream.
+		// Compression and patching count as decompression here.
+		decompress,
+	};
+
+	// CPU per byte of the result.
+	double m_cpu_per_byte{c_copy_cpu_per_byte};
+
+	production m_production{production::copy};
+
+	// The ingredients are read at random offsets, so any only available as a stream
+	// must first be staged in temp storage.
+	bool m_random_access_ingredients{false};
+
+	// The result is staged in temp storage by the recipe itself.
+	bool m_temp_storage{false};
+
+	static constexpr double c_copy_cpu_per_byte = 0.1;
+
+	// Writing an item to temp storage and reading it back.
+	static constexpr double c_temp_storage_per_byte = 2.0;
+};
+} // namespace archive_diff::diffs::core
@@ -7,9 +7,11 @@
 #pragma once
 
 #include <map>
+#include <memory>
 
 #include <hashing/hash.h>
 
+#include "hash_index.h"
 #include "item_definition.h"
 #include "recipe_set.h"
 
@@ -18,19 +20,27 @@ namespace archive_diff::diffs::core
 class recipe_lookup
 {
 	public:
+	// The set stays valid as more recipes are added, so callers may hold on to it
+	// while looking up other items.
 	bool find(const core::item_definition &item, const recipe_set **result)
 	{
-		for (auto &hash : item.get_hashes())
+		for (auto algorithm : item_definition::c_hash_algorithms)
 		{
-			std::pair<uint64_t, hashing::hash> key{item.size(), hash.second};
+			auto hash_data = item.get_hash_data(algorithm);
 
-			auto find_itr = m_map.find(key);
-			if (find_itr == m_map.cend())
+			digest_key key;
+			if (hash_data.empty() || !digest_key::try_make(item.size(), algorithm, hash_data, &key))
 			{
 				continue;
 			}
 
-			*result = &find_itr->second;
+			auto found = m_map.find(key);
+			if (found == nullptr)
+			{
+				continue;
+			}
+
+			*result = found->get();
 			return true;
 		}
 		return false;
@@ -38,19 +48,24 @@ class recipe_lookup
 
 	void add(const core::item_definition &item, const std::shared_ptr<recipe> &recipe)
 	{
-		for (auto &hash : item.get_hashes())
+		for (auto algorithm : item_definition::c_hash_algorithms)
 		{
-			std::pair<uint64_t, hashing::hash> key{item.size(), hash.second};
+			auto hash_data = item.get_hash_data(algorithm);
 
-			if (m_map.count(key) == 0)
+			digest_key key;
+			if (!hash_data.empty() && digest_key::try_make(item.size(), algorithm, hash_data, &key))
 			{
-				m_map.insert(std::pair{key, recipe_set{}});
+				auto &recipes = m_map[key];
+				if (!recipes)
+				{
+					recipes = std::make_unique<recipe_set>();
+				}
+				recipes->insert(recipe);
 			}
-			m_map.at(key).insert(recipe);
 		}
 	}
 
 	private:
-	std::map<std::pair<uint64_t, hashing::hash>, recipe_set> m_map;
+	digest_index<std::unique_ptr<recipe_set>> m_map;
 };
 } // namespace archive_diff::diffs::core
@@ -0,0 +1,28 @@
+/**
+ * @file recipe_source.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include "item_definition.h"
+
+namespace archive_diff::diffs::core
+{
+class cookbook;
+
+// Supplies a cookbook with recipes that are only loaded once they're asked for,
+// such as those of a diff that has a recipe index.
+class recipe_source
+{
+	public:
+	virtual ~recipe_source() = default;
+
+	// Adds every recipe whose result could be 'item' to the cookbook, unless already added.
+	virtual void load_recipes_for_item(const item_definition &item, cookbook &cookbook) = 0;
+
+	// Adds every recipe not yet added to the cookbook.
+	virtual void load_all_recipes(cookbook &cookbook) = 0;
+};
+} // namespace archive_diff::diffs::core
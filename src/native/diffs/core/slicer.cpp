@@ -10,6 +10,7 @@
 #include "adu_log.h"
 
 #include <hashing/hasher.h>
+#include <io/basic_reader_factory.h>
 #include <io/buffer/reader_factory.h>
 
 #include <thread>
@@ -154,9 +155,9 @@ bool slicer::try_consume_slice(const item_definition &item, std::shared_ptr<prep
 		return false;
 	}
 
-	auto stored_slice = m_stored_slices[item];
+	auto &stored = m_stored_slices[item];
 
-	auto &count = stored_slice.second;
+	auto &count = stored.m_count;
 
 	// should not be possible, exception
 	if (count == 0)
@@ -168,12 +169,14 @@ bool slicer::try_consume_slice(const item_definition &item, std::shared_ptr<prep
 	// we no longer need this, throw it away
 	if (count == 0)
 	{
-		result->swap(stored_slice.first);
+		result->swap(stored.m_prepared);
+		m_resident_slice_bytes -= stored.m_resident_bytes;
 		m_stored_slices.erase(item);
+		m_budget_cv.notify_all();
 	}
 	else
 	{
-		*result = stored_slice.first;
+		*result = stored.m_prepared;
 	}
 
 	return true;
@@ -202,7 +205,13 @@ std::shared_ptr<prepared_item> slicer::fetch_slice(const item_definition &item)
 		// not currently available, wait for it
 		// printf("Waiting for %s\n", item.to_string().c_str());
 		std::unique_lock<std::mutex> lock(m_store_mutex);
+
+		// Let any slicing threads waiting on the memory budget know that
+		// someone is blocked on them, so they spill rather than wait.
+		m_fetch_waiter_count++;
+		m_budget_cv.notify_all();
 		m_store_cv.wait(lock, [&] { return (m_stored_slices.count(item) > 0); });
+		m_fetch_waiter_count--;
 	}
 
 	return result;
@@ -348,10 +357,15 @@ void slicer::slice_and_populate_slice_store(const item_definition &item_to_slice
 	// printf("We're slicing %s\n", item_to_slice.to_string().c_str());
 	hashing::hasher hasher(hashing::algorithm::sha256);
 
+	std::vector<batched_slice> hash_batch;
+
 	for (auto offset_and_slice : *slices_requested)
 	{
 		if (m_state == slicing_state::paused)
 		{
+			// Slices already read shouldn't wait on the pause.
+			verify_and_store_batch(hash_batch);
+
 			m_paused_thread_count++;
 			m_running_thread_count--;
 			m_state_cv.notify_all();
@@ -391,58 +405,224 @@ void slicer::slice_and_populate_slice_store(const item_definition &item_to_slice
 			reader->skip(to_skip);
 		}
 
-		auto slice_vector = std::make_shared<std::vector<char>>();
-		if (slice.size() > std::numeric_limits<size_t>::max())
+		hasher.reset();
+
+		bool resident = try_reserve_resident_bytes(slice.size());
+
+		if (m_state == slicing_state::cancelled)
 		{
-			throw errors::user_exception(errors::error_code::diff_slicing_request_size_too_large);
+			return;
 		}
-		slice_vector->reserve(static_cast<size_t>(slice.size()));
 
-		reader->read(std::span<char>(slice_vector->data(), slice_vector->capacity()));
-		ADU_LOG(
-			"slicer::slice_and_populate_slice_store: Read {} in reader of {} bytes.",
-			slice_vector->capacity(),
-			reader->size());
+		if (resident && (slice.size() <= c_batched_slice_max_size))
+		{
+			hash_batch.push_back(batched_slice{offset, slice, read_slice_data(*reader, slice)});
+			if (hash_batch.size() == c_hash_batch_count)
+			{
+				verify_and_store_batch(hash_batch);
+			}
+			continue;
+		}
+
+		// Slices are stored in the order they're read.
+		verify_and_store_batch(hash_batch);
+
+		std::shared_ptr<prepared_item> prep_slice;
+		if (resident)
+		{
+			prep_slice = read_slice_to_buffer(*reader, slice, hasher);
+		}
+		else
+		{
+			prep_slice = read_slice_to_spill_file(*reader, slice, hasher);
+		}
 
-		hasher.reset();
-		hasher.hash_data(std::string_view{slice_vector->data(), slice_vector->capacity()});
 		auto slice_hash = hasher.get_hash();
+		verify_slice_hash(offset, slice, slice_hash);
 
-		if (!slice.has_matching_hash(slice_hash))
+		store_slice(slice, prep_slice, resident ? slice.size() : 0);
+	}
+
+	verify_and_store_batch(hash_batch);
+}
+
+void slicer::verify_and_store_batch(std::vector<batched_slice> &batch)
+{
+	if (batch.empty())
+	{
+		return;
+	}
+
+	std::vector<std::string_view> buffers;
+	for (auto &batched : batch)
+	{
+		buffers.push_back(std::string_view{batched.m_data->data(), batched.m_data->size()});
+	}
+
+	auto hashes = hashing::hasher::hash_many(hashing::algorithm::sha256, buffers);
+
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		auto &batched = batch[i];
+		verify_slice_hash(batched.m_offset, batched.m_slice, hashes[i]);
+
+		auto prep_slice = make_buffer_slice(batched.m_slice, batched.m_data);
+		store_slice(batched.m_slice, prep_slice, batched.m_slice.size());
+	}
+
+	batch.clear();
+}
+
+void slicer::store_slice(
+	const item_definition &slice, std::shared_ptr<prepared_item> &prep_slice, uint64_t resident_bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_store_mutex);
+
+		if (m_slice_item_request_counts.count(slice) == 0)
 		{
-			std::string msg = fmt::format(
-				"Generated slice doesn't match expected slice. Current offset: {}, Slice: {}, slice_hash: {}",
-				offset,
-				slice,
-				slice_hash);
-			throw errors::user_exception(errors::error_code::diff_slicing_produced_hash_mismatch, msg);
+			throw errors::user_exception(
+				errors::error_code::diff_slicing_no_requests_for_slice, "No requests for slice.");
 		}
 
-		std::shared_ptr<io::reader_factory> cache_entry_factory = std::make_shared<io::buffer::reader_factory>(
-			slice_vector, io::buffer::io_device::size_kind::vector_capacity);
+		auto count = m_slice_item_request_counts[slice];
+
+		ADU_LOG("Stored slice for {}.", slice);
+		m_stored_slices.insert(std::pair{slice, stored_slice{prep_slice, count, resident_bytes}});
+
+		m_slice_item_request_counts.erase(slice);
+	}
+
+	ADU_LOG("Notified: m_stored_slices_cv for {}", slice);
+	m_store_cv.notify_all();
+}
+
+bool slicer::try_reserve_resident_bytes(uint64_t size)
+{
+	std::unique_lock<std::mutex> lock(m_store_mutex);
 
-		auto prep_slice = std::make_shared<diffs::core::prepared_item>(
-			slice, diffs::core::prepared_item::reader_kind{cache_entry_factory});
+	uint64_t budget = m_memory_budget;
 
+	if (budget != 0)
+	{
+		if (size > budget)
 		{
-			std::lock_guard<std::mutex> lock(m_store_mutex);
+			return false;
+		}
 
-			if (m_slice_item_request_counts.count(slice) == 0)
-			{
-				throw errors::user_exception(
-					errors::error_code::diff_slicing_no_requests_for_slice, "No requests for slice.");
-			}
+		m_budget_cv.wait(lock, [&] {
+			return (m_resident_slice_bytes + size <= budget) || (m_fetch_waiter_count > 0)
+			    || (m_state == slicing_state::cancelled);
+		});
+
+		if (m_resident_slice_bytes + size > budget)
+		{
+			return false;
+		}
+	}
+
+	m_resident_slice_bytes += size;
+	if (m_resident_slice_bytes > m_peak_resident_slice_bytes)
+	{
+		m_peak_resident_slice_bytes.store(m_resident_slice_bytes);
+	}
+
+	return true;
+}
+
+std::shared_ptr<std::vector<char>> slicer::read_slice_data(io::sequential::reader &reader, const item_definition &slice)
+{
+	if (slice.size() > std::numeric_limits<size_t>::max())
+	{
+		throw errors::user_exception(errors::error_code::diff_slicing_request_size_too_large);
+	}
+	auto slice_vector = std::make_shared<std::vector<char>>(static_cast<size_t>(slice.size()));
+
+	reader.read(std::span<char>(slice_vector->data(), slice_vector->size()));
+	ADU_LOG("slicer::read_slice_data: Read {} in reader of {} bytes.", slice_vector->size(), reader.size());
+
+	return slice_vector;
+}
+
+std::shared_ptr<prepared_item> slicer::make_buffer_slice(
+	const item_definition &slice, std::shared_ptr<std::vector<char>> &slice_vector)
+{
+	std::shared_ptr<io::reader_factory> cache_entry_factory =
+		std::make_shared<io::buffer::reader_factory>(slice_vector, io::buffer::io_device::size_kind::vector_size);
+
+	return std::make_shared<diffs::core::prepared_item>(
+		slice, diffs::core::prepared_item::reader_kind{cache_entry_factory});
+}
+
+std::shared_ptr<prepared_item> slicer::read_slice_to_buffer(
+	io::sequential::reader &reader, const item_definition &slice, hashing::hasher &hasher)
+{
+	auto slice_vector = read_slice_data(reader, slice);
 
-			auto count = m_slice_item_request_counts[slice];
+	hasher.hash_data(std::string_view{slice_vector->data(), slice_vector->size()});
 
-			ADU_LOG("Stored slice for {}.", slice);
-			m_stored_slices.insert(std::pair{slice, std::pair{prep_slice, count}});
+	return make_buffer_slice(slice, slice_vector);
+}
+
+std::shared_ptr<prepared_item> slicer::read_slice_to_spill_file(
+	io::sequential::reader &reader, const item_definition &slice, hashing::hasher &hasher)
+{
+	std::shared_ptr<io::file::temp_file> spill_file;
+	uint64_t spill_offset;
 
-			m_slice_item_request_counts.erase(slice);
+	{
+		std::lock_guard<std::mutex> lock(m_spill_mutex);
+		if (!m_spill_file)
+		{
+			m_spill_file = std::make_shared<io::file::temp_file>();
 		}
 
-		ADU_LOG("Notified: m_stored_slices_cv for {}", slice);
-		m_store_cv.notify_all();
+		spill_file   = m_spill_file;
+		spill_offset = m_spill_file_size;
+		m_spill_file_size += slice.size();
+	}
+
+	ADU_LOG("slicer::read_slice_to_spill_file: Spilling {} to offset {}.", slice, spill_offset);
+
+	const size_t block_size = 64 * 1024;
+	std::vector<char> block(block_size);
+
+	auto remaining = slice.size();
+	auto offset    = spill_offset;
+
+	while (remaining)
+	{
+		auto to_read = static_cast<size_t>(std::min<uint64_t>(block_size, remaining));
+		auto data    = std::span<char>{block.data(), to_read};
+
+		reader.read(data);
+		hasher.hash_data(std::string_view{data.data(), data.size()});
+		spill_file->write(offset, std::string_view{data.data(), data.size()});
+
+		remaining -= to_read;
+		offset += to_read;
+	}
+
+	m_spilled_slice_bytes += slice.size();
+
+	auto spill_reader = io::file::temp_file_io_device::make_reader(spill_file).slice(spill_offset, slice.size());
+
+	std::shared_ptr<io::reader_factory> cache_entry_factory = std::make_shared<io::basic_reader_factory>(spill_reader);
+
+	return std::make_shared<diffs::core::prepared_item>(
+		slice, diffs::core::prepared_item::reader_kind{cache_entry_factory});
+}
+
+void slicer::verify_slice_hash(uint64_t offset, const item_definition &slice, hashing::hash &slice_hash)
+{
+	if (!slice.has_matching_hash(slice_hash))
+	{
+		std::string msg = fmt::format(
+			"Generated slice doesn't match expected slice. Current offset: {}, Slice: {}, slice_hash: {}",
+			offset,
+			slice,
+			slice_hash);
+		throw errors::user_exception(errors::error_code::diff_slicing_produced_hash_mismatch, msg);
 	}
 }
 
@@ -453,6 +633,12 @@ void slicer::cancel_slicing()
 		m_state = slicing_state::cancelled;
 	}
 	m_state_cv.notify_all();
+
+	// synchronize with any slicing thread about to wait on the budget
+	{
+		std::lock_guard<std::mutex> lock(m_store_mutex);
+	}
+	m_budget_cv.notify_all();
 }
 
 } // namespace archive_diff::diffs::core
\ No newline at end of file
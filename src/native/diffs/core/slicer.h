@@ -13,6 +13,10 @@
 #include <condition_variable>
 #include <thread>
 
+#include <hashing/hasher.h>
+#include <io/file/temp_file.h>
+#include <io/sequential/reader.h>
+
 #include "item_definition.h"
 #include "prepared_item.h"
 
@@ -48,9 +52,53 @@ class slicer
 	// so they check to see if cancellation is requested
 	void cancel_slicing();
 
+	// Limits the number of bytes of slices held in memory by the slice store.
+	// A value of 0 means there is no limit.
+	//
+	// When a slice doesn't fit, the slicing thread waits for stored slices to
+	// be consumed. If a consumer is already waiting for a slice, or the slice
+	// can never fit, the slice is written to a temp file instead.
+	void set_memory_budget(uint64_t budget_bytes) { m_memory_budget = budget_bytes; }
+	uint64_t get_memory_budget() const { return m_memory_budget; }
+
+	// Largest number of bytes held in memory by the slice store at any one time
+	uint64_t get_peak_resident_slice_bytes() const { return m_peak_resident_slice_bytes; }
+	// Total number of bytes of slices written to the spill file
+	uint64_t get_spilled_slice_bytes() const { return m_spilled_slice_bytes; }
+
 	private:
 	bool try_consume_slice(const item_definition &item, std::shared_ptr<prepared_item> *result);
 
+	// Reserves space for a slice of the given size within the memory budget.
+	// Returns false if the slice should be spilled to the temp file instead.
+	bool try_reserve_resident_bytes(uint64_t size);
+
+	std::shared_ptr<std::vector<char>> read_slice_data(io::sequential::reader &reader, const item_definition &slice);
+	std::shared_ptr<prepared_item> make_buffer_slice(
+		const item_definition &slice, std::shared_ptr<std::vector<char>> &slice_vector);
+	std::shared_ptr<prepared_item> read_slice_to_buffer(
+		io::sequential::reader &reader, const item_definition &slice, hashing::hasher &hasher);
+	std::shared_ptr<prepared_item> read_slice_to_spill_file(
+		io::sequential::reader &reader, const item_definition &slice, hashing::hasher &hasher);
+
+	void verify_slice_hash(uint64_t offset, const item_definition &slice, hashing::hash &slice_hash);
+
+	// Small slices kept in memory are read up to c_hash_batch_count at a time and hashed
+	// together with hashing::hasher::hash_many() before they're stored. Larger ones are
+	// hashed as they're read, so they're stored without waiting on others.
+	static constexpr uint64_t c_batched_slice_max_size = 64 * 1024;
+	static constexpr size_t c_hash_batch_count       = 8;
+
+	struct batched_slice
+	{
+		uint64_t m_offset{};
+		item_definition m_slice;
+		std::shared_ptr<std::vector<char>> m_data;
+	};
+
+	void verify_and_store_batch(std::vector<batched_slice> &batch);
+	void store_slice(const item_definition &slice, std::shared_ptr<prepared_item> &prep_slice, uint64_t resident_bytes);
+
 	enum class slicing_state
 	{
 		paused,
@@ -64,7 +112,14 @@ class slicer
 	std::map<item_definition, std::unique_ptr<offset_to_item_map>> m_items_to_slices_requested;
 	std::map<item_definition, std::shared_ptr<prepared_item>> m_item_to_slice_prepared;
 
-	std::map<item_definition, std::pair<std::shared_ptr<prepared_item>, uint32_t>> m_stored_slices;
+	struct stored_slice
+	{
+		std::shared_ptr<prepared_item> m_prepared;
+		uint32_t m_count{};
+		uint64_t m_resident_bytes{};
+	};
+
+	std::map<item_definition, stored_slice> m_stored_slices;
 
 	using slice_item_to_request_count_map = std::map<item_definition, uint32_t>;
 	slice_item_to_request_count_map m_slice_item_request_counts;
@@ -80,6 +135,17 @@ class slicer
 	std::condition_variable_any m_state_cv;
 	std::condition_variable m_store_cv;
 
+	std::atomic<uint64_t> m_memory_budget{0};
+	std::atomic<uint64_t> m_resident_slice_bytes{0};
+	std::atomic<uint64_t> m_peak_resident_slice_bytes{0};
+	std::atomic<uint64_t> m_spilled_slice_bytes{0};
+	uint32_t m_fetch_waiter_count{0};
+	std::condition_variable m_budget_cv;
+
+	std::mutex m_spill_mutex;
+	std::shared_ptr<io::file::temp_file> m_spill_file;
+	uint64_t m_spill_file_size{0};
+
 	std::vector<std::thread> m_slicing_threads;
 };
 } // namespace archive_diff::diffs::core
\ No newline at end of file
@@ -0,0 +1,248 @@
+/**
+ * @file source_hash_cache.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "source_hash_cache.h"
+#include "item_definition_helpers.h"
+
+#include "adu_log.h"
+#include "user_exception.h"
+
+#include <language_support/include_filesystem.h>
+
+#include <io/file/binary_file_writer.h>
+#include <io/file/io_device.h>
+#include <io/sequential/basic_reader_wrapper.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#ifndef WIN32
+	#include <sys/stat.h>
+#endif
+
+namespace archive_diff::diffs::core
+{
+// "SHC1"
+const uint32_t c_cache_file_magic = 0x31434853;
+
+// Keep every hash we have for an item, not just sha256.
+const item_definition::serialization_options c_cache_item_options =
+	item_definition::serialization_options::include_hashes;
+
+std::optional<source_hash_cache::file_identity> source_hash_cache::identify(const std::string &path)
+{
+	std::error_code ec;
+
+	auto absolute_path = fs::absolute(path, ec);
+	if (ec)
+	{
+		return std::nullopt;
+	}
+
+	auto size = fs::file_size(absolute_path, ec);
+	if (ec)
+	{
+		return std::nullopt;
+	}
+
+	auto write_time = fs::last_write_time(absolute_path, ec);
+	if (ec)
+	{
+		return std::nullopt;
+	}
+
+	file_identity identity;
+	identity.m_path              = absolute_path.string();
+	identity.m_size              = static_cast<uint64_t>(size);
+	identity.m_modification_time = static_cast<int64_t>(write_time.time_since_epoch().count());
+
+#ifndef WIN32
+	struct stat file_stat
+	{};
+	if (stat(identity.m_path.c_str(), &file_stat) != 0)
+	{
+		return std::nullopt;
+	}
+	identity.m_inode = static_cast<uint64_t>(file_stat.st_ino);
+#endif
+
+	return identity;
+}
+
+std::optional<item_definition> source_hash_cache::find(const file_identity &identity) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto itr = m_entries.find(identity.m_path);
+	if (itr == m_entries.end())
+	{
+		return std::nullopt;
+	}
+
+	auto &[cached_identity, item] = itr->second;
+	if (!(cached_identity == identity) || (item.size() != identity.m_size))
+	{
+		return std::nullopt;
+	}
+
+	return item;
+}
+
+void source_hash_cache::store(const file_identity &identity, const item_definition &item)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto itr = m_entries.find(identity.m_path);
+	if ((itr != m_entries.end()) && (itr->second.first == identity) && (itr->second.second == item))
+	{
+		return;
+	}
+
+	m_entries.insert_or_assign(identity.m_path, std::pair{identity, item});
+	m_change_count++;
+}
+
+item_definition source_hash_cache::get_definition(const std::string &path, io::reader &reader)
+{
+	auto identity = identify(path);
+
+	if (identity.has_value())
+	{
+		auto cached = find(identity.value());
+		if (cached.has_value())
+		{
+			ADU_LOG("Using cached hash for {}: {}", path, cached.value());
+			return cached.value();
+		}
+	}
+
+	auto item = create_definition_from_reader(reader);
+
+	// Only cache the result if the file didn't change while we were hashing it.
+	if (identity.has_value() && (identify(path) == identity))
+	{
+		store(identity.value(), item);
+	}
+
+	return item;
+}
+
+void source_hash_cache::load(const std::string &path)
+{
+	std::error_code ec;
+	if (!fs::exists(path, ec))
+	{
+		return;
+	}
+
+	decltype(m_entries) entries;
+
+	try
+	{
+		auto file_reader = io::file::io_device::make_reader(path);
+		io::sequential::basic_reader_wrapper reader(file_reader);
+
+		uint32_t magic;
+		reader.read_uint32_t(&magic);
+		if (magic != c_cache_file_magic)
+		{
+			ADU_LOG("Ignoring source hash cache {}, unexpected magic: {}", path, magic);
+			return;
+		}
+
+		uint64_t entry_count;
+		reader.read_uint64_t(&entry_count);
+
+		for (uint64_t i = 0; i < entry_count; i++)
+		{
+			file_identity identity;
+
+			uint64_t path_length;
+			reader.read_uint64_t(&path_length);
+			if (path_length > reader.available())
+			{
+				ADU_LOG("Ignoring source hash cache {}, bad path length: {}", path, path_length);
+				return;
+			}
+			identity.m_path.resize(static_cast<size_t>(path_length));
+			reader.read(std::span<char>{identity.m_path.data(), identity.m_path.size()});
+
+			uint64_t modification_time;
+			reader.read_uint64_t(&identity.m_size);
+			reader.read_uint64_t(&modification_time);
+			reader.read_uint64_t(&identity.m_inode);
+			identity.m_modification_time = static_cast<int64_t>(modification_time);
+
+			auto item = item_definition::read(reader, c_cache_item_options);
+
+			entries.insert_or_assign(identity.m_path, std::pair{identity, item});
+		}
+	}
+	catch (errors::user_exception &e)
+	{
+		ADU_LOG("Ignoring source hash cache {}, failed to read. Error: {}", path, e.get_message());
+		return;
+	}
+	catch (std::exception &e)
+	{
+		ADU_LOG("Ignoring source hash cache {}, failed to read. Exception: {}", path, e.what());
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries            = std::move(entries);
+	m_saved_change_count = m_change_count;
+}
+
+void source_hash_cache::save(const std::string &path)
+{
+	// Write next to the real cache and then rename, so a reader never sees a partial file.
+	auto temp_path = path + ".tmp";
+
+	uint64_t written_change_count{};
+
+	{
+		std::shared_ptr<io::writer> file_writer = std::make_shared<io::file::binary_file_writer>(temp_path);
+		io::sequential::basic_writer_wrapper writer(file_writer);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		written_change_count = m_change_count;
+
+		writer.write_uint32_t(c_cache_file_magic);
+		writer.write_uint64_t(m_entries.size());
+
+		for (auto &[entry_path, entry] : m_entries)
+		{
+			auto &[identity, item] = entry;
+
+			writer.write_value(identity.m_path);
+			writer.write_uint64_t(identity.m_size);
+			writer.write_uint64_t(static_cast<uint64_t>(identity.m_modification_time));
+			writer.write_uint64_t(identity.m_inode);
+
+			item.write(writer, c_cache_item_options);
+		}
+
+		writer.flush();
+	}
+
+	fs::rename(temp_path, path);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_saved_change_count = written_change_count;
+}
+
+bool source_hash_cache::has_unsaved_changes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_change_count != m_saved_change_count;
+}
+
+size_t source_hash_cache::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+} // namespace archive_diff::diffs::core
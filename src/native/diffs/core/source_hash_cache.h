@@ -0,0 +1,72 @@
+/**
+ * @file source_hash_cache.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include <io/reader.h>
+
+#include "item_definition.h"
+
+namespace archive_diff::diffs::core
+{
+// Remembers the item_definition of files that have already been hashed, so a large source
+// image doesn't need a full hashing pass on every apply. An entry is only used while the
+// file's path, size, modification time and inode are unchanged.
+// The cache can be loaded from and saved to a file between runs.
+class source_hash_cache
+{
+	public:
+	struct file_identity
+	{
+		std::string m_path;
+		uint64_t m_size{};
+		int64_t m_modification_time{};
+		uint64_t m_inode{};
+
+		bool operator==(const file_identity &rhs) const
+		{
+			return std::tie(m_path, m_size, m_modification_time, m_inode)
+			    == std::tie(rhs.m_path, rhs.m_size, rhs.m_modification_time, rhs.m_inode);
+		}
+	};
+
+	// Returns nullopt if the file can't be examined.
+	static std::optional<file_identity> identify(const std::string &path);
+
+	std::optional<item_definition> find(const file_identity &identity) const;
+	void store(const file_identity &identity, const item_definition &item);
+
+	// Uses the cached definition for the file if it is still valid, otherwise hashes
+	// the content using reader and caches the result.
+	item_definition get_definition(const std::string &path, io::reader &reader);
+
+	// A missing or malformed cache file leaves the cache empty; it is never an error
+	// to rehash.
+	void load(const std::string &path);
+	void save(const std::string &path);
+
+	// True when entries were added or replaced since the cache was last loaded or saved.
+	bool has_unsaved_changes() const;
+
+	size_t size() const;
+
+	private:
+	mutable std::mutex m_mutex;
+
+	// Counts stores that changed an entry; save() records the count it wrote.
+	uint64_t m_change_count{};
+	uint64_t m_saved_change_count{};
+
+	// One entry per path; storing a new identity for a path replaces the stale one.
+	std::map<std::string, std::pair<file_identity, item_definition>> m_entries;
+};
+} // namespace archive_diff::diffs::core
@@ -0,0 +1,370 @@
+/**
+ * @file tee_reader_factory.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "tee_reader_factory.h"
+
+#include <errors/user_exception.h>
+
+#include <io/file/temp_file.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fmt/format.h>
+
+namespace archive_diff::diffs::core
+{
+const uint64_t c_tee_chunk_size = 64 * 1024;
+
+struct tee_reader_factory::state
+{
+	struct chunk
+	{
+		uint64_t m_offset{};
+		std::vector<char> m_data;
+	};
+
+	std::mutex m_mutex;
+
+	std::shared_ptr<io::sequential::reader_factory> m_source_factory;
+	std::unique_ptr<io::sequential::reader> m_source;
+	size_t m_source_reader_count{};
+
+	uint64_t m_size{};
+	uint64_t m_window_size{};
+	uint64_t m_chunk_size{};
+	uint64_t m_produced{};
+
+	// Consumers that haven't been made yet, and the offsets of the ones that are reading.
+	size_t m_unopened_consumers{};
+	size_t m_next_consumer_id{};
+	std::map<size_t, uint64_t> m_consumer_offsets;
+
+	std::deque<chunk> m_window;
+	uint64_t m_window_bytes{};
+	uint64_t m_peak_window_bytes{};
+
+	// Content from m_spill_start to m_spill_end, once the window has overflowed.
+	std::shared_ptr<io::file::temp_file> m_spill;
+	uint64_t m_spill_start{};
+	uint64_t m_spill_end{};
+
+	// Set once make_reader() has staged the content; everything then goes to the spill file.
+	bool m_staging{false};
+	std::optional<io::reader> m_staged;
+
+	// The methods below are called with m_mutex held.
+	uint64_t get_lowest_needed_offset() const
+	{
+		if (m_unopened_consumers > 0)
+		{
+			return 0;
+		}
+
+		uint64_t lowest = m_size;
+		for (const auto &[id, offset] : m_consumer_offsets)
+		{
+			lowest = std::min(lowest, offset);
+		}
+		return lowest;
+	}
+
+	bool is_retained_from_start() const
+	{
+		if (m_spill)
+		{
+			return m_spill_start == 0;
+		}
+
+		if (!m_window.empty())
+		{
+			return m_window.front().m_offset == 0;
+		}
+
+		return m_produced == 0;
+	}
+
+	void produce_chunk()
+	{
+		if (!m_source)
+		{
+			m_source = m_source_factory->make_sequential_reader();
+			m_source_reader_count++;
+		}
+
+		chunk produced;
+		produced.m_offset = m_produced;
+		produced.m_data.resize(static_cast<size_t>(std::min(m_chunk_size, m_size - m_produced)));
+
+		size_t filled{};
+		while (filled < produced.m_data.size())
+		{
+			auto actual = m_source->read_some(std::span<char>{produced.m_data}.subspan(filled));
+			if (actual == 0)
+			{
+				throw errors::user_exception(
+					errors::error_code::diffs_prepared_item_shared_content_unavailable,
+					fmt::format(
+						"tee_reader_factory: Source ended at {} bytes, expected {}.", m_produced + filled, m_size));
+			}
+			filled += actual;
+		}
+
+		m_produced += filled;
+		m_window_bytes += filled;
+		m_peak_window_bytes = std::max(m_peak_window_bytes, m_window_bytes);
+		m_window.push_back(std::move(produced));
+
+		if (m_produced == m_size)
+		{
+			m_source.reset();
+		}
+	}
+
+	void spill_front()
+	{
+		auto &front = m_window.front();
+
+		if (!m_spill)
+		{
+			m_spill       = std::make_shared<io::file::temp_file>();
+			m_spill_start = front.m_offset;
+			m_spill_end   = front.m_offset;
+		}
+
+		m_spill->write(m_spill_end - m_spill_start, std::string_view{front.m_data.data(), front.m_data.size()});
+		m_spill_end += front.m_data.size();
+		m_window_bytes -= front.m_data.size();
+		m_window.pop_front();
+	}
+
+	// Drops content no consumer needs anymore and spills the oldest content while the
+	// window is over its limit. Once spilling has started everything leaving the window
+	// goes to the spill file, so it stays contiguous.
+	void trim()
+	{
+		auto lowest_needed = get_lowest_needed_offset();
+
+		while (!m_window.empty())
+		{
+			auto &front    = m_window.front();
+			auto front_end = front.m_offset + front.m_data.size();
+
+			if (!m_spill && (front_end <= lowest_needed))
+			{
+				m_window_bytes -= front.m_data.size();
+				m_window.pop_front();
+				continue;
+			}
+
+			if (m_staging || (m_window_bytes > m_window_size))
+			{
+				spill_front();
+				continue;
+			}
+
+			break;
+		}
+	}
+
+	size_t read_at(uint64_t offset, std::span<char> buffer)
+	{
+		if ((offset >= m_size) || buffer.empty())
+		{
+			return 0;
+		}
+
+		while (offset >= m_produced)
+		{
+			produce_chunk();
+			trim();
+		}
+
+		if (m_spill && (m_spill_start <= offset) && (offset < m_spill_end))
+		{
+			auto to_read = static_cast<size_t>(std::min<uint64_t>(buffer.size(), m_spill_end - offset));
+			return m_spill->read_some(offset - m_spill_start, buffer.subspan(0, to_read));
+		}
+
+		for (const auto &chunk : m_window)
+		{
+			if ((chunk.m_offset <= offset) && (offset < chunk.m_offset + chunk.m_data.size()))
+			{
+				auto chunk_offset = static_cast<size_t>(offset - chunk.m_offset);
+				auto to_copy      = std::min(buffer.size(), chunk.m_data.size() - chunk_offset);
+				std::memcpy(buffer.data(), chunk.m_data.data() + chunk_offset, to_copy);
+				return to_copy;
+			}
+		}
+
+		throw errors::user_exception(
+			errors::error_code::diffs_prepared_item_shared_content_unavailable,
+			fmt::format("tee_reader_factory: Offset {} is no longer retained.", offset));
+	}
+
+	// Fills as much of the buffer as the content allows, across chunk and spill boundaries.
+	size_t read(size_t id, uint64_t offset, std::span<char> buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		size_t total{};
+		while (total < buffer.size())
+		{
+			auto actual = read_at(offset + total, buffer.subspan(total));
+			if (actual == 0)
+			{
+				break;
+			}
+			total += actual;
+
+			m_consumer_offsets[id] = offset + total;
+			trim();
+		}
+
+		return total;
+	}
+
+	void move_to(size_t id, uint64_t offset)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_consumer_offsets[id] = offset;
+		trim();
+	}
+
+	void release(size_t id)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_consumer_offsets.erase(id);
+		trim();
+	}
+};
+
+class tee_reader_factory::consumer : public io::sequential::reader
+{
+	public:
+	consumer(std::shared_ptr<state> &state, size_t id) : m_state(state), m_id(id) {}
+
+	virtual ~consumer() { m_state->release(m_id); }
+
+	virtual void skip(uint64_t to_skip) override
+	{
+		m_offset = std::min(m_offset + to_skip, m_state->m_size);
+		m_state->move_to(m_id, m_offset);
+	}
+
+	virtual size_t read_some(std::span<char> buffer) override
+	{
+		auto actual = m_state->read(m_id, m_offset, buffer);
+		m_offset += actual;
+		return actual;
+	}
+
+	virtual uint64_t tellg() const override { return m_offset; }
+	virtual uint64_t size() const override { return m_state->m_size; }
+
+	private:
+	std::shared_ptr<state> m_state;
+	size_t m_id{};
+	uint64_t m_offset{};
+};
+
+tee_reader_factory::tee_reader_factory(
+	std::shared_ptr<io::sequential::reader_factory> &source,
+	uint64_t size,
+	size_t consumer_count,
+	uint64_t window_size) :
+	m_state(std::make_shared<state>())
+{
+	m_state->m_source_factory     = source;
+	m_state->m_size               = size;
+	m_state->m_unopened_consumers = consumer_count;
+	m_state->m_window_size        = window_size;
+	// Several chunks fit in the window, so consumers a little apart don't cause spilling.
+	m_state->m_chunk_size = std::clamp<uint64_t>(window_size / 4, 1, c_tee_chunk_size);
+}
+
+std::unique_ptr<io::sequential::reader> tee_reader_factory::make_sequential_reader()
+{
+	std::lock_guard<std::mutex> lock(m_state->m_mutex);
+
+	if (m_state->m_unopened_consumers > 0)
+	{
+		m_state->m_unopened_consumers--;
+	}
+	else if (!m_state->is_retained_from_start())
+	{
+		m_state->m_source_reader_count++;
+		return m_state->m_source_factory->make_sequential_reader();
+	}
+
+	auto id                         = m_state->m_next_consumer_id++;
+	m_state->m_consumer_offsets[id] = 0;
+
+	return std::make_unique<consumer>(m_state, id);
+}
+
+io::reader tee_reader_factory::make_reader()
+{
+	std::lock_guard<std::mutex> lock(m_state->m_mutex);
+
+	if (m_state->m_staged.has_value())
+	{
+		return m_state->m_staged.value();
+	}
+
+	if (m_state->is_retained_from_start())
+	{
+		m_state->m_staging = true;
+		if (!m_state->m_spill)
+		{
+			m_state->m_spill = std::make_shared<io::file::temp_file>();
+		}
+
+		m_state->trim();
+		while (m_state->m_produced < m_state->m_size)
+		{
+			m_state->produce_chunk();
+			m_state->trim();
+		}
+
+		m_state->m_staged = io::file::temp_file_io_device::make_reader(m_state->m_spill);
+		return m_state->m_staged.value();
+	}
+
+	// Part of the content is gone already, so it has to be produced again.
+	auto temp_file  = std::make_shared<io::file::temp_file>();
+	auto seq_reader = m_state->m_source_factory->make_sequential_reader();
+	m_state->m_source_reader_count++;
+
+	io::shared_writer writer = std::make_shared<io::file::temp_file_writer>(temp_file);
+	io::sequential::basic_writer_wrapper wrapper(writer);
+	wrapper.write(*seq_reader);
+
+	m_state->m_staged = io::file::temp_file_io_device::make_reader(temp_file);
+	return m_state->m_staged.value();
+}
+
+uint64_t tee_reader_factory::get_peak_window_size() const
+{
+	std::lock_guard<std::mutex> lock(m_state->m_mutex);
+	return m_state->m_peak_window_bytes;
+}
+
+uint64_t tee_reader_factory::get_spilled_size() const
+{
+	std::lock_guard<std::mutex> lock(m_state->m_mutex);
+	return m_state->m_spill_end - m_state->m_spill_start;
+}
+
+size_t tee_reader_factory::get_source_reader_count() const
+{
+	std::lock_guard<std::mutex> lock(m_state->m_mutex);
+	return m_state->m_source_reader_count;
+}
+} // namespace archive_diff::diffs::core
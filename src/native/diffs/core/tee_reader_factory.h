@@ -0,0 +1,64 @@
+/**
+ * @file tee_reader_factory.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <io/reader.h>
+#include <io/sequential/reader_factory.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace archive_diff::io::file
+{
+class temp_file;
+}
+
+namespace archive_diff::diffs::core
+{
+// Shares one sequential source between several consumers, so content that is expensive
+// to produce (decompression, patching) is only produced once.
+//
+// Each reader made by the factory is a consumer reading at its own pace. Content pulled
+// from the source is kept in a window until every expected consumer has read past it.
+// When the window grows beyond its limit because consumers have drifted apart, the oldest
+// content is spilled to a temp file that lagging consumers read from instead.
+//
+// Consumers that haven't been made yet are treated as sitting at the start, so content
+// is retained for them. Any readers beyond the expected count that arrive after the start
+// has been released get their own reader from the source factory.
+class tee_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	static const uint64_t c_default_window_size = 4 * 1024 * 1024;
+
+	tee_reader_factory(
+		std::shared_ptr<io::sequential::reader_factory> &source,
+		uint64_t size,
+		size_t consumer_count,
+		uint64_t window_size = c_default_window_size);
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override;
+
+	// Returns a reader over the whole content. When the content is still retained from the start
+	// the spill file is used to stage it, so staging doesn't produce the content a second time.
+	io::reader make_reader();
+
+	uint64_t get_peak_window_size() const;
+	uint64_t get_spilled_size() const;
+	size_t get_source_reader_count() const;
+
+	private:
+	class consumer;
+	struct state;
+
+	std::shared_ptr<state> m_state;
+};
+} // namespace archive_diff::diffs::core
@@ -34,6 +34,7 @@ diffs::core::recipe::prepare_result all_zeros_recipe::prepare(
 {
 	std::shared_ptr<io::reader_factory> factory =
 		std::make_shared<zeros_reader_factory>(m_result_item_definition.size());
-	return std::make_shared<prepared_item>(m_result_item_definition, diffs::core::prepared_item::reader_kind{factory});
+	return std::make_shared<prepared_item>(
+		m_result_item_definition, diffs::core::prepared_item::reader_kind{factory, {}, true});
 }
 } // namespace archive_diff::diffs::recipes::basic
@@ -34,6 +34,11 @@ class all_zeros_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{.m_cpu_per_byte = 0.0};
+	}
+
 	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
 
 	inline static const std::string c_recipe_name{"all_zeros"};
@@ -15,6 +15,24 @@ chain_recipe::chain_recipe(
 	recipe(result_item_definition, number_ingredients, item_ingredients)
 {}
 
+std::vector<diffs::core::recipe::ingredient_read> chain_recipe::get_ingredient_reads() const
+{
+	std::vector<ingredient_read> reads;
+
+	uint64_t result_offset{};
+	for (auto &ingredient : m_item_ingredients)
+	{
+		reads.push_back(ingredient_read{
+			.m_length        = ingredient.size(),
+			.m_result_offset = result_offset,
+			.m_result_length = ingredient.size(),
+			.m_in_order      = true});
+		result_offset += ingredient.size();
+	}
+
+	return reads;
+}
+
 diffs::core::recipe::prepare_result chain_recipe::prepare(
 	kitchen *, std::vector<std::shared_ptr<prepared_item>> &items) const
 {
@@ -32,6 +32,15 @@ class chain_recipe : public recipe
 		const std::vector<uint64_t> &number_ingredients,
 		const std::vector<item_definition> &item_ingredients);
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
+
+	// The parts are read in turn; their own recipes carry the cost.
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{.m_cpu_per_byte = 0.0};
+	}
+
+	// Each part is read in order as its place in the result is produced.
+	virtual std::vector<ingredient_read> get_ingredient_reads() const override;
 	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
 
 	inline static const std::string c_recipe_name = "chain";
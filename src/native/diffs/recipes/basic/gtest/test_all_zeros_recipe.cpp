@@ -198,3 +198,77 @@ TEST(all_zero_recipe, fetch_from_kitchen)
 			sequential_reader.get(), num_zeros, expected_hash, std::string_view{expected_data.data(), num_zeros});
 	}
 }
+
+// Counts the data written, and the zeros written without data.
+class zeros_counting_writer : public archive_diff::io::writer
+{
+	public:
+	virtual void write(uint64_t offset, std::string_view buffer) override
+	{
+		m_data_bytes += buffer.size();
+		m_size = std::max<uint64_t>(m_size, offset + buffer.size());
+	}
+
+	virtual void write_zeros(uint64_t offset, uint64_t length) override
+	{
+		m_zero_bytes += length;
+		m_size = std::max<uint64_t>(m_size, offset + length);
+	}
+
+	virtual void flush() override {}
+	virtual uint64_t size() const override { return m_size; }
+
+	uint64_t m_data_bytes{};
+	uint64_t m_zero_bytes{};
+	uint64_t m_size{};
+};
+
+TEST(all_zero_recipe, write_as_zeros)
+{
+	const size_t num_zeros = 100000;
+
+	std::vector<char> expected_data(num_zeros);
+	archive_diff::hashing::hasher hasher(archive_diff::hashing::algorithm::sha256);
+	hasher.hash_data(expected_data);
+
+	auto item = archive_diff::diffs::core::item_definition{num_zeros}.with_hash(hasher.get_hash());
+
+	archive_diff::diffs::recipes::basic::all_zeros_recipe recipe(item, {num_zeros}, {});
+
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	std::vector<std::shared_ptr<archive_diff::diffs::core::prepared_item>> no_prepared_ingredients;
+	auto prepared_item = recipe.prepare(kitchen.get(), no_prepared_ingredients);
+
+	ASSERT_TRUE(prepared_item->is_all_zeros());
+
+	for (bool verify_hash : {false, true})
+	{
+		auto counter                                     = std::make_shared<zeros_counting_writer>();
+		std::shared_ptr<archive_diff::io::writer> writer = counter;
+		prepared_item->write(writer, verify_hash);
+
+		ASSERT_EQ(0, counter->m_data_bytes);
+		ASSERT_EQ(num_zeros, counter->m_zero_bytes);
+	}
+
+	// A definition that doesn't match is still caught when verifying.
+	archive_diff::hashing::hasher wrong_hasher(archive_diff::hashing::algorithm::sha256);
+	wrong_hasher.hash_data(std::string_view{"not zeros"});
+	auto wrong_item = archive_diff::diffs::core::item_definition{num_zeros}.with_hash(wrong_hasher.get_hash());
+
+	archive_diff::diffs::recipes::basic::all_zeros_recipe wrong_recipe(wrong_item, {num_zeros}, {});
+	auto wrong_prepared_item = wrong_recipe.prepare(kitchen.get(), no_prepared_ingredients);
+
+	std::shared_ptr<archive_diff::io::writer> writer = std::make_shared<zeros_counting_writer>();
+
+	auto error = archive_diff::errors::error_code::none;
+	try
+	{
+		wrong_prepared_item->write(writer, true);
+	}
+	catch (archive_diff::errors::user_exception &e)
+	{
+		error = e.get_error();
+	}
+	ASSERT_EQ(archive_diff::errors::error_code::diffs_prepared_item_written_hash_mismatch, error);
+}
@@ -0,0 +1,189 @@
+/**
+ * @file test_kitchen_planning.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+
+#include <io/buffer/reader_factory.h>
+#include <io/buffer/writer.h>
+
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+
+#include <diffs/core/kitchen.h>
+
+using item_definition = archive_diff::diffs::core::item_definition;
+using recipe          = archive_diff::diffs::core::recipe;
+
+const size_t c_planning_item_size = 16;
+
+// Distinct items of the same size; the data behind them is only read by the tests that write.
+static item_definition make_planning_item(const std::string &label)
+{
+	std::string data = label;
+	data.resize(c_planning_item_size, '.');
+	return create_definition_from_data(data);
+}
+
+static std::shared_ptr<recipe> make_chain(const item_definition &result, std::vector<item_definition> ingredients)
+{
+	archive_diff::diffs::recipes::basic::chain_recipe::recipe_template chain_template{};
+	return chain_template.create_recipe(result, {}, ingredients);
+}
+
+static std::shared_ptr<recipe> make_slice(const item_definition &result, const item_definition &base)
+{
+	archive_diff::diffs::recipes::basic::slice_recipe::recipe_template slice_template{};
+	return slice_template.create_recipe(result, {0}, {base});
+}
+
+static bool plan_item(archive_diff::diffs::core::kitchen &kitchen, const item_definition &item)
+{
+	std::set<item_definition> mocked_items;
+	kitchen.request_item(item);
+	return kitchen.process_requested_items(true, mocked_items);
+}
+
+TEST(kitchen_planning, deep_nest_of_recipes)
+{
+	// Deep enough to exhaust the stack if each level were planned by a nested call.
+	const size_t c_depth = 50000;
+
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+
+	auto base = make_planning_item("base");
+	std::set<item_definition> mocked_items{base};
+
+	auto previous = base;
+	for (size_t i = 0; i < c_depth; i++)
+	{
+		auto item   = make_planning_item("level " + std::to_string(i));
+		auto recipe = make_chain(item, {previous});
+		kitchen->add_recipe(recipe);
+		previous = item;
+	}
+
+	kitchen->request_item(previous);
+	ASSERT_TRUE(kitchen->process_requested_items(true, mocked_items));
+	ASSERT_TRUE(kitchen->can_fetch_selected_recipe(previous));
+	ASSERT_TRUE(kitchen->can_fetch_selected_recipe(make_planning_item("level 0")));
+}
+
+TEST(kitchen_planning, unreachable_until_recipe_added)
+{
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+
+	auto base = make_planning_item("base");
+
+	std::shared_ptr<std::vector<char>> base_data = std::make_shared<std::vector<char>>();
+	std::string base_text = "base";
+	base_text.resize(c_planning_item_size, '.');
+	base_data->assign(base_text.begin(), base_text.end());
+
+	using device = archive_diff::io::buffer::io_device;
+	std::shared_ptr<archive_diff::io::reader_factory> base_factory =
+		std::make_shared<archive_diff::io::buffer::reader_factory>(base_data, device::size_kind::vector_size);
+	auto prep_base = std::make_shared<archive_diff::diffs::core::prepared_item>(
+		base, archive_diff::diffs::core::prepared_item::reader_kind{base_factory});
+	kitchen->store_item(prep_base);
+
+	auto part  = make_planning_item("part");
+	auto whole = make_planning_item("whole");
+	auto other = make_planning_item("other");
+
+	auto whole_recipe = make_chain(whole, {part});
+	auto other_recipe = make_chain(other, {part});
+	kitchen->add_recipe(whole_recipe);
+	kitchen->add_recipe(other_recipe);
+
+	ASSERT_FALSE(plan_item(*kitchen, whole));
+	// Asking again is answered from what was found the first time.
+	ASSERT_FALSE(plan_item(*kitchen, whole));
+	ASSERT_FALSE(plan_item(*kitchen, other));
+
+	// 'part' holds the same data as the base, so a chain of just the base makes it.
+	auto part_from_base = make_chain(part, {base});
+	kitchen->add_recipe(part_from_base);
+
+	ASSERT_TRUE(plan_item(*kitchen, whole));
+	ASSERT_TRUE(kitchen->can_fetch_selected_recipe(part));
+
+	// Everything that was missing 'part' was invalidated along with it.
+	kitchen->request_item(other);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	auto result_data = std::make_shared<std::vector<char>>();
+	archive_diff::io::buffer::writer writer(result_data);
+
+	kitchen->resume_slicing();
+	kitchen->write_item(writer, other);
+	kitchen->cancel_slicing();
+
+	ASSERT_EQ(*base_data, *result_data);
+}
+
+TEST(kitchen_planning, unreachable_until_item_stored)
+{
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+
+	auto base  = make_planning_item("base");
+	auto whole = make_planning_item("whole");
+
+	auto whole_recipe = make_chain(whole, {base});
+	kitchen->add_recipe(whole_recipe);
+
+	ASSERT_FALSE(plan_item(*kitchen, whole));
+
+	auto base_data = std::make_shared<std::vector<char>>(c_planning_item_size);
+	using device   = archive_diff::io::buffer::io_device;
+	std::shared_ptr<archive_diff::io::reader_factory> base_factory =
+		std::make_shared<archive_diff::io::buffer::reader_factory>(base_data, device::size_kind::vector_size);
+	auto prep_base = std::make_shared<archive_diff::diffs::core::prepared_item>(
+		base, archive_diff::diffs::core::prepared_item::reader_kind{base_factory});
+	kitchen->store_item(prep_base);
+
+	ASSERT_TRUE(plan_item(*kitchen, whole));
+}
+
+TEST(kitchen_planning, cycles_between_recipes)
+{
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+
+	auto base = make_planning_item("base");
+	std::set<item_definition> mocked_items{base};
+
+	// 'first' and 'second' can each be made from the other; only 'first' has another way.
+	auto first  = make_planning_item("first");
+	auto second = make_planning_item("second");
+	for (auto &recipe : {make_chain(first, {second}), make_chain(second, {first}), make_slice(first, base)})
+	{
+		auto to_add = recipe;
+		kitchen->add_recipe(to_add);
+	}
+
+	kitchen->request_item(second);
+	ASSERT_TRUE(kitchen->process_requested_items(true, mocked_items));
+	ASSERT_TRUE(kitchen->can_fetch_selected_recipe(first));
+
+	// 'third' and 'fourth' only have each other until a recipe for 'fourth' is added.
+	auto third  = make_planning_item("third");
+	auto fourth = make_planning_item("fourth");
+	for (auto &recipe : {make_chain(third, {fourth}), make_chain(fourth, {third})})
+	{
+		auto to_add = recipe;
+		kitchen->add_recipe(to_add);
+	}
+
+	kitchen->request_item(third);
+	ASSERT_FALSE(kitchen->process_requested_items(true, mocked_items));
+	ASSERT_FALSE(kitchen->process_requested_items(true, mocked_items));
+
+	auto fourth_from_base = make_slice(fourth, base);
+	kitchen->add_recipe(fourth_from_base);
+
+	ASSERT_TRUE(kitchen->process_requested_items(true, mocked_items));
+	ASSERT_TRUE(kitchen->can_fetch_selected_recipe(third));
+}
@@ -0,0 +1,149 @@
+/**
+ * @file test_kitchen_preparation.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+#include <test_utility/random_data_file.h>
+
+#include <io/buffer/reader_factory.h>
+#include <io/buffer/writer.h>
+
+#include <diffs/recipes/basic/all_zeros_recipe.h>
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+
+#include <diffs/core/kitchen.h>
+
+using item_definition = archive_diff::diffs::core::item_definition;
+
+struct preparation_test_data
+{
+	std::shared_ptr<std::vector<char>> m_base_data;
+	item_definition m_base_item;
+	std::vector<std::shared_ptr<archive_diff::diffs::core::recipe>> m_recipes;
+	std::vector<char> m_expected_data;
+	item_definition m_target_item;
+};
+
+// Builds a two-level chain: the target is a chain of groups, each group is a chain
+// of slices of the base item and all-zero regions. Every group can be prepared
+// independently of the others.
+static preparation_test_data create_preparation_test_data(size_t group_count, size_t parts_per_group)
+{
+	preparation_test_data data;
+
+	const size_t part_size = 1024;
+
+	data.m_base_data = std::make_shared<std::vector<char>>(
+		archive_diff::test_utility::create_random_data(group_count * parts_per_group * part_size, 0));
+	data.m_base_item = create_definition_from_data(std::string_view{data.m_base_data->data(), data.m_base_data->size()});
+
+	archive_diff::diffs::recipes::basic::slice_recipe::recipe_template slice_template{};
+	archive_diff::diffs::recipes::basic::chain_recipe::recipe_template chain_template{};
+	archive_diff::diffs::recipes::basic::all_zeros_recipe::recipe_template zeros_template{};
+
+	std::vector<item_definition> group_items;
+
+	for (size_t group = 0; group < group_count; group++)
+	{
+		std::vector<char> group_data;
+		std::vector<item_definition> part_items;
+
+		for (size_t part = 0; part < parts_per_group; part++)
+		{
+			// Walk the base backwards so the chained result differs from the base.
+			size_t offset = ((group_count * parts_per_group) - 1 - (group * parts_per_group + part)) * part_size;
+			std::string_view part_data{data.m_base_data->data() + offset, part_size};
+
+			std::vector<char> zeros(part_size / 2 + part, 0);
+			auto zeros_item = create_definition_from_data(std::string_view{zeros.data(), zeros.size()});
+			data.m_recipes.push_back(zeros_template.create_recipe(zeros_item, {}, {}));
+
+			auto part_item = create_definition_from_data(part_data);
+			data.m_recipes.push_back(slice_template.create_recipe(part_item, {offset}, {data.m_base_item}));
+
+			part_items.push_back(part_item);
+			part_items.push_back(zeros_item);
+			group_data.insert(group_data.end(), part_data.begin(), part_data.end());
+			group_data.insert(group_data.end(), zeros.begin(), zeros.end());
+		}
+
+		auto group_item = create_definition_from_data(std::string_view{group_data.data(), group_data.size()});
+		data.m_recipes.push_back(chain_template.create_recipe(group_item, {}, part_items));
+
+		group_items.push_back(group_item);
+		data.m_expected_data.insert(data.m_expected_data.end(), group_data.begin(), group_data.end());
+	}
+
+	data.m_target_item =
+		create_definition_from_data(std::string_view{data.m_expected_data.data(), data.m_expected_data.size()});
+	data.m_recipes.push_back(chain_template.create_recipe(data.m_target_item, {}, group_items));
+
+	return data;
+}
+
+static std::vector<char> prepare_and_write(preparation_test_data &data, uint32_t thread_count)
+{
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	kitchen->set_preparation_thread_count(thread_count);
+
+	using device = archive_diff::io::buffer::io_device;
+	std::shared_ptr<archive_diff::io::reader_factory> base_factory =
+		std::make_shared<archive_diff::io::buffer::reader_factory>(data.m_base_data, device::size_kind::vector_size);
+	auto prep_base = std::make_shared<archive_diff::diffs::core::prepared_item>(
+		data.m_base_item, archive_diff::diffs::core::prepared_item::reader_kind{base_factory});
+	kitchen->store_item(prep_base);
+
+	for (auto &recipe : data.m_recipes)
+	{
+		kitchen->add_recipe(recipe);
+	}
+
+	kitchen->request_item(data.m_target_item);
+	EXPECT_TRUE(kitchen->process_requested_items());
+
+	auto result_data = std::make_shared<std::vector<char>>();
+	archive_diff::io::buffer::writer writer(result_data);
+
+	kitchen->resume_slicing();
+	kitchen->write_item(writer, data.m_target_item);
+	kitchen->cancel_slicing();
+
+	return *result_data;
+}
+
+TEST(kitchen_preparation, parallel_matches_serial)
+{
+	auto data = create_preparation_test_data(8, 16);
+
+	auto serial_result = prepare_and_write(data, 1);
+	ASSERT_EQ(data.m_expected_data.size(), serial_result.size());
+	ASSERT_EQ(0, std::memcmp(data.m_expected_data.data(), serial_result.data(), serial_result.size()));
+
+	for (uint32_t thread_count : {2, 4, 8})
+	{
+		auto parallel_result = prepare_and_write(data, thread_count);
+		ASSERT_EQ(serial_result, parallel_result);
+	}
+}
+
+TEST(kitchen_preparation, parallel_reports_unreachable)
+{
+	auto data = create_preparation_test_data(4, 4);
+
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	kitchen->set_preparation_thread_count(4);
+
+	// No base item in the pantry, so none of the slices can be made.
+	for (auto &recipe : data.m_recipes)
+	{
+		kitchen->add_recipe(recipe);
+	}
+
+	kitchen->request_item(data.m_target_item);
+	ASSERT_FALSE(kitchen->process_requested_items());
+	ASSERT_FALSE(kitchen->can_fetch_item(data.m_target_item));
+}
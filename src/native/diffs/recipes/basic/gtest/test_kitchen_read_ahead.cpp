@@ -0,0 +1,175 @@
+/**
+ * @file test_kitchen_read_ahead.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+
+#include <io/buffer/io_device.h>
+#include <io/buffer/writer.h>
+#include <io/reader_factory.h>
+
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+
+#include <diffs/core/kitchen.h>
+
+using item_definition = archive_diff::diffs::core::item_definition;
+using access_hint     = archive_diff::io::access_hint;
+
+struct recorded_hint
+{
+	uint64_t m_offset{};
+	uint64_t m_length{};
+	access_hint m_hint{};
+
+	bool operator==(const recorded_hint &) const = default;
+};
+
+// Stands in for a source file; records the hints the kitchen gives it.
+class hint_recording_reader_factory : public archive_diff::io::reader_factory
+{
+	public:
+	class device : public archive_diff::io::buffer::io_device
+	{
+		public:
+		device(std::shared_ptr<std::vector<char>> &buffer) : io_device(buffer, size_kind::vector_size) {}
+
+		virtual void hint(uint64_t offset, uint64_t length, access_hint hint) override
+		{
+			m_hints.push_back(recorded_hint{offset, length, hint});
+		}
+
+		std::vector<recorded_hint> m_hints;
+	};
+
+	hint_recording_reader_factory(std::shared_ptr<std::vector<char>> &buffer) :
+		m_device(std::make_shared<device>(buffer))
+	{}
+
+	virtual archive_diff::io::reader make_reader() override
+	{
+		archive_diff::io::shared_io_device as_device = m_device;
+		return archive_diff::io::reader{as_device};
+	}
+
+	std::shared_ptr<device> m_device;
+};
+
+struct read_ahead_fixture
+{
+	read_ahead_fixture()
+	{
+		std::string source_text = "0123456789abcdefghijklmnopqrstuv";
+		m_source_data           = std::make_shared<std::vector<char>>(source_text.begin(), source_text.end());
+		m_source                = create_definition_from_data(source_text);
+		m_factory               = std::make_shared<hint_recording_reader_factory>(m_source_data);
+
+		std::shared_ptr<archive_diff::io::reader_factory> factory = m_factory;
+		auto prep_source = std::make_shared<archive_diff::diffs::core::prepared_item>(
+			m_source, archive_diff::diffs::core::prepared_item::reader_kind{factory});
+		m_kitchen->store_item(prep_source);
+
+		// The result is the second quarter of the source followed by the first.
+		auto later   = create_definition_from_data(source_text.substr(16, 8));
+		auto earlier = create_definition_from_data(source_text.substr(0, 8));
+		m_result     = create_definition_from_data(source_text.substr(16, 8) + source_text.substr(0, 8));
+
+		archive_diff::diffs::recipes::basic::slice_recipe::recipe_template slice_template{};
+		archive_diff::diffs::recipes::basic::chain_recipe::recipe_template chain_template{};
+		for (auto &recipe :
+		     {slice_template.create_recipe(later, {16}, {m_source}),
+		      slice_template.create_recipe(earlier, {0}, {m_source}),
+		      chain_template.create_recipe(m_result, {}, {later, earlier})})
+		{
+			auto to_add = recipe;
+			m_kitchen->add_recipe(to_add);
+		}
+
+		m_kitchen->request_item(m_result);
+		m_planned = m_kitchen->process_requested_items();
+	}
+
+	std::shared_ptr<archive_diff::diffs::core::kitchen> m_kitchen{archive_diff::diffs::core::kitchen::create()};
+	std::shared_ptr<std::vector<char>> m_source_data;
+	std::shared_ptr<hint_recording_reader_factory> m_factory;
+	item_definition m_source;
+	item_definition m_result;
+	bool m_planned{};
+};
+
+TEST(kitchen_read_ahead, planned_reads_follow_output)
+{
+	read_ahead_fixture fixture;
+	ASSERT_TRUE(fixture.m_planned);
+
+	auto reads = fixture.m_kitchen->get_planned_reads(fixture.m_result);
+	ASSERT_EQ(2, reads.size());
+
+	std::sort(reads.begin(), reads.end(), [](auto &left, auto &right) {
+		return left.m_needed_from < right.m_needed_from;
+	});
+
+	ASSERT_EQ(16, reads[0].m_offset);
+	ASSERT_EQ(8, reads[0].m_length);
+	ASSERT_EQ(0, reads[0].m_needed_from);
+	ASSERT_EQ(8, reads[0].m_needed_until);
+
+	ASSERT_EQ(0, reads[1].m_offset);
+	ASSERT_EQ(8, reads[1].m_length);
+	ASSERT_EQ(8, reads[1].m_needed_from);
+	ASSERT_EQ(16, reads[1].m_needed_until);
+
+	ASSERT_EQ(reads[0].m_source, reads[1].m_source);
+}
+
+TEST(kitchen_read_ahead, write_hints_source)
+{
+	read_ahead_fixture fixture;
+	ASSERT_TRUE(fixture.m_planned);
+
+	fixture.m_kitchen->set_read_ahead_window_size(8);
+
+	auto result_data = std::make_shared<std::vector<char>>();
+	archive_diff::io::buffer::writer writer(result_data);
+
+	fixture.m_kitchen->resume_slicing();
+	fixture.m_kitchen->write_item(writer, fixture.m_result);
+	fixture.m_kitchen->cancel_slicing();
+
+	std::string result_text(result_data->begin(), result_data->end());
+	ASSERT_EQ("ghijklmn01234567", result_text);
+
+	// Each range read is hinted as needed before it's read, and as not needed once it's used.
+	auto &hints = fixture.m_factory->m_device->m_hints;
+	ASSERT_EQ(4, hints.size());
+	for (uint64_t offset : {0, 16})
+	{
+		auto will_need = std::find(hints.begin(), hints.end(), recorded_hint{offset, 8, access_hint::will_need});
+		auto dont_need = std::find(hints.begin(), hints.end(), recorded_hint{offset, 8, access_hint::dont_need});
+		ASSERT_NE(hints.end(), will_need);
+		ASSERT_NE(hints.end(), dont_need);
+		ASSERT_LT(will_need, dont_need);
+	}
+	ASSERT_EQ((recorded_hint{16, 8, access_hint::will_need}), hints.front());
+}
+
+TEST(kitchen_read_ahead, disabled_with_zero_window)
+{
+	read_ahead_fixture fixture;
+	ASSERT_TRUE(fixture.m_planned);
+
+	fixture.m_kitchen->set_read_ahead_window_size(0);
+
+	auto result_data = std::make_shared<std::vector<char>>();
+	archive_diff::io::buffer::writer writer(result_data);
+
+	fixture.m_kitchen->resume_slicing();
+	fixture.m_kitchen->write_item(writer, fixture.m_result);
+	fixture.m_kitchen->cancel_slicing();
+
+	ASSERT_EQ(16, result_data->size());
+	ASSERT_TRUE(fixture.m_factory->m_device->m_hints.empty());
+}
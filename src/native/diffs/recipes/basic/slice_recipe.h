@@ -34,6 +34,18 @@ class slice_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	// A streamed item is staged by the kitchen before it can be sliced.
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{.m_random_access_ingredients = true};
+	}
+
+	virtual std::vector<ingredient_read> get_ingredient_reads() const override
+	{
+		auto size = m_result_item_definition.size();
+		return {ingredient_read{.m_offset = m_offset, .m_length = size, .m_result_length = size, .m_in_order = true}};
+	}
+
 	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
 
 	inline static const std::string c_recipe_name{"slice"};
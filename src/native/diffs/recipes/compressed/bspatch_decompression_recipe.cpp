@@ -20,9 +20,10 @@ class bspatch_decompression_reader_factory : public io::sequential::reader_facto
 	bspatch_decompression_reader_factory(
 		const item_definition &uncompressed,
 		std::shared_ptr<prepared_item> &compressed_prepared_item,
-		std::shared_ptr<prepared_item> &dictionary_prepared_item) :
+		std::shared_ptr<prepared_item> &dictionary_prepared_item,
+		io::compressed::bsdiff_patch_format format) :
 		m_uncompressed_result(uncompressed), m_compressed_prepared_item(compressed_prepared_item),
-		m_dictionary_prepared_item(dictionary_prepared_item)
+		m_dictionary_prepared_item(dictionary_prepared_item), m_format(format)
 	{}
 
 	virtual ~bspatch_decompression_reader_factory() = default;
@@ -33,20 +34,30 @@ class bspatch_decompression_reader_factory : public io::sequential::reader_facto
 		auto dictionary_reader = m_dictionary_prepared_item->make_reader();
 
 		return std::make_unique<io::compressed::bspatch_decompression_reader>(
-			compressed_reader, m_uncompressed_result.size(), dictionary_reader);
+			compressed_reader, m_uncompressed_result.size(), dictionary_reader, m_format);
 	}
 
 	private:
 	item_definition m_uncompressed_result{};
 	std::shared_ptr<prepared_item> m_compressed_prepared_item{};
 	std::shared_ptr<prepared_item> m_dictionary_prepared_item{};
+	io::compressed::bsdiff_patch_format m_format{};
 };
 
 bspatch_decompression_recipe::bspatch_decompression_recipe(
 	const item_definition &result_item_definition,
 	const std::vector<uint64_t> &number_ingredients,
 	const std::vector<item_definition> &item_ingredients) :
-	recipe(result_item_definition, number_ingredients, item_ingredients)
+	bspatch_decompression_recipe(
+		result_item_definition, number_ingredients, item_ingredients, io::compressed::bsdiff_patch_format::bz2)
+{}
+
+bspatch_decompression_recipe::bspatch_decompression_recipe(
+	const item_definition &result_item_definition,
+	const std::vector<uint64_t> &number_ingredients,
+	const std::vector<item_definition> &item_ingredients,
+	io::compressed::bsdiff_patch_format format) :
+	recipe(result_item_definition, number_ingredients, item_ingredients), m_format(format)
 {
 	if (item_ingredients.size() != 2)
 	{
@@ -66,8 +77,8 @@ diffs::core::recipe::prepare_result bspatch_decompression_recipe::prepare(
 	auto compressed = items[0];
 	auto dictionary = items[1];
 
-	std::shared_ptr<io::sequential::reader_factory> factory =
-		std::make_shared<bspatch_decompression_reader_factory>(m_result_item_definition, compressed, dictionary);
+	std::shared_ptr<io::sequential::reader_factory> factory = std::make_shared<bspatch_decompression_reader_factory>(
+		m_result_item_definition, compressed, dictionary, m_format);
 
 	return std::make_shared<prepared_item>(
 		m_result_item_definition,
@@ -12,6 +12,8 @@
 
 #include <diffs/core/recipe.h>
 
+#include <io/compressed/bsdiff_patch_packer.h>
+
 namespace archive_diff::diffs::recipes::compressed
 {
 using item_definition = diffs::core::item_definition;
@@ -29,14 +31,30 @@ class bspatch_decompression_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	// Patching reads the basis at random offsets, and the bz2 streams are slow to decompress.
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte              = 10.0,
+			.m_production                = diffs::core::recipe_cost::production::decompress,
+			.m_random_access_ingredients = true};
+	}
+
 	inline static const std::string c_recipe_name{"bspatch_decompression"};
 	using recipe_template = diffs::core::recipe_template_impl<bspatch_decompression_recipe>;
 
 	protected:
+	bspatch_decompression_recipe(
+		const item_definition &result_item_definition,
+		const std::vector<uint64_t> &number_ingredients,
+		const std::vector<item_definition> &item_ingredients,
+		io::compressed::bsdiff_patch_format format);
+
 	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
 
 	private:
 	item_definition m_compressed_input{};
 	item_definition m_dictionary{};
+	io::compressed::bsdiff_patch_format m_format{};
 };
 } // namespace archive_diff::diffs::recipes::compressed
\ No newline at end of file
@@ -0,0 +1,19 @@
+/**
+ * @file bspatch_zstd_decompression_recipe.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include "bspatch_zstd_decompression_recipe.h"
+
+namespace archive_diff::diffs::recipes::compressed
+{
+bspatch_zstd_decompression_recipe::bspatch_zstd_decompression_recipe(
+	const item_definition &result_item_definition,
+	const std::vector<uint64_t> &number_ingredients,
+	const std::vector<item_definition> &item_ingredients) :
+	bspatch_decompression_recipe(
+		result_item_definition, number_ingredients, item_ingredients, io::compressed::bsdiff_patch_format::zstd)
+{}
+} // namespace archive_diff::diffs::recipes::compressed
@@ -0,0 +1,37 @@
+/**
+ * @file bspatch_zstd_decompression_recipe.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+
+#include "bspatch_decompression_recipe.h"
+
+namespace archive_diff::diffs::recipes::compressed
+{
+// Same ingredients as bspatch_decompression_recipe - the patch, then the basis - with the patch
+// streams packed with zstd rather than bz2.
+class bspatch_zstd_decompression_recipe : public bspatch_decompression_recipe
+{
+	public:
+	bspatch_zstd_decompression_recipe(
+		const item_definition &result_item_definition,
+		const std::vector<uint64_t> &number_ingredients,
+		const std::vector<item_definition> &item_ingredients);
+
+	virtual std::string get_recipe_name() const override { return c_recipe_name; }
+
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte              = 4.0,
+			.m_production                = diffs::core::recipe_cost::production::decompress,
+			.m_random_access_ingredients = true};
+	}
+
+	inline static const std::string c_recipe_name{"bspatch_zstd_decompression"};
+	using recipe_template = diffs::core::recipe_template_impl<bspatch_zstd_decompression_recipe>;
+};
+} // namespace archive_diff::diffs::recipes::compressed
@@ -23,6 +23,7 @@
 #include <io/sequential/basic_writer_wrapper.h>
 
 #include <diffs/recipes/compressed/bspatch_decompression_recipe.h>
+#include <diffs/recipes/compressed/bspatch_zstd_decompression_recipe.h>
 
 #include <diffs/core/kitchen.h>
 
@@ -142,3 +143,58 @@ TEST(bspatch_decompression_recipe, make_sequential_reader)
 		std::memcmp(
 			uncompressed_data.data(), uncompressed_from_recipe_data.data(), uncompressed_from_recipe_data.size()));
 }
+
+TEST(bspatch_zstd_decompression_recipe, make_sequential_reader)
+{
+	using namespace archive_diff;
+	using device = io::buffer::io_device;
+
+	const size_t c_data_size = 256 * 1024;
+
+	auto basis_vector = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*basis_vector)[i] = static_cast<char>((i * 7) ^ (i >> 9));
+	}
+	auto result_vector = std::make_shared<std::vector<char>>(*basis_vector);
+	modify_vector(*result_vector, c_data_size - 100, 101, 23, 37);
+
+	auto basis_reader  = device::make_reader(basis_vector, device::size_kind::vector_size);
+	auto result_reader = device::make_reader(result_vector, device::size_kind::vector_size);
+
+	auto diff_vector                          = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> buffer_writer = std::make_shared<io::buffer::writer>(diff_vector);
+	io::compressed::bsdiff_compressor::delta_compress(
+		basis_reader, result_reader, buffer_writer, io::compressed::bsdiff_patch_format::zstd);
+
+	auto result_item = create_definition_from_data(std::string_view{result_vector->data(), result_vector->size()});
+	auto diff_item   = create_definition_from_data(std::string_view{diff_vector->data(), diff_vector->size()});
+	auto basis_item  = create_definition_from_data(std::string_view{basis_vector->data(), basis_vector->size()});
+
+	diffs::recipes::compressed::bspatch_zstd_decompression_recipe::recipe_template recipe_template{};
+	auto recipe = recipe_template.create_recipe(result_item, {}, {diff_item, basis_item});
+	ASSERT_EQ("bspatch_zstd_decompression", recipe->get_recipe_name());
+
+	auto kitchen = diffs::core::kitchen::create();
+	kitchen->add_recipe(recipe);
+
+	auto store_item = [&](const diffs::core::item_definition &item, std::shared_ptr<std::vector<char>> &vector)
+	{
+		std::shared_ptr<io::reader_factory> factory =
+			std::make_shared<io::buffer::reader_factory>(vector, device::size_kind::vector_size);
+		auto prepared = std::make_shared<diffs::core::prepared_item>(
+			item, diffs::core::prepared_item::reader_kind{factory});
+		kitchen->store_item(prepared);
+	};
+	store_item(diff_item, diff_vector);
+	store_item(basis_item, basis_vector);
+
+	kitchen->request_item(result_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	auto sequential_reader = kitchen->fetch_item(result_item)->make_sequential_reader();
+
+	std::vector<char> result_from_recipe;
+	sequential_reader->read_all_remaining(result_from_recipe);
+	ASSERT_EQ(*result_vector, result_from_recipe);
+}
@@ -0,0 +1,148 @@
+/**
+ * @file test_recipe_selection.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <json/json.h>
+
+#include <hashing/hasher.h>
+#include <io/buffer/writer.h>
+
+#include <diffs/recipes/basic/slice_recipe.h>
+#include <diffs/recipes/compressed/bspatch_decompression_recipe.h>
+#include <diffs/recipes/compressed/zstd_decompression_recipe.h>
+
+#include <diffs/core/kitchen.h>
+
+using item_definition = archive_diff::diffs::core::item_definition;
+
+namespace
+{
+item_definition make_item(uint64_t length, const std::string &label)
+{
+	archive_diff::hashing::hasher hasher(archive_diff::hashing::algorithm::sha256);
+	hasher.hash_data(label);
+	return item_definition{length}.with_hash(hasher.get_hash());
+}
+
+const uint64_t c_source_size = 1024 * 1024;
+const uint64_t c_target_size = 64 * 1024;
+
+struct selection_test_items
+{
+	item_definition m_source{make_item(c_source_size, "source")};
+	item_definition m_target{make_item(c_target_size, "target")};
+	item_definition m_compressed{make_item(16 * 1024, "compressed")};
+	item_definition m_patch{make_item(4 * 1024, "patch")};
+
+	std::set<item_definition> m_mocked{m_source, m_compressed, m_patch};
+};
+
+std::shared_ptr<archive_diff::diffs::core::recipe> make_slice(
+	const item_definition &result, const item_definition &whole)
+{
+	archive_diff::diffs::recipes::basic::slice_recipe::recipe_template slice_template{};
+	return slice_template.create_recipe(result, {1024}, {whole});
+}
+
+std::shared_ptr<archive_diff::diffs::core::recipe> make_zstd(
+	const item_definition &result, const item_definition &compressed)
+{
+	archive_diff::diffs::recipes::compressed::zstd_decompression_recipe::recipe_template zstd_template{};
+	return zstd_template.create_recipe(result, {}, {compressed});
+}
+
+std::shared_ptr<archive_diff::diffs::core::recipe> make_bspatch(
+	const item_definition &result, const item_definition &patch, const item_definition &basis)
+{
+	archive_diff::diffs::recipes::compressed::bspatch_decompression_recipe::recipe_template bspatch_template{};
+	return bspatch_template.create_recipe(result, {}, {patch, basis});
+}
+
+std::string select_recipe_name(
+	const item_definition &item,
+	std::vector<std::shared_ptr<archive_diff::diffs::core::recipe>> recipes,
+	std::set<item_definition> &mocked)
+{
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	for (auto &recipe : recipes)
+	{
+		kitchen->add_recipe(recipe);
+	}
+
+	kitchen->request_item(item);
+	EXPECT_TRUE(kitchen->process_requested_items(true, mocked));
+
+	return kitchen->fetch_selected_recipe(item)->get_recipe_name();
+}
+
+Json::Value save_selected_recipes(std::shared_ptr<archive_diff::diffs::core::kitchen> &kitchen)
+{
+	auto saved                                       = std::make_shared<std::vector<char>>();
+	std::shared_ptr<archive_diff::io::writer> writer = std::make_shared<archive_diff::io::buffer::writer>(saved);
+	kitchen->save_selected_recipes(writer);
+
+	Json::Value root;
+	Json::Reader reader;
+	EXPECT_TRUE(reader.parse(std::string{saved->begin(), saved->end()}, root));
+	return root;
+}
+} // namespace
+
+TEST(recipe_selection, cheapest_recipe_wins)
+{
+	selection_test_items items;
+
+	auto slice   = make_slice(items.m_target, items.m_source);
+	auto zstd    = make_zstd(items.m_target, items.m_compressed);
+	auto bspatch = make_bspatch(items.m_target, items.m_patch, items.m_source);
+
+	// Whatever order the recipes are added in, a copy beats decompression, and zstd beats bspatch.
+	ASSERT_EQ(slice->get_recipe_name(), select_recipe_name(items.m_target, {bspatch, zstd, slice}, items.m_mocked));
+	ASSERT_EQ(slice->get_recipe_name(), select_recipe_name(items.m_target, {slice, zstd, bspatch}, items.m_mocked));
+	ASSERT_EQ(zstd->get_recipe_name(), select_recipe_name(items.m_target, {bspatch, zstd}, items.m_mocked));
+	ASSERT_EQ(zstd->get_recipe_name(), select_recipe_name(items.m_target, {zstd, bspatch}, items.m_mocked));
+}
+
+TEST(recipe_selection, staging_is_costed)
+{
+	selection_test_items items;
+
+	// The basis for the patch is only available decompressed as a stream, so it must be staged
+	// before it can be patched. Decompressing the target directly avoids that.
+	auto basis        = make_item(c_source_size, "basis");
+	auto basis_recipe = make_zstd(basis, items.m_compressed);
+	auto bspatch      = make_bspatch(items.m_target, items.m_patch, basis);
+	auto zstd         = make_zstd(items.m_target, items.m_compressed);
+
+	auto kitchen = archive_diff::diffs::core::kitchen::create();
+	kitchen->add_recipe(basis_recipe);
+	kitchen->add_recipe(bspatch);
+
+	kitchen->request_item(items.m_target);
+	ASSERT_TRUE(kitchen->process_requested_items(true, items.m_mocked));
+	ASSERT_EQ(bspatch->get_recipe_name(), kitchen->fetch_selected_recipe(items.m_target)->get_recipe_name());
+
+	auto plan = save_selected_recipes(kitchen);
+	ASSERT_EQ(2, plan["Recipes"].size());
+
+	double patched_cost{};
+	for (auto &recipe : plan["Recipes"])
+	{
+		ASSERT_TRUE(recipe.isMember("EstimatedCost"));
+
+		if (recipe["Name"].asString() == bspatch->get_recipe_name())
+		{
+			ASSERT_EQ(c_source_size, recipe["EstimatedCost"]["TempBytes"].asUInt64());
+			patched_cost = recipe["EstimatedCost"]["Total"].asDouble();
+		}
+	}
+	ASSERT_GT(patched_cost, 0);
+	ASSERT_EQ(patched_cost, plan["EstimatedTotalCost"].asDouble());
+
+	ASSERT_EQ(
+		zstd->get_recipe_name(), select_recipe_name(items.m_target, {basis_recipe, bspatch, zstd}, items.m_mocked));
+}
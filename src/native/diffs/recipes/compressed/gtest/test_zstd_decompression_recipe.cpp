@@ -16,6 +16,7 @@
 #include <io/file/io_device.h>
 #include <io/sequential/basic_writer_wrapper.h>
 
+#include <diffs/recipes/basic/chain_recipe.h>
 #include <diffs/recipes/basic/slice_recipe.h>
 #include <diffs/recipes/compressed/zstd_decompression_recipe.h>
 
@@ -330,3 +331,215 @@ TEST(zstd_decompression_recipe, with_basis)
 		std::memcmp(
 			uncompressed_data.data(), uncompressed_from_recipe_data.data(), uncompressed_from_recipe_data.size()));
 }
+
+TEST(zstd_decompression_recipe, shared_between_consumers)
+{
+	using namespace archive_diff;
+	using device = io::buffer::io_device;
+
+	const size_t c_data_size = 256 * 1024;
+
+	auto uncompressed_vector = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*uncompressed_vector)[i] = static_cast<char>((i % 251) ^ (i >> 11));
+	}
+
+	auto compressed_vector             = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed_vector);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_compression_writer compression_writer(seq_writer, 3, c_data_size);
+		auto uncompressed_reader = device::make_reader(uncompressed_vector, device::size_kind::vector_size);
+		compression_writer.write(uncompressed_reader);
+	}
+
+	auto uncompressed_item = create_definition_from_data({uncompressed_vector->data(), uncompressed_vector->size()});
+	auto compressed_item   = create_definition_from_data({compressed_vector->data(), compressed_vector->size()});
+
+	diffs::recipes::compressed::zstd_decompression_recipe::recipe_template recipe_template{};
+	auto decompress_recipe = recipe_template.create_recipe(uncompressed_item, {}, {compressed_item});
+
+	// The decompressed item is used twice in the target.
+	std::vector<char> doubled(*uncompressed_vector);
+	doubled.insert(doubled.end(), uncompressed_vector->begin(), uncompressed_vector->end());
+	auto doubled_item = create_definition_from_data({doubled.data(), doubled.size()});
+
+	diffs::recipes::basic::chain_recipe::recipe_template chain_template;
+	auto chain_recipe = chain_template.create_recipe(doubled_item, {}, {uncompressed_item, uncompressed_item});
+
+	auto kitchen = diffs::core::kitchen::create();
+	kitchen->set_shared_reader_window_size(16 * 1024);
+	kitchen->add_recipe(decompress_recipe);
+	kitchen->add_recipe(chain_recipe);
+
+	std::shared_ptr<io::reader_factory> compressed_factory =
+		std::make_shared<io::buffer::reader_factory>(compressed_vector, device::size_kind::vector_size);
+	auto prep_compressed = std::make_shared<diffs::core::prepared_item>(
+		compressed_item, diffs::core::prepared_item::reader_kind{compressed_factory});
+	kitchen->store_item(prep_compressed);
+
+	// Requested as well, so it stays in the kitchen.
+	kitchen->request_item(uncompressed_item);
+	kitchen->request_item(doubled_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	ASSERT_TRUE(kitchen->fetch_item(uncompressed_item)->is_shared_sequential_reader());
+
+	auto result = std::make_shared<std::vector<char>>();
+	io::buffer::writer result_writer(result);
+	kitchen->write_item(result_writer, doubled_item);
+	ASSERT_EQ(doubled, *result);
+}
+
+TEST(zstd_decompression_recipe, releases_dead_items)
+{
+	using namespace archive_diff;
+	using device = io::buffer::io_device;
+
+	const size_t c_data_size  = 256 * 1024;
+	const size_t c_slice_size = 64 * 1024;
+
+	auto uncompressed_vector = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*uncompressed_vector)[i] = static_cast<char>((i % 241) ^ (i >> 12));
+	}
+
+	auto compressed_vector             = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed_vector);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_compression_writer compression_writer(seq_writer, 3, c_data_size);
+		auto uncompressed_reader = device::make_reader(uncompressed_vector, device::size_kind::vector_size);
+		compression_writer.write(uncompressed_reader);
+	}
+
+	auto uncompressed_item = create_definition_from_data({uncompressed_vector->data(), uncompressed_vector->size()});
+	auto compressed_item   = create_definition_from_data({compressed_vector->data(), compressed_vector->size()});
+
+	diffs::recipes::compressed::zstd_decompression_recipe::recipe_template recipe_template{};
+	auto decompress_recipe = recipe_template.create_recipe(uncompressed_item, {}, {compressed_item});
+
+	// Two slices of the decompressed item, which has to be staged to slice it.
+	diffs::recipes::basic::slice_recipe::recipe_template slice_template;
+	const uint64_t c_second_offset = c_data_size - c_slice_size;
+	auto first_item    = create_definition_from_data({uncompressed_vector->data(), c_slice_size});
+	auto second_item   = create_definition_from_data({uncompressed_vector->data() + c_second_offset, c_slice_size});
+	auto first_recipe  = slice_template.create_recipe(first_item, {0}, {uncompressed_item});
+	auto second_recipe = slice_template.create_recipe(second_item, {c_second_offset}, {uncompressed_item});
+
+	std::vector<char> expected(uncompressed_vector->begin(), uncompressed_vector->begin() + c_slice_size);
+	expected.insert(expected.end(), uncompressed_vector->end() - c_slice_size, uncompressed_vector->end());
+	auto target_item = create_definition_from_data({expected.data(), expected.size()});
+
+	diffs::recipes::basic::chain_recipe::recipe_template chain_template;
+	auto chain_recipe = chain_template.create_recipe(target_item, {}, {first_item, second_item});
+
+	auto prepare_target = [&](bool release_dead_items)
+	{
+		auto kitchen = diffs::core::kitchen::create();
+		kitchen->set_release_dead_items(release_dead_items);
+		kitchen->add_recipe(decompress_recipe);
+		kitchen->add_recipe(first_recipe);
+		kitchen->add_recipe(second_recipe);
+		kitchen->add_recipe(chain_recipe);
+
+		std::shared_ptr<io::reader_factory> compressed_factory =
+			std::make_shared<io::buffer::reader_factory>(compressed_vector, device::size_kind::vector_size);
+		auto prep_compressed = std::make_shared<diffs::core::prepared_item>(
+			compressed_item, diffs::core::prepared_item::reader_kind{compressed_factory});
+		kitchen->store_item(prep_compressed);
+
+		kitchen->request_item(target_item);
+		EXPECT_TRUE(kitchen->process_requested_items());
+		return kitchen;
+	};
+
+	auto keeping_kitchen = prepare_target(false);
+	ASSERT_TRUE(keeping_kitchen->can_fetch_item(uncompressed_item));
+
+	auto kitchen = prepare_target(true);
+	ASSERT_FALSE(kitchen->can_fetch_item(uncompressed_item));
+	ASSERT_FALSE(kitchen->can_fetch_item(first_item));
+
+	// The staged copy lives on through the slices that use it.
+	ASSERT_EQ(c_data_size, kitchen->get_live_intermediate_bytes());
+	ASSERT_EQ(c_data_size, kitchen->get_peak_intermediate_bytes());
+
+	auto result = std::make_shared<std::vector<char>>();
+	io::buffer::writer result_writer(result);
+	kitchen->write_item(result_writer, target_item);
+	ASSERT_EQ(expected, *result);
+
+	// Requesting a released item prepares it again.
+	kitchen->request_item(uncompressed_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	std::vector<char> uncompressed;
+	kitchen->fetch_item(uncompressed_item)->make_sequential_reader()->read_all_remaining(uncompressed);
+	ASSERT_EQ(*uncompressed_vector, uncompressed);
+}
+
+TEST(zstd_decompression_recipe, profiled)
+{
+	using namespace archive_diff;
+	using device = io::buffer::io_device;
+
+	const size_t c_data_size = 256 * 1024;
+
+	auto uncompressed_vector = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*uncompressed_vector)[i] = static_cast<char>((i % 239) ^ (i >> 10));
+	}
+
+	auto compressed_vector             = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed_vector);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_compression_writer compression_writer(seq_writer, 3, c_data_size);
+		auto uncompressed_reader = device::make_reader(uncompressed_vector, device::size_kind::vector_size);
+		compression_writer.write(uncompressed_reader);
+	}
+
+	auto uncompressed_item = create_definition_from_data({uncompressed_vector->data(), uncompressed_vector->size()});
+	auto compressed_item   = create_definition_from_data({compressed_vector->data(), compressed_vector->size()});
+
+	diffs::recipes::compressed::zstd_decompression_recipe::recipe_template recipe_template{};
+	auto decompress_recipe = recipe_template.create_recipe(uncompressed_item, {}, {compressed_item});
+
+	auto profiler = std::make_shared<diffs::core::apply_profiler>(true);
+
+	auto kitchen = diffs::core::kitchen::create();
+	kitchen->set_profiler(profiler);
+	kitchen->add_recipe(decompress_recipe);
+
+	auto compressed_reader = device::make_reader(compressed_vector, device::size_kind::vector_size);
+	auto profiled_reader   = profiler->wrap_reader(compressed_reader, diffs::core::apply_profiler::read_origin::diff);
+	auto prep_compressed   = std::make_shared<diffs::core::prepared_item>(compressed_item, profiled_reader);
+	kitchen->store_item(prep_compressed);
+
+	kitchen->request_item(uncompressed_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	auto result = std::make_shared<std::vector<char>>();
+	io::buffer::writer result_writer(result);
+	kitchen->write_item(result_writer, uncompressed_item);
+	ASSERT_EQ(*uncompressed_vector, *result);
+
+	auto summary = profiler->get_summary();
+
+	auto &recipe = summary["recipes"][diffs::recipes::compressed::zstd_decompression_recipe::c_recipe_name];
+	ASSERT_EQ(1, recipe["prepare_count"].asUInt64());
+	ASSERT_EQ(1, recipe["reader_count"].asUInt64());
+	ASSERT_EQ(c_data_size, summary["decompression"]["zstd"]["bytes_produced"].asUInt64());
+
+	ASSERT_EQ(compressed_vector->size(), summary["bytes_read"]["diff"].asUInt64());
+	ASSERT_EQ(1, summary["write"]["count"].asUInt64());
+	ASSERT_EQ(c_data_size, summary["write"]["bytes_written"].asUInt64());
+	ASSERT_GT(summary["trace_events"].asUInt64(), 0);
+}
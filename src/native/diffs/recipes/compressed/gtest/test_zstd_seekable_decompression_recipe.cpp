@@ -0,0 +1,90 @@
+/**
+ * @file test_zstd_seekable_decompression_recipe.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/buffer_helpers.h>
+
+#include <io/buffer/io_device.h>
+#include <io/buffer/reader_factory.h>
+#include <io/buffer/writer.h>
+#include <io/compressed/zstd_compression_writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <diffs/recipes/basic/slice_recipe.h>
+#include <diffs/recipes/compressed/zstd_seekable_decompression_recipe.h>
+
+#include <diffs/core/kitchen.h>
+
+TEST(zstd_seekable_decompression_recipe, slice_without_staging)
+{
+	using namespace archive_diff;
+	using device = io::buffer::io_device;
+
+	const size_t c_data_size    = 512 * 1024;
+	const uint32_t c_frame_size = 32 * 1024;
+
+	auto uncompressed_vector = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*uncompressed_vector)[i] = static_cast<char>((i % 253) ^ (i >> 10));
+	}
+
+	auto compressed_vector             = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed_vector);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+	{
+		io::compressed::zstd_seekable_format seekable{c_frame_size};
+		io::compressed::zstd_compression_writer compression_writer(
+			seq_writer, 3, c_data_size, io::compressed::zstd_compression_workers{}, seekable);
+
+		auto uncompressed_reader = device::make_reader(uncompressed_vector, device::size_kind::vector_size);
+		compression_writer.write(uncompressed_reader);
+	}
+
+	auto uncompressed_item = create_definition_from_data({uncompressed_vector->data(), uncompressed_vector->size()});
+	auto compressed_item   = create_definition_from_data({compressed_vector->data(), compressed_vector->size()});
+
+	diffs::recipes::compressed::zstd_seekable_decompression_recipe::recipe_template recipe_template{};
+	auto decompress_recipe = recipe_template.create_recipe(uncompressed_item, {}, {compressed_item});
+
+	const uint64_t c_slice_offset = 7 * c_frame_size + 100;
+	const uint64_t c_slice_length = 2 * c_frame_size;
+	auto slice_item = create_definition_from_data({uncompressed_vector->data() + c_slice_offset, c_slice_length});
+
+	diffs::recipes::basic::slice_recipe::recipe_template slice_template;
+	auto slice_recipe = slice_template.create_recipe(slice_item, {c_slice_offset}, {uncompressed_item});
+
+	auto kitchen = diffs::core::kitchen::create();
+	kitchen->add_recipe(decompress_recipe);
+	kitchen->add_recipe(slice_recipe);
+
+	std::shared_ptr<io::reader_factory> compressed_factory =
+		std::make_shared<io::buffer::reader_factory>(compressed_vector, device::size_kind::vector_size);
+	auto prep_compressed = std::make_shared<diffs::core::prepared_item>(
+		compressed_item, diffs::core::prepared_item::reader_kind{compressed_factory});
+	kitchen->store_item(prep_compressed);
+
+	kitchen->request_item(uncompressed_item);
+	kitchen->request_item(slice_item);
+	ASSERT_TRUE(kitchen->process_requested_items());
+
+	// The decompressed item is readable at random, so it isn't staged to reach the slice.
+	auto prep_uncompressed = kitchen->fetch_item(uncompressed_item);
+	ASSERT_TRUE(prep_uncompressed->can_make_reader());
+
+	auto prep_slice = kitchen->fetch_item(slice_item);
+	ASSERT_TRUE(prep_slice->can_make_reader());
+
+	std::vector<char> slice_data;
+	prep_slice->make_reader().read_all(slice_data);
+	ASSERT_EQ(c_slice_length, slice_data.size());
+	ASSERT_EQ(0, std::memcmp(slice_data.data(), uncompressed_vector->data() + c_slice_offset, c_slice_length));
+
+	std::vector<char> all_data;
+	prep_uncompressed->make_sequential_reader()->read_all_remaining(all_data);
+	ASSERT_EQ(*uncompressed_vector, all_data);
+}
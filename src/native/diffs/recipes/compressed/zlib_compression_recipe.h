@@ -32,6 +32,12 @@ class zlib_compression_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte = 20.0, .m_production = diffs::core::recipe_cost::production::decompress};
+	}
+
 	inline static const std::string c_recipe_name{"zlib_compression"};
 	using recipe_template = diffs::core::recipe_template_impl<zlib_compression_recipe>;
 
@@ -30,6 +30,12 @@ class zlib_decompression_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte = 3.0, .m_production = diffs::core::recipe_cost::production::decompress};
+	}
+
 	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
 
 	inline static const std::string c_recipe_name{"zlib_decompression"};
@@ -30,6 +30,12 @@ class zstd_decompression_recipe : public recipe
 
 	virtual std::string get_recipe_name() const override { return c_recipe_name; }
 
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte = 1.0, .m_production = diffs::core::recipe_cost::production::decompress};
+	}
+
 	inline static const std::string c_recipe_name{"zstd_decompression"};
 	using recipe_template = diffs::core::recipe_template_impl<zstd_decompression_recipe>;
 
@@ -0,0 +1,110 @@
+/**
+ * @file zstd_seekable_decompression_recipe.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "zstd_seekable_decompression_recipe.h"
+
+#include <io/compressed/zstd_decompression_reader.h>
+#include <io/compressed/zstd_seekable_io_device.h>
+#include <io/reader_factory.h>
+#include <io/sequential/reader_factory.h>
+
+#include <diffs/core/prepared_item.h>
+
+namespace archive_diff::diffs::recipes::compressed
+{
+class zstd_seekable_reader_factory : public io::reader_factory
+{
+	public:
+	zstd_seekable_reader_factory(
+		const item_definition &uncompressed, std::shared_ptr<prepared_item> &compressed_prepared_item) :
+		m_uncompressed_result(uncompressed), m_compressed_prepared_item(compressed_prepared_item)
+	{}
+
+	virtual io::reader make_reader() override
+	{
+		auto compressed_reader = m_compressed_prepared_item->make_reader();
+
+		io::reader reader;
+		if (!io::compressed::zstd_seekable_io_device::try_make_reader(compressed_reader, &reader))
+		{
+			throw errors::user_exception(
+				errors::error_code::io_zstd_seek_table_invalid,
+				"zstd_seekable_decompression_recipe: Compressed item has no seek table.");
+		}
+
+		if (reader.size() != m_uncompressed_result.size())
+		{
+			std::string msg = "zstd_seekable_decompression_recipe: Seek table describes "
+			                + std::to_string(reader.size()) + " bytes, expected "
+			                + std::to_string(m_uncompressed_result.size());
+			throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+		}
+
+		return reader;
+	}
+
+	private:
+	item_definition m_uncompressed_result{};
+	std::shared_ptr<prepared_item> m_compressed_prepared_item{};
+};
+
+class zstd_seekable_sequential_reader_factory : public io::sequential::reader_factory
+{
+	public:
+	zstd_seekable_sequential_reader_factory(
+		const item_definition &uncompressed, std::shared_ptr<prepared_item> &compressed_prepared_item) :
+		m_uncompressed_result(uncompressed), m_compressed_prepared_item(compressed_prepared_item)
+	{}
+
+	virtual std::unique_ptr<io::sequential::reader> make_sequential_reader() override
+	{
+		return std::make_unique<io::compressed::zstd_decompression_reader>(
+			m_compressed_prepared_item->make_sequential_reader(), m_uncompressed_result.size());
+	}
+
+	private:
+	item_definition m_uncompressed_result{};
+	std::shared_ptr<prepared_item> m_compressed_prepared_item{};
+};
+
+zstd_seekable_decompression_recipe::zstd_seekable_decompression_recipe(
+	const item_definition &result_item_definition,
+	const std::vector<uint64_t> &number_ingredients,
+	const std::vector<item_definition> &item_ingredients) :
+	recipe(result_item_definition, number_ingredients, item_ingredients)
+{
+	if (item_ingredients.size() != 1)
+	{
+		throw errors::user_exception(
+			errors::error_code::diff_recipe_invalid_parameter_count,
+			"zstd_seekable_decompression_recipe: Incorrect item count. Expected 1, found "
+				+ std::to_string(item_ingredients.size()));
+	}
+
+	m_compressed_input = item_ingredients[0];
+}
+
+diffs::core::recipe::prepare_result zstd_seekable_decompression_recipe::prepare(
+	[[maybe_unused]] kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const
+{
+	auto compressed = items[0];
+
+	if (compressed->can_make_reader())
+	{
+		std::shared_ptr<io::reader_factory> factory =
+			std::make_shared<zstd_seekable_reader_factory>(m_result_item_definition, compressed);
+
+		return std::make_shared<prepared_item>(
+			m_result_item_definition, diffs::core::prepared_item::reader_kind{factory, items});
+	}
+
+	std::shared_ptr<io::sequential::reader_factory> factory =
+		std::make_shared<zstd_seekable_sequential_reader_factory>(m_result_item_definition, compressed);
+
+	return std::make_shared<prepared_item>(
+		m_result_item_definition, diffs::core::prepared_item::sequential_reader_kind{factory, items});
+}
+} // namespace archive_diff::diffs::recipes::compressed
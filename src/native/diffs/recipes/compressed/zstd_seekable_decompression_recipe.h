@@ -0,0 +1,49 @@
+/**
+ * @file zstd_seekable_decompression_recipe.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <diffs/core/recipe_template.h>
+#include <diffs/core/recipe_template_impl.h>
+
+#include <diffs/core/recipe.h>
+
+namespace archive_diff::diffs::recipes::compressed
+{
+using item_definition = diffs::core::item_definition;
+using recipe          = diffs::core::recipe;
+using kitchen         = diffs::core::kitchen;
+using prepared_item   = diffs::core::prepared_item;
+
+// Decompresses an item written in the zstd seekable format. When the compressed item can be
+// read at random, so can the result, and reading part of it only decompresses the frames
+// that part covers. Otherwise the result is decompressed sequentially, as plain zstd.
+class zstd_seekable_decompression_recipe : public recipe
+{
+	public:
+	zstd_seekable_decompression_recipe(
+		const item_definition &result_item_definition,
+		const std::vector<uint64_t> &number_ingredients,
+		const std::vector<item_definition> &item_ingredients);
+
+	virtual std::string get_recipe_name() const override { return c_recipe_name; }
+
+	virtual diffs::core::recipe_cost get_cost() const override
+	{
+		return diffs::core::recipe_cost{
+			.m_cpu_per_byte = 1.0, .m_production = diffs::core::recipe_cost::production::decompress};
+	}
+
+	inline static const std::string c_recipe_name{"zstd_seekable_decompression"};
+	using recipe_template = diffs::core::recipe_template_impl<zstd_seekable_decompression_recipe>;
+
+	protected:
+	virtual prepare_result prepare(kitchen *kitchen, std::vector<std::shared_ptr<prepared_item>> &items) const override;
+
+	private:
+	item_definition m_compressed_input{};
+};
+} // namespace archive_diff::diffs::recipes::compressed
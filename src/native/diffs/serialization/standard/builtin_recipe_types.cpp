@@ -13,10 +13,12 @@
 #include <diffs/recipes/basic/slice_recipe.h>
 
 #include <diffs/recipes/compressed/bspatch_decompression_recipe.h>
+#include <diffs/recipes/compressed/bspatch_zstd_decompression_recipe.h>
 #include <diffs/recipes/compressed/zlib_compression_recipe.h>
 #include <diffs/recipes/compressed/zlib_decompression_recipe.h>
 #include <diffs/recipes/compressed/zstd_compression_recipe.h>
 #include <diffs/recipes/compressed/zstd_decompression_recipe.h>
+#include <diffs/recipes/compressed/zstd_seekable_decompression_recipe.h>
 
 namespace archive_diff::diffs::serialization::standard
 {
@@ -37,5 +39,8 @@ void ensure_builtin_recipe_types(core::archive *archive)
 	ensure_builtin_recipe<diffs::recipes::compressed::zlib_decompression_recipe>(archive);
 	ensure_builtin_recipe<diffs::recipes::compressed::zstd_compression_recipe>(archive);
 	ensure_builtin_recipe<diffs::recipes::compressed::zstd_decompression_recipe>(archive);
+	// Recipe type ids follow this order, so new types go last.
+	ensure_builtin_recipe<diffs::recipes::compressed::bspatch_zstd_decompression_recipe>(archive);
+	ensure_builtin_recipe<diffs::recipes::compressed::zstd_seekable_decompression_recipe>(archive);
 }
 } // namespace archive_diff::diffs::serialization::standard
\ No newline at end of file
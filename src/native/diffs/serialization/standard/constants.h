@@ -11,4 +11,6 @@ namespace archive_diff::diffs::serialization::standard
 static const std::string g_DIFF_MAGIC_VALUE   = "PAMZ";
 static const uint64_t g_STANDARD_DIFF_VERSION = 1;
 static const uint64_t g_STANDARD_DIFF_VERSION_2 = 2;
+// Version 2 with an index of the recipe sets, so recipes can be loaded as they're needed.
+static const uint64_t g_STANDARD_DIFF_VERSION_3 = 3;
 } // namespace archive_diff::diffs::serialization::standard
\ No newline at end of file
@@ -6,6 +6,7 @@
  */
 #include "deserializer.h"
 #include "constants.h"
+#include "recipe_index.h"
 
 #include <io/reader.h>
 #include <io/basic_reader_factory.h>
@@ -15,6 +16,7 @@
 #include <io/buffer/writer.h>
 #include <io/sequential/basic_writer_wrapper.h>
 #include <io/compressed/zlib_compression_writer.h>
+#include <io/hashed/verifying_io_device.h>
 
 #include <errors/user_exception.h>
 #include <hashing/hash.h>
@@ -53,10 +55,10 @@ bool deserializer::is_this_format(io::reader &reader, std::string *reason)
 
 	reader.read_uint64_t(4, &version);
 
-	if (version != g_STANDARD_DIFF_VERSION_2)
+	if ((version != g_STANDARD_DIFF_VERSION_2) && (version != g_STANDARD_DIFF_VERSION_3))
 	{
-		*reason = "Wrong version. Expected: " + std::to_string(g_STANDARD_DIFF_VERSION_2)
-		        + ", Found: " + std::to_string(version);
+		*reason = "Wrong version. Expected: " + std::to_string(g_STANDARD_DIFF_VERSION_2) + " or "
+		        + std::to_string(g_STANDARD_DIFF_VERSION_3) + ", Found: " + std::to_string(version);
 		return false;
 	}
 
@@ -68,7 +70,14 @@ void deserializer::read(io::reader &reader)
 	io::sequential::basic_reader_wrapper seq(reader);
 	read_header(seq);
 	read_supported_recipe_types(seq);
-	read_recipes(seq);
+	if (m_version == g_STANDARD_DIFF_VERSION_3)
+	{
+		read_recipe_index(seq, reader);
+	}
+	else
+	{
+		read_recipes(seq);
+	}
 	read_inline_assets(seq, reader);
 	read_remainder(seq, reader);
 
@@ -92,13 +101,12 @@ void deserializer::read_header(io::sequential::reader &seq)
 		throw errors::user_exception(errors::error_code::diff_magic_header_wrong, msg);
 	}
 
-	uint64_t version;
-	seq.read_uint64_t(&version);
+	seq.read_uint64_t(&m_version);
 
-	if (version != g_STANDARD_DIFF_VERSION_2)
+	if ((m_version != g_STANDARD_DIFF_VERSION_2) && (m_version != g_STANDARD_DIFF_VERSION_3))
 	{
-		std::string msg = "Not a valid version. Expected: " + std::to_string(g_STANDARD_DIFF_VERSION_2)
-		                + ", Found: " + std::to_string(version);
+		std::string msg = "Not a valid version. Expected: " + std::to_string(g_STANDARD_DIFF_VERSION_2) + " or "
+		                + std::to_string(g_STANDARD_DIFF_VERSION_3) + ", Found: " + std::to_string(m_version);
 		throw errors::user_exception(errors::error_code::diff_version_wrong, msg);
 	}
 
@@ -134,67 +142,72 @@ void deserializer::read_supported_recipe_types(io::sequential::reader &seq)
 	}
 }
 
-void deserializer::read_recipe(io::sequential::reader &seq, const core::item_definition &result_item)
+void deserializer::read_recipes(io::sequential::reader &seq)
 {
-	uint32_t recipe_type_id;
-	seq.read_uint32_t(&recipe_type_id);
-
-	uint64_t numbers_count;
-	seq.read_uint64_t(&numbers_count);
+	uint64_t result_count;
+	seq.read_uint64_t(&result_count);
 
-	std::vector<uint64_t> number_ingredients;
-	while (numbers_count)
+	std::vector<std::shared_ptr<core::recipe>> recipes;
+	for (uint64_t result_index = 0; result_index < result_count; result_index++)
 	{
-		uint64_t number;
-		seq.read_uint64_t(&number);
-		number_ingredients.push_back(number);
-		numbers_count--;
-	}
+		recipes.clear();
+		read_recipe_set(seq, m_archive->get_recipe_templates(), &recipes);
 
-	uint64_t items_count;
-	seq.read_uint64_t(&items_count);
-
-	std::vector<core::item_definition> item_ingredients;
-	while (items_count)
-	{
-		auto item = core::item_definition::read(seq, core::item_definition::serialization_options::standard);
-		item_ingredients.push_back(item);
-		items_count--;
+		for (auto &recipe : recipes)
+		{
+			m_archive->add_recipe(recipe);
+		}
 	}
-
-	auto recipe = m_archive->create_recipe(recipe_type_id, result_item, number_ingredients, item_ingredients);
-
-	m_archive->add_recipe(recipe);
 }
 
-void deserializer::read_recipe_set(io::sequential::reader &seq)
+// The recipe sets aren't read here; the cookbook loads them through the index as items are looked up.
+void deserializer::read_recipe_index(io::sequential::reader &seq, io::reader &reader)
 {
-	uint64_t recipes_count;
-	seq.read_uint64_t(&recipes_count);
+	uint64_t result_count;
+	seq.read_uint64_t(&result_count);
 
-	auto result_item = core::item_definition::read(seq, diffs::core::item_definition::standard);
+	uint64_t recipes_size;
+	seq.read_uint64_t(&recipes_size);
 
-	for (uint64_t i = 0; i < recipes_count; i++)
+	auto recipes_offset = seq.tellg();
+	if (recipes_size > reader.size() - recipes_offset)
 	{
-		read_recipe(seq, result_item);
+		std::string msg = "Recipes extend past the end of the diff. Size: " + std::to_string(recipes_size);
+		throw errors::user_exception(errors::error_code::diff_recipe_index_invalid, msg);
 	}
-}
+	seq.skip(recipes_size);
 
-void deserializer::read_recipes(io::sequential::reader &seq)
-{
-	uint64_t result_count;
-	seq.read_uint64_t(&result_count);
+	uint64_t index_entry_count;
+	seq.read_uint64_t(&index_entry_count);
 
-	for (uint64_t result_index = 0; result_index < result_count; result_index++)
+	auto index_offset = seq.tellg();
+	if (index_entry_count > (reader.size() - index_offset) / recipe_index_entry::c_serialized_size)
 	{
-		read_recipe_set(seq);
+		std::string msg =
+			"Recipe index extends past the end of the diff. Entries: " + std::to_string(index_entry_count);
+		throw errors::user_exception(errors::error_code::diff_recipe_index_invalid, msg);
 	}
+	auto index_size = index_entry_count * recipe_index_entry::c_serialized_size;
+	seq.skip(index_size);
+
+	auto source = std::make_shared<indexed_recipe_source>(
+		reader.slice(recipes_offset, recipes_size),
+		result_count,
+		reader.slice(index_offset, index_size),
+		index_entry_count,
+		m_archive->get_recipe_templates());
+	m_archive->get_cookbook()->set_recipe_source(source);
 }
 
 void deserializer::set_compressed_remainder(io::reader &reader)
 {
-	m_remainder_compressed_item =
-		core::create_definition_from_reader(reader).with_name(core::archive::c_remainder_compressed);
+	store_compressed_remainder(
+		core::create_definition_from_reader(reader).with_name(core::archive::c_remainder_compressed), reader);
+}
+
+void deserializer::store_compressed_remainder(const core::item_definition &item, io::reader &reader)
+{
+	m_remainder_compressed_item = item;
 
 	std::shared_ptr<io::reader_factory> remainder_compressed_factory =
 		std::make_shared<io::basic_reader_factory>(reader);
@@ -253,7 +266,12 @@ void deserializer::set_remainder(const std::string &path)
 
 void deserializer::set_inline_assets(io::reader &reader)
 {
-	m_inline_assets_item = core::create_definition_from_reader(reader).with_name(core::archive::c_inline_assets);
+	store_inline_assets(core::create_definition_from_reader(reader).with_name(core::archive::c_inline_assets), reader);
+}
+
+void deserializer::store_inline_assets(const core::item_definition &item, io::reader &reader)
+{
+	m_inline_assets_item = item;
 
 	std::shared_ptr<io::reader_factory> inline_assets_factory = std::make_shared<io::basic_reader_factory>(reader);
 
@@ -279,7 +297,15 @@ void deserializer::read_inline_assets(io::sequential::reader &seq, io::reader &r
 	{
 		auto inline_assets_offset = seq.tellg();
 		auto inline_assets_reader = reader.slice(inline_assets_offset, inline_assets_item.size());
-		set_inline_assets(inline_assets_reader);
+		if (m_deferred_verification && inline_assets_item.has_hash_for_alg(hashing::algorithm::sha256))
+		{
+			auto verifying_reader = make_verifying_reader(inline_assets_item, inline_assets_reader);
+			store_inline_assets(inline_assets_item, verifying_reader);
+		}
+		else
+		{
+			set_inline_assets(inline_assets_reader);
+		}
 
 		if (!inline_assets_item.equals(m_inline_assets_item))
 		{
@@ -300,7 +326,15 @@ void deserializer::read_remainder(io::sequential::reader &seq, io::reader &reade
 	{
 		auto remainder_offset            = seq.tellg();
 		auto remainder_compressed_reader = reader.slice(remainder_offset, remainder_compressed_item.size());
-		set_compressed_remainder(remainder_compressed_reader);
+		if (m_deferred_verification && remainder_compressed_item.has_hash_for_alg(hashing::algorithm::sha256))
+		{
+			auto verifying_reader = make_verifying_reader(remainder_compressed_item, remainder_compressed_reader);
+			store_compressed_remainder(remainder_compressed_item, verifying_reader);
+		}
+		else
+		{
+			set_compressed_remainder(remainder_compressed_reader);
+		}
 
 		if (!remainder_compressed_item.equals(m_remainder_compressed_item))
 		{
@@ -311,6 +345,20 @@ void deserializer::read_remainder(io::sequential::reader &seq, io::reader &reade
 	}
 }
 
+io::reader deserializer::make_verifying_reader(const core::item_definition &item, io::reader &reader)
+{
+	auto expected = hashing::hash::import_hash_value(
+		hashing::algorithm::sha256, item.get_hash_data(hashing::algorithm::sha256));
+	auto device = std::make_shared<io::hashed::verifying_io_device>(reader, expected);
+
+	// The archive's kitchens finish the check once something is written, covering anything
+	// the apply didn't read.
+	m_archive->add_deferred_verification([device]() { device->verify_all(); });
+
+	std::shared_ptr<io::io_device> verifying_device = device;
+	return io::reader{io::io_device_view{verifying_device}};
+}
+
 void deserializer::read_nested_archives(io::reader &reader)
 {
 	uint32_t nested_archives_count;
@@ -333,6 +381,7 @@ void deserializer::read_nested_archives(io::reader &reader)
 		auto archive_reader = reader.slice(offset, archive_data_item.size());
 
 		deserializer nested;
+		nested.set_deferred_verification(m_deferred_verification);
 		nested.read(archive_reader);
 
 		auto archive = nested.get_archive();
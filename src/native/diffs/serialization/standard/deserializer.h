@@ -30,6 +30,13 @@ class deserializer
 
 	static bool is_this_format(io::reader &reader, std::string *reason);
 
+	// When set, the inline assets and remainder are stored with the definitions serialized
+	// in the diff instead of being hashed while reading. They are hashed as the apply reads
+	// them instead, and kitchens stocked from the archive hash whatever wasn't read once an
+	// item is written; see io::hashed::verifying_io_device. Either way, content that doesn't
+	// match its definition fails the apply.
+	void set_deferred_verification(bool value) { m_deferred_verification = value; }
+
 	void read(io::reader &reader);
 
 	void set_target_item(const core::item_definition &item) { m_archive->set_archive_item(item); }
@@ -62,12 +69,15 @@ class deserializer
 	void read_header(io::sequential::reader &seq);
 	void read_supported_recipe_types(io::sequential::reader &seq);
 	void read_recipes(io::sequential::reader &seq);
-	void read_recipe_set(io::sequential::reader &seq);
-	void read_recipe(io::sequential::reader &seq, const core::item_definition &result_item);
+	void read_recipe_index(io::sequential::reader &seq, io::reader &reader);
 	void read_inline_assets(io::sequential::reader &seq, io::reader &reader);
 	void read_remainder(io::sequential::reader &seq, io::reader &reader);
 	void read_nested_archives(io::reader &reader);
 
+	void store_inline_assets(const core::item_definition &item, io::reader &reader);
+	void store_compressed_remainder(const core::item_definition &item, io::reader &reader);
+	io::reader make_verifying_reader(const core::item_definition &item, io::reader &reader);
+
 	std::shared_ptr<diffs::core::archive> m_archive{std::make_shared<diffs::core::archive>()};
 	std::optional<diffs::core::item_definition> m_origin;
 
@@ -76,6 +86,9 @@ class deserializer
 
 	core::item_definition m_source_item;
 
+	uint64_t m_version{};
+	bool m_deferred_verification{false};
+
 	core::item_definition m_inline_assets_item{};
 	core::item_definition m_remainder_uncompressed_item{};
 	core::item_definition m_remainder_compressed_item{};
@@ -0,0 +1,11 @@
+/**
+ * @file main.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <language_support/include_filesystem.h>
+
+extern fs::path g_test_data_root;
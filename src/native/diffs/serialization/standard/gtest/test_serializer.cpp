@@ -0,0 +1,257 @@
+/**
+ * @file test_serializer.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <errors/user_exception.h>
+#include <hashing/hasher.h>
+
+#include <io/buffer/io_device.h>
+#include <io/buffer/writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <diffs/core/item_definition_helpers.h>
+#include <diffs/core/kitchen.h>
+#include <diffs/recipes/basic/chain_recipe.h>
+#include <diffs/recipes/basic/slice_recipe.h>
+#include <diffs/serialization/standard/deserializer.h>
+#include <diffs/serialization/standard/serializer.h>
+
+using namespace archive_diff;
+
+using item_definition = diffs::core::item_definition;
+
+const uint64_t c_chunk_size      = 1024;
+const size_t c_chunk_count      = 300;
+const size_t c_chunks_per_group = 16;
+
+static item_definition make_item(uint64_t length, const std::string &label)
+{
+	hashing::hasher hasher(hashing::algorithm::sha256);
+	hasher.hash_data(label);
+	return item_definition{length}.with_hash(hasher.get_hash());
+}
+
+static item_definition make_chunk_item(size_t index)
+{
+	return make_item(c_chunk_size, "chunk " + std::to_string(index));
+}
+
+// The target is a chain of groups, each a chain of chunks sliced out of the source.
+static std::shared_ptr<diffs::core::archive> make_archive()
+{
+	diffs::serialization::standard::deserializer builder;
+
+	auto source_item = make_item(c_chunk_count * c_chunk_size, "source");
+	builder.set_source_item(source_item);
+
+	std::vector<item_definition> groups;
+	std::vector<item_definition> chunks;
+	for (size_t i = 0; i < c_chunk_count; i++)
+	{
+		auto chunk = make_chunk_item(i);
+		builder.add_recipe(
+			diffs::recipes::basic::slice_recipe::c_recipe_name, chunk, {i * c_chunk_size}, {source_item});
+		chunks.push_back(chunk);
+
+		if (chunks.size() == c_chunks_per_group || (i + 1 == c_chunk_count))
+		{
+			auto group = make_item(chunks.size() * c_chunk_size, "group " + std::to_string(groups.size()));
+			builder.add_recipe(diffs::recipes::basic::chain_recipe::c_recipe_name, group, {}, chunks);
+			groups.push_back(group);
+			chunks.clear();
+		}
+	}
+
+	auto target = make_item(c_chunk_count * c_chunk_size, "target");
+	builder.add_recipe(diffs::recipes::basic::chain_recipe::c_recipe_name, target, {}, groups);
+	builder.set_target_item(target);
+
+	return builder.get_archive();
+}
+
+static std::shared_ptr<std::vector<char>> serialize(std::shared_ptr<diffs::core::archive> &archive, bool index)
+{
+	auto serialized                    = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(serialized);
+	io::sequential::basic_writer_wrapper seq(writer);
+
+	diffs::serialization::standard::serializer serializer(archive);
+	serializer.set_write_recipe_index(index);
+	serializer.write(seq);
+
+	return serialized;
+}
+
+static std::shared_ptr<diffs::core::archive> deserialize(
+	std::shared_ptr<std::vector<char>> &serialized, bool deferred_verification = false)
+{
+	auto reader = io::buffer::io_device::make_reader(serialized, io::buffer::io_device::size_kind::vector_size);
+
+	std::string reason;
+	EXPECT_TRUE(diffs::serialization::standard::deserializer::is_this_format(reader, &reason));
+
+	diffs::serialization::standard::deserializer deserializer;
+	deserializer.set_deferred_verification(deferred_verification);
+	deserializer.read(reader);
+	return deserializer.get_archive();
+}
+
+TEST(standard_serializer, recipe_index_round_trip)
+{
+	auto archive = make_archive();
+
+	auto without_index = serialize(archive, false);
+	auto with_index    = serialize(archive, true);
+	ASSERT_NE(*without_index, *with_index);
+
+	auto indexed_archive = deserialize(with_index);
+	ASSERT_EQ(archive->get_archive_item(), indexed_archive->get_archive_item());
+
+	auto cookbook = indexed_archive->get_cookbook();
+
+	const diffs::core::recipe_set *recipes;
+	ASSERT_TRUE(cookbook->find_recipes_for_item(make_chunk_item(123), &recipes));
+	ASSERT_EQ(1, recipes->size());
+	auto &slice = *recipes->begin();
+	ASSERT_EQ(diffs::recipes::basic::slice_recipe::c_recipe_name, slice->get_recipe_name());
+	ASSERT_EQ(123 * c_chunk_size, slice->get_number_ingredients()[0]);
+
+	ASSERT_TRUE(cookbook->find_recipes_for_item(archive->get_archive_item(), &recipes));
+	ASSERT_EQ(1, recipes->size());
+	ASSERT_EQ(c_chunk_count / c_chunks_per_group + 1, (*recipes->begin())->get_item_ingredients().size());
+
+	ASSERT_FALSE(cookbook->find_recipes_for_item(make_chunk_item(c_chunk_count), &recipes));
+
+	// Everything not yet looked up is loaded when all recipes are asked for.
+	ASSERT_EQ(archive->get_cookbook()->get_all_recipes().size(), cookbook->get_all_recipes().size());
+	ASSERT_EQ(*without_index, *serialize(indexed_archive, false));
+	ASSERT_EQ(*with_index, *serialize(indexed_archive, true));
+
+	// Diffs without an index are still read up front.
+	auto unindexed_archive = deserialize(without_index);
+	ASSERT_EQ(*with_index, *serialize(unindexed_archive, true));
+}
+
+TEST(standard_serializer, recipe_index_loads_on_demand)
+{
+	auto archive    = make_archive();
+	auto with_index = serialize(archive, true);
+
+	// The index is followed by the empty inline assets and remainder and the nested archive count.
+	auto empty_item                         = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> item_writer = std::make_shared<io::buffer::writer>(empty_item);
+	io::sequential::basic_writer_wrapper item_seq(item_writer);
+	item_definition{0}.write(item_seq, item_definition::serialization_options::standard);
+	auto trailer_size = 2 * empty_item->size() + sizeof(uint32_t);
+
+	// The last entry is for the largest item, the target. Point it past the end of the recipes.
+	auto last_offset = with_index->size() - trailer_size - sizeof(uint64_t);
+	std::memset(with_index->data() + last_offset, 0x7f, sizeof(uint64_t));
+
+	auto indexed_archive = deserialize(with_index);
+	auto cookbook        = indexed_archive->get_cookbook();
+
+	// Recipes that don't involve the bad entry are unaffected.
+	const diffs::core::recipe_set *recipes;
+	ASSERT_TRUE(cookbook->find_recipes_for_item(make_chunk_item(7), &recipes));
+
+	bool caught = false;
+	try
+	{
+		cookbook->find_recipes_for_item(archive->get_archive_item(), &recipes);
+	}
+	catch (errors::user_exception &e)
+	{
+		caught = true;
+		ASSERT_EQ(errors::error_code::diff_recipe_index_invalid, e.get_error());
+	}
+	ASSERT_TRUE(caught);
+}
+
+TEST(standard_serializer, deferred_verification)
+{
+	const std::string c_inline_assets_content = "inline assets for deferred_verification";
+
+	diffs::serialization::standard::deserializer builder;
+	builder.set_target_item(make_item(1, "target"));
+
+	auto inline_assets =
+		std::make_shared<std::vector<char>>(c_inline_assets_content.begin(), c_inline_assets_content.end());
+	auto inline_assets_reader =
+		io::buffer::io_device::make_reader(inline_assets, io::buffer::io_device::size_kind::vector_size);
+	builder.set_inline_assets(inline_assets_reader);
+
+	std::shared_ptr<diffs::core::prepared_item> original;
+	ASSERT_TRUE(
+		builder.get_archive()->try_fetch_stored_item_by_name(diffs::core::archive::c_inline_assets, &original));
+
+	// An item made only from bytes after the first, which is the one altered below.
+	auto tail      = c_inline_assets_content.substr(1);
+	auto tail_item = diffs::core::create_definition_from_string_view(tail);
+	builder.add_recipe(
+		diffs::recipes::basic::slice_recipe::c_recipe_name, tail_item, {1}, {original->get_item_definition()});
+
+	auto archive    = builder.get_archive();
+	auto serialized = serialize(archive, false);
+
+	ASSERT_EQ(0, deserialize(serialized)->get_deferred_verification_count());
+	ASSERT_EQ(1, deserialize(serialized, true)->get_deferred_verification_count());
+
+	// Alter the inline assets without changing their serialized definition.
+	auto found = std::search(
+		serialized->begin(), serialized->end(), c_inline_assets_content.begin(), c_inline_assets_content.end());
+	ASSERT_NE(serialized->end(), found);
+	*found = 'I';
+
+	// Hashing at load time catches the change.
+	ASSERT_ANY_THROW(deserialize(serialized));
+
+	// Deferring trusts the serialized definition until the content is used.
+	auto deferred = deserialize(serialized, true);
+
+	std::shared_ptr<diffs::core::prepared_item> stored;
+	ASSERT_TRUE(deferred->try_fetch_stored_item_by_name(diffs::core::archive::c_inline_assets, &stored));
+	ASSERT_EQ(original->get_item_definition(), stored->get_item_definition());
+
+	auto expect_hash_failure = [&](const item_definition &item)
+	{
+		// A fresh archive each time, so nothing has been checked yet.
+		auto kitchen = diffs::core::kitchen::create();
+		deserialize(serialized, true)->stock_kitchen(kitchen.get());
+		ASSERT_FALSE(kitchen->get_verify_written_items());
+
+		kitchen->request_item(item);
+		ASSERT_TRUE(kitchen->process_requested_items());
+
+		auto written = std::make_shared<std::vector<char>>();
+		io::buffer::writer writer(written);
+
+		bool caught = false;
+		try
+		{
+			kitchen->write_item(writer, item);
+		}
+		catch (errors::user_exception &e)
+		{
+			caught = true;
+			ASSERT_EQ(errors::error_code::diff_verify_hash_failure, e.get_error());
+		}
+		ASSERT_TRUE(caught);
+	};
+
+	// The altered content is caught as it is read, without verifying the written item.
+	expect_hash_failure(stored->get_item_definition());
+
+	// An item that doesn't read the altered byte still fails, since the rest of the inline
+	// assets are checked once it is written.
+	expect_hash_failure(tail_item);
+}
@@ -0,0 +1,291 @@
+/**
+ * @file recipe_index.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "recipe_index.h"
+
+#include <cstring>
+
+#include <io/sequential/basic_reader_wrapper.h>
+
+#include <errors/user_exception.h>
+
+#include <diffs/core/cookbook.h>
+#include <diffs/core/recipe_template.h>
+
+namespace archive_diff::diffs::serialization::standard
+{
+static std::shared_ptr<core::recipe> read_recipe(
+	io::sequential::reader &seq,
+	const core::archive::recipe_template_map &templates,
+	const core::item_definition &result_item)
+{
+	uint32_t recipe_type_id;
+	seq.read_uint32_t(&recipe_type_id);
+
+	uint64_t numbers_count;
+	seq.read_uint64_t(&numbers_count);
+
+	std::vector<uint64_t> number_ingredients;
+	while (numbers_count)
+	{
+		uint64_t number;
+		seq.read_uint64_t(&number);
+		number_ingredients.push_back(number);
+		numbers_count--;
+	}
+
+	uint64_t items_count;
+	seq.read_uint64_t(&items_count);
+
+	std::vector<core::item_definition> item_ingredients;
+	while (items_count)
+	{
+		auto item = core::item_definition::read(seq, core::item_definition::serialization_options::standard);
+		item_ingredients.push_back(item);
+		items_count--;
+	}
+
+	auto template_itr = templates.find(recipe_type_id);
+	if (template_itr == templates.cend())
+	{
+		std::string msg = "Recipe type id not supported: " + std::to_string(recipe_type_id);
+		throw errors::user_exception(errors::error_code::diff_invalid_recipe_type, msg);
+	}
+
+	return template_itr->second->create_recipe(result_item, number_ingredients, item_ingredients);
+}
+
+void read_recipe_set(
+	io::sequential::reader &seq,
+	const core::archive::recipe_template_map &templates,
+	std::vector<std::shared_ptr<core::recipe>> *recipes)
+{
+	uint64_t recipes_count;
+	seq.read_uint64_t(&recipes_count);
+
+	auto result_item = core::item_definition::read(seq, diffs::core::item_definition::standard);
+
+	for (uint64_t i = 0; i < recipes_count; i++)
+	{
+		recipes->push_back(read_recipe(seq, templates, result_item));
+	}
+}
+
+void recipe_index_entry::make_entries(
+	const core::item_definition &result, uint64_t offset, std::vector<recipe_index_entry> *entries)
+{
+	for (auto algorithm : core::item_definition::c_hash_algorithms)
+	{
+		auto hash_data = result.get_hash_data(algorithm);
+
+		recipe_index_entry entry;
+		if (!hash_data.empty() && core::digest_key::try_make(result.size(), algorithm, hash_data, &entry.m_key))
+		{
+			entry.m_offset = offset;
+			entries->push_back(entry);
+		}
+	}
+}
+
+// The digest is compared bytewise so the order doesn't depend on the signedness of char.
+bool recipe_index_entry::key_less(const core::digest_key &lhs, const core::digest_key &rhs)
+{
+	if (lhs.m_size != rhs.m_size)
+	{
+		return lhs.m_size < rhs.m_size;
+	}
+
+	if (lhs.m_algorithm != rhs.m_algorithm)
+	{
+		return lhs.m_algorithm < rhs.m_algorithm;
+	}
+
+	return std::memcmp(lhs.m_digest.data(), rhs.m_digest.data(), lhs.m_digest.size()) < 0;
+}
+
+void recipe_index_entry::write(io::sequential::writer &writer) const
+{
+	writer.write_uint64_t(m_key.m_size);
+	writer.write_uint32_t(static_cast<uint32_t>(m_key.m_algorithm));
+	writer.write(std::string_view{m_key.m_digest.data(), m_key.m_digest.size()});
+	writer.write_uint64_t(m_offset);
+}
+
+// Numbers are written in network byte order.
+static uint64_t read_big_endian(const char *data, size_t size)
+{
+	uint64_t value{};
+	for (size_t i = 0; i < size; i++)
+	{
+		value = (value << 8) | static_cast<uint8_t>(data[i]);
+	}
+	return value;
+}
+
+// The entry is read with a single read, as the index is searched one entry at a time.
+recipe_index_entry recipe_index_entry::read(io::reader &reader, uint64_t index)
+{
+	char buffer[c_serialized_size];
+	reader.read(index * c_serialized_size, std::span<char>{buffer, sizeof(buffer)});
+
+	const char *position = buffer;
+
+	auto size = read_big_endian(position, sizeof(uint64_t));
+	position += sizeof(uint64_t);
+
+	auto algorithm_value = static_cast<uint32_t>(read_big_endian(position, sizeof(uint32_t)));
+	position += sizeof(uint32_t);
+
+	const char *digest = position;
+	position += core::digest_key::c_max_digest_size;
+
+	auto algorithm = static_cast<hashing::algorithm>(algorithm_value);
+	if ((algorithm != hashing::algorithm::md5) && (algorithm != hashing::algorithm::sha256))
+	{
+		std::string msg = "Recipe index entry has an invalid hash type: " + std::to_string(algorithm_value);
+		throw errors::user_exception(errors::error_code::diff_recipe_index_invalid, msg);
+	}
+
+	recipe_index_entry entry;
+	core::digest_key::try_make(
+		size,
+		algorithm,
+		std::string_view{digest, hashing::get_byte_count_for_algorithm(algorithm)},
+		&entry.m_key);
+	entry.m_offset = read_big_endian(position, sizeof(uint64_t));
+
+	return entry;
+}
+
+indexed_recipe_source::indexed_recipe_source(
+	const io::reader &recipes_reader,
+	uint64_t recipe_set_count,
+	const io::reader &index_reader,
+	uint64_t index_entry_count,
+	const core::archive::recipe_template_map &templates) :
+	m_recipes_reader(recipes_reader), m_recipe_set_count(recipe_set_count), m_index_reader(index_reader),
+	m_index_entry_count(index_entry_count), m_templates(templates)
+{}
+
+void indexed_recipe_source::load_recipes_for_item(const core::item_definition &item, core::cookbook &cookbook)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_all_loaded)
+	{
+		return;
+	}
+
+	for (auto algorithm : core::item_definition::c_hash_algorithms)
+	{
+		auto hash_data = item.get_hash_data(algorithm);
+
+		core::digest_key key;
+		if (hash_data.empty() || !core::digest_key::try_make(item.size(), algorithm, hash_data, &key))
+		{
+			continue;
+		}
+
+		// Each key is only searched for once, the cookbook answers repeated lookups.
+		if (m_searched_keys.insert(key, true))
+		{
+			load_recipes_for_key(key, cookbook);
+		}
+	}
+}
+
+void indexed_recipe_source::load_all_recipes(core::cookbook &cookbook)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_all_loaded)
+	{
+		return;
+	}
+
+	io::sequential::basic_reader_wrapper seq(m_recipes_reader);
+
+	std::vector<std::shared_ptr<core::recipe>> recipes;
+	for (uint64_t i = 0; i < m_recipe_set_count; i++)
+	{
+		auto offset = seq.tellg();
+
+		recipes.clear();
+		read_recipe_set(seq, m_templates, &recipes);
+
+		if (!m_loaded_offsets.insert(offset).second)
+		{
+			continue;
+		}
+
+		for (auto &recipe : recipes)
+		{
+			cookbook.add_recipe(recipe);
+		}
+	}
+
+	m_all_loaded = true;
+	m_loaded_offsets.clear();
+	m_searched_keys.clear();
+}
+
+void indexed_recipe_source::load_recipes_for_key(const core::digest_key &key, core::cookbook &cookbook)
+{
+	// Find the first entry not less than the key.
+	uint64_t low  = 0;
+	uint64_t high = m_index_entry_count;
+	while (low < high)
+	{
+		auto middle = low + (high - low) / 2;
+		auto entry  = recipe_index_entry::read(m_index_reader, middle);
+		if (recipe_index_entry::key_less(entry.m_key, key))
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	// Distinct result items can share a hash, so every matching entry is loaded.
+	for (; low < m_index_entry_count; low++)
+	{
+		auto entry = recipe_index_entry::read(m_index_reader, low);
+		if (!(entry.m_key == key))
+		{
+			break;
+		}
+
+		load_recipe_set(entry.m_offset, cookbook);
+	}
+}
+
+void indexed_recipe_source::load_recipe_set(uint64_t offset, core::cookbook &cookbook)
+{
+	if (offset >= m_recipes_reader.size())
+	{
+		std::string msg = "Recipe index entry offset out of range: " + std::to_string(offset);
+		throw errors::user_exception(errors::error_code::diff_recipe_index_invalid, msg);
+	}
+
+	if (!m_loaded_offsets.insert(offset).second)
+	{
+		return;
+	}
+
+	auto set_reader = m_recipes_reader.slice_at(offset);
+	io::sequential::basic_reader_wrapper seq(set_reader);
+
+	std::vector<std::shared_ptr<core::recipe>> recipes;
+	read_recipe_set(seq, m_templates, &recipes);
+
+	for (auto &recipe : recipes)
+	{
+		cookbook.add_recipe(recipe);
+	}
+}
+} // namespace archive_diff::diffs::serialization::standard
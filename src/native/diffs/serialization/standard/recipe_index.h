@@ -0,0 +1,82 @@
+/**
+ * @file recipe_index.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <io/reader.h>
+#include <io/sequential/reader.h>
+#include <io/sequential/writer.h>
+
+#include <diffs/core/archive.h>
+#include <diffs/core/hash_index.h>
+#include <diffs/core/recipe_source.h>
+
+namespace archive_diff::diffs::serialization::standard
+{
+// Reads one recipe set - the recipes for a single result item - creating the recipes
+// with the given templates.
+void read_recipe_set(
+	io::sequential::reader &seq,
+	const core::archive::recipe_template_map &templates,
+	std::vector<std::shared_ptr<core::recipe>> *recipes);
+
+// Entry of the recipe index written after the recipe sets of a version 3 diff. There is an
+// entry for each hash of each result item, sorted by item size, hash algorithm and digest.
+// The offset is that of the recipe set from the start of the recipe sets.
+struct recipe_index_entry
+{
+	static const uint64_t c_serialized_size =
+		sizeof(uint64_t) + sizeof(uint32_t) + core::digest_key::c_max_digest_size + sizeof(uint64_t);
+
+	static void make_entries(
+		const core::item_definition &result, uint64_t offset, std::vector<recipe_index_entry> *entries);
+
+	static bool key_less(const core::digest_key &lhs, const core::digest_key &rhs);
+	bool operator<(const recipe_index_entry &rhs) const { return key_less(m_key, rhs.m_key); }
+
+	void write(io::sequential::writer &writer) const;
+	static recipe_index_entry read(io::reader &reader, uint64_t index);
+
+	core::digest_key m_key;
+	uint64_t m_offset{};
+};
+
+// Loads recipe sets of a version 3 diff as their result items are looked up, using a
+// binary search of the index, so opening a diff doesn't depend on how many recipes it has.
+class indexed_recipe_source : public core::recipe_source
+{
+	public:
+	indexed_recipe_source(
+		const io::reader &recipes_reader,
+		uint64_t recipe_set_count,
+		const io::reader &index_reader,
+		uint64_t index_entry_count,
+		const core::archive::recipe_template_map &templates);
+
+	virtual void load_recipes_for_item(const core::item_definition &item, core::cookbook &cookbook) override;
+	virtual void load_all_recipes(core::cookbook &cookbook) override;
+
+	private:
+	void load_recipes_for_key(const core::digest_key &key, core::cookbook &cookbook);
+	void load_recipe_set(uint64_t offset, core::cookbook &cookbook);
+
+	io::reader m_recipes_reader;
+	uint64_t m_recipe_set_count{};
+	io::reader m_index_reader;
+	uint64_t m_index_entry_count{};
+	core::archive::recipe_template_map m_templates;
+
+	std::mutex m_mutex;
+	core::digest_index<bool> m_searched_keys;
+	std::set<uint64_t> m_loaded_offsets;
+	bool m_all_loaded{};
+};
+} // namespace archive_diff::diffs::serialization::standard
@@ -10,10 +10,14 @@
 #include "archive.h"
 #include "item_definition.h"
 
+#include <algorithm>
+
 #include <io/buffer/writer.h>
 #include <io/hashed/hashed_sequential_writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
 
 #include "constants.h"
+#include "recipe_index.h"
 
 namespace archive_diff::diffs::serialization::standard
 {
@@ -21,7 +25,14 @@ void serializer::write(io::sequential::writer &writer)
 {
 	write_header(writer);
 	write_suported_recipe_types(writer);
-	write_recipes(writer);
+	if (m_write_recipe_index)
+	{
+		write_indexed_recipes(writer);
+	}
+	else
+	{
+		write_recipes(writer);
+	}
 	write_inline_assets(writer);
 	write_remainder(writer);
 	write_nested_archives(writer);
@@ -30,7 +41,7 @@ void serializer::write(io::sequential::writer &writer)
 void serializer::write_header(io::sequential::writer &writer)
 {
 	writer.write(std::string_view{g_DIFF_MAGIC_VALUE.data(), g_DIFF_MAGIC_VALUE.size()});
-	writer.write_uint64_t(g_STANDARD_DIFF_VERSION_2);
+	writer.write_uint64_t(m_write_recipe_index ? g_STANDARD_DIFF_VERSION_3 : g_STANDARD_DIFF_VERSION_2);
 
 	auto target_item = m_archive->get_archive_item();
 	target_item.write(writer, core::item_definition::serialization_options::standard);
@@ -84,6 +95,38 @@ void serializer::write_recipes(io::sequential::writer &writer)
 	}
 }
 
+// The recipe sets are written as for version 2, preceded by their total size and followed by the index.
+void serializer::write_indexed_recipes(io::sequential::writer &writer)
+{
+	auto recipe_set_map = m_archive->get_cookbook()->get_all_recipes();
+
+	auto recipe_sets                               = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> recipe_sets_writer = std::make_shared<io::buffer::writer>(recipe_sets);
+	io::sequential::basic_writer_wrapper recipe_sets_seq(recipe_sets_writer);
+
+	std::vector<recipe_index_entry> index;
+	for (auto &entry : recipe_set_map)
+	{
+		recipe_index_entry::make_entries(entry.first, recipe_sets_seq.tellp(), &index);
+		write_recipe_set(recipe_sets_seq, entry.first, entry.second);
+	}
+	recipe_sets_seq.flush();
+
+	std::sort(index.begin(), index.end());
+
+	uint64_t result_set_count = recipe_set_map.size();
+	writer.write_uint64_t(result_set_count);
+
+	writer.write_uint64_t(static_cast<uint64_t>(recipe_sets->size()));
+	writer.write(std::string_view{recipe_sets->data(), recipe_sets->size()});
+
+	writer.write_uint64_t(static_cast<uint64_t>(index.size()));
+	for (auto &entry : index)
+	{
+		entry.write(writer);
+	}
+}
+
 void serializer::write_recipe(io::sequential::writer &writer, const core::recipe &recipe)
 {
 	auto recipe_name = recipe.get_recipe_name();
@@ -159,6 +202,7 @@ void serializer::write_nested_archives(io::sequential::writer &writer)
 		io::hashed::hashed_sequential_writer seq(buffer_writer, hasher);
 
 		serializer nested(archive);
+		nested.set_write_recipe_index(m_write_recipe_index);
 
 		nested.write(seq);
 
@@ -20,10 +20,15 @@ class serializer
 
 	void write(io::sequential::writer &writer);
 
+	// Writes a version 3 diff, which has an index of the recipe sets so they can be loaded
+	// on demand. Version 2 diffs are written otherwise, as older readers don't accept version 3.
+	void set_write_recipe_index(bool value) { m_write_recipe_index = value; }
+
 	private:
 	void write_header(io::sequential::writer &writer);
 	void write_suported_recipe_types(io::sequential::writer &writer);
 	void write_recipes(io::sequential::writer &writer);
+	void write_indexed_recipes(io::sequential::writer &writer);
 	void write_recipe_set(
 		io::sequential::writer &writer, const core::item_definition &result, const core::recipe_set &recipes);
 	void write_recipe(io::sequential::writer &writer, const core::recipe &recipe);
@@ -34,5 +39,6 @@ class serializer
 	void write_nested_archives(io::sequential::writer &writer);
 
 	std::shared_ptr<diffs::core::archive> m_archive;
+	bool m_write_recipe_index{false};
 };
 } // namespace archive_diff::diffs::serialization::standard
\ No newline at end of file
@@ -52,9 +52,14 @@ enum class error_code : uint16_t
 	io_zstd_compress_finished_early                               = 20206,
 	io_zstd_decompress_finished_early                             = 20207,
 	io_zstd_too_much_data_processed                               = 20208,
+	io_zstd_set_parameter_failed                                  = 20209,
+	io_zstd_seek_table_invalid                                    = 20210,
 	io_binary_file_reader_failed_open                             = 20300,
 	io_temp_file_readerwriter_failed_open                         = 20301,
 	io_binary_file_writer_failed_open                             = 20302,
+	io_binary_file_reader_read_failed                             = 20303,
+	io_binary_file_reader_mmap_failed                             = 20304,
+	io_binary_file_writer_set_size_failed                         = 20305,
 	io_child_reader_parent_is_null                                = 20400,
 	io_child_reader_out_of_bounds                                 = 20401,
 	io_sequential_reader_bad_offset                               = 20500,
@@ -96,6 +101,7 @@ enum class error_code : uint16_t
 	diff_cannot_add_implicit_offset                         = 30018,
 	diff_cannot_add_implicit_length                         = 30019,
 	diff_remainder_chunk_offset_too_large                   = 30020,
+	diff_recipe_index_invalid                               = 30021,
 	diff_invalid_recipe_parameter_type                      = 30100,
 	diff_recipe_parameter_read_invalid_type                 = 30101,
 	diff_recipe_parameter_invalid_type_for_apply            = 30102,
@@ -137,6 +143,11 @@ enum class error_code : uint16_t
 	diffs_prepared_item_wrong_kind                          = 31601,
 	diffs_prepared_visit_no_result                          = 31602,
 	diffs_prepared_item_unkown                              = 31603,
+	diffs_prepared_item_written_size_mismatch               = 31604,
+	diffs_prepared_item_written_hash_mismatch               = 31605,
+	diffs_prepared_item_shared_content_unavailable          = 31606,
+	diffs_apply_profiler_trace_not_enabled                  = 31800,
+	diffs_apply_profiler_failed_open                        = 31801,
 
 	recipe_chain_item_and_recipe_mismatch   = 31700,
 	recipe_chain_total_item_length_mismatch = 31701,
@@ -156,5 +167,7 @@ enum class error_code : uint16_t
 	api_unexpected_recipe_type       = 40003,
 	api_already_finalized            = 40004,
 	api_unknown_zlib_compression     = 40005,
+	api_profiling_not_enabled        = 40006,
+	api_verification_not_enabled     = 40007,
 };
 }
@@ -0,0 +1,155 @@
+/**
+ * @file test_hasher.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <hashing/hasher.h>
+#include <test_utility/random_data_file.h>
+
+using hasher  = archive_diff::hashing::hasher;
+using backend = archive_diff::hashing::hasher::backend;
+
+using archive_diff::hashing::algorithm;
+
+static std::vector<std::vector<char>> hash_values(const std::vector<archive_diff::hashing::hash> &hashes)
+{
+	std::vector<std::vector<char>> values;
+	for (auto &hash : hashes)
+	{
+		values.push_back(hash.m_hash_data);
+	}
+	return values;
+}
+
+static std::string hash_string(std::string_view data, backend hash_backend)
+{
+	hasher hash_it(algorithm::sha256, hash_backend);
+	hash_it.hash_data(data);
+	return hash_it.get_hash_string();
+}
+
+TEST(hasher, known_answers)
+{
+	for (auto hash_backend : {backend::library, backend::sha_ni})
+	{
+		if (!hasher::is_backend_supported(hash_backend))
+		{
+			continue;
+		}
+
+		ASSERT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", hash_string("", hash_backend));
+		ASSERT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hash_string("abc", hash_backend));
+		ASSERT_EQ(
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+			hash_string("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", hash_backend));
+	}
+}
+
+TEST(hasher, sha_ni_matches_library)
+{
+	if (!hasher::is_backend_supported(backend::sha_ni))
+	{
+		GTEST_SKIP() << "CPU doesn't support the SHA extensions.";
+	}
+
+	auto data = archive_diff::test_utility::create_random_data(64 * 1024, 0);
+
+	// Every length around the one and two block padding boundaries, then some larger ones.
+	std::vector<size_t> lengths;
+	for (size_t length = 0; length <= 200; length++)
+	{
+		lengths.push_back(length);
+	}
+	for (size_t length : {1000, 4095, 4096, 4097, 64 * 1024})
+	{
+		lengths.push_back(length);
+	}
+
+	for (auto length : lengths)
+	{
+		std::string_view view{data.data(), length};
+		ASSERT_EQ(hash_string(view, backend::library), hash_string(view, backend::sha_ni)) << "length: " << length;
+	}
+
+	// Uneven chunks exercise the partial block buffering.
+	hasher library(algorithm::sha256, backend::library);
+	hasher sha_ni(algorithm::sha256, backend::sha_ni);
+	size_t offset = 0;
+	size_t chunk  = 1;
+	while (offset < data.size())
+	{
+		auto to_hash = std::min(chunk, data.size() - offset);
+		library.hash_data(data.data() + offset, to_hash);
+		sha_ni.hash_data(data.data() + offset, to_hash);
+		offset += to_hash;
+		chunk = (chunk * 7) % 301 + 1;
+	}
+	ASSERT_EQ(library.get_hash_string(), sha_ni.get_hash_string());
+
+	// reset() starts over.
+	sha_ni.reset();
+	sha_ni.hash_data(std::string_view{"abc"});
+	ASSERT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", sha_ni.get_hash_string());
+}
+
+TEST(hasher, hash_many_matches_library)
+{
+	auto data = archive_diff::test_utility::create_random_data(256 * 1024, 0);
+
+	// Different lengths so lanes finish at different times and get refilled.
+	std::vector<std::string_view> buffers;
+	size_t offset = 0;
+	for (size_t i = 0; i < 97; i++)
+	{
+		auto length = (i * 613) % 4099;
+		buffers.push_back(std::string_view{data.data() + offset, length});
+		offset = (offset + 1237) % (data.size() - 4099);
+	}
+
+	auto expected = hash_values(hasher::hash_many(algorithm::sha256, buffers, backend::library));
+	ASSERT_EQ(buffers.size(), expected.size());
+
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		hasher single(algorithm::sha256, backend::library);
+		single.hash_data(buffers[i]);
+		ASSERT_EQ(single.get_hash_binary(), expected[i]);
+	}
+
+	for (auto hash_backend : {backend::sha_ni, backend::avx2_multi_buffer})
+	{
+		if (!hasher::is_backend_supported(hash_backend))
+		{
+			continue;
+		}
+
+		ASSERT_EQ(expected, hash_values(hasher::hash_many(algorithm::sha256, buffers, hash_backend)));
+
+		// Fewer buffers than lanes.
+		std::span<const std::string_view> few{buffers.data(), 3};
+		auto few_hashes = hash_values(hasher::hash_many(algorithm::sha256, few, hash_backend));
+		ASSERT_EQ(3, few_hashes.size());
+		ASSERT_TRUE(std::equal(few_hashes.begin(), few_hashes.end(), expected.begin()));
+	}
+
+	ASSERT_TRUE(hasher::hash_many(algorithm::sha256, std::span<const std::string_view>{}).empty());
+}
+
+TEST(hasher, hash_many_md5_uses_library)
+{
+	std::vector<std::string_view> buffers{"", "abc"};
+
+	auto hashes = hasher::hash_many(algorithm::md5, buffers, backend::avx2_multi_buffer);
+	ASSERT_EQ(2, hashes.size());
+
+	hasher md5(algorithm::md5);
+	md5.hash_data(std::string_view{"abc"});
+	ASSERT_EQ(md5.get_hash_binary(), hashes[1].m_hash_data);
+}
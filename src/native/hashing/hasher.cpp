@@ -152,8 +152,83 @@ const EVP_MD *algorithm_to_EVP_MP(algorithm alg)
 }
 #endif
 
+bool hasher::is_backend_supported(backend hash_backend)
+{
+	switch (hash_backend)
+	{
+	case backend::library:
+		return true;
+	case backend::sha_ni:
+		return sha256_accelerated::cpu_has_sha_extensions();
+	case backend::avx2_multi_buffer:
+		return sha256_accelerated::cpu_has_avx2();
+	}
+
+	return false;
+}
+
+hasher::backend hasher::get_default_backend()
+{
+	// Streams hashed with the SHA extensions are no faster than the library, which already
+	// uses them where it can, so single streams stay on the audited implementation.
+	return backend::library;
+}
+
+hasher::backend hasher::get_default_batch_backend()
+{
+	// A single stream with the SHA extensions is about as fast as eight AVX2 lanes and
+	// doesn't waste lanes on small batches, so it is preferred when available.
+	if (is_backend_supported(backend::sha_ni))
+	{
+		return backend::sha_ni;
+	}
+
+	if (is_backend_supported(backend::avx2_multi_buffer))
+	{
+		return backend::avx2_multi_buffer;
+	}
+
+	return backend::library;
+}
+
+std::vector<hash> hasher::hash_many(algorithm alg, std::span<const std::string_view> buffers, backend hash_backend)
+{
+	std::vector<hash> hashes;
+	hashes.reserve(buffers.size());
+
+	if ((alg == algorithm::sha256) && (hash_backend == backend::avx2_multi_buffer)
+	    && is_backend_supported(backend::avx2_multi_buffer))
+	{
+		std::vector<sha256_accelerated::digest> digests(buffers.size());
+		sha256_accelerated::hash_many_avx2(buffers, digests);
+
+		for (auto &digest : digests)
+		{
+			hashes.push_back(hash::import_hash_value(alg, std::string_view{digest.data(), digest.size()}));
+		}
+
+		return hashes;
+	}
+
+	hasher single(alg, hash_backend == backend::avx2_multi_buffer ? backend::library : hash_backend);
+	for (auto &buffer : buffers)
+	{
+		single.reset();
+		single.hash_data(buffer);
+		hashes.push_back(single.get_hash());
+	}
+
+	return hashes;
+}
+
 void hasher::reset()
 {
+	if (m_sha_ni)
+	{
+		m_sha_ni->reset();
+		return;
+	}
+
 #ifdef USE_BCRYPT
 	#ifndef STATUS_SUCCESS
 		#define STATUS_SUCCESS ((NTSTATUS)0x00000000)
@@ -214,8 +289,14 @@ void hasher::reset()
 #endif
 }
 
-hasher::hasher(algorithm alg) : m_alg(alg)
+hasher::hasher(algorithm alg, backend hash_backend) : m_alg(alg)
 {
+	if ((alg == algorithm::sha256) && (hash_backend == backend::sha_ni) && is_backend_supported(backend::sha_ni))
+	{
+		m_sha_ni = std::make_unique<sha256_accelerated::sha_ni_context>();
+		return;
+	}
+
 #ifdef USE_BCRYPT
 	#ifndef STATUS_SUCCESS
 		#define STATUS_SUCCESS ((NTSTATUS)0x00000000)
@@ -275,6 +356,12 @@ hasher::libgcrypt_initializer::libgcrypt_initializer()
 
 int hasher::hash_data(const void *data, size_t bytes)
 {
+	if (m_sha_ni)
+	{
+		m_sha_ni->update(data, bytes);
+		return 0;
+	}
+
 #ifdef USE_BCRYPT
 	if (bytes > std::numeric_limits<ULONG>::max())
 	{
@@ -309,6 +396,12 @@ int hasher::hash_data(const void *data, size_t bytes)
 
 std::vector<char> hasher::get_hash_binary()
 {
+	if (m_sha_ni)
+	{
+		auto digest = m_sha_ni->finish();
+		return std::vector<char>{digest.begin(), digest.end()};
+	}
+
 #ifdef USE_BCRYPT
 	DWORD hash_byte_count;
 	DWORD result_byte_count;
@@ -7,15 +7,13 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <span>
 
-#ifdef USE_BCRYPT
-	#include <memory>
-#endif
-
 #ifdef USE_LIBGCRYPT
 	#include <gcrypt.h>
 #endif
@@ -26,14 +24,42 @@
 
 #include "algorithm.h"
 #include "hash.h"
+#include "sha256_accelerated.h"
 
 namespace archive_diff::hashing
 {
 class hasher
 {
 	public:
-	hasher(algorithm alg);
+	// How sha256 is computed.
+	// library - the platform crypto library (bcrypt, OpenSSL or libgcrypt)
+	// sha_ni - the x86 SHA extensions
+	// avx2_multi_buffer - AVX2, hashing eight buffers at once; only used by hash_many()
+	// Other algorithms, and backends the CPU doesn't support, fall back to library.
+	enum class backend
+	{
+		library,
+		sha_ni,
+		avx2_multi_buffer,
+	};
+
+	static bool is_backend_supported(backend hash_backend);
+
+	// Always library; the accelerated backends are only used when asked for, or by hash_many().
+	static backend get_default_backend();
+	static backend get_default_batch_backend();
+
+	hasher(algorithm alg) : hasher(alg, get_default_backend()) {}
+	hasher(algorithm alg, backend hash_backend);
 	~hasher();
+
+	// Hashes each buffer independently, returning one hash per buffer.
+	static std::vector<hash> hash_many(algorithm alg, std::span<const std::string_view> buffers)
+	{
+		return hash_many(alg, buffers, get_default_batch_backend());
+	}
+	static std::vector<hash> hash_many(algorithm alg, std::span<const std::string_view> buffers, backend hash_backend);
+
 	void reset();
 	int hash_data(std::span<char> data) { return hash_data(data.data(), data.size()); }
 	int hash_data(std::string_view data) { return hash_data(data.data(), data.size()); }
@@ -50,6 +76,9 @@ class hasher
 
 	private:
 	algorithm m_alg;
+
+	std::unique_ptr<sha256_accelerated::sha_ni_context> m_sha_ni;
+
 #ifdef USE_BCRYPT
 	struct algorithm_provider_handle_deleter
 	{
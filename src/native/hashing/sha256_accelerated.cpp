@@ -0,0 +1,495 @@
+/**
+ * @file sha256_accelerated.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <errors/user_exception.h>
+
+#include "sha256_accelerated.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define SHA256_ACCELERATED_X86 1
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define SHA256_TARGET_SHA
+		#define SHA256_TARGET_AVX2
+	#else
+		#include <cpuid.h>
+		#define SHA256_TARGET_SHA  __attribute__((target("sha,sse4.1")))
+		#define SHA256_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace archive_diff::hashing::sha256_accelerated
+{
+alignas(16) static const uint32_t c_round_constants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t c_initial_state[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+// Builds the padding that follows the last partial block of a message: the remaining
+// bytes, 0x80, zeros and the message length in bits. Returns the number of blocks used (1 or 2).
+static size_t build_final_blocks(
+	const uint8_t *remaining, size_t remaining_bytes, uint64_t total_bytes, uint8_t (&blocks)[2 * c_block_size])
+{
+	std::memset(blocks, 0, sizeof(blocks));
+	if (remaining_bytes)
+	{
+		std::memcpy(blocks, remaining, remaining_bytes);
+	}
+	blocks[remaining_bytes] = 0x80;
+
+	size_t block_count = (remaining_bytes + 1 + sizeof(uint64_t) <= c_block_size) ? 1 : 2;
+
+	uint64_t total_bits = total_bytes * 8;
+	auto length_end     = blocks + block_count * c_block_size;
+	for (size_t i = 0; i < sizeof(uint64_t); i++)
+	{
+		length_end[-1 - static_cast<ptrdiff_t>(i)] = static_cast<uint8_t>(total_bits >> (8 * i));
+	}
+
+	return block_count;
+}
+
+static void store_digest(const uint32_t (&state)[8], digest &result)
+{
+	for (size_t i = 0; i < 8; i++)
+	{
+		result[4 * i + 0] = static_cast<char>(state[i] >> 24);
+		result[4 * i + 1] = static_cast<char>(state[i] >> 16);
+		result[4 * i + 2] = static_cast<char>(state[i] >> 8);
+		result[4 * i + 3] = static_cast<char>(state[i]);
+	}
+}
+
+#ifdef SHA256_ACCELERATED_X86
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&registers)[4])
+{
+	#ifdef _MSC_VER
+	int values[4];
+	__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (size_t i = 0; i < 4; i++)
+	{
+		registers[i] = static_cast<uint32_t>(values[i]);
+	}
+	#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+	#endif
+}
+
+static bool os_saves_avx_state()
+{
+	uint32_t registers[4];
+	cpuid(1, 0, registers);
+
+	const uint32_t c_osxsave = 1u << 27;
+	if ((registers[2] & c_osxsave) == 0)
+	{
+		return false;
+	}
+
+	#ifdef _MSC_VER
+	auto xcr0 = _xgetbv(0);
+	#else
+	uint32_t eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	uint64_t xcr0 = (static_cast<uint64_t>(edx) << 32) | eax;
+	#endif
+
+	// XMM and YMM state.
+	return (xcr0 & 0x6) == 0x6;
+}
+
+static uint32_t get_extended_features()
+{
+	uint32_t registers[4];
+	cpuid(0, 0, registers);
+	if (registers[0] < 7)
+	{
+		return 0;
+	}
+
+	cpuid(7, 0, registers);
+	return registers[1];
+}
+
+bool cpu_has_sha_extensions()
+{
+	static const bool has_sha = (get_extended_features() & (1u << 29)) != 0;
+	return has_sha;
+}
+
+bool cpu_has_avx2()
+{
+	static const bool has_avx2 = ((get_extended_features() & (1u << 5)) != 0) && os_saves_avx_state();
+	return has_avx2;
+}
+
+SHA256_TARGET_SHA static inline __m128i schedule_sha_ni(__m128i w16, __m128i w12, __m128i w8, __m128i w4)
+{
+	// W[t] = σ1(W[t-2]) + W[t-7] + σ0(W[t-15]) + W[t-16], four words at a time.
+	auto result = _mm_sha256msg1_epu32(w16, w12);
+	result      = _mm_add_epi32(result, _mm_alignr_epi8(w4, w8, 4));
+	return _mm_sha256msg2_epu32(result, w4);
+}
+
+SHA256_TARGET_SHA static inline void rounds_sha_ni(__m128i &abef, __m128i &cdgh, __m128i w, size_t round)
+{
+	auto wk = _mm_add_epi32(w, _mm_load_si128(reinterpret_cast<const __m128i *>(&c_round_constants[round])));
+	cdgh    = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+	wk      = _mm_shuffle_epi32(wk, 0x0E);
+	abef    = _mm_sha256rnds2_epu32(abef, cdgh, wk);
+}
+
+SHA256_TARGET_SHA static void compress_sha_ni(uint32_t (&state)[8], const uint8_t *data, size_t block_count)
+{
+	const auto byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	// The instructions want the state as ABEF and CDGH.
+	auto dcba = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0]));
+	auto hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4]));
+	auto cdab = _mm_shuffle_epi32(dcba, 0xB1);
+	auto efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+	auto abef = _mm_alignr_epi8(cdab, efgh, 8);
+	auto cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+	for (size_t block = 0; block < block_count; block++, data += c_block_size)
+	{
+		auto abef_saved = abef;
+		auto cdgh_saved = cdgh;
+
+		auto w0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0)), byte_swap);
+		auto w1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16)), byte_swap);
+		auto w2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 32)), byte_swap);
+		auto w3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 48)), byte_swap);
+
+		rounds_sha_ni(abef, cdgh, w0, 0);
+		rounds_sha_ni(abef, cdgh, w1, 4);
+		rounds_sha_ni(abef, cdgh, w2, 8);
+		rounds_sha_ni(abef, cdgh, w3, 12);
+
+		for (size_t round = 16; round < 64; round += 16)
+		{
+			w0 = schedule_sha_ni(w0, w1, w2, w3);
+			rounds_sha_ni(abef, cdgh, w0, round);
+			w1 = schedule_sha_ni(w1, w2, w3, w0);
+			rounds_sha_ni(abef, cdgh, w1, round + 4);
+			w2 = schedule_sha_ni(w2, w3, w0, w1);
+			rounds_sha_ni(abef, cdgh, w2, round + 8);
+			w3 = schedule_sha_ni(w3, w0, w1, w2);
+			rounds_sha_ni(abef, cdgh, w3, round + 12);
+		}
+
+		abef = _mm_add_epi32(abef, abef_saved);
+		cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+	}
+
+	auto feba = _mm_shuffle_epi32(abef, 0x1B);
+	auto dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+	dcba      = _mm_blend_epi16(feba, dchg, 0xF0);
+	hgfe      = _mm_alignr_epi8(dchg, feba, 8);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), dcba);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), hgfe);
+}
+
+SHA256_TARGET_AVX2 static inline __m256i rotr_avx2(__m256i x, int bits)
+{
+	return _mm256_or_si256(_mm256_srli_epi32(x, bits), _mm256_slli_epi32(x, 32 - bits));
+}
+
+// Transposes eight rows of eight words so that row i holds word i of each input row.
+SHA256_TARGET_AVX2 static inline void transpose_avx2(__m256i (&rows)[8])
+{
+	auto t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+	auto t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+	auto t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+	auto t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+	auto t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+	auto t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+	auto t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+	auto t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+	auto u0 = _mm256_unpacklo_epi64(t0, t2);
+	auto u1 = _mm256_unpackhi_epi64(t0, t2);
+	auto u2 = _mm256_unpacklo_epi64(t1, t3);
+	auto u3 = _mm256_unpackhi_epi64(t1, t3);
+	auto u4 = _mm256_unpacklo_epi64(t4, t6);
+	auto u5 = _mm256_unpackhi_epi64(t4, t6);
+	auto u6 = _mm256_unpacklo_epi64(t5, t7);
+	auto u7 = _mm256_unpackhi_epi64(t5, t7);
+
+	rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+	rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+	rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+	rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+	rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+	rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+	rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+	rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// state[word][lane] holds the state of eight independent messages; blocks[lane] is the
+// next block of each.
+SHA256_TARGET_AVX2 static void compress_avx2(uint32_t (&state)[8][8], const uint8_t *(&blocks)[8])
+{
+	const auto byte_swap = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+	__m256i w[64];
+
+	for (size_t half = 0; half < 2; half++)
+	{
+		__m256i rows[8];
+		for (size_t lane = 0; lane < 8; lane++)
+		{
+			auto row   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks[lane] + 32 * half));
+			rows[lane] = _mm256_shuffle_epi8(row, byte_swap);
+		}
+		transpose_avx2(rows);
+		for (size_t i = 0; i < 8; i++)
+		{
+			w[8 * half + i] = rows[i];
+		}
+	}
+
+	for (size_t t = 16; t < 64; t++)
+	{
+		auto w15    = w[t - 15];
+		auto w2     = w[t - 2];
+		auto sigma0 = _mm256_xor_si256(
+			_mm256_xor_si256(rotr_avx2(w15, 7), rotr_avx2(w15, 18)), _mm256_srli_epi32(w15, 3));
+		auto sigma1 = _mm256_xor_si256(
+			_mm256_xor_si256(rotr_avx2(w2, 17), rotr_avx2(w2, 19)), _mm256_srli_epi32(w2, 10));
+		w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], sigma0), _mm256_add_epi32(w[t - 7], sigma1));
+	}
+
+	__m256i v[8];
+	for (size_t i = 0; i < 8; i++)
+	{
+		v[i] = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[i]));
+	}
+
+	auto a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+	for (size_t t = 0; t < 64; t++)
+	{
+		auto big_sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(e, 6), rotr_avx2(e, 11)), rotr_avx2(e, 25));
+		auto choose     = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+		auto round_word = _mm256_add_epi32(w[t], _mm256_set1_epi32(static_cast<int>(c_round_constants[t])));
+		auto t1 = _mm256_add_epi32(_mm256_add_epi32(h, big_sigma1), _mm256_add_epi32(choose, round_word));
+
+		auto big_sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(a, 2), rotr_avx2(a, 13)), rotr_avx2(a, 22));
+		auto majority   = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+		auto t2         = _mm256_add_epi32(big_sigma0, majority);
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm256_add_epi32(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm256_add_epi32(t1, t2);
+	}
+
+	__m256i results[8] = {a, b, c, d, e, f, g, h};
+	for (size_t i = 0; i < 8; i++)
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i *>(state[i]), _mm256_add_epi32(v[i], results[i]));
+	}
+}
+
+#else
+
+bool cpu_has_sha_extensions() { return false; }
+bool cpu_has_avx2() { return false; }
+
+static void compress_sha_ni(uint32_t (&)[8], const uint8_t *, size_t)
+{
+	throw errors::user_exception(errors::error_code::hash_data_failure, "SHA extensions aren't available.");
+}
+
+static void compress_avx2(uint32_t (&)[8][8], const uint8_t *(&)[8])
+{
+	throw errors::user_exception(errors::error_code::hash_data_failure, "AVX2 isn't available.");
+}
+
+#endif
+
+void sha_ni_context::reset()
+{
+	std::memcpy(m_state, c_initial_state, sizeof(m_state));
+	m_pending_bytes = 0;
+	m_total_bytes   = 0;
+}
+
+void sha_ni_context::update(const void *data, size_t bytes)
+{
+	auto input = static_cast<const uint8_t *>(data);
+	m_total_bytes += bytes;
+
+	if (m_pending_bytes)
+	{
+		auto to_copy = std::min(bytes, c_block_size - m_pending_bytes);
+		std::memcpy(m_pending + m_pending_bytes, input, to_copy);
+		m_pending_bytes += to_copy;
+		input += to_copy;
+		bytes -= to_copy;
+
+		if (m_pending_bytes < c_block_size)
+		{
+			return;
+		}
+
+		compress_sha_ni(m_state, m_pending, 1);
+		m_pending_bytes = 0;
+	}
+
+	auto block_count = bytes / c_block_size;
+	if (block_count)
+	{
+		compress_sha_ni(m_state, input, block_count);
+		input += block_count * c_block_size;
+		bytes -= block_count * c_block_size;
+	}
+
+	if (bytes)
+	{
+		std::memcpy(m_pending, input, bytes);
+		m_pending_bytes = bytes;
+	}
+}
+
+digest sha_ni_context::finish()
+{
+	uint8_t final_blocks[2 * c_block_size];
+	auto block_count = build_final_blocks(m_pending, m_pending_bytes, m_total_bytes, final_blocks);
+	compress_sha_ni(m_state, final_blocks, block_count);
+	m_pending_bytes = 0;
+
+	digest result;
+	store_digest(m_state, result);
+	return result;
+}
+
+void hash_many_avx2(std::span<const std::string_view> buffers, std::span<digest> results)
+{
+	if (results.size() != buffers.size())
+	{
+		std::string msg = "hash_many_avx2: results size " + std::to_string(results.size())
+		                + " doesn't match buffers size " + std::to_string(buffers.size());
+		throw errors::user_exception(errors::error_code::hash_data_failure, msg);
+	}
+
+	struct lane_state
+	{
+		bool m_active{};
+		size_t m_buffer_index{};
+		const uint8_t *m_data{};
+		size_t m_full_blocks{};
+		size_t m_total_blocks{};
+		size_t m_next_block{};
+		uint8_t m_final_blocks[2 * c_block_size];
+	};
+
+	alignas(32) uint32_t state[8][8];
+	lane_state lanes[8];
+
+	// Lanes with nothing left to hash still run through the rounds; their results are ignored.
+	static const uint8_t c_idle_block[c_block_size]{};
+
+	size_t next_buffer = 0;
+
+	auto start_next_buffer = [&](size_t lane_index)
+	{
+		auto &lane = lanes[lane_index];
+		if (next_buffer == buffers.size())
+		{
+			lane.m_active = false;
+			return;
+		}
+
+		auto &buffer        = buffers[next_buffer];
+		lane.m_active       = true;
+		lane.m_buffer_index = next_buffer++;
+		lane.m_data         = reinterpret_cast<const uint8_t *>(buffer.data());
+		lane.m_full_blocks  = buffer.size() / c_block_size;
+		lane.m_next_block   = 0;
+
+		auto remaining         = buffer.size() % c_block_size;
+		auto remaining_data    = lane.m_data + lane.m_full_blocks * c_block_size;
+		auto final_block_count = build_final_blocks(remaining_data, remaining, buffer.size(), lane.m_final_blocks);
+		lane.m_total_blocks = lane.m_full_blocks + final_block_count;
+
+		for (size_t word = 0; word < 8; word++)
+		{
+			state[word][lane_index] = c_initial_state[word];
+		}
+	};
+
+	for (size_t lane_index = 0; lane_index < 8; lane_index++)
+	{
+		start_next_buffer(lane_index);
+	}
+
+	while (std::any_of(std::begin(lanes), std::end(lanes), [](const lane_state &lane) { return lane.m_active; }))
+	{
+		const uint8_t *blocks[8];
+		for (size_t lane_index = 0; lane_index < 8; lane_index++)
+		{
+			auto &lane = lanes[lane_index];
+			if (!lane.m_active)
+			{
+				blocks[lane_index] = c_idle_block;
+			}
+			else if (lane.m_next_block < lane.m_full_blocks)
+			{
+				blocks[lane_index] = lane.m_data + lane.m_next_block * c_block_size;
+			}
+			else
+			{
+				blocks[lane_index] = lane.m_final_blocks + (lane.m_next_block - lane.m_full_blocks) * c_block_size;
+			}
+		}
+
+		compress_avx2(state, blocks);
+
+		for (size_t lane_index = 0; lane_index < 8; lane_index++)
+		{
+			auto &lane = lanes[lane_index];
+			if (!lane.m_active || (++lane.m_next_block < lane.m_total_blocks))
+			{
+				continue;
+			}
+
+			uint32_t lane_result[8];
+			for (size_t word = 0; word < 8; word++)
+			{
+				lane_result[word] = state[word][lane_index];
+			}
+			store_digest(lane_result, results[lane.m_buffer_index]);
+
+			start_next_buffer(lane_index);
+		}
+	}
+}
+} // namespace archive_diff::hashing::sha256_accelerated
@@ -0,0 +1,48 @@
+/**
+ * @file sha256_accelerated.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace archive_diff::hashing::sha256_accelerated
+{
+// SHA-256 using x86 SIMD instructions rather than the platform crypto library.
+// Callers must check that the CPU supports the instructions first; on other
+// architectures both checks are always false.
+bool cpu_has_sha_extensions();
+bool cpu_has_avx2();
+
+const size_t c_block_size  = 64;
+const size_t c_digest_size = 32;
+
+using digest = std::array<char, c_digest_size>;
+
+// Incremental hashing with the SHA extensions (SHA-NI).
+class sha_ni_context
+{
+	public:
+	sha_ni_context() { reset(); }
+
+	void reset();
+	void update(const void *data, size_t bytes);
+	digest finish();
+
+	private:
+	uint32_t m_state[8]{};
+	uint8_t m_pending[c_block_size]{};
+	size_t m_pending_bytes{};
+	uint64_t m_total_bytes{};
+};
+
+// Hashes each buffer independently, working on eight buffers at once with AVX2.
+// results must have the same size as buffers.
+void hash_many_avx2(std::span<const std::string_view> buffers, std::span<digest> results);
+} // namespace archive_diff::hashing::sha256_accelerated
@@ -18,4 +18,15 @@ size_t all_zeros_io_device::read_some(uint64_t offset, std::span<char> buffer)
 	std::memset(buffer.data(), 0, to_read);
 	return to_read;
 }
+
+static const size_t c_zeros_block_size = 64 * 1024;
+static const char c_zeros_block[c_zeros_block_size]{};
+
+std::optional<std::span<const char>> all_zeros_io_device::borrow_some(uint64_t offset, uint64_t length)
+{
+	auto available = (offset < m_length) ? (m_length - offset) : 0;
+	auto to_borrow = static_cast<size_t>(std::min<uint64_t>({available, length, c_zeros_block_size}));
+
+	return std::span<const char>{c_zeros_block, to_borrow};
+}
 } // namespace archive_diff::io
\ No newline at end of file
@@ -17,6 +17,8 @@ class all_zeros_io_device : public io::io_device
 	all_zeros_io_device(uint64_t length) : m_length(length) {}
 
 	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
+	// Lends out a shared block of zeros, so a call may return less than was asked for.
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override;
 	virtual uint64_t size() const override { return m_length; }
 
 	static io::reader make_reader(uint64_t length)
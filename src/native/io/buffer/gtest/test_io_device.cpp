@@ -34,4 +34,25 @@ TEST(io_device, using_vector_size)
 	auto reader  = device::make_reader(data, device::size_kind::vector_size);
 
 	test_buffer_reader(data, reader);
-}
\ No newline at end of file
+}
+TEST(io_device, borrow_lends_vector_storage)
+{
+	auto data = std::make_shared<std::vector<char>>();
+
+	data->resize(c_reader_vector_size);
+
+	using device = archive_diff::io::buffer::io_device;
+	auto reader  = device::make_reader(data, device::size_kind::vector_size);
+
+	auto whole = reader.borrow(0, c_reader_vector_size);
+	ASSERT_TRUE(whole.has_value());
+	ASSERT_EQ(data->data(), whole->data());
+	ASSERT_EQ(c_reader_vector_size, whole->size());
+
+	auto tail = reader.borrow_some(c_reader_vector_size - 10, c_reader_vector_size);
+	ASSERT_TRUE(tail.has_value());
+	ASSERT_EQ(data->data() + c_reader_vector_size - 10, tail->data());
+	ASSERT_EQ(10, tail->size());
+
+	ASSERT_FALSE(reader.borrow(1, c_reader_vector_size).has_value());
+}
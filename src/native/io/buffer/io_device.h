@@ -60,6 +60,21 @@ class io_device : public io::io_device
 		return to_read;
 	}
 
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override
+	{
+		if (size() < offset)
+		{
+			std::string msg = "Attempting to borrow at offset " + std::to_string(offset)
+			                + " but capacity is: " + std::to_string(size());
+			throw errors::user_exception(errors::error_code::io_stored_blob_reader_read_offset, msg);
+		}
+
+		auto available = size() - offset;
+		auto to_borrow = static_cast<size_t>(std::min<uint64_t>(available, length));
+
+		return std::span<const char>{m_buffer->data() + offset, to_borrow};
+	}
+
 	virtual uint64_t size() const override
 	{
 		return (m_size_kind == size_kind::vector_size) ? m_buffer->size() : m_buffer->capacity();
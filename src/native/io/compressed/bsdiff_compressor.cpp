@@ -14,6 +14,15 @@ namespace archive_diff::io::compressed
 {
 void bsdiff_compressor::delta_compress(
 	io::reader &old_reader, io::reader &new_reader, std::shared_ptr<io::writer> &diff_writer)
+{
+	delta_compress(old_reader, new_reader, diff_writer, bsdiff_patch_format::bz2);
+}
+
+void bsdiff_compressor::delta_compress(
+	io::reader &old_reader,
+	io::reader &new_reader,
+	std::shared_ptr<io::writer> &diff_writer,
+	bsdiff_patch_format format)
 {
 	bsdiff_ctx ctx{0};
 
@@ -22,10 +31,11 @@ void bsdiff_compressor::delta_compress(
 	auto_bsdiff_stream diff_stream = create_writer_based_bsdiff_stream(diff_writer);
 
 	auto_bsdiff_patch_packer diff_packer;
-	int ret = bsdiff_open_bz2_patch_packer(BSDIFF_MODE_WRITE, &diff_stream, &diff_packer);
+	int ret = open_bsdiff_patch_packer(format, BSDIFF_MODE_WRITE, &diff_stream, &diff_packer);
 	if (ret != BSDIFF_SUCCESS)
 	{
-		std::string msg = "bsdiff_open_bz2_patch_packer failed. ret: " + std::to_string(ret);
+		std::string msg = "open_bsdiff_patch_packer failed. format: " + get_bsdiff_patch_format_name(format)
+		                + ", ret: " + std::to_string(ret);
 		throw errors::user_exception(errors::error_code::diff_bspatch_failure, msg);
 	}
 
@@ -9,6 +9,8 @@
 #include <io/reader.h>
 #include <io/sequential/writer.h>
 
+#include "bsdiff_patch_packer.h"
+
 namespace archive_diff::io::compressed
 {
 // bsdiff doesn't easily fit the model of a writer. It takes in two
@@ -22,5 +24,10 @@ class bsdiff_compressor
 	public:
 	static void delta_compress(
 		io::reader &old_reader, io::reader &new_reader, std::shared_ptr<io::writer> &diff_writer);
+	static void delta_compress(
+		io::reader &old_reader,
+		io::reader &new_reader,
+		std::shared_ptr<io::writer> &diff_writer,
+		bsdiff_patch_format format);
 };
 }; // namespace archive_diff::io::compressed
@@ -0,0 +1,479 @@
+/**
+ * @file bsdiff_patch_packer.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "bsdiff_patch_packer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <bsdiff.h>
+
+#include "zstd_wrappers.h"
+
+namespace archive_diff::io::compressed
+{
+std::string get_bsdiff_patch_format_name(bsdiff_patch_format format)
+{
+	switch (format)
+	{
+	case bsdiff_patch_format::bz2:
+		return "bz2";
+	case bsdiff_patch_format::zstd:
+		return "zstd";
+	}
+
+	return "unknown";
+}
+
+int open_bsdiff_patch_packer(
+	bsdiff_patch_format format, int mode, bsdiff_stream *stream, bsdiff_patch_packer *packer)
+{
+	switch (format)
+	{
+	case bsdiff_patch_format::bz2:
+		return bsdiff_open_bz2_patch_packer(mode, stream, packer);
+	case bsdiff_patch_format::zstd:
+		return open_zstd_patch_packer(mode, stream, packer);
+	}
+
+	return BSDIFF_INVALID_ARG;
+}
+
+// A zstd packed patch is laid out as:
+//   magic                     "BSDFZSTD"
+//   control, diff and extra stream lengths, then the new size
+//   control, diff and extra streams, each a single zstd frame
+// Numbers are encoded as bsdiff encodes them, and the control stream holds the diff length,
+// extra length and seek of each entry.
+static const char c_zstd_patch_magic[]{'B', 'S', 'D', 'F', 'Z', 'S', 'T', 'D'};
+static const size_t c_zstd_patch_header_size       = sizeof(c_zstd_patch_magic) + 4 * sizeof(int64_t);
+static const size_t c_zstd_patch_entry_header_size = 3 * sizeof(int64_t);
+static const int c_zstd_patch_compression_level    = 19;
+
+// Little-endian magnitude with the sign in the top bit.
+static void encode_int64(int64_t value, char *buffer)
+{
+	uint64_t magnitude = (value < 0) ? (0 - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value);
+	for (size_t i = 0; i < sizeof(int64_t); i++)
+	{
+		buffer[i] = static_cast<char>(magnitude >> (8 * i));
+	}
+
+	if (value < 0)
+	{
+		buffer[sizeof(int64_t) - 1] |= static_cast<char>(0x80);
+	}
+}
+
+static int64_t decode_int64(const char *buffer)
+{
+	uint64_t magnitude{};
+	for (size_t i = sizeof(int64_t); i > 0; i--)
+	{
+		magnitude = (magnitude << 8) | static_cast<uint8_t>(buffer[i - 1]);
+	}
+
+	const uint64_t c_sign_bit = uint64_t{1} << 63;
+	if (magnitude & c_sign_bit)
+	{
+		return -static_cast<int64_t>(magnitude & ~c_sign_bit);
+	}
+	return static_cast<int64_t>(magnitude);
+}
+
+// Compresses one of the streams into memory. Input is staged so small writes, such as
+// entry headers, are handed to zstd in blocks.
+class zstd_patch_section_writer
+{
+	public:
+	zstd_patch_section_writer()
+	{
+		ZSTD_CCtx_setParameter(m_cstream.get(), ZSTD_c_compressionLevel, c_zstd_patch_compression_level);
+		m_pending.reserve(ZSTD_CStreamInSize());
+	}
+
+	bool write(const void *buffer, size_t size)
+	{
+		auto data = static_cast<const char *>(buffer);
+		m_pending.insert(m_pending.end(), data, data + size);
+
+		if (m_pending.size() < ZSTD_CStreamInSize())
+		{
+			return true;
+		}
+		return compress_pending(ZSTD_e_continue);
+	}
+
+	bool finish() { return compress_pending(ZSTD_e_end); }
+
+	const std::vector<char> &get_compressed() const { return m_compressed; }
+
+	private:
+	bool compress_pending(ZSTD_EndDirective directive)
+	{
+		ZSTD_inBuffer input{m_pending.data(), m_pending.size(), 0};
+
+		while (true)
+		{
+			auto used = m_compressed.size();
+			m_compressed.resize(used + ZSTD_CStreamOutSize());
+
+			ZSTD_outBuffer output{m_compressed.data() + used, ZSTD_CStreamOutSize(), 0};
+			auto remaining = ZSTD_compressStream2(m_cstream.get(), &output, &input, directive);
+			m_compressed.resize(used + output.pos);
+
+			if (ZSTD_isError(remaining))
+			{
+				return false;
+			}
+
+			if ((directive == ZSTD_e_end) ? (remaining == 0) : (input.pos == input.size))
+			{
+				break;
+			}
+		}
+
+		m_pending.clear();
+		return true;
+	}
+
+	unique_zstd_cstream m_cstream{ZSTD_createCStream()};
+	std::vector<char> m_pending;
+	std::vector<char> m_compressed;
+};
+
+// Decompresses one of the streams, reading the patch from wherever that stream left off.
+class zstd_patch_section_reader
+{
+	public:
+	zstd_patch_section_reader(bsdiff_stream *stream, uint64_t offset, uint64_t length) :
+		m_stream(stream), m_next_offset(offset), m_end_offset(offset + length)
+	{
+		ZSTD_DCtx_setParameter(m_dstream.get(), ZSTD_d_windowLogMax, c_zstd_window_log_max);
+		m_input_data.resize(ZSTD_DStreamInSize());
+	}
+
+	int read(void *buffer, size_t size, size_t *readed)
+	{
+		ZSTD_outBuffer output{buffer, size, 0};
+
+		while (output.pos < output.size)
+		{
+			if ((m_input.pos == m_input.size) && (m_next_offset < m_end_offset))
+			{
+				int ret = refill();
+				if (ret != BSDIFF_SUCCESS)
+				{
+					*readed = output.pos;
+					return ret;
+				}
+			}
+
+			auto output_before = output.pos;
+			auto input_before  = m_input.pos;
+
+			auto result = ZSTD_decompressStream(m_dstream.get(), &output, &m_input);
+			if (ZSTD_isError(result))
+			{
+				*readed = output.pos;
+				return BSDIFF_CORRUPT_PATCH;
+			}
+
+			// Nothing left to decompress.
+			if ((output.pos == output_before) && (m_input.pos == input_before))
+			{
+				break;
+			}
+		}
+
+		*readed = output.pos;
+		return (output.pos < size) ? BSDIFF_END_OF_FILE : BSDIFF_SUCCESS;
+	}
+
+	private:
+	int refill()
+	{
+		auto to_read = std::min<uint64_t>(m_input_data.size(), m_end_offset - m_next_offset);
+
+		int ret = m_stream->seek(m_stream->state, static_cast<int64_t>(m_next_offset), SEEK_SET);
+		if (ret != BSDIFF_SUCCESS)
+		{
+			return ret;
+		}
+
+		size_t actual{};
+		ret = m_stream->read(m_stream->state, m_input_data.data(), static_cast<size_t>(to_read), &actual);
+		if (actual == 0)
+		{
+			return ((ret == BSDIFF_SUCCESS) || (ret == BSDIFF_END_OF_FILE)) ? BSDIFF_CORRUPT_PATCH : ret;
+		}
+
+		m_next_offset += actual;
+		m_input = ZSTD_inBuffer{m_input_data.data(), actual, 0};
+
+		return BSDIFF_SUCCESS;
+	}
+
+	bsdiff_stream *m_stream{};
+	uint64_t m_next_offset{};
+	uint64_t m_end_offset{};
+
+	unique_zstd_dstream m_dstream{ZSTD_createDStream()};
+	std::vector<char> m_input_data;
+	ZSTD_inBuffer m_input{};
+};
+
+struct zstd_patch_writer_state
+{
+	bsdiff_stream *m_stream{};
+	int64_t m_new_size{};
+	bool m_flushed{};
+
+	zstd_patch_section_writer m_control;
+	zstd_patch_section_writer m_diff;
+	zstd_patch_section_writer m_extra;
+};
+
+struct zstd_patch_reader_state
+{
+	int64_t m_new_size{};
+
+	std::unique_ptr<zstd_patch_section_reader> m_control;
+	std::unique_ptr<zstd_patch_section_reader> m_diff;
+	std::unique_ptr<zstd_patch_section_reader> m_extra;
+};
+
+static void zstd_patch_writer_close(void *state) { delete static_cast<zstd_patch_writer_state *>(state); }
+
+static int zstd_patch_writer_get_mode(void *) { return BSDIFF_MODE_WRITE; }
+
+static int zstd_patch_writer_write_new_size(void *state, int64_t size)
+{
+	static_cast<zstd_patch_writer_state *>(state)->m_new_size = size;
+	return BSDIFF_SUCCESS;
+}
+
+static int zstd_patch_writer_write_entry_header(void *state, int64_t diff, int64_t extra, int64_t seek)
+{
+	char header[c_zstd_patch_entry_header_size];
+	encode_int64(diff, header);
+	encode_int64(extra, header + sizeof(int64_t));
+	encode_int64(seek, header + 2 * sizeof(int64_t));
+
+	auto writer_state = static_cast<zstd_patch_writer_state *>(state);
+	return writer_state->m_control.write(header, sizeof(header)) ? BSDIFF_SUCCESS : BSDIFF_ERROR;
+}
+
+static int zstd_patch_writer_write_entry_diff(void *state, const void *buffer, size_t size)
+{
+	auto writer_state = static_cast<zstd_patch_writer_state *>(state);
+	return writer_state->m_diff.write(buffer, size) ? BSDIFF_SUCCESS : BSDIFF_ERROR;
+}
+
+static int zstd_patch_writer_write_entry_extra(void *state, const void *buffer, size_t size)
+{
+	auto writer_state = static_cast<zstd_patch_writer_state *>(state);
+	return writer_state->m_extra.write(buffer, size) ? BSDIFF_SUCCESS : BSDIFF_ERROR;
+}
+
+// The streams are only written out here, as the header needs their compressed lengths.
+static int zstd_patch_writer_flush(void *state)
+{
+	auto writer_state = static_cast<zstd_patch_writer_state *>(state);
+	if (writer_state->m_flushed)
+	{
+		return BSDIFF_SUCCESS;
+	}
+
+	if (!writer_state->m_control.finish() || !writer_state->m_diff.finish() || !writer_state->m_extra.finish())
+	{
+		return BSDIFF_ERROR;
+	}
+
+	auto &control = writer_state->m_control.get_compressed();
+	auto &diff    = writer_state->m_diff.get_compressed();
+	auto &extra   = writer_state->m_extra.get_compressed();
+
+	char header[c_zstd_patch_header_size];
+	std::memcpy(header, c_zstd_patch_magic, sizeof(c_zstd_patch_magic));
+	int64_t values[]{
+		static_cast<int64_t>(control.size()),
+		static_cast<int64_t>(diff.size()),
+		static_cast<int64_t>(extra.size()),
+		writer_state->m_new_size};
+
+	char *position = header + sizeof(c_zstd_patch_magic);
+	for (auto value : values)
+	{
+		encode_int64(value, position);
+		position += sizeof(int64_t);
+	}
+
+	auto stream = writer_state->m_stream;
+
+	int ret = stream->write(stream->state, header, sizeof(header));
+	for (auto section : {&control, &diff, &extra})
+	{
+		if ((ret == BSDIFF_SUCCESS) && !section->empty())
+		{
+			ret = stream->write(stream->state, section->data(), section->size());
+		}
+	}
+
+	if ((ret == BSDIFF_SUCCESS) && stream->flush)
+	{
+		ret = stream->flush(stream->state);
+	}
+
+	if (ret == BSDIFF_SUCCESS)
+	{
+		writer_state->m_flushed = true;
+	}
+	return ret;
+}
+
+static void zstd_patch_reader_close(void *state) { delete static_cast<zstd_patch_reader_state *>(state); }
+
+static int zstd_patch_reader_get_mode(void *) { return BSDIFF_MODE_READ; }
+
+static int zstd_patch_reader_read_new_size(void *state, int64_t *size)
+{
+	*size = static_cast<zstd_patch_reader_state *>(state)->m_new_size;
+	return BSDIFF_SUCCESS;
+}
+
+static int zstd_patch_reader_read_entry_header(void *state, int64_t *diff, int64_t *extra, int64_t *seek)
+{
+	auto reader_state = static_cast<zstd_patch_reader_state *>(state);
+
+	char header[c_zstd_patch_entry_header_size];
+	size_t readed{};
+	int ret = reader_state->m_control->read(header, sizeof(header), &readed);
+	if (ret != BSDIFF_SUCCESS)
+	{
+		return (readed == 0) ? BSDIFF_END_OF_FILE : BSDIFF_CORRUPT_PATCH;
+	}
+
+	*diff  = decode_int64(header);
+	*extra = decode_int64(header + sizeof(int64_t));
+	*seek  = decode_int64(header + 2 * sizeof(int64_t));
+
+	return BSDIFF_SUCCESS;
+}
+
+static int zstd_patch_reader_read_entry_diff(void *state, void *buffer, size_t size, size_t *readed)
+{
+	return static_cast<zstd_patch_reader_state *>(state)->m_diff->read(buffer, size, readed);
+}
+
+static int zstd_patch_reader_read_entry_extra(void *state, void *buffer, size_t size, size_t *readed)
+{
+	return static_cast<zstd_patch_reader_state *>(state)->m_extra->read(buffer, size, readed);
+}
+
+static int open_zstd_patch_reader(bsdiff_stream *stream, zstd_patch_reader_state *reader_state)
+{
+	char header[c_zstd_patch_header_size];
+
+	int ret = stream->seek(stream->state, 0, SEEK_SET);
+	if (ret != BSDIFF_SUCCESS)
+	{
+		return ret;
+	}
+
+	size_t readed{};
+	ret = stream->read(stream->state, header, sizeof(header), &readed);
+	if (readed != sizeof(header))
+	{
+		return ((ret == BSDIFF_SUCCESS) || (ret == BSDIFF_END_OF_FILE)) ? BSDIFF_CORRUPT_PATCH : ret;
+	}
+
+	if (std::memcmp(header, c_zstd_patch_magic, sizeof(c_zstd_patch_magic)) != 0)
+	{
+		return BSDIFF_CORRUPT_PATCH;
+	}
+
+	const char *position = header + sizeof(c_zstd_patch_magic);
+
+	int64_t lengths[3];
+	for (auto &length : lengths)
+	{
+		length = decode_int64(position);
+		position += sizeof(int64_t);
+		if (length < 0)
+		{
+			return BSDIFF_CORRUPT_PATCH;
+		}
+	}
+
+	reader_state->m_new_size = decode_int64(position);
+	if (reader_state->m_new_size < 0)
+	{
+		return BSDIFF_CORRUPT_PATCH;
+	}
+
+	uint64_t offset         = c_zstd_patch_header_size;
+	reader_state->m_control = std::make_unique<zstd_patch_section_reader>(stream, offset, lengths[0]);
+	offset += lengths[0];
+	reader_state->m_diff = std::make_unique<zstd_patch_section_reader>(stream, offset, lengths[1]);
+	offset += lengths[1];
+	reader_state->m_extra = std::make_unique<zstd_patch_section_reader>(stream, offset, lengths[2]);
+
+	return BSDIFF_SUCCESS;
+}
+
+int open_zstd_patch_packer(int mode, bsdiff_stream *stream, bsdiff_patch_packer *packer)
+{
+	if ((stream == nullptr) || (packer == nullptr))
+	{
+		return BSDIFF_INVALID_ARG;
+	}
+
+	std::memset(packer, 0, sizeof(*packer));
+
+	if (mode == BSDIFF_MODE_WRITE)
+	{
+		auto writer_state      = new zstd_patch_writer_state;
+		writer_state->m_stream = stream;
+
+		packer->state              = writer_state;
+		packer->close              = zstd_patch_writer_close;
+		packer->get_mode           = zstd_patch_writer_get_mode;
+		packer->write_new_size     = zstd_patch_writer_write_new_size;
+		packer->write_entry_header = zstd_patch_writer_write_entry_header;
+		packer->write_entry_diff   = zstd_patch_writer_write_entry_diff;
+		packer->write_entry_extra  = zstd_patch_writer_write_entry_extra;
+		packer->flush              = zstd_patch_writer_flush;
+
+		return BSDIFF_SUCCESS;
+	}
+
+	if (mode != BSDIFF_MODE_READ)
+	{
+		return BSDIFF_INVALID_ARG;
+	}
+
+	auto reader_state = std::make_unique<zstd_patch_reader_state>();
+
+	int ret = open_zstd_patch_reader(stream, reader_state.get());
+	if (ret != BSDIFF_SUCCESS)
+	{
+		return ret;
+	}
+
+	packer->state             = reader_state.release();
+	packer->close             = zstd_patch_reader_close;
+	packer->get_mode          = zstd_patch_reader_get_mode;
+	packer->read_new_size     = zstd_patch_reader_read_new_size;
+	packer->read_entry_header = zstd_patch_reader_read_entry_header;
+	packer->read_entry_diff   = zstd_patch_reader_read_entry_diff;
+	packer->read_entry_extra  = zstd_patch_reader_read_entry_extra;
+
+	return BSDIFF_SUCCESS;
+}
+} // namespace archive_diff::io::compressed
@@ -0,0 +1,33 @@
+/**
+ * @file bsdiff_patch_packer.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <string>
+
+struct bsdiff_stream;
+struct bsdiff_patch_packer;
+
+namespace archive_diff::io::compressed
+{
+// How the control, diff and extra streams of a bsdiff patch are compressed.
+// bz2 is the classic BSDIFF40 layout. zstd keeps the same layout, with a different magic,
+// but stores each stream as a zstd frame, which is much cheaper to decompress on devices.
+enum class bsdiff_patch_format
+{
+	bz2,
+	zstd,
+};
+
+std::string get_bsdiff_patch_format_name(bsdiff_patch_format format);
+
+// Same contract as bsdiff_open_bz2_patch_packer(): returns BSDIFF_SUCCESS or a BSDIFF_* error,
+// and the packer is closed with bsdiff_close_patch_packer().
+int open_bsdiff_patch_packer(
+	bsdiff_patch_format format, int mode, bsdiff_stream *stream, bsdiff_patch_packer *packer);
+
+int open_zstd_patch_packer(int mode, bsdiff_stream *stream, bsdiff_patch_packer *packer);
+} // namespace archive_diff::io::compressed
@@ -16,28 +16,54 @@ namespace archive_diff::io::compressed
 {
 bspatch_decompression_reader::bspatch_decompression_reader(
 	io::reader &diff_reader, uint64_t uncompressed_size, io::reader &dictionary_reader) :
-	m_diff_reader(diff_reader), m_dictionary_reader(dictionary_reader),
+	bspatch_decompression_reader(diff_reader, uncompressed_size, dictionary_reader, bsdiff_patch_format::bz2)
+{}
+
+bspatch_decompression_reader::bspatch_decompression_reader(
+	io::reader &diff_reader,
+	uint64_t uncompressed_size,
+	io::reader &dictionary_reader,
+	bsdiff_patch_format format) :
+	m_diff_reader(diff_reader), m_dictionary_reader(dictionary_reader), m_format(format),
 	m_channel(std::make_shared<writer_to_reader_channel>(uncompressed_size)), m_channel_as_writer(m_channel)
 {
-	m_channel_thread =
-		std::thread(apply_patch_worker, &m_dictionary_reader, &m_channel_as_writer, &m_diff_reader, this);
+	// The job waits here for its reader to catch up, and so does another job reading this one
+	// as its dictionary; neither holds a slot meanwhile.
+	m_channel->set_wait_hooks(
+		[]() { bspatch_job_pool::get().begin_wait(); }, []() { bspatch_job_pool::get().end_wait(); });
 }
 
 bspatch_decompression_reader::~bspatch_decompression_reader()
 {
 	m_channel->cancel();
-	m_channel_thread.join();
+
+	// The job uses this reader's members, so it must not outlive it.
+	if (m_job)
+	{
+		m_job->cancel_or_wait();
+	}
+}
+
+void bspatch_decompression_reader::ensure_started()
+{
+	if (m_job)
+	{
+		return;
+	}
+
+	m_job = bspatch_job_pool::get().submit(
+		[this]() { apply_patch_worker(&m_dictionary_reader, &m_channel_as_writer, &m_diff_reader, m_format); });
 }
 
 void bspatch_decompression_reader::apply_patch_worker(
 	io::reader *old_reader,
 	std::shared_ptr<io::sequential::writer> *new_writer,
 	io::reader *diff_reader,
-	[[maybe_unused]] bspatch_decompression_reader *self)
+	bsdiff_patch_format format)
 {
 	try
 	{
-		apply_patch(old_reader, new_writer, diff_reader);
+		apply_patch(old_reader, new_writer, diff_reader, format);
 	}
 	catch (const std::exception &e)
 	{
@@ -58,7 +84,10 @@ void bspatch_decompression_reader::apply_patch_worker(
 }
 
 void bspatch_decompression_reader::apply_patch(
-	io::reader *old_reader, std::shared_ptr<io::sequential::writer> *new_writer, io::reader *diff_reader)
+	io::reader *old_reader,
+	std::shared_ptr<io::sequential::writer> *new_writer,
+	io::reader *diff_reader,
+	bsdiff_patch_format format)
 {
 	bsdiff_ctx ctx{0};
 
@@ -67,10 +96,11 @@ void bspatch_decompression_reader::apply_patch(
 	auto_bsdiff_stream diff_stream = create_reader_based_bsdiff_stream(*diff_reader);
 
 	auto_bsdiff_patch_packer diff_packer;
-	int ret = bsdiff_open_bz2_patch_packer(BSDIFF_MODE_READ, &diff_stream, &diff_packer);
+	int ret = open_bsdiff_patch_packer(format, BSDIFF_MODE_READ, &diff_stream, &diff_packer);
 	if (ret != BSDIFF_SUCCESS)
 	{
-		std::string msg = "bsdiff_open_bz2_patch_packer failed. ret: " + std::to_string(ret);
+		std::string msg = "open_bsdiff_patch_packer failed. format: " + get_bsdiff_patch_format_name(format)
+		                + ", ret: " + std::to_string(ret);
 		throw errors::user_exception(errors::error_code::diff_bspatch_failure, msg);
 	}
 
@@ -6,44 +6,73 @@
  */
 #pragma once
 
-#include <thread>
+#include <memory>
 #include <string>
 
 #include <bsdiff.h>
 
 #include <io/sequential/reader.h>
 
+#include "bsdiff_patch_packer.h"
+#include "bspatch_job_pool.h"
 #include "writer_to_reader_channel.h"
 
 namespace archive_diff::io::compressed
 {
+// The patch is applied by a job on the shared bspatch_job_pool, which is only submitted
+// once the reader is first read, so readers that are made well ahead of being consumed
+// (such as those in a chain) don't hold a worker.
 class bspatch_decompression_reader : public io::sequential::reader
 {
 	public:
 	bspatch_decompression_reader(io::reader &diff_reader, uint64_t uncompressed_size, io::reader &dictionary_reader);
+	bspatch_decompression_reader(
+		io::reader &diff_reader,
+		uint64_t uncompressed_size,
+		io::reader &dictionary_reader,
+		bsdiff_patch_format format);
 	virtual ~bspatch_decompression_reader();
 
-	virtual void skip(uint64_t to_skip) { m_channel->skip(to_skip); }
-	virtual size_t read_some(std::span<char> buffer) override { return m_channel->read_some(buffer); }
+	virtual void skip(uint64_t to_skip)
+	{
+		ensure_started();
+		m_channel->skip(to_skip);
+	}
+	virtual size_t read_some(std::span<char> buffer) override
+	{
+		ensure_started();
+		return m_channel->read_some(buffer);
+	}
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t length) override
+	{
+		ensure_started();
+		return m_channel->borrow_some(length);
+	}
 	virtual uint64_t tellg() const override { return m_channel->tellg(); }
 	virtual uint64_t size() const override { return m_channel->size(); }
 
 	private:
+	void ensure_started();
+
 	static void apply_patch_worker(
 		io::reader *old_reader,
 		std::shared_ptr<io::sequential::writer> *new_writer,
 		io::reader *diff_reader,
-		bspatch_decompression_reader *self);
+		bsdiff_patch_format format);
 
 	static void apply_patch(
-		io::reader *old_reader, std::shared_ptr<io::sequential::writer> *new_writer, io::reader *diff_reader);
+		io::reader *old_reader,
+		std::shared_ptr<io::sequential::writer> *new_writer,
+		io::reader *diff_reader,
+		bsdiff_patch_format format);
 
 	io::reader m_diff_reader;
 	io::reader m_dictionary_reader;
+	bsdiff_patch_format m_format{bsdiff_patch_format::bz2};
 
 	std::shared_ptr<writer_to_reader_channel> m_channel;
 	std::shared_ptr<io::sequential::writer> m_channel_as_writer;
 
-	std::thread m_channel_thread;
+	std::shared_ptr<bspatch_job_pool::job> m_job;
 };
 } // namespace archive_diff::io::compressed
\ No newline at end of file
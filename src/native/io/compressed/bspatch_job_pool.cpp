@@ -0,0 +1,208 @@
+/**
+ * @file bspatch_job_pool.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "bspatch_job_pool.h"
+
+#include <algorithm>
+
+namespace archive_diff::io::compressed
+{
+namespace
+{
+enum class slot_state
+{
+	none,
+	held,
+	given_up,
+};
+
+// Whether the job running on this thread holds one of the pool's slots.
+thread_local slot_state t_slot_state{slot_state::none};
+} // namespace
+
+void bspatch_job_pool::job::cancel_or_wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_state == state::pending)
+	{
+		m_state = state::canceled;
+		return;
+	}
+
+	m_done_cv.wait(lock, [&] { return m_state != state::running; });
+}
+
+bspatch_job_pool &bspatch_job_pool::get()
+{
+	static bspatch_job_pool pool;
+	return pool;
+}
+
+bspatch_job_pool::bspatch_job_pool()
+{
+	// Patching is mostly CPU bound, but a job can also sit waiting on a slow reader.
+	m_max_concurrent_jobs = std::max<size_t>(4, std::thread::hardware_concurrency());
+}
+
+bspatch_job_pool::~bspatch_job_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_work_cv.notify_all();
+
+	for (auto &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+std::shared_ptr<bspatch_job_pool::job> bspatch_job_pool::submit(std::function<void()> work)
+{
+	auto new_job    = std::make_shared<job>();
+	new_job->m_work = std::move(work);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(new_job);
+		start_worker_if_needed();
+	}
+	m_work_cv.notify_one();
+
+	return new_job;
+}
+
+void bspatch_job_pool::set_max_concurrent_jobs(size_t count)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_max_concurrent_jobs = std::max<size_t>(count, 1);
+		start_worker_if_needed();
+	}
+	m_work_cv.notify_all();
+}
+
+size_t bspatch_job_pool::get_max_concurrent_jobs() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_max_concurrent_jobs;
+}
+
+size_t bspatch_job_pool::get_running_jobs() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_running_jobs;
+}
+
+void bspatch_job_pool::begin_wait()
+{
+	if (t_slot_state != slot_state::held)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		t_slot_state = slot_state::given_up;
+		m_running_jobs--;
+		m_waiting_jobs++;
+		start_worker_if_needed();
+	}
+	m_work_cv.notify_all();
+}
+
+void bspatch_job_pool::end_wait()
+{
+	if (t_slot_state != slot_state::given_up)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// Jobs going on get their slots back before queued jobs start; see worker_thread().
+	m_resuming_jobs++;
+	m_work_cv.wait(lock, [&] { return m_stopping || (m_running_jobs < m_max_concurrent_jobs); });
+	m_resuming_jobs--;
+
+	t_slot_state = slot_state::held;
+	m_waiting_jobs--;
+	m_running_jobs++;
+}
+
+// Called with m_mutex held. Workers are only started when queued jobs outnumber the idle
+// ones, and never beyond the cap plus the jobs that gave up their slots; after the cap is
+// lowered the extra workers stay idle.
+void bspatch_job_pool::start_worker_if_needed()
+{
+	while ((m_queue.size() > m_idle_workers) && (m_threads.size() < m_max_concurrent_jobs + m_waiting_jobs))
+	{
+		m_threads.emplace_back(&bspatch_job_pool::worker_thread, this);
+		m_idle_workers++;
+	}
+}
+
+void bspatch_job_pool::worker_thread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_work_cv.wait(
+			lock,
+			[&]
+			{
+				return m_stopping
+				    || (!m_queue.empty() && (m_running_jobs + m_resuming_jobs < m_max_concurrent_jobs));
+			});
+		if (m_stopping)
+		{
+			return;
+		}
+
+		auto next = std::move(m_queue.front());
+		m_queue.pop_front();
+
+		{
+			std::lock_guard<std::mutex> job_lock(next->m_mutex);
+			if (next->m_state == job::state::canceled)
+			{
+				continue;
+			}
+			next->m_state = job::state::running;
+		}
+
+		m_idle_workers--;
+		m_running_jobs++;
+		if (m_running_jobs > m_peak_concurrent_jobs)
+		{
+			m_peak_concurrent_jobs = m_running_jobs;
+		}
+		lock.unlock();
+
+		t_slot_state = slot_state::held;
+		next->m_work();
+		t_slot_state = slot_state::none;
+
+		// The job only counts as done once it no longer counts as running.
+		lock.lock();
+		m_running_jobs--;
+		m_idle_workers++;
+
+		{
+			std::lock_guard<std::mutex> job_lock(next->m_mutex);
+			next->m_state = job::state::done;
+			next->m_work  = nullptr;
+		}
+		next->m_done_cv.notify_all();
+
+		// A job may have been left queued, or be waiting to go on, because the cap was reached.
+		m_work_cv.notify_all();
+	}
+}
+} // namespace archive_diff::io::compressed
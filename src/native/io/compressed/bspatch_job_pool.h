@@ -0,0 +1,93 @@
+/**
+ * @file bspatch_job_pool.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace archive_diff::io::compressed
+{
+// Process-wide pool of worker threads that run bspatch jobs, so the number of patches
+// being applied at once is capped rather than growing with the number of bspatch readers.
+// Jobs start in the order they are submitted. The cap only counts jobs that are patching:
+// a job that waits on something outside the pool, such as its reader not keeping up, gives
+// up its slot until it can go on, so a consumer can read any number of bspatch readers side
+// by side without the jobs it needs waiting behind ones it isn't reading yet.
+class bspatch_job_pool
+{
+	public:
+	class job
+	{
+		public:
+		// A job that hasn't started yet is dropped, otherwise this waits for it to finish.
+		void cancel_or_wait();
+
+		private:
+		friend class bspatch_job_pool;
+
+		enum class state
+		{
+			pending,
+			running,
+			done,
+			canceled,
+		};
+
+		std::function<void()> m_work;
+
+		std::mutex m_mutex;
+		std::condition_variable m_done_cv;
+		state m_state{state::pending};
+	};
+
+	static bspatch_job_pool &get();
+
+	// The work is run on one of the pool's threads and must not throw.
+	std::shared_ptr<job> submit(std::function<void()> work);
+
+	void set_max_concurrent_jobs(size_t count);
+	size_t get_max_concurrent_jobs() const;
+
+	size_t get_running_jobs() const;
+
+	// Called by a job around a wait on something outside the pool. begin_wait() gives up the
+	// job's slot and end_wait() waits for one to be free again. Both do nothing on threads
+	// that aren't running a job.
+	void begin_wait();
+	void end_wait();
+	size_t get_peak_concurrent_jobs() const { return m_peak_concurrent_jobs; }
+	void reset_peak_concurrent_jobs() { m_peak_concurrent_jobs = 0; }
+
+	~bspatch_job_pool();
+
+	private:
+	bspatch_job_pool();
+
+	void start_worker_if_needed();
+	void worker_thread();
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::deque<std::shared_ptr<job>> m_queue;
+	std::vector<std::thread> m_threads;
+
+	size_t m_max_concurrent_jobs{};
+	size_t m_idle_workers{};
+	size_t m_running_jobs{};
+	size_t m_waiting_jobs{};
+	size_t m_resuming_jobs{};
+	bool m_stopping{false};
+
+	std::atomic<size_t> m_peak_concurrent_jobs{0};
+};
+} // namespace archive_diff::io::compressed
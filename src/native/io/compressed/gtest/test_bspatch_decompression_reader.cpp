@@ -8,6 +8,8 @@
 #include <test_utility/buffer_helpers.h>
 #include <test_utility/dump_helpers.h>
 
+#include <map>
+
 #include <io/file/io_device.h>
 
 // To access the uncompressed sample.zst - we aren't interested
@@ -16,6 +18,7 @@
 
 #include <io/compressed/bsdiff_compressor.h>
 #include <io/compressed/bspatch_decompression_reader.h>
+#include <io/compressed/bspatch_job_pool.h>
 
 #include <io/buffer/io_device.h>
 #include <io/buffer/writer.h>
@@ -85,3 +88,179 @@ TEST(bspatch_decompression_reader, compress_with_basis_and_then_decompress)
 	ASSERT_EQ(applied_diff_vector.size(), uncompressed_data.size());
 	ASSERT_EQ(0, std::memcmp(applied_diff_vector.data(), uncompressed_data.data(), uncompressed_data.size()));
 }
+
+TEST(bspatch_decompression_reader, many_readers_share_bounded_pool)
+{
+	using namespace archive_diff;
+	using device = archive_diff::io::buffer::io_device;
+
+	auto &pool             = io::compressed::bspatch_job_pool::get();
+	auto original_max_jobs = pool.get_max_concurrent_jobs();
+	pool.set_max_concurrent_jobs(2);
+	pool.reset_peak_concurrent_jobs();
+
+	const size_t c_reader_count = 32;
+	const size_t c_data_size    = 256 * 1024;
+
+	auto old_data = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*old_data)[i] = static_cast<char>((i * 7) ^ (i >> 9));
+	}
+	auto old_reader = device::make_reader(old_data, device::size_kind::vector_size);
+
+	std::vector<std::shared_ptr<std::vector<char>>> new_datas;
+	std::vector<std::unique_ptr<io::compressed::bspatch_decompression_reader>> readers;
+	for (size_t i = 0; i < c_reader_count; i++)
+	{
+		auto new_data = std::make_shared<std::vector<char>>(*old_data);
+		modify_vector(*new_data, c_data_size - 100, 101, i + 1, 37);
+		new_datas.push_back(new_data);
+
+		auto new_reader = device::make_reader(new_data, device::size_kind::vector_size);
+
+		auto diff_data                            = std::make_shared<std::vector<char>>();
+		std::shared_ptr<io::writer> buffer_writer = std::make_shared<io::buffer::writer>(diff_data);
+		io::compressed::bsdiff_compressor::delta_compress(old_reader, new_reader, buffer_writer);
+
+		auto diff_reader = device::make_reader(diff_data, device::size_kind::vector_size);
+		readers.push_back(
+			std::make_unique<io::compressed::bspatch_decompression_reader>(diff_reader, new_data->size(), old_reader));
+	}
+
+	// Nothing is patched until a reader is read.
+	ASSERT_EQ(0, pool.get_peak_concurrent_jobs());
+
+	// Read the first half of the readers completely, and only the start of the next few.
+	for (size_t i = 0; i < c_reader_count / 2; i++)
+	{
+		std::vector<char> applied;
+		readers[i]->read_all_remaining(applied);
+		ASSERT_EQ(*new_datas[i], applied);
+	}
+
+	for (size_t i = c_reader_count / 2; i < c_reader_count / 2 + 2; i++)
+	{
+		char start[16];
+		readers[i]->read(std::span<char>{start, sizeof(start)});
+		ASSERT_EQ(0, std::memcmp(start, new_datas[i]->data(), sizeof(start)));
+	}
+
+	// Dropping readers, started or not, cancels their jobs.
+	readers.clear();
+
+	ASSERT_LE(pool.get_peak_concurrent_jobs(), 2);
+	ASSERT_GE(pool.get_peak_concurrent_jobs(), 1);
+	ASSERT_EQ(0, pool.get_running_jobs());
+
+	pool.set_max_concurrent_jobs(original_max_jobs);
+}
+
+TEST(bspatch_decompression_reader, readers_read_side_by_side_past_the_cap)
+{
+	using namespace archive_diff;
+	using device = archive_diff::io::buffer::io_device;
+
+	auto &pool             = io::compressed::bspatch_job_pool::get();
+	auto original_max_jobs = pool.get_max_concurrent_jobs();
+	pool.set_max_concurrent_jobs(1);
+	pool.reset_peak_concurrent_jobs();
+
+	// Each patch is bigger than a channel, so a job stalls until its reader catches up.
+	const size_t c_reader_count = 3;
+	const size_t c_data_size    = 256 * 1024;
+	const size_t c_new_size     = c_data_size - 100;
+	const size_t c_chunk_size   = 4096;
+
+	auto old_data = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*old_data)[i] = static_cast<char>((i * 11) ^ (i >> 7));
+	}
+	auto old_reader = device::make_reader(old_data, device::size_kind::vector_size);
+
+	std::vector<std::shared_ptr<std::vector<char>>> new_datas;
+	std::vector<std::unique_ptr<io::compressed::bspatch_decompression_reader>> readers;
+	for (size_t i = 0; i < c_reader_count; i++)
+	{
+		auto new_data = std::make_shared<std::vector<char>>(*old_data);
+		modify_vector(*new_data, c_new_size, 101, i + 1, 37);
+		new_datas.push_back(new_data);
+
+		auto new_reader = device::make_reader(new_data, device::size_kind::vector_size);
+
+		auto diff_data                            = std::make_shared<std::vector<char>>();
+		std::shared_ptr<io::writer> buffer_writer = std::make_shared<io::buffer::writer>(diff_data);
+		io::compressed::bsdiff_compressor::delta_compress(old_reader, new_reader, buffer_writer);
+
+		auto diff_reader = device::make_reader(diff_data, device::size_kind::vector_size);
+		readers.push_back(
+			std::make_unique<io::compressed::bspatch_decompression_reader>(diff_reader, new_data->size(), old_reader));
+	}
+
+	// Reading a chunk from each in turn needs every job going at once, which only works if a
+	// stalled job lets the others have the one slot.
+	std::vector<std::vector<char>> applied(c_reader_count, std::vector<char>(c_new_size));
+	for (size_t offset = 0; offset < c_new_size; offset += c_chunk_size)
+	{
+		auto chunk_size = std::min(c_chunk_size, c_new_size - offset);
+		for (size_t i = 0; i < c_reader_count; i++)
+		{
+			readers[i]->read(std::span<char>{applied[i].data() + offset, chunk_size});
+		}
+	}
+
+	for (size_t i = 0; i < c_reader_count; i++)
+	{
+		ASSERT_EQ(*new_datas[i], applied[i]);
+	}
+
+	readers.clear();
+
+	ASSERT_EQ(1, pool.get_peak_concurrent_jobs());
+	ASSERT_EQ(0, pool.get_running_jobs());
+
+	pool.set_max_concurrent_jobs(original_max_jobs);
+}
+
+TEST(bspatch_decompression_reader, zstd_patch_format)
+{
+	using namespace archive_diff;
+	using device = archive_diff::io::buffer::io_device;
+	using io::compressed::bsdiff_patch_format;
+
+	const size_t c_data_size = 1024 * 1024;
+
+	auto old_data = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*old_data)[i] = static_cast<char>((i * 13) ^ (i >> 11));
+	}
+	auto new_data = std::make_shared<std::vector<char>>(*old_data);
+	modify_vector(*new_data, c_data_size / 2, 4096, 23, 37);
+	new_data->resize(c_data_size + 1000, 'x');
+
+	auto old_reader = device::make_reader(old_data, device::size_kind::vector_size);
+	auto new_reader = device::make_reader(new_data, device::size_kind::vector_size);
+
+	std::map<bsdiff_patch_format, std::shared_ptr<std::vector<char>>> diffs;
+	for (auto format : {bsdiff_patch_format::bz2, bsdiff_patch_format::zstd})
+	{
+		auto diff_data                            = std::make_shared<std::vector<char>>();
+		std::shared_ptr<io::writer> buffer_writer = std::make_shared<io::buffer::writer>(diff_data);
+		io::compressed::bsdiff_compressor::delta_compress(old_reader, new_reader, buffer_writer, format);
+		diffs[format] = diff_data;
+
+		auto diff_reader = device::make_reader(diff_data, device::size_kind::vector_size);
+		io::compressed::bspatch_decompression_reader reader(diff_reader, new_data->size(), old_reader, format);
+
+		std::vector<char> applied;
+		reader.read_all_remaining(applied);
+		ASSERT_EQ(*new_data, applied);
+	}
+
+	auto &zstd_diff = *diffs[bsdiff_patch_format::zstd];
+	ASSERT_NE(*diffs[bsdiff_patch_format::bz2], zstd_diff);
+	ASSERT_EQ(0, std::memcmp(zstd_diff.data(), "BSDFZSTD", 8));
+	ASSERT_LT(zstd_diff.size(), new_data->size());
+}
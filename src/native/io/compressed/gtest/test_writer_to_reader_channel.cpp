@@ -0,0 +1,144 @@
+/**
+ * @file test_writer_to_reader_channel.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/random_data_file.h>
+
+#include <cstring>
+#include <thread>
+
+#include <io/compressed/writer_to_reader_channel.h>
+
+// Writes data in uneven chunk sizes so writes straddle the end of the ring.
+static void write_in_chunks(
+	archive_diff::io::compressed::writer_to_reader_channel &channel, const std::vector<char> &data)
+{
+	size_t offset = 0;
+	size_t chunk  = 1;
+	while (offset < data.size())
+	{
+		auto to_write = std::min(chunk, data.size() - offset);
+		channel.write(std::string_view{data.data() + offset, to_write});
+		offset += to_write;
+		chunk = (chunk * 7) % 3001 + 1;
+	}
+}
+
+TEST(writer_to_reader_channel, read_some_across_wrap)
+{
+	const size_t c_data_size = 1024 * 1024;
+	auto data                = archive_diff::test_utility::create_random_data(c_data_size, 0);
+
+	using channel_type = archive_diff::io::compressed::writer_to_reader_channel;
+
+	for (size_t capacity : {size_t{997}, size_t{4096}, channel_type::c_default_capacity})
+	{
+		archive_diff::io::compressed::writer_to_reader_channel channel{c_data_size, capacity};
+		ASSERT_EQ(capacity, channel.capacity());
+
+		std::thread writer_thread([&] { write_in_chunks(channel, data); });
+
+		std::vector<char> result(c_data_size);
+		size_t offset = 0;
+		size_t chunk  = 5;
+		while (offset < c_data_size)
+		{
+			auto to_read = std::min(chunk, c_data_size - offset);
+			channel.read(std::span<char>{result.data() + offset, to_read});
+			offset += to_read;
+			chunk = (chunk * 13) % 5003 + 1;
+		}
+
+		writer_thread.join();
+
+		ASSERT_EQ(c_data_size, channel.tellg());
+		ASSERT_EQ(c_data_size, channel.tellp());
+		ASSERT_EQ(data, result);
+	}
+}
+
+TEST(writer_to_reader_channel, borrow_and_acquire_write_region)
+{
+	const size_t c_data_size = 512 * 1024;
+	auto data                = archive_diff::test_utility::create_random_data(c_data_size, 0);
+
+	archive_diff::io::compressed::writer_to_reader_channel channel{c_data_size, 1000};
+
+	std::thread writer_thread(
+		[&]
+		{
+			size_t offset = 0;
+			while (offset < c_data_size)
+			{
+				auto region = channel.acquire_write_region(c_data_size - offset);
+				ASSERT_FALSE(region.empty());
+				ASSERT_LE(region.size(), channel.capacity());
+
+				// Only fill part of the region to exercise partial commits.
+				auto to_commit = std::max<size_t>(1, region.size() / 2);
+				std::memcpy(region.data(), data.data() + offset, to_commit);
+				channel.commit_write(to_commit);
+				offset += to_commit;
+			}
+		});
+
+	std::vector<char> result;
+	channel.for_each_block(
+		c_data_size, [&](std::string_view block) { result.insert(result.end(), block.begin(), block.end()); });
+
+	writer_thread.join();
+
+	ASSERT_EQ(data, result);
+}
+
+TEST(writer_to_reader_channel, cancel_releases_writer)
+{
+	archive_diff::io::compressed::writer_to_reader_channel channel{1024 * 1024, 1024};
+
+	auto data = archive_diff::test_utility::create_random_data(64 * 1024, 0);
+
+	std::thread writer_thread([&] { channel.write(std::string_view{data.data(), data.size()}); });
+
+	std::vector<char> result(100);
+	channel.read(result);
+	ASSERT_EQ(0, std::memcmp(data.data(), result.data(), result.size()));
+
+	// The writer is now blocked on a full ring.
+	channel.cancel();
+	writer_thread.join();
+}
+
+TEST(writer_to_reader_channel, flush_wakes_reader)
+{
+	archive_diff::io::compressed::writer_to_reader_channel channel{1024 * 1024, 64 * 1024};
+
+	// Fewer bytes than the watermark, so only the flush wakes the reader.
+	const char c_small[] = "flushed";
+
+	std::thread writer_thread(
+		[&]
+		{
+			channel.write(std::string_view{c_small, sizeof(c_small)});
+			channel.flush();
+		});
+
+	std::vector<char> result(sizeof(c_small));
+	auto borrowed = channel.borrow_some(1024);
+	ASSERT_TRUE(borrowed.has_value());
+	ASSERT_GT(borrowed->size(), 0);
+	ASSERT_LE(borrowed->size(), sizeof(c_small));
+	std::memcpy(result.data(), borrowed->data(), borrowed->size());
+	auto remaining = sizeof(c_small) - borrowed->size();
+	if (remaining)
+	{
+		channel.read(std::span<char>{result.data() + borrowed->size(), remaining});
+	}
+
+	writer_thread.join();
+
+	ASSERT_EQ(0, std::memcmp(c_small, result.data(), sizeof(c_small)));
+	channel.cancel();
+}
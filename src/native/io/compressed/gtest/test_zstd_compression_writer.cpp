@@ -136,4 +136,89 @@ TEST(zstd_compression_writer, uncompressed_size_one_byte_too_many)
 		}
 	}
 	ASSERT_TRUE(caught_exception);
-}
\ No newline at end of file
+}
+static std::vector<char> compress_with_workers(
+	std::shared_ptr<std::vector<char>> &uncompressed_data_vector,
+	const archive_diff::io::compressed::zstd_compression_workers &workers)
+{
+	using device             = archive_diff::io::buffer::io_device;
+	auto uncompressed_reader = device::make_reader(uncompressed_data_vector, device::size_kind::vector_size);
+
+	auto compressed_data_vector = std::make_shared<std::vector<char>>();
+
+	std::shared_ptr<archive_diff::io::writer> buffer_writer =
+		std::make_shared<archive_diff::io::buffer::writer>(compressed_data_vector);
+	std::shared_ptr<archive_diff::io::sequential::writer> sequential_buffer_writer =
+		std::make_shared<archive_diff::io::sequential::basic_writer_wrapper>(buffer_writer);
+
+	archive_diff::io::compressed::zstd_compression_writer compression_writer(
+		sequential_buffer_writer, c_sample_file_zst_compression_level, uncompressed_reader.size(), workers);
+
+	compression_writer.write(uncompressed_reader);
+
+	return *compressed_data_vector;
+}
+
+TEST(zstd_compression_writer, multiple_workers_deterministic)
+{
+	// Repeat the sample several times so the input spans multiple zstd jobs.
+	auto uncompressed_path = g_test_data_root / c_sample_file_zst_uncompressed;
+	auto sample_reader     = archive_diff::io::file::io_device::make_reader(uncompressed_path.string());
+	auto sample_data       = reader_to_vector(sample_reader);
+
+	auto uncompressed_data_vector = std::make_shared<std::vector<char>>();
+	for (int i = 0; i < 8; i++)
+	{
+		uncompressed_data_vector->insert(uncompressed_data_vector->end(), sample_data.begin(), sample_data.end());
+	}
+
+	archive_diff::io::compressed::zstd_compression_workers workers;
+	workers.m_job_size    = 512 * 1024;
+	workers.m_overlap_log = 6;
+
+	workers.m_worker_count = 1;
+	auto expected          = compress_with_workers(uncompressed_data_vector, workers);
+
+	for (uint32_t worker_count : {2, 4, 8})
+	{
+		workers.m_worker_count = worker_count;
+		auto compressed        = compress_with_workers(uncompressed_data_vector, workers);
+		ASSERT_EQ(expected, compressed);
+	}
+
+	using device                = archive_diff::io::buffer::io_device;
+	auto compressed_data_vector = std::make_shared<std::vector<char>>(expected);
+	auto compressed_reader      = device::make_reader(compressed_data_vector, device::size_kind::vector_size);
+
+	archive_diff::io::compressed::zstd_decompression_reader decompression_reader{
+		compressed_reader, uncompressed_data_vector->size()};
+
+	std::vector<char> round_trip;
+	decompression_reader.read_all_remaining(round_trip);
+	ASSERT_EQ(*uncompressed_data_vector, round_trip);
+}
+
+TEST(zstd_compression_writer, job_size_out_of_range)
+{
+	auto uncompressed_data_vector = std::make_shared<std::vector<char>>(1024, 'a');
+
+	// Narrowed to zstd's int this would be 0, which zstd takes as its default job size.
+	archive_diff::io::compressed::zstd_compression_workers workers;
+	workers.m_worker_count = 2;
+	workers.m_job_size     = 4ull * 1024 * 1024 * 1024;
+
+	bool caught_exception{false};
+	try
+	{
+		compress_with_workers(uncompressed_data_vector, workers);
+	}
+	catch (archive_diff::errors::user_exception &e)
+	{
+		if (e.get_error() == archive_diff::errors::error_code::io_zstd_set_parameter_failed)
+		{
+			caught_exception = true;
+		}
+	}
+
+	ASSERT_TRUE(caught_exception);
+}
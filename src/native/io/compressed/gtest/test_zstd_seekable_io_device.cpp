@@ -0,0 +1,115 @@
+/**
+ * @file test_zstd_seekable_io_device.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <io/buffer/io_device.h>
+#include <io/buffer/writer.h>
+#include <io/sequential/basic_writer_wrapper.h>
+
+#include <io/compressed/zstd_compression_writer.h>
+#include <io/compressed/zstd_decompression_reader.h>
+#include <io/compressed/zstd_seekable_io_device.h>
+
+using namespace archive_diff;
+using device = io::buffer::io_device;
+
+const uint32_t c_frame_size = 64 * 1024;
+const size_t c_data_size    = 10 * c_frame_size + 1234;
+
+static std::shared_ptr<std::vector<char>> make_data()
+{
+	auto data = std::make_shared<std::vector<char>>(c_data_size);
+	for (size_t i = 0; i < c_data_size; i++)
+	{
+		(*data)[i] = static_cast<char>((i % 251) ^ (i >> 12));
+	}
+	return data;
+}
+
+static std::shared_ptr<std::vector<char>> compress(std::shared_ptr<std::vector<char>> &data, uint32_t frame_size)
+{
+	auto compressed                    = std::make_shared<std::vector<char>>();
+	std::shared_ptr<io::writer> writer = std::make_shared<io::buffer::writer>(compressed);
+	std::shared_ptr<io::sequential::writer> seq_writer =
+		std::make_shared<io::sequential::basic_writer_wrapper>(writer);
+
+	io::compressed::zstd_seekable_format seekable{frame_size};
+	io::compressed::zstd_compression_writer compression_writer(
+		seq_writer, 3, data->size(), io::compressed::zstd_compression_workers{}, seekable);
+
+	auto data_reader = device::make_reader(data, device::size_kind::vector_size);
+	compression_writer.write(data_reader);
+
+	return compressed;
+}
+
+TEST(zstd_seekable_io_device, random_access)
+{
+	auto data       = make_data();
+	auto compressed = compress(data, c_frame_size);
+
+	auto compressed_reader = device::make_reader(compressed, device::size_kind::vector_size);
+
+	io::compressed::zstd_seek_table seek_table;
+	ASSERT_TRUE(io::compressed::zstd_seek_table::try_read(compressed_reader, &seek_table));
+	ASSERT_EQ(11, seek_table.get_frames().size());
+	ASSERT_EQ(c_data_size, seek_table.get_uncompressed_size());
+	ASSERT_EQ(1234, seek_table.get_frames().back().m_uncompressed_size);
+	ASSERT_EQ(3, seek_table.find_frame(3 * c_frame_size + 7));
+
+	io::reader reader;
+	ASSERT_TRUE(io::compressed::zstd_seekable_io_device::try_make_reader(compressed_reader, &reader));
+	ASSERT_EQ(c_data_size, reader.size());
+
+	// Reads within a frame, across frames and backwards.
+	for (uint64_t offset : {uint64_t{5}, uint64_t{c_frame_size - 10}, uint64_t{7 * c_frame_size + 3}, uint64_t{100}})
+	{
+		std::vector<char> slice(3 * c_frame_size / 2);
+		auto to_read = std::min<uint64_t>(slice.size(), c_data_size - offset);
+		reader.read(offset, std::span<char>{slice.data(), static_cast<size_t>(to_read)});
+		ASSERT_EQ(0, std::memcmp(slice.data(), data->data() + offset, static_cast<size_t>(to_read)));
+	}
+
+	std::vector<char> tail(2000);
+	ASSERT_EQ(1000, reader.read_some(c_data_size - 1000, tail));
+	ASSERT_EQ(0, std::memcmp(tail.data(), data->data() + c_data_size - 1000, 1000));
+}
+
+TEST(zstd_seekable_io_device, plain_zstd_compatible)
+{
+	auto data       = make_data();
+	auto compressed = compress(data, c_frame_size);
+
+	auto compressed_reader = device::make_reader(compressed, device::size_kind::vector_size);
+
+	// A sequential reader decompresses the frames in turn and never reaches the seek table.
+	{
+		io::compressed::zstd_decompression_reader reader(compressed_reader, c_data_size);
+		std::vector<char> decompressed;
+		reader.read_all_remaining(decompressed);
+		ASSERT_EQ(*data, decompressed);
+	}
+
+	// Skipping moves to the frame holding the target, rather than decompressing up to it.
+	{
+		io::compressed::zstd_decompression_reader reader(compressed_reader, c_data_size);
+		reader.skip(9 * c_frame_size + 17);
+		ASSERT_EQ(9 * c_frame_size + 17, reader.tellg());
+
+		std::vector<char> decompressed;
+		reader.read_all_remaining(decompressed);
+		ASSERT_EQ(c_data_size - (9 * c_frame_size + 17), decompressed.size());
+		ASSERT_EQ(0, std::memcmp(decompressed.data(), data->data() + 9 * c_frame_size + 17, decompressed.size()));
+	}
+
+	// Without a frame size there is a single frame and no seek table.
+	auto single_frame        = compress(data, 0);
+	auto single_frame_reader = device::make_reader(single_frame, device::size_kind::vector_size);
+
+	io::reader reader;
+	ASSERT_FALSE(io::compressed::zstd_seekable_io_device::try_make_reader(single_frame_reader, &reader));
+}
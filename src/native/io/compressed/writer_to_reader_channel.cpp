@@ -10,63 +10,101 @@
 
 namespace archive_diff::io::compressed
 {
+writer_to_reader_channel::writer_to_reader_channel(uint64_t expected_total_read, size_t capacity) :
+	m_expected_total_read(expected_total_read)
+{
+	m_buffer.resize(std::max<size_t>(capacity, 4));
+
+	// Must be at most half the capacity, or a full ring may not be enough to wake the reader.
+	m_watermark = m_buffer.size() / 4;
+}
+
 size_t writer_to_reader_channel::read_some(std::span<char> buffer)
 {
-	auto remaining_to_read = buffer.size();
-	size_t total_read      = 0;
+	release_borrowed();
 
-	while (remaining_to_read)
+	size_t total_read = 0;
+
+	while (total_read < buffer.size())
 	{
-		if (done_reading())
+		auto region = acquire_read_region(buffer.size() - total_read);
+		if (region.empty())
 		{
-			return total_read;
+			break;
 		}
 
-		auto available = get_available_read();
-		while (available == 0)
-		{
-			if (done_reading())
-			{
-				return total_read;
-			}
+		std::memcpy(buffer.data() + total_read, region.data(), region.size());
 
-			// wait for a signal
-			wait_for_available_content();
+		m_total_read += region.size();
+		release_read(region.size());
 
-			if (canceled())
-			{
-				return total_read;
-			}
+		total_read += region.size();
+	}
 
-			available = get_available_read();
-		}
+	return total_read;
+}
 
-		auto to_read = std::min<size_t>(available, remaining_to_read);
+std::optional<std::span<const char>> writer_to_reader_channel::borrow_some(uint64_t length)
+{
+	// The previous borrowed region is only valid until the next read, so it goes back to the writer now.
+	release_borrowed();
 
-		{
-			std::lock_guard<std::mutex> lock(m_buffer_mutex);
-			auto max_to_read = get_max_available_read();
-			// we shouldn't read more than we think is available
-			if (max_to_read < to_read)
-			{
-				std::string msg = "More data is available than we expect. m_total_read: " + std::to_string(m_total_read)
-				                + ", max_to_read: " + std::to_string(max_to_read);
-				throw errors::user_exception(
-					errors::error_code::io_producer_consumer_reader_writer_reading_too_much_available, msg);
-			}
-			std::memcpy(buffer.data() + total_read, m_buffer.data() + m_start_offset, to_read);
+	auto to_borrow = static_cast<size_t>(std::min<uint64_t>(length, capacity()));
+	auto region    = acquire_read_region(to_borrow);
 
-			m_start_offset += to_read;
-			m_total_read += to_read;
-		}
+	m_borrowed = region.size();
+	m_total_read += region.size();
 
-		notify_all_writers();
+	return region;
+}
 
-		remaining_to_read -= to_read;
-		total_read += to_read;
+void writer_to_reader_channel::release_borrowed()
+{
+	if (m_borrowed == 0)
+	{
+		return;
 	}
 
-	return total_read;
+	auto borrowed = m_borrowed;
+	m_borrowed    = 0;
+	release_read(borrowed);
+}
+
+std::span<const char> writer_to_reader_channel::acquire_read_region(size_t max_size)
+{
+	auto wanted = static_cast<size_t>(std::min<uint64_t>(max_size, get_max_available_read()));
+	if (wanted == 0)
+	{
+		return {};
+	}
+
+	if (!wait_for_available_content(std::min(wanted, m_watermark)))
+	{
+		return {};
+	}
+
+	auto available   = get_available_read();
+	auto max_to_read = get_max_available_read();
+	// we shouldn't read more than we think is available
+	if (max_to_read < available)
+	{
+		std::string msg = "More data is available than we expect. m_total_read: " + std::to_string(m_total_read)
+		                + ", max_to_read: " + std::to_string(max_to_read)
+		                + ", available: " + std::to_string(available);
+		throw errors::user_exception(
+			errors::error_code::io_producer_consumer_reader_writer_reading_too_much_available, msg);
+	}
+
+	auto offset     = static_cast<size_t>(m_read_position % capacity());
+	auto contiguous = std::min<uint64_t>({available, capacity() - offset, wanted});
+
+	return std::span<const char>{m_buffer.data() + offset, static_cast<size_t>(contiguous)};
+}
+
+void writer_to_reader_channel::release_read(size_t size)
+{
+	m_read_position += size;
+	notify_writer_if_ready();
 }
 
 void writer_to_reader_channel::write(std::string_view buffer)
@@ -85,61 +123,164 @@ void writer_to_reader_channel::write(std::string_view buffer)
 			throw errors::user_exception(errors::error_code::io_producer_consumer_reader_writer_writing_when_done, msg);
 		}
 
+		auto region = acquire_write_region(remaining);
+		if (region.empty())
 		{
-			std::lock_guard<std::mutex> lock_guard(m_buffer_mutex);
-
-			shift_buffer();
-
-			auto available = get_available_write();
-			auto to_write  = std::min<uint64_t>(remaining, available);
-
-			memcpy(m_buffer.data() + m_end_offset, buffer.data() + read_offset, to_write);
-			m_end_offset += to_write;
-
-			remaining -= to_write;
-			m_total_written += to_write;
-			read_offset += to_write;
+			// Either nothing to write, canceled, or the reader is done and the check above throws.
+			if ((remaining == 0) || canceled())
+			{
+				return;
+			}
+			continue;
 		}
 
-		// we wrote something, signal any waiting readers
-		notify_all_readers();
+		std::memcpy(region.data(), buffer.data() + read_offset, region.size());
+		commit_write(region.size());
+
+		remaining -= region.size();
+		read_offset += region.size();
 
 		if (remaining == 0)
 		{
 			return;
 		}
+	}
+}
 
-		// wait for a signal
-		wait_until_write_possible();
+std::span<char> writer_to_reader_channel::acquire_write_region(size_t max_size)
+{
+	if (max_size == 0)
+	{
+		return {};
+	}
 
-		if (canceled())
-		{
-			return;
-		}
+	if (!wait_until_write_possible(std::min(max_size, m_watermark)))
+	{
+		return {};
 	}
+
+	auto available  = get_available_write();
+	auto offset     = static_cast<size_t>(m_write_position % capacity());
+	auto contiguous = std::min({available, capacity() - offset, max_size});
+
+	return std::span<char>{m_buffer.data() + offset, contiguous};
 }
 
-void writer_to_reader_channel::shift_buffer()
+void writer_to_reader_channel::commit_write(size_t size)
 {
-	if (m_start_offset == 0)
+	if (size > get_available_write())
 	{
-		return;
+		std::string msg = "Committing more than was acquired. size: " + std::to_string(size)
+		                + ", available: " + std::to_string(get_available_write());
+		throw errors::user_exception(errors::error_code::io_producer_consumer_reader_writer_invalid_offset, msg);
+	}
+
+	m_write_position += size;
+	notify_reader_if_ready();
+}
+
+void writer_to_reader_channel::flush()
+{
+	m_flushed_position = m_write_position.load();
+
+	if (m_reader_wakeup_threshold)
+	{
+		std::lock_guard<std::mutex> lock(m_wait_mutex);
+		m_waiting_reader_cv.notify_all();
 	}
-	auto bytes = m_end_offset - m_start_offset;
-	memcpy(m_buffer.data(), m_buffer.data() + m_start_offset, bytes);
-	m_end_offset   = m_end_offset - m_start_offset;
-	m_start_offset = 0;
 }
 
-void writer_to_reader_channel::wait_for_available_content()
+void writer_to_reader_channel::notify_all_writers()
 {
-	std::unique_lock<std::mutex> lock(m_buffer_mutex);
-	m_waiting_reader_cv.wait(lock, [&] { return m_start_offset != m_end_offset || canceled(); });
+	std::lock_guard<std::mutex> lock(m_wait_mutex);
+	m_waiting_writer_cv.notify_all();
+}
+
+void writer_to_reader_channel::cancel()
+{
+	m_canceled = true;
+
+	std::lock_guard<std::mutex> lock(m_wait_mutex);
+	m_waiting_writer_cv.notify_all();
+	m_waiting_reader_cv.notify_all();
+}
+
+// Waiting publishes a threshold before checking the positions, and the other side
+// advances its position before checking the threshold. With both being sequentially
+// consistent atomics, at least one of them sees the other and no wakeup is lost.
+void writer_to_reader_channel::notify_reader_if_ready()
+{
+	auto threshold = m_reader_wakeup_threshold.load();
+	if (threshold && reader_should_wake(threshold))
+	{
+		std::lock_guard<std::mutex> lock(m_wait_mutex);
+		m_waiting_reader_cv.notify_all();
+	}
+}
+
+void writer_to_reader_channel::notify_writer_if_ready()
+{
+	auto threshold = m_writer_wakeup_threshold.load();
+	if (threshold && writer_should_wake(threshold))
+	{
+		std::lock_guard<std::mutex> lock(m_wait_mutex);
+		m_waiting_writer_cv.notify_all();
+	}
 }
 
-void writer_to_reader_channel::wait_until_write_possible()
+void writer_to_reader_channel::set_wait_hooks(std::function<void()> before_wait, std::function<void()> after_wait)
 {
-	std::unique_lock<std::mutex> lock(m_buffer_mutex);
-	m_waiting_writer_cv.wait(lock, [&] { return !buffer_is_full() || done_reading() || canceled(); });
+	m_before_wait = std::move(before_wait);
+	m_after_wait  = std::move(after_wait);
+}
+
+void writer_to_reader_channel::before_wait()
+{
+	if (m_before_wait)
+	{
+		m_before_wait();
+	}
+}
+
+void writer_to_reader_channel::after_wait()
+{
+	if (m_after_wait)
+	{
+		m_after_wait();
+	}
+}
+
+bool writer_to_reader_channel::wait_for_available_content(size_t threshold)
+{
+	if (get_available_read() < threshold)
+	{
+		before_wait();
+		{
+			std::unique_lock<std::mutex> lock(m_wait_mutex);
+			m_reader_wakeup_threshold = threshold;
+			m_waiting_reader_cv.wait(lock, [&] { return reader_should_wake(threshold); });
+			m_reader_wakeup_threshold = 0;
+		}
+		after_wait();
+	}
+
+	return get_available_read() != 0;
+}
+
+bool writer_to_reader_channel::wait_until_write_possible(size_t threshold)
+{
+	if (get_available_write() < threshold)
+	{
+		before_wait();
+		{
+			std::unique_lock<std::mutex> lock(m_wait_mutex);
+			m_writer_wakeup_threshold = threshold;
+			m_waiting_writer_cv.wait(lock, [&] { return writer_should_wake(threshold); });
+			m_writer_wakeup_threshold = 0;
+		}
+		after_wait();
+	}
+
+	return !canceled() && !done_reading() && (get_available_write() != 0);
 }
 } // namespace archive_diff::io::compressed
\ No newline at end of file
@@ -6,9 +6,12 @@
  */
 #pragma once
 
+#include <atomic>
 #include <exception>
+#include <functional>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include <io/sequential/reader.h>
 #include <io/sequential/writer.h>
@@ -16,66 +19,106 @@
 namespace archive_diff::io::compressed
 {
 // This class is written to and allows a user to read the content written to the shared buffer.
+// It is a single-producer/single-consumer ring: one thread writes and one thread reads.
+// Positions are only advanced with atomics, so neither side takes a lock unless it has to
+// wait. A waiting side is only woken once a watermark's worth of data (or space) is ready,
+// or when the writer flushes, rather than on every chunk.
 class writer_to_reader_channel : public io::sequential::writer, public io::sequential::reader
 {
 	public:
-	const size_t c_buffer_capacity = 64 * 1024;
+	static const size_t c_default_capacity = 64 * 1024;
 
-	writer_to_reader_channel(uint64_t expected_total_read) : m_expected_total_read(expected_total_read)
-	{
-		m_buffer.reserve(c_buffer_capacity);
-	}
+	writer_to_reader_channel(uint64_t expected_total_read) :
+		writer_to_reader_channel(expected_total_read, c_default_capacity)
+	{}
+
+	writer_to_reader_channel(uint64_t expected_total_read, size_t capacity);
 
 	virtual ~writer_to_reader_channel() = default;
 
 	virtual size_t read_some(std::span<char> buffer) override;
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t length) override;
 	virtual uint64_t tellg() const override { return m_total_read; }
 	virtual void skip(uint64_t to_skip) { skip_by_reading(to_skip); }
 	virtual uint64_t size() const { return m_expected_total_read; }
 
 	virtual void write(std::string_view buffer) override;
-	virtual uint64_t tellp() override { return m_total_written; }
-	virtual void flush() override { shift_buffer(); }
+	virtual uint64_t tellp() override { return m_write_position; }
+	virtual void flush() override;
 
-	void notify_all_writers() { m_waiting_writer_cv.notify_all(); }
-	void cancel()
-	{
-		m_canceled = true;
-		notify_all_writers();
-	}
+	// Zero-copy writing: acquire_write_region() returns the largest contiguous free region
+	// of up to max_size bytes, waiting for space if needed. The caller fills a prefix of it
+	// and then calls commit_write() with the number of bytes filled. An empty region means
+	// the channel was canceled or the reader already has everything.
+	std::span<char> acquire_write_region(size_t max_size);
+	void commit_write(size_t size);
 
-	private:
-	void shift_buffer();
+	size_t capacity() const { return m_buffer.size(); }
+
+	void notify_all_writers();
+	void cancel();
+
+	// Called on the waiting side's thread right before it sleeps for the other side and right
+	// after it wakes, so whatever runs that side can hand out its resources in between.
+	void set_wait_hooks(std::function<void()> before_wait, std::function<void()> after_wait);
 
+	private:
 	uint64_t get_max_available_read() const { return done_reading() ? 0 : m_expected_total_read - m_total_read; }
 
-	uint64_t get_available_read() const { return m_end_offset - m_start_offset; }
-	size_t get_available_write() const { return m_buffer.capacity() - m_end_offset; }
+	uint64_t get_available_read() const { return m_write_position - m_read_position; }
+	size_t get_available_write() const { return capacity() - static_cast<size_t>(get_available_read()); }
 
-	void notify_all_readers() { m_waiting_reader_cv.notify_all(); }
+	std::span<const char> acquire_read_region(size_t max_size);
+	void release_read(size_t size);
+	void release_borrowed();
 
-	void wait_for_available_content();
+	bool wait_for_available_content(size_t threshold);
+	bool wait_until_write_possible(size_t threshold);
 
-	bool done_reading() const { return (m_total_read >= m_expected_total_read); }
-	bool buffer_is_full() const { return (m_start_offset) == 0 && (m_end_offset == m_buffer.capacity()); }
-	bool canceled() { return m_canceled; }
+	void before_wait();
+	void after_wait();
 
-	void wait_until_write_possible();
+	void notify_reader_if_ready();
+	void notify_writer_if_ready();
+
+	bool reader_should_wake(size_t threshold) const
+	{
+		return (get_available_read() >= threshold) || (m_flushed_position > m_read_position) || canceled();
+	}
+	bool writer_should_wake(size_t threshold) const
+	{
+		return (get_available_write() >= threshold) || done_reading() || canceled();
+	}
+
+	bool done_reading() const { return (m_total_read >= m_expected_total_read); }
+	bool canceled() const { return m_canceled; }
 
 	std::vector<char> m_buffer;
-	size_t m_start_offset{};
-	size_t m_end_offset{};
+	size_t m_watermark{};
+
+	// Total bytes written and released by the reader. Their difference is what is in the ring.
+	std::atomic<uint64_t> m_write_position{};
+	std::atomic<uint64_t> m_read_position{};
+	std::atomic<uint64_t> m_flushed_position{};
 
-	uint64_t m_total_read{};
-	uint64_t m_total_written{};
+	// Includes bytes handed out by borrow_some() that are not yet released back to the ring.
+	std::atomic<uint64_t> m_total_read{};
+	size_t m_borrowed{};
 
 	uint64_t m_expected_total_read{};
 
-	std::mutex m_buffer_mutex{};
+	// Only used to sleep; a side publishes what it is waiting for in its threshold.
+	std::mutex m_wait_mutex{};
 
 	std::condition_variable m_waiting_writer_cv{};
 	std::condition_variable m_waiting_reader_cv{};
 
-	bool m_canceled{false};
+	std::atomic<size_t> m_reader_wakeup_threshold{};
+	std::atomic<size_t> m_writer_wakeup_threshold{};
+
+	std::atomic<bool> m_canceled{false};
+
+	std::function<void()> m_before_wait;
+	std::function<void()> m_after_wait;
 };
 } // namespace archive_diff::io::compressed
\ No newline at end of file
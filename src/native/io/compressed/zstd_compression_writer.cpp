@@ -14,13 +14,39 @@ namespace archive_diff::io::compressed
 {
 zstd_compression_writer::zstd_compression_writer(
 	std::shared_ptr<io::sequential::writer> &writer, uint64_t level, uint64_t uncompressed_input_size) :
+	zstd_compression_writer(writer, level, uncompressed_input_size, zstd_compression_workers{})
+{}
+
+zstd_compression_writer::zstd_compression_writer(
+	std::shared_ptr<io::sequential::writer> &writer,
+	uint64_t level,
+	uint64_t uncompressed_input_size,
+	const zstd_compression_workers &workers) :
 	io::sequential::writer_impl(), m_writer(writer), m_uncompressed_input_size(uncompressed_input_size)
 {
 	ZSTD_CCtx_setPledgedSrcSize(m_zstd_cstream.get(), m_uncompressed_input_size);
 	ZSTD_CCtx_reset(m_zstd_cstream.get(), ZSTD_reset_session_only);
 	ZSTD_CCtx_refCDict(m_zstd_cstream.get(), nullptr);
 	ZSTD_CCtx_setParameter(m_zstd_cstream.get(), ZSTD_c_compressionLevel, (int)level);
-	ZSTD_CCtx_setParameter(m_zstd_cstream.get(), ZSTD_c_nbWorkers, 1);
+
+	// A single worker is the long-standing default and is allowed to fail quietly on
+	// zstd builds without multi-threading; asking for more must be honored.
+	if (workers.m_worker_count > 1)
+	{
+		set_unsigned_parameter(ZSTD_c_nbWorkers, workers.m_worker_count);
+	}
+	else
+	{
+		ZSTD_CCtx_setParameter(m_zstd_cstream.get(), ZSTD_c_nbWorkers, 1);
+	}
+	if (workers.m_job_size)
+	{
+		set_unsigned_parameter(ZSTD_c_jobSize, workers.m_job_size);
+	}
+	if (workers.m_overlap_log)
+	{
+		set_parameter(ZSTD_c_overlapLog, workers.m_overlap_log);
+	}
 
 	m_input_data.reserve(ZSTD_CStreamInSize());
 	m_output_data.reserve(ZSTD_CStreamOutSize());
@@ -35,12 +61,72 @@ zstd_compression_writer::zstd_compression_writer(
 	std::shared_ptr<io::sequential::writer> &writer,
 	uint64_t level,
 	uint64_t uncompressed_input_size,
-	compression_dictionary &&dictionary) : zstd_compression_writer(writer, level, uncompressed_input_size)
+	compression_dictionary &&dictionary) :
+	zstd_compression_writer(writer, level, uncompressed_input_size, std::move(dictionary), zstd_compression_workers{})
+{}
+
+zstd_compression_writer::zstd_compression_writer(
+	std::shared_ptr<io::sequential::writer> &writer,
+	uint64_t level,
+	uint64_t uncompressed_input_size,
+	compression_dictionary &&dictionary,
+	const zstd_compression_workers &workers) :
+	zstd_compression_writer(writer, level, uncompressed_input_size, workers)
 {
 	m_compression_dictionary = std::move(dictionary);
 	set_dictionary(m_compression_dictionary);
 }
 
+zstd_compression_writer::zstd_compression_writer(
+	std::shared_ptr<io::sequential::writer> &writer,
+	uint64_t level,
+	uint64_t uncompressed_input_size,
+	const zstd_compression_workers &workers,
+	const zstd_seekable_format &seekable) :
+	zstd_compression_writer(writer, level, uncompressed_input_size, workers)
+{
+	m_frame_size = seekable.m_frame_size;
+	if (m_frame_size)
+	{
+		set_pledged_frame_size();
+	}
+}
+
+// Each frame gets its own pledged size, so every frame header records its content size.
+void zstd_compression_writer::set_pledged_frame_size()
+{
+	auto remaining = m_uncompressed_input_size - m_frame_start_processed;
+	ZSTD_CCtx_setPledgedSrcSize(m_zstd_cstream.get(), std::min<uint64_t>(m_frame_size, remaining));
+}
+
+void zstd_compression_writer::set_parameter(ZSTD_cParameter parameter, int value)
+{
+	auto ret = ZSTD_CCtx_setParameter(m_zstd_cstream.get(), parameter, value);
+	if (ZSTD_isError(ret))
+	{
+		auto error_name = ZSTD_getErrorName(ret);
+		std::string msg = "ZSTD_CCtx_setParameter() failed. parameter: " + std::to_string(parameter)
+		                + ", value: " + std::to_string(value) + std::string(" error_name: ") + error_name;
+		throw errors::user_exception(errors::error_code::io_zstd_set_parameter_failed, msg);
+	}
+}
+
+// zstd takes an int, so a larger value would wrap to one meaning something else (0 is "default").
+void zstd_compression_writer::set_unsigned_parameter(ZSTD_cParameter parameter, uint64_t value)
+{
+	auto bounds = ZSTD_cParam_getBounds(parameter);
+	if (!ZSTD_isError(bounds.error) && (value <= static_cast<uint64_t>(bounds.upperBound)))
+	{
+		set_parameter(parameter, static_cast<int>(value));
+		return;
+	}
+
+	std::string msg = "ZSTD_CCtx_setParameter() failed. parameter: " + std::to_string(parameter)
+	                + ", value: " + std::to_string(value)
+	                + " is out of range, max: " + std::to_string(bounds.upperBound);
+	throw errors::user_exception(errors::error_code::io_zstd_set_parameter_failed, msg);
+}
+
 void zstd_compression_writer::set_dictionary(const compression_dictionary &dictionary)
 {
 	ZSTD_CCtx_setParameter(m_zstd_cstream.get(), ZSTD_c_enableLongDistanceMatching, 1);
@@ -58,10 +144,6 @@ void zstd_compression_writer::write_impl(std::string_view buffer)
 		return;
 	}
 
-	ZSTD_inBuffer input_buffer{buffer.data(), buffer.size(), 0};
-
-	bool done = false;
-
 	auto new_processed_bytes = m_processed_bytes + buffer.size();
 	if (new_processed_bytes > m_uncompressed_input_size)
 	{
@@ -73,13 +155,68 @@ void zstd_compression_writer::write_impl(std::string_view buffer)
 		throw errors::user_exception(errors::error_code::io_zstd_too_much_data_processed, msg);
 	}
 
-	bool last_chunk = new_processed_bytes == m_uncompressed_input_size;
+	if (m_frame_size)
+	{
+		compress_frames(buffer);
+	}
+	else
+	{
+		bool last_chunk = new_processed_bytes == m_uncompressed_input_size;
+		compress(buffer, last_chunk ? ZSTD_EndDirective::ZSTD_e_end : ZSTD_EndDirective::ZSTD_e_continue);
+	}
+
+	m_processed_bytes = new_processed_bytes;
+
+	if (m_processed_bytes == m_uncompressed_input_size)
+	{
+		if (m_frame_size)
+		{
+			m_seek_table.write(*m_writer);
+		}
+		flush();
+	}
+}
+
+// Splits the input at frame boundaries, ending a frame whenever one is full.
+void zstd_compression_writer::compress_frames(std::string_view buffer)
+{
+	while (!buffer.empty())
+	{
+		auto frame_processed = m_processed_bytes - m_frame_start_processed;
+		auto frame_size      = std::min<uint64_t>(m_frame_size, m_uncompressed_input_size - m_frame_start_processed);
+		auto to_compress     = static_cast<size_t>(std::min<uint64_t>(buffer.size(), frame_size - frame_processed));
+		bool frame_end       = (frame_processed + to_compress) == frame_size;
+
+		compress(
+			buffer.substr(0, to_compress),
+			frame_end ? ZSTD_EndDirective::ZSTD_e_end : ZSTD_EndDirective::ZSTD_e_continue);
+
+		buffer = buffer.substr(to_compress);
+		m_processed_bytes += to_compress;
+
+		if (frame_end)
+		{
+			m_seek_table.add_frame(m_compressed_size - m_frame_start_compressed, frame_size);
+			m_frame_start_processed  = m_processed_bytes;
+			m_frame_start_compressed = m_compressed_size;
+
+			if (m_frame_start_processed < m_uncompressed_input_size)
+			{
+				set_pledged_frame_size();
+			}
+		}
+	}
+}
+
+void zstd_compression_writer::compress(std::string_view buffer, ZSTD_EndDirective op)
+{
+	ZSTD_inBuffer input_buffer{buffer.data(), buffer.size(), 0};
+
+	bool done = false;
 	do
 	{
 		ZSTD_outBuffer output_buffer{m_output_data.data(), m_output_data.capacity(), 0};
 
-		auto op = last_chunk ? ZSTD_EndDirective::ZSTD_e_end : ZSTD_EndDirective::ZSTD_e_continue;
-
 		size_t ret = ZSTD_compressStream2(m_zstd_cstream.get(), &output_buffer, &input_buffer, op);
 		if (ZSTD_isError(ret))
 		{
@@ -95,16 +232,9 @@ void zstd_compression_writer::write_impl(std::string_view buffer)
 			m_compressed_size += output_buffer.pos;
 		}
 
-		done = last_chunk ? (ret == 0) : (input_buffer.size == input_buffer.pos);
+		done = (op == ZSTD_EndDirective::ZSTD_e_end) ? (ret == 0) : (input_buffer.size == input_buffer.pos);
 	}
 	while (!done);
-
-	m_processed_bytes = new_processed_bytes;
-
-	if (m_processed_bytes == m_uncompressed_input_size)
-	{
-		flush();
-	}
 }
 
 void zstd_compression_writer::flush() { m_writer->flush(); }
@@ -14,12 +14,33 @@
 #include <io/writer.h>
 #include <io/sequential/writer_impl.h>
 
+#include "zstd_seek_table.h"
 #include "zstd_wrappers.h"
 
 #include "compression_dictionary.h"
 
 namespace archive_diff::io::compressed
 {
+// Controls how zstd splits compression across worker threads. Output depends on
+// the level, job size and overlap log, but not on the worker count once it is at
+// least 1, so any worker count can be used to produce the same content.
+// A job size or overlap log of 0 uses zstd's default for the level.
+struct zstd_compression_workers
+{
+	uint32_t m_worker_count{1};
+	uint64_t m_job_size{0};
+	int m_overlap_log{0};
+};
+
+// Writes the content in the zstd seekable format: independent frames of m_frame_size
+// uncompressed bytes followed by a seek table (see zstd_seek_table), so it can be read
+// from any frame. Smaller frames make random access cheaper and compress less well.
+// A frame size of 0 writes a single frame without a seek table.
+struct zstd_seekable_format
+{
+	uint32_t m_frame_size{};
+};
+
 // We could potentially omit the uncompressed_size, but then we wouldn't
 // know when we're done. This would mean we wouldn't set
 // ZSTD_EndDirective::ZSTD_e_end, which would produce decompressable content,
@@ -34,12 +55,33 @@ class zstd_compression_writer : public io::sequential::writer_impl
 	zstd_compression_writer(
 		std::shared_ptr<io::sequential::writer> &writer, uint64_t level, uint64_t uncompressed_input_size);
 
+	zstd_compression_writer(
+		std::shared_ptr<io::sequential::writer> &writer,
+		uint64_t level,
+		uint64_t uncompressed_input_size,
+		const zstd_compression_workers &workers);
+
 	zstd_compression_writer(
 		std::shared_ptr<io::sequential::writer> &writer,
 		uint64_t level,
 		uint64_t uncompressed_input_size,
 		compression_dictionary &&dictionary);
 
+	zstd_compression_writer(
+		std::shared_ptr<io::sequential::writer> &writer,
+		uint64_t level,
+		uint64_t uncompressed_input_size,
+		compression_dictionary &&dictionary,
+		const zstd_compression_workers &workers);
+
+	// Frames are independent, so there is no dictionary variant.
+	zstd_compression_writer(
+		std::shared_ptr<io::sequential::writer> &writer,
+		uint64_t level,
+		uint64_t uncompressed_input_size,
+		const zstd_compression_workers &workers,
+		const zstd_seekable_format &seekable);
+
 	virtual ~zstd_compression_writer() = default;
 
 	virtual uint64_t tellp() override { return m_processed_bytes; }
@@ -50,6 +92,12 @@ class zstd_compression_writer : public io::sequential::writer_impl
 
 	private:
 	void set_dictionary(const compression_dictionary &dictionary);
+	void set_parameter(ZSTD_cParameter parameter, int value);
+	void set_unsigned_parameter(ZSTD_cParameter parameter, uint64_t value);
+	void set_pledged_frame_size();
+
+	void compress(std::string_view buffer, ZSTD_EndDirective op);
+	void compress_frames(std::string_view buffer);
 
 	std::shared_ptr<io::sequential::writer> m_writer{};
 	uint64_t m_uncompressed_input_size{};
@@ -58,6 +106,11 @@ class zstd_compression_writer : public io::sequential::writer_impl
 
 	uint64_t m_processed_bytes{};
 
+	uint32_t m_frame_size{};
+	zstd_seek_table m_seek_table;
+	uint64_t m_frame_start_processed{};
+	uint64_t m_frame_start_compressed{};
+
 	unique_zstd_cstream m_zstd_cstream{ZSTD_createCStream()};
 
 	ZSTD_inBuffer m_input_buffer{};
@@ -64,4 +64,65 @@ size_t zstd_decompression_reader::read_some(std::span<char> buffer)
 
 	return total_read;
 }
+
+void zstd_decompression_reader::skip(uint64_t to_skip)
+{
+	auto target = m_read_offset + to_skip;
+
+	if (m_compressed_reader.has_value())
+	{
+		seek_to_frame_before(target);
+	}
+
+	skip_by_reading(target - m_read_offset);
+}
+
+// Restarts decompression at the start of the frame holding the offset, if that's ahead.
+void zstd_decompression_reader::seek_to_frame_before(uint64_t offset)
+{
+	if (!m_seek_table_checked)
+	{
+		m_seek_table_checked = true;
+
+		// Plain zstd content can end with the seekable magic by chance, so a table that
+		// doesn't hold up only means this content is read without seeking.
+		try
+		{
+			zstd_seek_table seek_table;
+			if (zstd_seek_table::try_read(m_compressed_reader.value(), &seek_table))
+			{
+				m_seek_table = std::move(seek_table);
+			}
+		}
+		catch (errors::user_exception &)
+		{}
+	}
+
+	if (!m_seek_table.has_value())
+	{
+		return;
+	}
+
+	auto frame_index = m_seek_table->find_frame(offset);
+	if (frame_index == m_seek_table->get_frames().size())
+	{
+		return;
+	}
+
+	auto &frame = m_seek_table->get_frames()[frame_index];
+	if (frame.m_uncompressed_offset <= m_read_offset)
+	{
+		return;
+	}
+
+	m_reader = std::make_unique<io::sequential::basic_reader_wrapper>(
+		m_compressed_reader->slice_at(frame.m_compressed_offset));
+	ZSTD_DCtx_reset(m_zstd_dstream.get(), ZSTD_reset_session_only);
+
+	m_in_zstd_buffer.src  = m_in_vector.data();
+	m_in_zstd_buffer.pos  = 0;
+	m_in_zstd_buffer.size = 0;
+
+	m_read_offset = frame.m_uncompressed_offset;
+}
 } // namespace archive_diff::io::compressed
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <map>
+#include <optional>
 
 #include <zstd.h>
 
@@ -17,6 +18,7 @@
 
 #include "compression_dictionary.h"
 
+#include "zstd_seek_table.h"
 #include "zstd_wrappers.h"
 
 namespace archive_diff::io::compressed
@@ -30,10 +32,14 @@ class zstd_decompression_reader : public io::sequential::reader
 		setup_input_buffer();
 	}
 
+	// Content in the zstd seekable format is skipped a frame at a time when read through
+	// this constructor.
 	zstd_decompression_reader(io::reader &reader, uint64_t uncompressed_size) :
 		zstd_decompression_reader(
 			std::move(std::make_unique<io::sequential::basic_reader_wrapper>(reader)), uncompressed_size)
-	{}
+	{
+		m_compressed_reader = reader;
+	}
 
 	zstd_decompression_reader(
 		std::unique_ptr<io::sequential::reader> &&reader,
@@ -57,7 +63,7 @@ class zstd_decompression_reader : public io::sequential::reader
 	virtual size_t read_some(std::span<char> buffer) override;
 	virtual uint64_t size() const override { return m_uncompressed_result_size; }
 	virtual uint64_t tellg() const override { return m_read_offset; }
-	virtual void skip(uint64_t to_skip) override { skip_by_reading(to_skip); }
+	virtual void skip(uint64_t to_skip) override;
 
 	protected:
 	void setup_input_buffer()
@@ -76,7 +82,12 @@ class zstd_decompression_reader : public io::sequential::reader
 	}
 
 	private:
+	void seek_to_frame_before(uint64_t offset);
+
 	std::unique_ptr<io::sequential::reader> m_reader;
+	std::optional<io::reader> m_compressed_reader;
+	std::optional<zstd_seek_table> m_seek_table;
+	bool m_seek_table_checked{false};
 	compression_dictionary m_compression_dictionary;
 
 	unique_zstd_dstream m_zstd_dstream{ZSTD_createDStream()};
@@ -0,0 +1,181 @@
+/**
+ * @file zstd_seek_table.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "zstd_seek_table.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <errors/user_exception.h>
+
+namespace archive_diff::io::compressed
+{
+// The table is a skippable frame:
+//   skippable frame magic, size of the rest of the frame
+//   an entry per frame: compressed size, uncompressed size, optional checksum
+//   footer: frame count, descriptor, seekable magic
+// All numbers are 32-bit little-endian.
+static const uint32_t c_skippable_frame_magic   = 0x184D2A5E;
+static const uint32_t c_seekable_magic          = 0x8F92EAB1;
+static const uint8_t c_checksum_flag            = 0x80;
+static const uint8_t c_reserved_descriptor_bits = 0x7C;
+static const size_t c_skippable_header_size     = 2 * sizeof(uint32_t);
+static const size_t c_footer_size               = 2 * sizeof(uint32_t) + sizeof(uint8_t);
+static const size_t c_entry_size                = 2 * sizeof(uint32_t);
+static const size_t c_entry_size_with_checksum  = 3 * sizeof(uint32_t);
+
+static void append_uint32_le(std::vector<char> &buffer, uint32_t value)
+{
+	for (size_t i = 0; i < sizeof(uint32_t); i++)
+	{
+		buffer.push_back(static_cast<char>(value >> (8 * i)));
+	}
+}
+
+static uint32_t read_uint32_le(const char *data)
+{
+	uint32_t value{};
+	for (size_t i = sizeof(uint32_t); i > 0; i--)
+	{
+		value = (value << 8) | static_cast<uint8_t>(data[i - 1]);
+	}
+	return value;
+}
+
+void zstd_seek_table::add_frame(uint64_t compressed_size, uint64_t uncompressed_size)
+{
+	const uint64_t c_max_size = std::numeric_limits<uint32_t>::max();
+	if ((compressed_size > c_max_size) || (uncompressed_size > c_max_size))
+	{
+		std::string msg = "zstd_seek_table::add_frame: Frame too large. compressed_size: "
+		                + std::to_string(compressed_size)
+		                + ", uncompressed_size: " + std::to_string(uncompressed_size);
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	frame new_frame;
+	new_frame.m_compressed_offset   = m_compressed_size;
+	new_frame.m_uncompressed_offset = m_uncompressed_size;
+	new_frame.m_compressed_size     = static_cast<uint32_t>(compressed_size);
+	new_frame.m_uncompressed_size   = static_cast<uint32_t>(uncompressed_size);
+	m_frames.push_back(new_frame);
+
+	m_compressed_size += compressed_size;
+	m_uncompressed_size += uncompressed_size;
+}
+
+size_t zstd_seek_table::find_frame(uint64_t uncompressed_offset) const
+{
+	if (uncompressed_offset >= m_uncompressed_size)
+	{
+		return m_frames.size();
+	}
+
+	// The last frame starting at or before the offset. Empty frames are never the answer,
+	// as the next frame starts at the same offset.
+	auto next = std::upper_bound(
+		m_frames.cbegin(),
+		m_frames.cend(),
+		uncompressed_offset,
+		[](uint64_t offset, const frame &entry) { return offset < entry.m_uncompressed_offset; });
+
+	return static_cast<size_t>(std::distance(m_frames.cbegin(), next)) - 1;
+}
+
+void zstd_seek_table::write(io::sequential::writer &writer) const
+{
+	if (m_frames.size() > std::numeric_limits<uint32_t>::max())
+	{
+		std::string msg = "zstd_seek_table::write: Too many frames: " + std::to_string(m_frames.size());
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	auto frame_size = m_frames.size() * c_entry_size + c_footer_size;
+
+	std::vector<char> buffer;
+	buffer.reserve(c_skippable_header_size + frame_size);
+
+	append_uint32_le(buffer, c_skippable_frame_magic);
+	append_uint32_le(buffer, static_cast<uint32_t>(frame_size));
+
+	for (const auto &entry : m_frames)
+	{
+		append_uint32_le(buffer, entry.m_compressed_size);
+		append_uint32_le(buffer, entry.m_uncompressed_size);
+	}
+
+	append_uint32_le(buffer, static_cast<uint32_t>(m_frames.size()));
+	buffer.push_back(0);
+	append_uint32_le(buffer, c_seekable_magic);
+
+	writer.write(std::string_view{buffer.data(), buffer.size()});
+}
+
+bool zstd_seek_table::try_read(const io::reader &reader, zstd_seek_table *table)
+{
+	auto size = reader.size();
+	if (size < c_skippable_header_size + c_footer_size)
+	{
+		return false;
+	}
+
+	char footer[c_footer_size];
+	reader.read(size - c_footer_size, std::span<char>{footer, sizeof(footer)});
+
+	if (read_uint32_le(footer + sizeof(uint32_t) + sizeof(uint8_t)) != c_seekable_magic)
+	{
+		return false;
+	}
+
+	auto frame_count = read_uint32_le(footer);
+	auto descriptor  = static_cast<uint8_t>(footer[sizeof(uint32_t)]);
+
+	if (descriptor & c_reserved_descriptor_bits)
+	{
+		std::string msg = "zstd_seek_table::try_read: Reserved descriptor bits set: " + std::to_string(descriptor);
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	auto entry_size   = (descriptor & c_checksum_flag) ? c_entry_size_with_checksum : c_entry_size;
+	auto entries_size = static_cast<uint64_t>(frame_count) * entry_size;
+	auto table_size   = c_skippable_header_size + entries_size + c_footer_size;
+
+	if (table_size > size)
+	{
+		std::string msg = "zstd_seek_table::try_read: Seek table of " + std::to_string(frame_count)
+		                + " frames is larger than the content: " + std::to_string(size);
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	std::vector<char> table_data(static_cast<size_t>(c_skippable_header_size + entries_size));
+	reader.read(size - table_size, std::span<char>{table_data.data(), table_data.size()});
+
+	if ((read_uint32_le(table_data.data()) != c_skippable_frame_magic)
+	    || (read_uint32_le(table_data.data() + sizeof(uint32_t)) != entries_size + c_footer_size))
+	{
+		std::string msg = "zstd_seek_table::try_read: Seek table isn't a valid skippable frame.";
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	zstd_seek_table result;
+	const char *entries = table_data.data() + c_skippable_header_size;
+	for (uint32_t i = 0; i < frame_count; i++)
+	{
+		auto entry = entries + i * entry_size;
+		result.add_frame(read_uint32_le(entry), read_uint32_le(entry + sizeof(uint32_t)));
+	}
+
+	if (result.m_compressed_size != size - table_size)
+	{
+		std::string msg = "zstd_seek_table::try_read: Frames hold " + std::to_string(result.m_compressed_size)
+		                + " bytes, but " + std::to_string(size - table_size) + " bytes precede the seek table.";
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	*table = std::move(result);
+	return true;
+}
+} // namespace archive_diff::io::compressed
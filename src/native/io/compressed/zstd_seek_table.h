@@ -0,0 +1,51 @@
+/**
+ * @file zstd_seek_table.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <vector>
+
+#include <io/reader.h>
+#include <io/sequential/writer.h>
+
+namespace archive_diff::io::compressed
+{
+// Seek table of the zstd seekable format. The content is a series of independent frames
+// followed by a skippable frame listing the compressed and uncompressed size of each, so
+// any frame can be decompressed on its own. Decoders that don't know the format skip the
+// table, so the content is still plain zstd.
+class zstd_seek_table
+{
+	public:
+	struct frame
+	{
+		uint64_t m_compressed_offset{};
+		uint64_t m_uncompressed_offset{};
+		uint32_t m_compressed_size{};
+		uint32_t m_uncompressed_size{};
+	};
+
+	void add_frame(uint64_t compressed_size, uint64_t uncompressed_size);
+
+	const std::vector<frame> &get_frames() const { return m_frames; }
+	uint64_t get_compressed_size() const { return m_compressed_size; }
+	uint64_t get_uncompressed_size() const { return m_uncompressed_size; }
+
+	// Index of the frame holding the offset, or the frame count if the offset is past the end.
+	size_t find_frame(uint64_t uncompressed_offset) const;
+
+	void write(io::sequential::writer &writer) const;
+
+	// Returns false if the content doesn't end with a seek table, and throws if it ends
+	// with one that doesn't describe the content.
+	static bool try_read(const io::reader &reader, zstd_seek_table *table);
+
+	private:
+	std::vector<frame> m_frames;
+	uint64_t m_compressed_size{};
+	uint64_t m_uncompressed_size{};
+};
+} // namespace archive_diff::io::compressed
@@ -0,0 +1,107 @@
+/**
+ * @file zstd_seekable_io_device.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "zstd_seekable_io_device.h"
+
+#include <cstring>
+
+namespace archive_diff::io::compressed
+{
+zstd_seekable_io_device::zstd_seekable_io_device(const io::reader &compressed, zstd_seek_table &&seek_table) :
+	m_compressed(compressed), m_seek_table(std::move(seek_table))
+{
+	ZSTD_DCtx_setParameter(m_dctx.get(), ZSTD_d_windowLogMax, c_zstd_window_log_max);
+}
+
+bool zstd_seekable_io_device::try_make_reader(const io::reader &compressed, io::reader *result)
+{
+	zstd_seek_table seek_table;
+	if (!zstd_seek_table::try_read(compressed, &seek_table))
+	{
+		return false;
+	}
+
+	std::shared_ptr<io::io_device> device =
+		std::make_shared<zstd_seekable_io_device>(compressed, std::move(seek_table));
+	*result = io::reader{device};
+	return true;
+}
+
+size_t zstd_seekable_io_device::read_some(uint64_t offset, std::span<char> buffer)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	size_t total_read = 0;
+	while (total_read < buffer.size())
+	{
+		auto frame_index = m_seek_table.find_frame(offset + total_read);
+		if (frame_index == m_seek_table.get_frames().size())
+		{
+			break;
+		}
+
+		load_frame(frame_index);
+
+		auto &frame          = m_seek_table.get_frames()[frame_index];
+		auto offset_in_frame = static_cast<size_t>(offset + total_read - frame.m_uncompressed_offset);
+		auto available       = m_uncompressed_frame.size() - offset_in_frame;
+		auto to_copy         = std::min(available, buffer.size() - total_read);
+
+		std::memcpy(buffer.data() + total_read, m_uncompressed_frame.data() + offset_in_frame, to_copy);
+		total_read += to_copy;
+	}
+
+	return total_read;
+}
+
+void zstd_seekable_io_device::load_frame(size_t frame_index)
+{
+	if (m_frame_loaded && (m_loaded_frame == frame_index))
+	{
+		return;
+	}
+
+	auto &frame = m_seek_table.get_frames()[frame_index];
+
+	// Decompress straight from the compressed data where it can be lent out.
+	auto compressed_data = m_compressed.borrow(frame.m_compressed_offset, frame.m_compressed_size);
+	if (!compressed_data.has_value())
+	{
+		m_compressed_frame.resize(frame.m_compressed_size);
+		m_compressed.read(
+			frame.m_compressed_offset, std::span<char>{m_compressed_frame.data(), m_compressed_frame.size()});
+		compressed_data = std::span<const char>{m_compressed_frame.data(), m_compressed_frame.size()};
+	}
+
+	m_frame_loaded = false;
+	m_uncompressed_frame.resize(frame.m_uncompressed_size);
+
+	auto ret = ZSTD_decompressDCtx(
+		m_dctx.get(),
+		m_uncompressed_frame.data(),
+		m_uncompressed_frame.size(),
+		compressed_data->data(),
+		compressed_data->size());
+
+	if (ZSTD_isError(ret))
+	{
+		auto error_name = ZSTD_getErrorName(ret);
+		std::string msg = "ZSTD_decompressDCtx() failed. frame: " + std::to_string(frame_index)
+		                + std::string(" error_name: ") + error_name;
+		throw errors::user_exception(errors::error_code::io_zstd_decompress_stream_failed, msg);
+	}
+
+	if (ret != frame.m_uncompressed_size)
+	{
+		std::string msg = "zstd_seekable_io_device: frame " + std::to_string(frame_index) + " decompressed to "
+		                + std::to_string(ret) + " bytes, expected " + std::to_string(frame.m_uncompressed_size);
+		throw errors::user_exception(errors::error_code::io_zstd_seek_table_invalid, msg);
+	}
+
+	m_loaded_frame = frame_index;
+	m_frame_loaded = true;
+}
+} // namespace archive_diff::io::compressed
@@ -0,0 +1,49 @@
+/**
+ * @file zstd_seekable_io_device.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <zstd.h>
+
+#include <io/io_device.h>
+#include <io/reader.h>
+
+#include "zstd_seek_table.h"
+#include "zstd_wrappers.h"
+
+namespace archive_diff::io::compressed
+{
+// Random access to the uncompressed content of zstd seekable data. A read decompresses
+// only the frames it covers; the last frame decompressed is kept, as reads tend to be
+// sequential within a frame.
+class zstd_seekable_io_device : public io::io_device
+{
+	public:
+	zstd_seekable_io_device(const io::reader &compressed, zstd_seek_table &&seek_table);
+
+	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
+	virtual uint64_t size() const override { return m_seek_table.get_uncompressed_size(); }
+
+	// Returns false, leaving result alone, if the content doesn't end with a seek table.
+	static bool try_make_reader(const io::reader &compressed, io::reader *result);
+
+	private:
+	void load_frame(size_t frame_index);
+
+	io::reader m_compressed;
+	zstd_seek_table m_seek_table;
+
+	std::mutex m_mutex;
+	unique_zstd_dctx m_dctx{ZSTD_createDCtx()};
+	size_t m_loaded_frame{};
+	bool m_frame_loaded{false};
+	std::vector<char> m_compressed_frame;
+	std::vector<char> m_uncompressed_frame;
+};
+} // namespace archive_diff::io::compressed
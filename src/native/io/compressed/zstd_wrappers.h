@@ -26,6 +26,13 @@ struct ZSTD_DStreamDeleter
 
 using unique_zstd_dstream = std::unique_ptr<ZSTD_DStream, ZSTD_DStreamDeleter>;
 
+struct ZSTD_DCtxDeleter
+{
+	void operator()(ZSTD_DCtx *obj) { ZSTD_freeDCtx(obj); }
+};
+
+using unique_zstd_dctx = std::unique_ptr<ZSTD_DCtx, ZSTD_DCtxDeleter>;
+
 int windowLog_from_target_size(uintmax_t target_size);
 
 const int c_zstd_window_log_max = 28; /* sets limit to 1 << 28 or around 268 MB */
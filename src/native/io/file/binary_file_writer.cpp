@@ -6,17 +6,121 @@
  */
 #include "binary_file_writer.h"
 
+#include <algorithm>
+#include <string>
+
+#include <io/all_zeros_io_device.h>
+#include <io/zero_detection.h>
+
 #include "user_exception.h"
 
 namespace archive_diff::io::file
 {
-binary_file_writer::binary_file_writer(const std::string &path) :
+binary_file_writer::binary_file_writer(const std::string &path, bool allow_sparse) :
 	m_File(path, file::mode::write, errors::error_code::io_binary_file_writer_failed_open)
-{}
+{
+	m_sparse = allow_sparse && m_File.supports_holes();
+}
+
+binary_file_writer::~binary_file_writer()
+{
+	// Nothing can be reported from here; flush() should be used to find out about failures.
+	extend_over_trailing_hole();
+}
+
+void binary_file_writer::flush()
+{
+	if (!extend_over_trailing_hole())
+	{
+		std::string msg = "Failed to extend file to " + std::to_string(m_size) + " bytes.";
+		throw errors::user_exception(errors::error_code::io_binary_file_writer_set_size_failed, msg);
+	}
+
+	m_File.flush();
+}
+
+void binary_file_writer::write(uint64_t offset, std::string_view buffer)
+{
+	if (m_sparse && (buffer.size() >= c_min_hole_size) && is_all_zeros(buffer))
+	{
+		write_zeros(offset, buffer.size());
+		return;
+	}
+
+	m_File.write(offset, buffer);
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	m_data_end = std::max(m_data_end, offset + buffer.size());
+	m_size     = std::max(m_size, m_data_end);
+}
 
-void binary_file_writer::flush() { m_File.flush(); }
+void binary_file_writer::write_zeros(uint64_t offset, uint64_t length)
+{
+	if (!m_sparse)
+	{
+		write_dense_zeros(offset, length);
+		return;
+	}
+
+	uint64_t data_end;
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		data_end = m_data_end;
+		m_size   = std::max(m_size, offset + length);
+	}
+
+	// Anything past the stored data reads back as zeros once the file is extended.
+	if (offset >= data_end)
+	{
+		return;
+	}
+
+	auto overlap = std::min(offset + length, data_end) - offset;
+	if ((overlap < c_min_hole_size) || !m_File.punch_hole(offset, overlap))
+	{
+		write_dense_zeros(offset, overlap);
+	}
+}
+
+uint64_t binary_file_writer::size() const
+{
+	auto file_size = m_File.size();
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return std::max(file_size, m_size);
+}
+
+void binary_file_writer::write_dense_zeros(uint64_t offset, uint64_t length)
+{
+	auto zeros = io::all_zeros_io_device::make_reader(length);
+	zeros.for_each_block(
+		0,
+		length,
+		[&](std::string_view block)
+		{
+			m_File.write(offset, block);
+			offset += block.size();
+		});
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	m_data_end = std::max(m_data_end, offset);
+	m_size     = std::max(m_size, m_data_end);
+}
+
+bool binary_file_writer::extend_over_trailing_hole()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (m_size <= m_data_end)
+	{
+		return true;
+	}
 
-void binary_file_writer::write(uint64_t offset, std::string_view buffer) { m_File.write(offset, buffer); }
+	if (!m_File.set_size(m_size))
+	{
+		return false;
+	}
 
-uint64_t binary_file_writer::size() const { return m_File.size(); }
-} // namespace archive_diff::io::file
\ No newline at end of file
+	m_data_end = m_size;
+	return true;
+}
+} // namespace archive_diff::io::file
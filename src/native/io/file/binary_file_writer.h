@@ -6,23 +6,46 @@
  */
 #pragma once
 
+#include <mutex>
+
 #include <io/writer.h>
 #include "file.h"
 
 namespace archive_diff::io::file
 {
+// When the file supports holes, zero-filled ranges aren't stored: ranges past the data
+// written so far are left as holes and the file is extended over them on flush() or
+// destruction, and ranges over written data are punched out. This applies to write_zeros()
+// and to written blocks found to be all zeros. Pass allow_sparse as false to have every
+// byte written, for targets such as raw block devices that must be overwritten in full.
 class binary_file_writer : public writer
 {
 	public:
-	binary_file_writer(const std::string &path);
+	binary_file_writer(const std::string &path) : binary_file_writer(path, true) {}
+	binary_file_writer(const std::string &path, bool allow_sparse);
 
 	virtual void flush() override;
 	virtual void write(uint64_t offset, std::string_view buffer) override;
+	virtual void write_zeros(uint64_t offset, uint64_t length) override;
 	virtual uint64_t size() const override;
 
-	virtual ~binary_file_writer() = default;
+	bool is_sparse() const { return m_sparse; }
+
+	virtual ~binary_file_writer();
 
 	private:
+	// Shorter zero runs are written as data; a hole can't be smaller than a filesystem block.
+	static constexpr uint64_t c_min_hole_size = 4096;
+
+	void write_dense_zeros(uint64_t offset, uint64_t length);
+	bool extend_over_trailing_hole();
+
 	mutable file m_File;
+	bool m_sparse{};
+
+	// m_data_end is the end of the data actually stored, m_size also counts trailing holes.
+	mutable std::mutex m_mutex;
+	uint64_t m_data_end{};
+	uint64_t m_size{};
 };
-} // namespace archive_diff::io::file
\ No newline at end of file
+} // namespace archive_diff::io::file
@@ -8,6 +8,18 @@
 
 #include "user_exception.h"
 
+#ifdef WIN32
+	#include <io.h>
+#else
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+
+// Targets past 2 GiB are truncated or have holes punched in the wrong place unless
+// ftruncate() and fallocate() take 64-bit offsets; see _FILE_OFFSET_BITS.
+static_assert(sizeof(off_t) == sizeof(uint64_t), "off_t must be 64 bits");
+#endif
+
 namespace archive_diff::io::file
 {
 file::file(const std::string &file, mode mode, errors::error_code error) : m_path(file)
@@ -85,6 +97,44 @@ void file::write(uint64_t offset, std::string_view buffer)
 
 void file::flush() { fflush(m_fp); }
 
+bool file::supports_holes()
+{
+#ifdef WIN32
+	return false;
+#else
+	struct stat st;
+	if (fstat(fileno(m_fp), &st) != 0)
+	{
+		return false;
+	}
+	return S_ISREG(st.st_mode);
+#endif
+}
+
+bool file::punch_hole([[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t length)
+{
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+	std::lock_guard<std::mutex> guard(m_mutex);
+	fflush(m_fp);
+	auto mode   = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+	auto result = fallocate(fileno(m_fp), mode, static_cast<off_t>(offset), static_cast<off_t>(length));
+	return result == 0;
+#else
+	return false;
+#endif
+}
+
+bool file::set_size(uint64_t size)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	fflush(m_fp);
+#ifdef WIN32
+	return _chsize_s(_fileno(m_fp), static_cast<__int64>(size)) == 0;
+#else
+	return ftruncate(fileno(m_fp), static_cast<off_t>(size)) == 0;
+#endif
+}
+
 size_t file::read_some(uint64_t offset, std::span<char> buffer)
 {
 	std::lock_guard<std::mutex> guard(m_mutex);
@@ -34,6 +34,17 @@ class file
 	uint64_t size();
 	void write(uint64_t offset, std::string_view buffer);
 	void flush();
+
+	// Whether unwritten ranges can be left as holes: true for regular files, false for block
+	// and character devices, pipes and on Windows. Whether the filesystem can actually make
+	// a hole is only known once punch_hole() is tried.
+	bool supports_holes();
+	// Flushes, then deallocates the range so it reads back as zeros. Returns false if the
+	// filesystem can't do that, in which case the range is unchanged.
+	bool punch_hole(uint64_t offset, uint64_t length);
+	// Flushes, then extends or truncates the file to size. Returns false on failure.
+	bool set_size(uint64_t size);
+
 	void close()
 	{
 		fclose(m_fp);
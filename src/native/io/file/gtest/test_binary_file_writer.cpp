@@ -121,3 +121,144 @@ TEST(binary_file_writer, write_file_and_verify)
 
 	ASSERT_TRUE(archive_diff::test_utility::files_are_equal(data_file_from_writer.string(), data_file_path));
 }
+
+#ifndef WIN32
+static uint64_t get_allocated_bytes(const fs::path &path)
+{
+	struct stat st;
+	if (stat(path.string().c_str(), &st) != 0)
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>(st.st_blocks) * 512;
+}
+
+static std::vector<char> read_whole_file(const fs::path &path)
+{
+	std::ifstream file_stream(path, std::ios::binary | std::ios::in);
+	return std::vector<char>{std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>()};
+}
+
+// Data, then zeros found when written, data, zeros from write_zeros() and a trailing hole.
+static std::vector<char> write_sparse_test_file(const fs::path &path, bool allow_sparse)
+{
+	const size_t c_run_size = 4 * 1024 * 1024;
+
+	std::vector<char> data(c_run_size);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = static_cast<char>((i % 251) + 1);
+	}
+	std::vector<char> zeros(c_run_size);
+
+	std::vector<char> expected;
+	expected.insert(expected.end(), data.begin(), data.end());
+	expected.insert(expected.end(), zeros.begin(), zeros.end());
+	expected.insert(expected.end(), data.begin(), data.end());
+	expected.resize(expected.size() + 2 * c_run_size);
+
+	archive_diff::io::file::binary_file_writer writer(path.string(), allow_sparse);
+
+	uint64_t offset = 0;
+	writer.write(offset, std::string_view{data.data(), data.size()});
+	offset += data.size();
+	writer.write(offset, std::string_view{zeros.data(), zeros.size()});
+	offset += zeros.size();
+	writer.write(offset, std::string_view{data.data(), data.size()});
+	offset += data.size();
+	writer.write_zeros(offset, 2 * c_run_size);
+
+	EXPECT_EQ(expected.size(), writer.size());
+	writer.flush();
+
+	return expected;
+}
+
+TEST(binary_file_writer, sparse_zero_runs)
+{
+	auto test_temp_path = fs::temp_directory_path() / "binary_file_writer" / "sparse_zero_runs";
+	fs::remove_all(test_temp_path);
+	fs::create_directories(test_temp_path);
+
+	auto sparse_path = test_temp_path / "sparse.bin";
+	auto expected    = write_sparse_test_file(sparse_path, true);
+
+	ASSERT_EQ(expected.size(), fs::file_size(sparse_path));
+	ASSERT_EQ(expected, read_whole_file(sparse_path));
+
+	// Only the two data runs need to be stored.
+	ASSERT_LT(get_allocated_bytes(sparse_path), expected.size() / 2);
+
+	auto dense_path = test_temp_path / "dense.bin";
+	ASSERT_EQ(expected, write_sparse_test_file(dense_path, false));
+
+	ASSERT_EQ(expected, read_whole_file(dense_path));
+	ASSERT_GE(get_allocated_bytes(dense_path), expected.size());
+}
+
+TEST(binary_file_writer, zeros_over_written_data)
+{
+	auto test_temp_path = fs::temp_directory_path() / "binary_file_writer" / "zeros_over_written_data";
+	fs::remove_all(test_temp_path);
+	fs::create_directories(test_temp_path);
+
+	auto path = test_temp_path / "overwritten.bin";
+
+	std::vector<char> expected(1024 * 1024, 'a');
+	{
+		archive_diff::io::file::binary_file_writer writer(path.string());
+		writer.write(0, std::string_view{expected.data(), expected.size()});
+
+		// Large enough for a hole to be punched, and too small for one.
+		writer.write_zeros(64 * 1024, 512 * 1024);
+		writer.write_zeros(10, 100);
+		std::fill(expected.begin() + 64 * 1024, expected.begin() + 576 * 1024, 0);
+		std::fill(expected.begin() + 10, expected.begin() + 110, 0);
+
+		writer.flush();
+	}
+
+	ASSERT_EQ(expected, read_whole_file(path));
+}
+
+TEST(binary_file_writer, zero_runs_past_4_gib)
+{
+	auto test_temp_path = fs::temp_directory_path() / "binary_file_writer" / "zero_runs_past_4_gib";
+	fs::remove_all(test_temp_path);
+	fs::create_directories(test_temp_path);
+
+	auto path = test_temp_path / "large.bin";
+
+	// Holes are punched and the file is extended at offsets that don't fit in 32 bits.
+	const uint64_t c_data_offset = 4ull << 30;
+	const size_t c_run_size      = 1024 * 1024;
+
+	std::vector<char> expected(c_run_size, 'a');
+	{
+		archive_diff::io::file::binary_file_writer writer(path.string());
+		writer.write(c_data_offset, std::string_view{expected.data(), expected.size()});
+		writer.write_zeros(c_data_offset + 64 * 1024, 512 * 1024);
+		writer.write_zeros(c_data_offset + c_run_size, c_run_size);
+		writer.flush();
+	}
+	std::fill(expected.begin() + 64 * 1024, expected.begin() + 576 * 1024, 0);
+	expected.resize(2 * c_run_size);
+
+	ASSERT_EQ(c_data_offset + expected.size(), fs::file_size(path));
+	ASSERT_LT(get_allocated_bytes(path), expected.size());
+
+	std::ifstream file_stream(path, std::ios::binary | std::ios::in);
+	file_stream.seekg(static_cast<std::streamoff>(c_data_offset));
+	std::vector<char> actual(expected.size());
+	file_stream.read(actual.data(), static_cast<std::streamsize>(actual.size()));
+	ASSERT_EQ(expected, actual);
+
+	fs::remove_all(test_temp_path);
+}
+
+TEST(binary_file_writer, character_device_is_dense)
+{
+	archive_diff::io::file::binary_file_writer writer("/dev/null");
+	ASSERT_FALSE(writer.is_sparse());
+}
+#endif
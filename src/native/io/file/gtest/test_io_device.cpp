@@ -9,10 +9,14 @@
 #include <test_utility/random_data_file.h>
 
 #include <io/reader.h>
+#include <io/file/binary_file_writer.h>
 #include <io/file/io_device.h>
 
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <thread>
 
 #include <language_support/include_filesystem.h>
 
@@ -180,3 +184,206 @@ TEST(io_device, more_slice_tests)
 	auto whole_file_slice = reader.slice(0, file_size);
 	compare_reader_and_file(whole_file_slice, data_file_path, 0, file_size);
 }
+
+const archive_diff::io::file::io_device::backend c_all_backends[] = {
+	archive_diff::io::file::io_device::backend::standard,
+	archive_diff::io::file::io_device::backend::pread,
+	archive_diff::io::file::io_device::backend::mmap,
+};
+
+TEST(io_device, open_and_verify_each_backend)
+{
+	auto test_temp_path = fs::temp_directory_path() / "io_device" / "open_and_verify_each_backend";
+	auto data_file_path = test_temp_path / "data_file.bin";
+
+	fs::create_directories(test_temp_path);
+	std::srand(0);
+	archive_diff::test_utility::create_random_data_file(data_file_path.string(), 100000);
+
+	auto file_size = fs::file_size(data_file_path);
+
+	for (auto backend : c_all_backends)
+	{
+		auto reader = archive_diff::io::file::io_device::make_reader(data_file_path.string(), backend);
+		ASSERT_EQ(file_size, reader.size());
+		compare_reader_and_file(reader, data_file_path, 0, file_size);
+
+		auto slice = reader.slice(3000, 50000);
+		compare_reader_and_file(slice, data_file_path, 3000, 50000);
+
+		// reads past the end return what is available
+		std::vector<char> buffer(100);
+		ASSERT_EQ(10, reader.read_some(file_size - 10, buffer));
+		ASSERT_EQ(0, reader.read_some(file_size, buffer));
+	}
+}
+
+TEST(io_device, open_missing_each_backend)
+{
+	for (auto backend : c_all_backends)
+	{
+		auto error = archive_diff::errors::error_code::none;
+
+		try
+		{
+			auto reader = archive_diff::io::file::io_device::make_reader("this_path_does_not_exist_I_hope", backend);
+		}
+		catch (archive_diff::errors::user_exception &e)
+		{
+			error = e.get_error();
+		}
+
+		ASSERT_EQ(archive_diff::errors::error_code::io_binary_file_reader_failed_open, error);
+	}
+}
+
+TEST(io_device, empty_file_each_backend)
+{
+	auto test_temp_path = fs::temp_directory_path() / "io_device" / "empty_file_each_backend";
+	auto data_file_path = test_temp_path / "empty_file.bin";
+
+	fs::create_directories(test_temp_path);
+	std::ofstream{data_file_path, std::ios::binary | std::ios::trunc};
+
+	for (auto backend : c_all_backends)
+	{
+		auto reader = archive_diff::io::file::io_device::make_reader(data_file_path.string(), backend);
+		ASSERT_EQ(0, reader.size());
+
+		std::vector<char> buffer(100);
+		ASSERT_EQ(0, reader.read_some(0, buffer));
+	}
+}
+
+TEST(io_device, concurrent_reads_each_backend)
+{
+	auto test_temp_path = fs::temp_directory_path() / "io_device" / "concurrent_reads_each_backend";
+	auto data_file_path = test_temp_path / "data_file.bin";
+
+	fs::create_directories(test_temp_path);
+	std::srand(0);
+	archive_diff::test_utility::create_random_data_file(data_file_path.string(), 1024 * 1024);
+
+	auto file_size = fs::file_size(data_file_path);
+
+	for (auto backend : c_all_backends)
+	{
+		auto reader = archive_diff::io::file::io_device::make_reader(data_file_path.string(), backend);
+
+		std::vector<std::thread> threads;
+		std::atomic<bool> all_equal{true};
+
+		for (uint64_t i = 0; i < 8; i++)
+		{
+			threads.emplace_back([&, i]() {
+				auto length = file_size / 8;
+				auto slice  = reader.slice(i * length, length);
+				if (!archive_diff::test_utility::reader_and_file_are_equal(
+						slice, data_file_path, i * length, length, 4096))
+				{
+					all_equal = false;
+				}
+			});
+		}
+
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		ASSERT_TRUE(all_equal);
+	}
+}
+
+TEST(io_device, borrow_each_backend)
+{
+	auto test_temp_path = fs::temp_directory_path() / "io_device" / "borrow_each_backend";
+	auto data_file_path = test_temp_path / "data_file.bin";
+
+	fs::create_directories(test_temp_path);
+	std::srand(0);
+	archive_diff::test_utility::create_random_data_file(data_file_path.string(), 100000);
+
+	auto file_size = fs::file_size(data_file_path);
+
+	for (auto backend : c_all_backends)
+	{
+		auto reader = archive_diff::io::file::io_device::make_reader(data_file_path.string(), backend);
+
+		std::vector<char> expected;
+		reader.read_all(expected);
+
+		// Only the mapped file has memory to lend.
+		auto borrowed = reader.borrow(0, file_size);
+		ASSERT_EQ(backend == archive_diff::io::file::io_device::backend::mmap, borrowed.has_value());
+		if (borrowed.has_value())
+		{
+			ASSERT_EQ(0, std::memcmp(expected.data(), borrowed->data(), expected.size()));
+		}
+
+		std::vector<char> collected;
+		reader.slice(3000, 50000).for_each_block(
+			0, 50000, [&](std::string_view block) { collected.insert(collected.end(), block.begin(), block.end()); });
+		ASSERT_EQ(50000, collected.size());
+		ASSERT_EQ(0, std::memcmp(expected.data() + 3000, collected.data(), collected.size()));
+	}
+}
+
+#ifndef WIN32
+TEST(io_device, read_past_4_gib_in_sparse_file)
+{
+	auto test_temp_path = fs::temp_directory_path() / "io_device" / "read_past_4_gib_in_sparse_file";
+	auto data_file_path = test_temp_path / "sparse_file.bin";
+
+	fs::remove_all(test_temp_path);
+	fs::create_directories(test_temp_path);
+
+	// Offsets that don't fit in 32 bits, signed or not; only the written blocks are stored.
+	const uint64_t c_data_offset = (4ull << 30) + 100;
+	const std::string c_start    = "start of file";
+	const std::string c_data     = "data past 4 GiB";
+	const uint64_t c_file_size   = c_data_offset + c_data.size();
+
+	{
+		archive_diff::io::file::binary_file_writer writer(data_file_path.string());
+		writer.write(0, c_start);
+		writer.write(c_data_offset, c_data);
+		writer.flush();
+	}
+
+	ASSERT_EQ(c_file_size, fs::file_size(data_file_path));
+
+	for (auto backend : c_all_backends)
+	{
+		// A file this size can't be mapped into a 32-bit address space.
+		if ((backend == archive_diff::io::file::io_device::backend::mmap) && (sizeof(size_t) < sizeof(uint64_t)))
+		{
+			continue;
+		}
+
+		auto reader = archive_diff::io::file::io_device::make_reader(data_file_path.string(), backend);
+		ASSERT_EQ(c_file_size, reader.size());
+
+		// Hints past 4 GiB are passed on without being cut down to 32 bits; they never change what's read.
+		reader.hint(c_data_offset - 1, c_data.size() + 1, archive_diff::io::access_hint::will_need);
+
+		std::string buffer(c_data.size() + 10, 'x');
+		auto read = reader.read_some(c_data_offset - 1, std::span<char>{buffer.data(), buffer.size()});
+		ASSERT_EQ(c_data.size() + 1, read);
+		ASSERT_EQ(std::string(1, '\0') + c_data, buffer.substr(0, c_data.size() + 1));
+
+		std::string start(c_start.size(), 'x');
+		ASSERT_EQ(start.size(), reader.read_some(0, std::span<char>{start.data(), start.size()}));
+		ASSERT_EQ(c_start, start);
+
+		reader.hint(c_data_offset - 1, c_data.size() + 1, archive_diff::io::access_hint::dont_need);
+
+		auto slice = reader.slice(c_data_offset, c_data.size());
+		std::vector<char> sliced;
+		slice.read_all(sliced);
+		ASSERT_EQ(c_data, std::string(sliced.begin(), sliced.end()));
+	}
+
+	fs::remove_all(test_temp_path);
+}
+#endif
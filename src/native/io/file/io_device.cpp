@@ -7,6 +7,11 @@
 
 #include "io_device.h"
 
+#ifndef WIN32
+	#include "pread_io_device.h"
+	#include "mmap_io_device.h"
+#endif
+
 #include <string>
 #include <iostream>
 
@@ -20,8 +25,20 @@ io_device::io_device(const std::string &path) :
 	m_File(path, file::mode::read, errors::error_code::io_binary_file_reader_failed_open)
 {}
 
-reader io_device::make_reader(const std::string &path)
+reader io_device::make_reader(const std::string &path, [[maybe_unused]] backend file_backend)
 {
+#ifndef WIN32
+	switch (file_backend)
+	{
+	case backend::pread:
+		return pread_io_device::make_reader(path);
+	case backend::mmap:
+		return mmap_io_device::make_reader(path);
+	case backend::standard:
+		break;
+	}
+#endif
+
 	std::shared_ptr<io::io_device> device = std::make_shared<io_device>(path);
 	return io::reader{device};
 }
@@ -21,7 +21,26 @@ class io_device : public io::io_device
 	io_device(const std::string &path);
 	virtual ~io_device() = default;
 
-	static reader make_reader(const std::string &path);
+	// How a file is read.
+	// standard - stdio with a lock around each seek and read
+	// pread - pread() on POSIX platforms; no lock or shared file position
+	// mmap - the whole file is mapped read-only on POSIX platforms
+	// On platforms without pread/mmap, those fall back to standard.
+	enum class backend
+	{
+		standard,
+		pread,
+		mmap,
+	};
+
+#ifdef WIN32
+	static constexpr backend c_default_backend = backend::standard;
+#else
+	static constexpr backend c_default_backend = backend::pread;
+#endif
+
+	static reader make_reader(const std::string &path) { return make_reader(path, c_default_backend); }
+	static reader make_reader(const std::string &path, backend file_backend);
 
 	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
 
@@ -0,0 +1,124 @@
+/**
+ * @file mmap_io_device.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include "mmap_io_device.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include "user_exception.h"
+#include "error_codes.h"
+
+namespace archive_diff::io::file
+{
+mmap_io_device::mmap_io_device(const std::string &path)
+{
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+	{
+		std::string msg = "Failed to open file: " + path + ". errno: " + std::to_string(errno);
+		throw errors::user_exception(errors::error_code::io_binary_file_reader_failed_open, msg);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		std::string msg = "Failed to stat file: " + path + ". errno: " + std::to_string(errno);
+		close(fd);
+		throw errors::user_exception(errors::error_code::io_binary_file_reader_failed_open, msg);
+	}
+
+	m_size = static_cast<uint64_t>(st.st_size);
+
+	if (m_size > std::numeric_limits<size_t>::max())
+	{
+		close(fd);
+		std::string msg = "File too large to map: " + path + ". Size: " + std::to_string(m_size);
+		throw errors::user_exception(errors::error_code::io_binary_file_reader_mmap_failed, msg);
+	}
+
+	// mmap() doesn't allow empty mappings; an empty file simply has no data.
+	if (m_size != 0)
+	{
+		auto mapping = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			std::string msg = "Failed to map file: " + path + ". errno: " + std::to_string(errno);
+			close(fd);
+			throw errors::user_exception(errors::error_code::io_binary_file_reader_mmap_failed, msg);
+		}
+
+		m_data = static_cast<const char *>(mapping);
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	close(fd);
+}
+
+mmap_io_device::~mmap_io_device()
+{
+	if (m_data != nullptr)
+	{
+		munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+	}
+}
+
+reader mmap_io_device::make_reader(const std::string &path)
+{
+	std::shared_ptr<io::io_device> device = std::make_shared<mmap_io_device>(path);
+	return io::reader{device};
+}
+
+size_t mmap_io_device::read_some(uint64_t offset, std::span<char> buffer)
+{
+	if (offset >= m_size)
+	{
+		return 0;
+	}
+
+	auto to_copy = static_cast<size_t>(std::min<uint64_t>(buffer.size(), m_size - offset));
+	std::memcpy(buffer.data(), m_data + offset, to_copy);
+
+	return to_copy;
+}
+
+std::optional<std::span<const char>> mmap_io_device::borrow_some(uint64_t offset, uint64_t length)
+{
+	if (offset >= m_size)
+	{
+		return std::span<const char>{};
+	}
+
+	auto to_borrow = static_cast<size_t>(std::min<uint64_t>(length, m_size - offset));
+	return std::span<const char>{m_data + offset, to_borrow};
+}
+
+void mmap_io_device::hint(uint64_t offset, uint64_t length, access_hint hint)
+{
+	if ((m_data == nullptr) || (offset >= m_size))
+	{
+		return;
+	}
+
+	// madvise() needs a page aligned address.
+	auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	auto start     = offset - (offset % page_size);
+	auto end       = std::min(m_size, offset + length);
+
+	int advice = (hint == access_hint::will_need) ? MADV_WILLNEED : MADV_DONTNEED;
+
+	// Only advice; the data is read the same way whether or not it is taken.
+	madvise(const_cast<char *>(m_data) + start, static_cast<size_t>(end - start), advice);
+}
+} // namespace archive_diff::io::file
@@ -0,0 +1,43 @@
+/**
+ * @file mmap_io_device.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+
+#include <io/io_device.h>
+#include <io/reader.h>
+
+#include <string>
+
+namespace archive_diff::io::file
+{
+// Maps a whole file read-only into memory. Reads are copies out of the
+// mapping with no system call and no lock, and borrow_some() lends the
+// mapping itself.
+class mmap_io_device : public io::io_device
+{
+	public:
+	mmap_io_device(const std::string &path);
+	virtual ~mmap_io_device();
+
+	static reader make_reader(const std::string &path);
+
+	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override;
+
+	// madvise() on the pages holding the range. Dropped pages are read from the file again
+	// if they are used, so spans lent by borrow_some() stay valid.
+	virtual void hint(uint64_t offset, uint64_t length, access_hint hint) override;
+
+	virtual uint64_t size() const override { return m_size; }
+
+	std::span<const char> data() const { return std::span<const char>{m_data, static_cast<size_t>(m_size)}; }
+
+	private:
+	const char *m_data{nullptr};
+	uint64_t m_size{0};
+};
+} // namespace archive_diff::io::file
@@ -0,0 +1,103 @@
+/**
+ * @file pread_io_device.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include "pread_io_device.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "user_exception.h"
+#include "error_codes.h"
+
+// Files past 2 GiB need pread() and fstat() to take 64-bit offsets; 32-bit targets get them
+// from _FILE_OFFSET_BITS=64, set in the top-level CMakeLists.txt.
+static_assert(sizeof(off_t) == sizeof(uint64_t), "off_t must be 64 bits");
+
+namespace archive_diff::io::file
+{
+pread_io_device::pread_io_device(const std::string &path) : m_path(path)
+{
+	m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_fd == -1)
+	{
+		std::string msg = "Failed to open file: " + path + ". errno: " + std::to_string(errno);
+		throw errors::user_exception(errors::error_code::io_binary_file_reader_failed_open, msg);
+	}
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0)
+	{
+		std::string msg = "Failed to stat file: " + path + ". errno: " + std::to_string(errno);
+		close(m_fd);
+		throw errors::user_exception(errors::error_code::io_binary_file_reader_failed_open, msg);
+	}
+
+	m_size = static_cast<uint64_t>(st.st_size);
+}
+
+pread_io_device::~pread_io_device()
+{
+	if (m_fd != -1)
+	{
+		close(m_fd);
+	}
+}
+
+reader pread_io_device::make_reader(const std::string &path)
+{
+	std::shared_ptr<io::io_device> device = std::make_shared<pread_io_device>(path);
+	return io::reader{device};
+}
+
+size_t pread_io_device::read_some(uint64_t offset, std::span<char> buffer)
+{
+	size_t total_read{0};
+
+	// pread() may return fewer bytes than requested before the end of the file,
+	// so keep going until we fill the buffer or reach the end.
+	while (total_read < buffer.size())
+	{
+		auto result = pread(
+			m_fd, buffer.data() + total_read, buffer.size() - total_read, static_cast<off_t>(offset + total_read));
+
+		if (result == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			std::string msg = "Failed to read file: " + m_path + ". errno: " + std::to_string(errno);
+			throw errors::user_exception(errors::error_code::io_binary_file_reader_read_failed, msg);
+		}
+
+		if (result == 0)
+		{
+			break;
+		}
+
+		total_read += static_cast<size_t>(result);
+	}
+
+	return total_read;
+}
+
+void pread_io_device::hint(
+	[[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t length, [[maybe_unused]] access_hint hint)
+{
+#ifdef POSIX_FADV_WILLNEED
+	int advice = (hint == access_hint::will_need) ? POSIX_FADV_WILLNEED : POSIX_FADV_DONTNEED;
+
+	// Only advice; the data is read the same way whether or not it is taken. off_t is 64 bits
+	// (see above), so this is posix_fadvise64() on 32-bit targets.
+	posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(length), advice);
+#endif
+}
+} // namespace archive_diff::io::file
@@ -0,0 +1,39 @@
+/**
+ * @file pread_io_device.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+
+#include <io/io_device.h>
+#include <io/reader.h>
+
+#include <string>
+
+namespace archive_diff::io::file
+{
+// Reads a file with pread(). There is no shared file position, so
+// concurrent readers of the same device don't need to serialize.
+class pread_io_device : public io::io_device
+{
+	public:
+	pread_io_device(const std::string &path);
+	virtual ~pread_io_device();
+
+	static reader make_reader(const std::string &path);
+
+	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
+
+	// posix_fadvise() on the range, so the page cache reads it ahead or drops it.
+	virtual void hint(uint64_t offset, uint64_t length, access_hint hint) override;
+
+	virtual uint64_t size() const override { return m_size; }
+
+	private:
+	std::string m_path;
+	int m_fd{-1};
+	uint64_t m_size{0};
+};
+} // namespace archive_diff::io::file
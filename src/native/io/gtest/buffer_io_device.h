@@ -7,6 +7,7 @@
 #pragma once
 
 #include <cstring>
+#include <vector>
 
 #include <io/io_device.h>
 #include <string_view>
@@ -35,7 +36,49 @@ class buffer_io_device : public io::io_device
 	}
 	virtual uint64_t size() const override { return m_buffer.size(); }
 
-	private:
+	protected:
 	std::string_view m_buffer;
 };
+
+// Same as buffer_io_device, but lends out its buffer instead of only copying.
+class lending_buffer_io_device : public buffer_io_device
+{
+	public:
+	lending_buffer_io_device(std::string_view buffer) : buffer_io_device(buffer) {}
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override
+	{
+		auto available = static_cast<uint64_t>(m_buffer.size());
+		if (offset > available)
+		{
+			return std::span<const char>{};
+		}
+		available -= offset;
+
+		auto to_borrow = static_cast<size_t>(std::min<uint64_t>(length, available));
+
+		return std::span<const char>{m_buffer.data() + offset, to_borrow};
+	}
+};
+
+// Same as buffer_io_device, but keeps every hint it's given.
+class hint_recording_buffer_io_device : public buffer_io_device
+{
+	public:
+	struct recorded_hint
+	{
+		uint64_t m_offset{};
+		uint64_t m_length{};
+		io::access_hint m_hint{};
+
+		bool operator==(const recorded_hint &) const = default;
+	};
+
+	hint_recording_buffer_io_device(std::string_view buffer) : buffer_io_device(buffer) {}
+	virtual void hint(uint64_t offset, uint64_t length, io::access_hint hint) override
+	{
+		m_hints.push_back(recorded_hint{offset, length, hint});
+	}
+
+	std::vector<recorded_hint> m_hints;
+};
 } // namespace archive_diff::io::test
\ No newline at end of file
@@ -0,0 +1,181 @@
+/**
+ * @file pipelined_writer_test.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+#include <test_utility/random_data_file.h>
+
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <errors/user_exception.h>
+#include <io/pipelined_writer.h>
+
+namespace
+{
+// Records the writes it receives, optionally failing once enough bytes have been written.
+class recording_writer : public archive_diff::io::writer
+{
+	public:
+	virtual void write(uint64_t offset, std::string_view buffer) override
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_write_count++;
+		m_writing_thread = std::this_thread::get_id();
+
+		if (m_fail_after && (m_bytes_written + buffer.size() > m_fail_after))
+		{
+			throw archive_diff::errors::user_exception(
+				archive_diff::errors::error_code::io_binary_file_writer_failed_open, "recording_writer: failing");
+		}
+
+		if (offset + buffer.size() > m_data.size())
+		{
+			m_data.resize(offset + buffer.size());
+		}
+		std::memcpy(m_data.data() + offset, buffer.data(), buffer.size());
+		m_bytes_written += buffer.size();
+	}
+
+	virtual void write_zeros(uint64_t offset, uint64_t length) override
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_zeros_count++;
+		if (offset + length > m_data.size())
+		{
+			m_data.resize(offset + length);
+		}
+		std::memset(m_data.data() + offset, 0, length);
+	}
+
+	virtual void flush() override { m_flush_count++; }
+
+	virtual uint64_t size() const override { return m_data.size(); }
+
+	std::mutex m_mutex;
+	std::vector<char> m_data;
+	size_t m_write_count{};
+	size_t m_zeros_count{};
+	size_t m_flush_count{};
+	size_t m_bytes_written{};
+	size_t m_fail_after{};
+	std::thread::id m_writing_thread;
+};
+} // namespace
+
+TEST(pipelined_writer, contiguous_writes)
+{
+	auto recorder                                   = std::make_shared<recording_writer>();
+	std::shared_ptr<archive_diff::io::writer> inner = recorder;
+
+	auto data = archive_diff::test_utility::create_random_data(100000, 0);
+
+	{
+		archive_diff::io::pipelined_writer writer(inner, 4096, 3);
+
+		size_t offset = 0;
+		size_t chunk  = 1;
+		while (offset < data.size())
+		{
+			auto to_write = std::min(chunk, data.size() - offset);
+			writer.write(offset, std::string_view{data.data() + offset, to_write});
+			offset += to_write;
+			chunk = (chunk * 13) % 9001 + 1;
+		}
+
+		ASSERT_EQ(data.size(), writer.size());
+		writer.flush();
+	}
+
+	ASSERT_EQ(data, recorder->m_data);
+	ASSERT_EQ(1, recorder->m_flush_count);
+
+	// Writes are gathered into whole buffers.
+	ASSERT_EQ((data.size() + 4095) / 4096, recorder->m_write_count);
+
+	// And written on a thread other than the caller's.
+	ASSERT_NE(std::this_thread::get_id(), recorder->m_writing_thread);
+}
+
+TEST(pipelined_writer, non_contiguous_writes)
+{
+	auto recorder                                   = std::make_shared<recording_writer>();
+	std::shared_ptr<archive_diff::io::writer> inner = recorder;
+
+	auto data = archive_diff::test_utility::create_random_data(10000, 0);
+
+	{
+		archive_diff::io::pipelined_writer writer(inner, 1024, 2);
+
+		// Write the second half first, then the first half.
+		writer.write(5000, std::string_view{data.data() + 5000, 5000});
+		writer.write(0, std::string_view{data.data(), 5000});
+
+		ASSERT_EQ(data.size(), writer.size());
+		writer.flush();
+	}
+
+	ASSERT_EQ(data, recorder->m_data);
+}
+
+TEST(pipelined_writer, failure_is_rethrown)
+{
+	auto recorder                                   = std::make_shared<recording_writer>();
+	std::shared_ptr<archive_diff::io::writer> inner = recorder;
+	recorder->m_fail_after                          = 3000;
+
+	auto data = archive_diff::test_utility::create_random_data(64 * 1024, 0);
+
+	archive_diff::io::pipelined_writer writer(inner, 1024, 2);
+
+	bool caught = false;
+	try
+	{
+		for (size_t offset = 0; offset < data.size(); offset += 100)
+		{
+			auto to_write = std::min<size_t>(100, data.size() - offset);
+			writer.write(offset, std::string_view{data.data() + offset, to_write});
+		}
+		writer.flush();
+	}
+	catch (archive_diff::errors::user_exception &e)
+	{
+		caught = true;
+		ASSERT_EQ(archive_diff::errors::error_code::io_binary_file_writer_failed_open, e.get_error());
+	}
+
+	ASSERT_TRUE(caught);
+	ASSERT_EQ(0, recorder->m_flush_count);
+	ASSERT_LE(recorder->m_bytes_written, 3000);
+}
+
+TEST(pipelined_writer, zeros_pass_through)
+{
+	auto recorder                                   = std::make_shared<recording_writer>();
+	std::shared_ptr<archive_diff::io::writer> inner = recorder;
+
+	auto data = archive_diff::test_utility::create_random_data(30000, 0);
+
+	auto expected = data;
+	std::memset(expected.data() + 10000, 0, 10000);
+
+	{
+		archive_diff::io::pipelined_writer writer(inner, 4096, 2);
+
+		// The zeros overwrite part of a range that is still buffered.
+		writer.write(0, std::string_view{data.data(), 15000});
+		writer.write_zeros(10000, 10000);
+		writer.write(20000, std::string_view{data.data() + 20000, 10000});
+
+		ASSERT_EQ(data.size(), writer.size());
+		writer.flush();
+	}
+
+	ASSERT_EQ(1, recorder->m_zeros_count);
+	ASSERT_EQ(expected, recorder->m_data);
+}
@@ -123,4 +123,129 @@ TEST(reader_chain, slice_alphabet)
 
 		test_slicing_alphabet_reader(chain);
 	}
-}
\ No newline at end of file
+}
+template <typename DeviceT>
+archive_diff::io::reader make_alphabet_reader(size_t offset, size_t length)
+{
+	archive_diff::io::shared_io_device device =
+		std::make_shared<DeviceT>(std::string_view{c_alphabet + offset, length});
+	archive_diff::io::io_device_view view{device};
+	return archive_diff::io::reader{view};
+}
+
+void test_for_each_block_alphabet_reader(const archive_diff::io::reader &reader)
+{
+	for (size_t offset = 0; offset <= c_letters_in_alphabet; offset++)
+	{
+		for (size_t length = 0; length <= c_letters_in_alphabet - offset; length++)
+		{
+			std::string collected;
+			reader.for_each_block(offset, length, [&](std::string_view block) { collected.append(block); });
+
+			ASSERT_EQ(std::string_view(c_alphabet + offset, length), collected);
+		}
+	}
+}
+
+TEST(reader_borrow, simple_lending_device)
+{
+	auto reader = make_alphabet_reader<archive_diff::io::test::lending_buffer_io_device>(0, c_letters_in_alphabet);
+
+	auto whole = reader.borrow(0, c_letters_in_alphabet);
+	ASSERT_TRUE(whole.has_value());
+	ASSERT_EQ(c_alphabet, whole->data());
+	ASSERT_EQ(c_letters_in_alphabet, whole->size());
+
+	// Slices lend the matching part of the same storage and never past their own end.
+	auto slice    = reader.slice(3, 5);
+	auto borrowed = slice.borrow_some(1, 100);
+	ASSERT_TRUE(borrowed.has_value());
+	ASSERT_EQ(c_alphabet + 4, borrowed->data());
+	ASSERT_EQ(4, borrowed->size());
+
+	ASSERT_FALSE(slice.borrow(0, 6).has_value());
+
+	test_for_each_block_alphabet_reader(reader);
+}
+
+TEST(reader_borrow, simple_copying_device)
+{
+	auto reader = make_alphabet_reader<archive_diff::io::test::buffer_io_device>(0, c_letters_in_alphabet);
+
+	ASSERT_FALSE(reader.borrow_some(0, 1).has_value());
+	ASSERT_FALSE(reader.borrow(0, c_letters_in_alphabet).has_value());
+
+	test_for_each_block_alphabet_reader(reader);
+}
+
+TEST(reader_borrow, chain_stops_at_link)
+{
+	using lending_device = archive_diff::io::test::lending_buffer_io_device;
+	using copying_device = archive_diff::io::test::buffer_io_device;
+
+	for (size_t split_pos = 1; split_pos < c_letters_in_alphabet; split_pos++)
+	{
+		auto first  = make_alphabet_reader<lending_device>(0, split_pos);
+		auto second = make_alphabet_reader<lending_device>(split_pos, c_letters_in_alphabet - split_pos);
+		auto chain  = first.chain(second);
+
+		auto borrowed = chain.borrow_some(0, c_letters_in_alphabet);
+		ASSERT_TRUE(borrowed.has_value());
+		ASSERT_EQ(c_alphabet, borrowed->data());
+		ASSERT_EQ(split_pos, borrowed->size());
+
+		borrowed = chain.borrow_some(split_pos, c_letters_in_alphabet);
+		ASSERT_TRUE(borrowed.has_value());
+		ASSERT_EQ(c_alphabet + split_pos, borrowed->data());
+		ASSERT_EQ(c_letters_in_alphabet - split_pos, borrowed->size());
+
+		ASSERT_FALSE(chain.borrow(0, c_letters_in_alphabet).has_value());
+
+		test_for_each_block_alphabet_reader(chain);
+
+		// A chain that mixes lending and copying devices falls back per link.
+		auto copying     = make_alphabet_reader<copying_device>(split_pos, c_letters_in_alphabet - split_pos);
+		auto mixed_chain = first.chain(copying);
+		ASSERT_FALSE(mixed_chain.borrow_some(split_pos, 1).has_value());
+
+		test_for_each_block_alphabet_reader(mixed_chain);
+	}
+}
+
+TEST(reader_hint, reaches_devices_through_slices_and_chains)
+{
+	using recording_device = archive_diff::io::test::hint_recording_buffer_io_device;
+	using recorded_hint    = recording_device::recorded_hint;
+	using archive_diff::io::access_hint;
+
+	auto first_device  = std::make_shared<recording_device>(std::string_view{c_alphabet, 10});
+	auto second_device = std::make_shared<recording_device>(std::string_view{c_alphabet + 10, 16});
+
+	archive_diff::io::shared_io_device first_shared  = first_device;
+	archive_diff::io::shared_io_device second_shared = second_device;
+	archive_diff::io::reader first{archive_diff::io::io_device_view{first_shared}};
+	archive_diff::io::reader second{archive_diff::io::io_device_view{second_shared}};
+
+	// A slice passes the range on at its offset in the device.
+	first.slice(2, 6).hint(1, 3, access_hint::will_need);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{3, 3, access_hint::will_need})}, first_device->m_hints);
+	first_device->m_hints.clear();
+
+	// A chain splits the range between the links it spans and clips it to the end.
+	auto chain = first.slice(4, 6).chain(second);
+	chain.hint(3, 100, access_hint::dont_need);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{7, 3, access_hint::dont_need})}, first_device->m_hints);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{0, 16, access_hint::dont_need})}, second_device->m_hints);
+
+	// Links that the range doesn't reach aren't given the hint.
+	first_device->m_hints.clear();
+	second_device->m_hints.clear();
+	chain.hint(8, 10, access_hint::will_need);
+	ASSERT_TRUE(first_device->m_hints.empty());
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{2, 10, access_hint::will_need})}, second_device->m_hints);
+
+	second_device->m_hints.clear();
+	chain.hint(5, 2, access_hint::will_need);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{9, 1, access_hint::will_need})}, first_device->m_hints);
+	ASSERT_EQ(std::vector<recorded_hint>{(recorded_hint{0, 1, access_hint::will_need})}, second_device->m_hints);
+}
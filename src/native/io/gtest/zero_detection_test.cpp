@@ -0,0 +1,36 @@
+/**
+ * @file zero_detection_test.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <test_utility/gtest_includes.h>
+
+#include <vector>
+
+#include <io/zero_detection.h>
+
+TEST(zero_detection, is_all_zeros)
+{
+	ASSERT_TRUE(archive_diff::io::is_all_zeros(std::string_view{}));
+
+	// Sizes either side of the block size, with buffers not aligned to it.
+	for (size_t size : {1, 15, 63, 64, 65, 127, 4096, 4099})
+	{
+		std::vector<char> data(size + 1);
+		std::string_view unaligned{data.data() + 1, size};
+
+		ASSERT_TRUE(archive_diff::io::is_all_zeros(unaligned));
+
+		for (size_t i = 0; i < size; i++)
+		{
+			data[i + 1] = 1;
+			ASSERT_FALSE(archive_diff::io::is_all_zeros(unaligned));
+			data[i + 1] = 0;
+		}
+
+		// Bytes outside the buffer don't count.
+		data[0] = 1;
+		ASSERT_TRUE(archive_diff::io::is_all_zeros(unaligned));
+	}
+}
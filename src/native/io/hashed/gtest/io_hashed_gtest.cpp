@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <functional>
 #include <vector>
 #include <fstream>
 
@@ -19,10 +20,12 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 
+#include <io/buffer/io_device.h>
 #include <io/file/io_device.h>
 #include <io/file/binary_file_writer.h>
 
 #include <io/hashed/hashed_sequential_writer.h>
+#include <io/hashed/verifying_io_device.h>
 
 #include <io/reader.h>
 
@@ -152,6 +155,96 @@ TEST(hashed_sequential_writer, child_hasher)
 	ASSERT_TRUE(0 == memcmp(hash.data(), child_calculated_hash.data(), hash.size()));
 }
 
+static std::shared_ptr<std::vector<char>> make_verifying_test_data()
+{
+	auto data = std::make_shared<std::vector<char>>(10000);
+	for (size_t i = 0; i < data->size(); i++)
+	{
+		(*data)[i] = static_cast<char>(i * 7);
+	}
+	return data;
+}
+
+static std::shared_ptr<archive_diff::io::hashed::verifying_io_device> make_verifying_device(
+	std::shared_ptr<std::vector<char>> &data, const std::vector<char> &expected_hash)
+{
+	using buffer_io_device = archive_diff::io::buffer::io_device;
+
+	auto reader   = buffer_io_device::make_reader(data, buffer_io_device::size_kind::vector_size);
+	auto expected = archive_diff::hashing::hash::import_hash_value(
+		archive_diff::hashing::algorithm::sha256, std::string_view{expected_hash.data(), expected_hash.size()});
+
+	return std::make_shared<archive_diff::io::hashed::verifying_io_device>(reader, expected);
+}
+
+TEST(verifying_io_device, in_order_reads_verify)
+{
+	auto data   = make_verifying_test_data();
+	auto device = make_verifying_device(data, get_hash(data->data(), data->size()));
+
+	std::vector<char> buffer(3000);
+	for (uint64_t offset = 0; offset < data->size(); offset += buffer.size())
+	{
+		ASSERT_FALSE(device->is_verified());
+		device->read_some(offset, std::span<char>{buffer.data(), buffer.size()});
+	}
+
+	// Every byte was read in order, so nothing is left to hash.
+	ASSERT_TRUE(device->is_verified());
+}
+
+TEST(verifying_io_device, out_of_order_reads_verify_all)
+{
+	auto data   = make_verifying_test_data();
+	auto device = make_verifying_device(data, get_hash(data->data(), data->size()));
+
+	std::vector<char> buffer(4000);
+	device->read_some(5000, std::span<char>{buffer.data(), buffer.size()});
+	device->read_some(0, std::span<char>{buffer.data(), buffer.size()});
+	device->read_some(2000, std::span<char>{buffer.data(), buffer.size()});
+
+	ASSERT_FALSE(device->is_verified());
+	device->verify_all();
+	ASSERT_TRUE(device->is_verified());
+}
+
+TEST(verifying_io_device, mismatch)
+{
+	auto data          = make_verifying_test_data();
+	auto expected_hash = get_hash(data->data(), data->size());
+	(*data)[1234]++;
+
+	auto device = make_verifying_device(data, expected_hash);
+
+	auto expect_mismatch = [](const std::function<void()> &action)
+	{
+		bool caught = false;
+		try
+		{
+			action();
+		}
+		catch (archive_diff::errors::user_exception &e)
+		{
+			caught = true;
+			ASSERT_EQ(archive_diff::errors::error_code::diff_verify_hash_failure, e.get_error());
+		}
+		ASSERT_TRUE(caught);
+	};
+
+	std::vector<char> buffer(data->size() / 2);
+	device->read_some(0, std::span<char>{buffer.data(), buffer.size()});
+
+	// The read that completes the hash reports the mismatch, as does everything after it.
+	expect_mismatch([&]() { device->read_some(buffer.size(), std::span<char>{buffer.data(), buffer.size()}); });
+	expect_mismatch([&]() { device->read_some(0, std::span<char>{buffer.data(), buffer.size()}); });
+	expect_mismatch([&]() { device->verify_all(); });
+	ASSERT_FALSE(device->is_verified());
+
+	// Content that wasn't read is still checked by verify_all().
+	auto unread_device = make_verifying_device(data, expected_hash);
+	expect_mismatch([&]() { unread_device->verify_all(); });
+}
+
 int main(int argc, char **argv)
 {
 	InitGoogleTest(&argc, argv);
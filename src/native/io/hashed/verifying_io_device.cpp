@@ -0,0 +1,119 @@
+/**
+ * @file verifying_io_device.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "verifying_io_device.h"
+
+namespace archive_diff::io::hashed
+{
+verifying_io_device::verifying_io_device(const io::reader &reader, const hashing::hash &expected) :
+	m_reader(reader), m_expected(expected), m_hasher(expected.m_algorithm)
+{}
+
+size_t verifying_io_device::read_some(uint64_t offset, std::span<char> buffer)
+{
+	throw_if_mismatched();
+
+	auto actual = m_reader.read_some(offset, buffer);
+	hash_read(offset, std::string_view{buffer.data(), actual});
+	return actual;
+}
+
+std::optional<std::span<const char>> verifying_io_device::borrow_some(uint64_t offset, uint64_t length)
+{
+	throw_if_mismatched();
+
+	auto borrowed = m_reader.borrow_some(offset, length);
+	if (borrowed.has_value())
+	{
+		hash_read(offset, std::string_view{borrowed->data(), borrowed->size()});
+	}
+	return borrowed;
+}
+
+void verifying_io_device::hint(uint64_t offset, uint64_t length, access_hint hint)
+{
+	m_reader.hint(offset, length, hint);
+}
+
+void verifying_io_device::verify_all()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_state == state::hashing)
+	{
+		m_reader.for_each_block(
+			m_hashed_length,
+			m_reader.size() - m_hashed_length,
+			[&](std::string_view block) { m_hasher.hash_data(block); });
+		m_hashed_length = m_reader.size();
+
+		compare_if_complete();
+	}
+
+	throw_if_mismatched();
+}
+
+bool verifying_io_device::is_verified() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_state == state::matched;
+}
+
+void verifying_io_device::hash_read(uint64_t offset, std::string_view data)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_state != state::hashing)
+	{
+		return;
+	}
+
+	// Only the part extending the hashed prefix is new; earlier bytes were hashed already and
+	// a read starting past the prefix leaves a gap that verify_all() fills.
+	auto end = offset + data.size();
+	if ((offset > m_hashed_length) || (end <= m_hashed_length))
+	{
+		return;
+	}
+
+	auto skip = static_cast<size_t>(m_hashed_length - offset);
+	m_hasher.hash_data(data.substr(skip));
+	m_hashed_length = end;
+
+	compare_if_complete();
+	throw_if_mismatched();
+}
+
+// Called with m_mutex held.
+void verifying_io_device::compare_if_complete()
+{
+	if (m_hashed_length < m_reader.size())
+	{
+		return;
+	}
+
+	auto actual = m_hasher.get_hash();
+	if ((actual.m_algorithm == m_expected.m_algorithm) && (actual.m_hash_data == m_expected.m_hash_data))
+	{
+		m_state = state::matched;
+		return;
+	}
+
+	m_state = state::mismatched;
+}
+
+void verifying_io_device::throw_if_mismatched() const
+{
+	if (m_state != state::mismatched)
+	{
+		return;
+	}
+
+	std::string msg = "verifying_io_device: Content of " + std::to_string(m_reader.size())
+	                + " bytes doesn't match its expected hash: " + m_expected.to_string();
+	throw errors::user_exception(errors::error_code::diff_verify_hash_failure, msg);
+}
+} // namespace archive_diff::io::hashed
@@ -0,0 +1,63 @@
+/**
+ * @file verifying_io_device.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include <hashing/hash.h>
+#include <hashing/hasher.h>
+#include <io/io_device.h>
+#include <io/reader.h>
+
+namespace archive_diff::io::hashed
+{
+// Checks a reader's content against an expected hash as it is read, instead of in a separate
+// pass before it is used. Bytes are hashed as reads extend the prefix hashed so far, so content
+// read in order is hashed for free. Reads that skip ahead aren't hashed; verify_all() reads
+// and hashes whatever wasn't covered, so out-of-order content costs at most one extra read.
+//
+// The hash is compared as soon as the whole content has been hashed. A mismatch throws
+// diff_verify_hash_failure from the read or verify_all() call that found it, and from any
+// read after that.
+class verifying_io_device : public io_device
+{
+	public:
+	verifying_io_device(const io::reader &reader, const hashing::hash &expected);
+
+	virtual size_t read_some(uint64_t offset, std::span<char> buffer) override;
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) override;
+	virtual void hint(uint64_t offset, uint64_t length, access_hint hint) override;
+	virtual uint64_t size() const override { return m_reader.size(); }
+
+	// Hashes the content not read yet and compares the result, if that hasn't happened yet.
+	void verify_all();
+
+	bool is_verified() const;
+
+	private:
+	enum class state
+	{
+		hashing,
+		matched,
+		mismatched,
+	};
+
+	void hash_read(uint64_t offset, std::string_view data);
+	void compare_if_complete();
+	void throw_if_mismatched() const;
+
+	io::reader m_reader;
+	hashing::hash m_expected;
+
+	// Guards the hasher and the hashed length; the state is also checked without it.
+	mutable std::mutex m_mutex;
+	hashing::hasher m_hasher;
+	uint64_t m_hashed_length{};
+	std::atomic<state> m_state{state::hashing};
+};
+} // namespace archive_diff::io::hashed
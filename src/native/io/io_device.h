@@ -7,12 +7,22 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <span>
 
 #include <errors/user_exception.h>
 
 namespace archive_diff::io
 {
+// How a range of a device is about to be used; see io_device::hint().
+enum class access_hint
+{
+	// The range will be read soon, so the device may start fetching it.
+	will_need,
+	// The range won't be read again, so the device may drop it from its caches.
+	dont_need,
+};
+
 class io_device
 {
 	public:
@@ -20,6 +30,22 @@ class io_device
 
 	virtual size_t read_some(uint64_t offset, std::span<char> buffer) = 0;
 
+	// Devices with contiguous backing storage can lend it out instead of copying.
+	// Returns up to length bytes starting at offset, or std::nullopt if this device
+	// has no memory to lend. The span stays valid while the device is alive and
+	// its storage isn't resized.
+	virtual std::optional<std::span<const char>> borrow_some(
+		[[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t length)
+	{
+		return std::nullopt;
+	}
+
+	// Devices backed by storage with a cache may act on hints about upcoming reads.
+	// Hints never change what is read, so the default ignores them.
+	virtual void hint(
+		[[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t length, [[maybe_unused]] access_hint hint)
+	{}
+
 	virtual uint64_t size() const = 0;
 };
 
@@ -56,6 +56,27 @@ class io_device_view
 		return actual_read;
 	}
 
+	std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) const
+	{
+		if (offset >= size())
+		{
+			return m_device->borrow_some(m_offset + size(), 0);
+		}
+
+		auto to_borrow = std::min<uint64_t>(length, size() - offset);
+		return m_device->borrow_some(m_offset + offset, to_borrow);
+	}
+
+	void hint(uint64_t offset, uint64_t length, access_hint hint) const
+	{
+		if (offset >= size())
+		{
+			return;
+		}
+
+		m_device->hint(m_offset + offset, std::min<uint64_t>(length, size() - offset), hint);
+	}
+
 	uint64_t get_offset_in_device() const { return m_offset; }
 	uint64_t size() const 
 	{
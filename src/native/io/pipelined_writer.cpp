@@ -0,0 +1,213 @@
+/**
+ * @file pipelined_writer.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "pipelined_writer.h"
+
+#include <algorithm>
+
+namespace archive_diff::io
+{
+pipelined_writer::pipelined_writer(std::shared_ptr<writer> &inner, size_t buffer_size, size_t buffer_count) :
+	m_inner(inner), m_buffer_size(std::max<size_t>(buffer_size, 1))
+{
+	// With fewer than two buffers nothing would overlap.
+	buffer_count = std::max<size_t>(buffer_count, 2);
+
+	m_current.m_data.reserve(m_buffer_size);
+	for (size_t i = 1; i < buffer_count; i++)
+	{
+		m_free_buffers.emplace_back().reserve(m_buffer_size);
+	}
+
+	m_thread = std::thread(&pipelined_writer::writer_thread, this);
+}
+
+pipelined_writer::~pipelined_writer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_work_cv.notify_all();
+	m_thread.join();
+}
+
+void pipelined_writer::write(uint64_t offset, std::string_view buffer)
+{
+	throw_if_failed();
+
+	while (!buffer.empty())
+	{
+		// Only contiguous writes are gathered into the same buffer.
+		if (!m_current.m_data.empty() && (m_current.m_offset + m_current.m_data.size() != offset))
+		{
+			submit_current();
+		}
+
+		if (m_current.m_data.empty())
+		{
+			m_current.m_offset = offset;
+		}
+
+		auto to_copy = std::min(buffer.size(), m_buffer_size - m_current.m_data.size());
+		m_current.m_data.insert(m_current.m_data.end(), buffer.data(), buffer.data() + to_copy);
+
+		buffer.remove_prefix(to_copy);
+		offset += to_copy;
+		m_size = std::max(m_size, offset);
+
+		if (m_current.m_data.size() == m_buffer_size)
+		{
+			submit_current();
+		}
+	}
+}
+
+void pipelined_writer::write_zeros(uint64_t offset, uint64_t length)
+{
+	throw_if_failed();
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	submit_current();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(pending_write{offset, {}, length});
+	}
+	m_work_cv.notify_one();
+
+	m_size = std::max(m_size, offset + length);
+}
+
+void pipelined_writer::flush()
+{
+	throw_if_failed();
+
+	submit_current();
+	wait_until_written();
+
+	throw_if_failed();
+
+	m_inner->flush();
+}
+
+// The inner writer may be busy on the writer thread, so this is the end of the furthest
+// write made through this writer rather than the inner writer's size.
+uint64_t pipelined_writer::size() const { return m_size; }
+
+void pipelined_writer::submit_current()
+{
+	if (m_current.m_data.empty())
+	{
+		return;
+	}
+
+	std::exception_ptr failure;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_queue.push_back(std::move(m_current));
+		m_work_cv.notify_one();
+
+		m_done_cv.wait(lock, [&] { return !m_free_buffers.empty() || m_failure; });
+
+		m_current.m_offset = 0;
+		if (m_failure)
+		{
+			failure = m_failure;
+		}
+		else
+		{
+			m_current.m_data = std::move(m_free_buffers.back());
+			m_free_buffers.pop_back();
+		}
+	}
+
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+}
+
+void pipelined_writer::wait_until_written()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done_cv.wait(lock, [&] { return (m_queue.empty() && !m_writing) || m_failure; });
+}
+
+void pipelined_writer::throw_if_failed()
+{
+	std::exception_ptr failure;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		failure = m_failure;
+	}
+
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+}
+
+void pipelined_writer::writer_thread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_work_cv.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+		if (m_stopping)
+		{
+			return;
+		}
+
+		auto pending = std::move(m_queue.front());
+		m_queue.pop_front();
+
+		// After a failure the remaining buffers are just recycled.
+		if (!m_failure)
+		{
+			m_writing = true;
+			lock.unlock();
+
+			std::exception_ptr failure;
+			try
+			{
+				if (pending.m_zeros_length)
+				{
+					m_inner->write_zeros(pending.m_offset, pending.m_zeros_length);
+				}
+				else
+				{
+					m_inner->write(pending.m_offset, std::string_view{pending.m_data.data(), pending.m_data.size()});
+				}
+			}
+			catch (...)
+			{
+				failure = std::current_exception();
+			}
+
+			lock.lock();
+			m_writing = false;
+			if (failure)
+			{
+				m_failure = failure;
+			}
+		}
+
+		if (!pending.m_zeros_length)
+		{
+			pending.m_data.clear();
+			m_free_buffers.push_back(std::move(pending.m_data));
+		}
+		m_done_cv.notify_all();
+	}
+}
+} // namespace archive_diff::io
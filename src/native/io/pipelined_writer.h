@@ -0,0 +1,83 @@
+/**
+ * @file pipelined_writer.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "writer.h"
+
+namespace archive_diff::io
+{
+// Hands writes to a dedicated thread so the caller can produce the next buffer while
+// the previous one is being written. Writes are gathered into buffers of buffer_size;
+// at most buffer_count buffers are in use, after which write() waits for the writer thread.
+// A failure on the writer thread is rethrown from the next write() or flush().
+// flush() must be called to complete the writes; destroying the writer discards anything
+// not yet written.
+class pipelined_writer : public writer
+{
+	public:
+	static constexpr size_t c_default_buffer_size  = 1024 * 1024;
+	static constexpr size_t c_default_buffer_count = 4;
+
+	pipelined_writer(std::shared_ptr<writer> &inner) :
+		pipelined_writer(inner, c_default_buffer_size, c_default_buffer_count)
+	{}
+	pipelined_writer(std::shared_ptr<writer> &inner, size_t buffer_size, size_t buffer_count);
+
+	virtual ~pipelined_writer();
+
+	virtual void write(uint64_t offset, std::string_view buffer) override;
+	// Passed through to the inner writer in order with the other writes, without buffering any zeros.
+	virtual void write_zeros(uint64_t offset, uint64_t length) override;
+
+	// Waits for all buffered writes to complete, then flushes the inner writer.
+	virtual void flush() override;
+
+	virtual uint64_t size() const override;
+
+	private:
+	struct pending_write
+	{
+		uint64_t m_offset{};
+		std::vector<char> m_data;
+		// When set, the write is of this many zeros and m_data isn't one of the buffers.
+		uint64_t m_zeros_length{};
+	};
+
+	void submit_current();
+	void wait_until_written();
+	void throw_if_failed();
+
+	void writer_thread();
+
+	std::shared_ptr<writer> m_inner;
+	size_t m_buffer_size{};
+
+	// Only touched by the caller's thread.
+	pending_write m_current;
+	uint64_t m_size{};
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_done_cv;
+
+	std::deque<pending_write> m_queue;
+	std::vector<std::vector<char>> m_free_buffers;
+	bool m_writing{};
+	bool m_stopping{};
+	std::exception_ptr m_failure;
+
+	std::thread m_thread;
+};
+} // namespace archive_diff::io
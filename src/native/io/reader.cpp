@@ -5,8 +5,10 @@
  * Licensed under the MIT License.
  */
 
+#include <algorithm>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include <span>
 
@@ -59,6 +61,79 @@ void reader::read_all(std::vector<char> &data) const
 	read(0, std::span<char>{data.data(), data_size});
 }
 
+std::optional<std::span<const char>> reader::borrow(uint64_t offset, uint64_t length) const
+{
+	auto borrowed = borrow_some(offset, length);
+
+	if (!borrowed.has_value() || (borrowed->size() != length))
+	{
+		return std::nullopt;
+	}
+
+	return borrowed;
+}
+
+void reader::hint(uint64_t offset, uint64_t length, access_hint hint) const
+{
+	if (auto view = get_io_device_view(); view.has_value())
+	{
+		view->hint(offset, length, hint);
+		return;
+	}
+
+	uint64_t link_offset{};
+	for (auto &link : unchain())
+	{
+		auto link_end = link_offset + link.size();
+		if ((offset < link_end) && (link_offset < offset + length))
+		{
+			auto start = std::max(offset, link_offset);
+			auto end   = std::min(offset + length, link_end);
+			link.hint(start - link_offset, end - start, hint);
+		}
+
+		if (link_end >= offset + length)
+		{
+			break;
+		}
+		link_offset = link_end;
+	}
+}
+
+void reader::for_each_block(uint64_t offset, uint64_t length, const block_handler &handler) const
+{
+	const size_t c_copy_buffer_max_capacity = 32 * 1024;
+	std::vector<char> copy_buffer;
+
+	auto remaining = length;
+
+	while (remaining)
+	{
+		auto borrowed = borrow_some(offset, remaining);
+
+		if (borrowed.has_value() && !borrowed->empty())
+		{
+			handler(std::string_view{borrowed->data(), borrowed->size()});
+
+			remaining -= borrowed->size();
+			offset += borrowed->size();
+			continue;
+		}
+
+		if (copy_buffer.empty())
+		{
+			copy_buffer.resize(static_cast<size_t>(std::min<uint64_t>(c_copy_buffer_max_capacity, remaining)));
+		}
+
+		auto to_read = static_cast<size_t>(std::min<uint64_t>(copy_buffer.size(), remaining));
+		read(offset, std::span<char>{copy_buffer.data(), to_read});
+		handler(std::string_view{copy_buffer.data(), to_read});
+
+		remaining -= to_read;
+		offset += to_read;
+	}
+}
+
 reader reader::chained_reader_impl::slice(uint64_t offset, uint64_t length) const
 {
 	std::vector<reader> readers;
@@ -188,6 +263,23 @@ size_t reader::chained_reader_impl::read_some(uint64_t offset, std::span<char> b
 	return total_read;
 }
 
+std::optional<std::span<const char>> reader::chained_reader_impl::borrow_some(uint64_t offset, uint64_t length) const
+{
+	if ((length == 0) || (offset >= m_length))
+	{
+		return std::span<const char>{};
+	}
+
+	auto upper_bound = std::upper_bound(m_offsets.begin(), m_offsets.end(), offset);
+	auto index       = static_cast<size_t>(upper_bound - m_offsets.begin()) - 1;
+
+	// upper_bound skips any empty readers starting at the same offset, so this
+	// reader holds the byte at offset.
+	uint64_t offset_in_reader = offset - m_offsets[index];
+
+	return m_readers[index].borrow_some(offset_in_reader, length);
+}
+
 void reader::read_uint8_t(uint64_t offset, uint8_t *value)
 {
 	read(offset, std::span<char>{reinterpret_cast<char *>(value), sizeof(*value)});
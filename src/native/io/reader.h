@@ -8,8 +8,10 @@
 #pragma once
 
 #include <optional>
+#include <functional>
 #include <memory>
 #include <set>
+#include <string_view>
 
 #include "io_device_view.h"
 #include "nul_device_reader.h"
@@ -69,6 +71,26 @@ class reader
 	void read(uint64_t offset, std::span<char> buffer) const { return m_impl->read(offset, buffer); }
 	void read_all(std::vector<char> &buffer) const;
 
+	// Lends up to length bytes at offset from the backing storage without copying.
+	// Returns std::nullopt if the underlying device can't lend memory. For chains,
+	// the span stops at the end of the current link.
+	std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) const
+	{
+		return m_impl->borrow_some(offset, length);
+	}
+
+	// Lends the whole range [offset, offset + length) as a single span, or std::nullopt
+	// if it isn't contiguous in one device that can lend memory.
+	std::optional<std::span<const char>> borrow(uint64_t offset, uint64_t length) const;
+
+	// Passes the hint for [offset, offset + length) to the devices holding those bytes.
+	void hint(uint64_t offset, uint64_t length, access_hint hint) const;
+
+	// Passes the range [offset, offset + length) to handler in order, one block at a time.
+	// Blocks are borrowed where possible and copied through a bounce buffer otherwise.
+	using block_handler = std::function<void(std::string_view)>;
+	void for_each_block(uint64_t offset, uint64_t length, const block_handler &handler) const;
+
 	protected:
 	class reader_impl
 	{
@@ -89,6 +111,8 @@ class reader
 		}
 		virtual uint64_t size() const = 0;
 
+		virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) const = 0;
+
 		virtual std::optional<io_device_view> get_io_device_view() const = 0;
 	};
 
@@ -105,6 +129,11 @@ class reader
 			return m_view.read_some(offset, buffer);
 		}
 
+		virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) const override
+		{
+			return m_view.borrow_some(offset, length);
+		}
+
 		virtual uint64_t size() const override { return m_view.size(); }
 
 		virtual std::optional<io_device_view> get_io_device_view() const override { return m_view; }
@@ -143,6 +172,8 @@ class reader
 
 		virtual size_t read_some(uint64_t offset, std::span<char> buffer) const override;
 
+		virtual std::optional<std::span<const char>> borrow_some(uint64_t offset, uint64_t length) const override;
+
 		virtual uint64_t size() const override { return m_length; }
 
 		virtual std::optional<io_device_view> get_io_device_view() const override { return std::nullopt; }
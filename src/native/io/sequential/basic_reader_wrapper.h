@@ -24,6 +24,18 @@ class basic_reader_wrapper : public reader_impl
 		return;
 	}
 
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t length) override
+	{
+		auto borrowed = m_wrapped_reader.borrow_some(m_read_offset, length);
+
+		if (borrowed.has_value())
+		{
+			m_read_offset += borrowed->size();
+		}
+
+		return borrowed;
+	}
+
 	static std::shared_ptr<archive_diff::io::sequential::reader> make_shared(io::reader &reader)
 	{
 		return std::make_shared<basic_reader_wrapper>(reader);
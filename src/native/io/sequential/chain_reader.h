@@ -128,6 +128,40 @@ class chain_reader : public reader
 		return total_read;
 	}
 
+	virtual std::optional<std::span<const char>> borrow_some(uint64_t length)
+	{
+		while ((m_current_reader_index < m_readers.size())
+		       && (m_readers[m_current_reader_index]->available() == 0))
+		{
+			m_offset_in_current_reader = 0;
+			m_current_reader_index++;
+		}
+
+		if ((length == 0) || (m_current_reader_index >= m_readers.size()))
+		{
+			return std::span<const char>{};
+		}
+
+		auto &current_reader = m_readers[m_current_reader_index];
+
+		auto borrowed = current_reader->borrow_some(length);
+		if (!borrowed.has_value())
+		{
+			return std::nullopt;
+		}
+
+		m_read_offset += borrowed->size();
+		m_offset_in_current_reader += borrowed->size();
+
+		if (current_reader->tellg() == current_reader->size())
+		{
+			m_offset_in_current_reader = 0;
+			m_current_reader_index++;
+		}
+
+		return borrowed;
+	}
+
 	virtual uint64_t tellg() const { return m_read_offset; }
 
 	virtual uint64_t size() const { return m_size; }
@@ -79,6 +79,38 @@ void reader::read_all_remaining(std::vector<char> &buffer)
 	read(std::span<char>{buffer.data(), data_size});
 }
 
+void reader::for_each_block(uint64_t length, const io::reader::block_handler &handler)
+{
+	const size_t c_copy_buffer_max_capacity = 32 * 1024;
+	std::vector<char> copy_buffer;
+
+	auto remaining = length;
+
+	while (remaining)
+	{
+		auto borrowed = borrow_some(remaining);
+
+		if (borrowed.has_value() && !borrowed->empty())
+		{
+			handler(std::string_view{borrowed->data(), borrowed->size()});
+
+			remaining -= borrowed->size();
+			continue;
+		}
+
+		if (copy_buffer.empty())
+		{
+			copy_buffer.resize(static_cast<size_t>(std::min<uint64_t>(c_copy_buffer_max_capacity, remaining)));
+		}
+
+		auto to_read = static_cast<size_t>(std::min<uint64_t>(copy_buffer.size(), remaining));
+		read(std::span<char>{copy_buffer.data(), to_read});
+		handler(std::string_view{copy_buffer.data(), to_read});
+
+		remaining -= to_read;
+	}
+}
+
 void reader::skip_by_reading(uint64_t to_skip)
 {
 	const size_t c_read_buffer_size = 32 * 1204;
@@ -30,6 +30,17 @@ class reader
 
 	void read_all_remaining(std::vector<char> &buffer);
 
+	// Lends up to length bytes at the current position and advances past them.
+	// Returns std::nullopt, without advancing, if the reader can't lend memory.
+	virtual std::optional<std::span<const char>> borrow_some([[maybe_unused]] uint64_t length)
+	{
+		return std::nullopt;
+	}
+
+	// Consumes the next length bytes, passing them to handler one block at a time.
+	// Blocks are borrowed where possible and copied through a bounce buffer otherwise.
+	void for_each_block(uint64_t length, const io::reader::block_handler &handler);
+
 	uint64_t available() const { return size() - tellg(); }
 
 	protected:
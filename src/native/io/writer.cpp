@@ -21,9 +21,22 @@
 #endif
 
 #include "writer.h"
+#include "all_zeros_io_device.h"
 
 namespace archive_diff::io
 {
+void writer::write_zeros(uint64_t offset, uint64_t length)
+{
+	auto zeros = all_zeros_io_device::make_reader(length);
+	zeros.for_each_block(
+		0,
+		length,
+		[&](std::string_view block)
+		{
+			write(offset, block);
+			offset += block.size();
+		});
+}
 
 void writer::write_uint8_t(uint64_t offset, uint8_t value)
 {
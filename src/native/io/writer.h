@@ -23,6 +23,10 @@ class writer
 	void write_uint32_t(uint64_t offset, uint32_t value);
 	void write_uint64_t(uint64_t offset, uint64_t value);
 
+	// Writes length zero bytes at offset. Writers that can leave the range as a hole,
+	// rather than storing the zeros, override this.
+	virtual void write_zeros(uint64_t offset, uint64_t length);
+
 	virtual void flush()                                         = 0;
 	virtual uint64_t size() const                                = 0;
 };
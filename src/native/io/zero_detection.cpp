@@ -0,0 +1,80 @@
+/**
+ * @file zero_detection.cpp
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "zero_detection.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define ZERO_DETECTION_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+	#include <arm_neon.h>
+	#define ZERO_DETECTION_NEON
+#endif
+
+namespace archive_diff::io
+{
+// Blocks of 64 bytes are OR'd together before testing, so there's one branch per block.
+static const size_t c_block_size = 64;
+
+static bool is_block_all_zeros(const char *data)
+{
+#if defined(ZERO_DETECTION_SSE2)
+	auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+	auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16));
+	auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 32));
+	auto d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 48));
+
+	auto combined = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(combined, _mm_setzero_si128())) == 0xffff;
+#elif defined(ZERO_DETECTION_NEON)
+	auto data_u8 = reinterpret_cast<const uint8_t *>(data);
+
+	auto combined = vorrq_u8(
+		vorrq_u8(vld1q_u8(data_u8), vld1q_u8(data_u8 + 16)), vorrq_u8(vld1q_u8(data_u8 + 32), vld1q_u8(data_u8 + 48)));
+	auto halves = vreinterpretq_u64_u8(combined);
+	return (vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1)) == 0;
+#else
+	uint64_t combined{};
+	for (size_t i = 0; i < c_block_size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		combined |= word;
+	}
+	return combined == 0;
+#endif
+}
+
+bool is_all_zeros(std::string_view buffer)
+{
+	auto data      = buffer.data();
+	auto remaining = buffer.size();
+
+	while (remaining >= c_block_size)
+	{
+		if (!is_block_all_zeros(data))
+		{
+			return false;
+		}
+
+		data += c_block_size;
+		remaining -= c_block_size;
+	}
+
+	for (size_t i = 0; i < remaining; i++)
+	{
+		if (data[i] != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+} // namespace archive_diff::io
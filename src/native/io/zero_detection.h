@@ -0,0 +1,16 @@
+/**
+ * @file zero_detection.h
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#pragma once
+
+#include <string_view>
+
+namespace archive_diff::io
+{
+// Checks a whole buffer for non-zero bytes, 16 bytes at a time where SSE2 or NEON is available.
+// Returns as soon as one is found, so this is cheap for ordinary data.
+bool is_all_zeros(std::string_view buffer);
+} // namespace archive_diff::io
@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <random>
 
 namespace archive_diff::test_utility
 {
@@ -40,4 +41,60 @@ void create_random_data_file(const std::string &path, uint64_t size)
 		remaining -= to_write;
 	}
 }
+
+std::vector<char> create_random_data(uint64_t size, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+
+	std::vector<char> data(static_cast<size_t>(size));
+	for (auto &c : data)
+	{
+		c = static_cast<char>(engine());
+	}
+
+	return data;
+}
+
+std::vector<char> create_compressible_data(uint64_t size, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+
+	const size_t c_word_count = 512;
+	std::vector<std::string> words;
+	for (size_t i = 0; i < c_word_count; i++)
+	{
+		std::string word;
+		auto length = 2 + engine() % 10;
+		for (size_t j = 0; j < length; j++)
+		{
+			word.push_back(static_cast<char>('a' + engine() % 26));
+		}
+		words.push_back(word);
+	}
+
+	std::vector<char> data;
+	data.reserve(static_cast<size_t>(size));
+	while (data.size() < size)
+	{
+		auto &word = words[engine() % c_word_count];
+		data.insert(data.end(), word.begin(), word.end());
+		data.push_back((engine() % 8 == 0) ? '\n' : ' ');
+	}
+	data.resize(static_cast<size_t>(size));
+
+	return data;
+}
+
+std::vector<char> create_edited_copy(const std::vector<char> &data, size_t edit_interval, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+
+	auto edited = data;
+	for (size_t offset = engine() % edit_interval; offset < edited.size(); offset += edit_interval)
+	{
+		edited[offset] = static_cast<char>(engine());
+	}
+
+	return edited;
+}
 } // namespace archive_diff::test_utility
\ No newline at end of file
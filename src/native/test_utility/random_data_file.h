@@ -6,9 +6,22 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace archive_diff::test_utility
 {
 void create_random_data_file(const std::string &path, uint64_t size);
-}
\ No newline at end of file
+
+// Incompressible bytes. The same seed always gives the same data.
+std::vector<char> create_random_data(uint64_t size, uint32_t seed);
+
+// Text-like data built from a small vocabulary, which compresses roughly the way
+// source files and configuration do.
+std::vector<char> create_compressible_data(uint64_t size, uint32_t seed);
+
+// A copy of data with a byte changed every edit_interval bytes, shaped like a new
+// version of a binary that mostly matches the old one.
+std::vector<char> create_edited_copy(const std::vector<char> &data, size_t edit_interval, uint32_t seed);
+} // namespace archive_diff::test_utility
\ No newline at end of file
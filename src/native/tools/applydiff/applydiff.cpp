@@ -7,30 +7,174 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
 #include <string>
 
 #include <diffs/api/legacy_adudiffapply.h>
 
-int apply(const char *source, const char *diff, const char *target);
+int apply(
+	const char *source,
+	const char *diff,
+	const char *target,
+	uint32_t write_pipeline_depth,
+	bool dense_output,
+	std::optional<uint64_t> read_ahead_window,
+	const char *profile_path,
+	const char *trace_path,
+	const char *source_hash_cache_path,
+	bool trust_diff_source_item);
 
 int main(int argc, char **argv)
 {
-	if (argc != 4)
+	if (argc < 4)
 	{
-		printf("Usage: applydiff <source path> <diff path> <target path>\n");
+		printf("Usage: applydiff <source path> <diff path> <target path> [options]\n");
+		printf("    --write-pipeline <buffer count>\n");
+		printf("    --dense                     Write every byte, e.g. for a raw block device target\n");
+		printf("    --read-ahead <bytes>        How far ahead of the target to read; 0 turns read-ahead off\n");
+		printf("    --profile <summary path>    Write a JSON profile of the apply\n");
+		printf("    --trace <trace path>        With --profile, also write a Chrome trace\n");
+		printf("    --source-hash-cache <path>  Reuse the source's hash from this cache file when it is unchanged\n");
+		printf("    --trust-source              Use the diff's source hash instead of hashing the source\n");
 		return 1;
 	}
 
-	return apply(argv[1], argv[2], argv[3]);
+	uint32_t write_pipeline_depth = 0;
+	bool dense_output             = false;
+	const char *profile_path      = nullptr;
+	const char *trace_path        = nullptr;
+	const char *hash_cache_path   = nullptr;
+	bool trust_diff_source_item   = false;
+	std::optional<uint64_t> read_ahead_window;
+
+	for (int i = 4; i < argc; i++)
+	{
+		if (0 == strcmp(argv[i], "--dense"))
+		{
+			dense_output = true;
+			continue;
+		}
+
+		if (0 == strcmp(argv[i], "--trust-source"))
+		{
+			trust_diff_source_item = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+		{
+			printf("Missing value for option: %s\n", argv[i]);
+			return 1;
+		}
+
+		if (0 == strcmp(argv[i], "--write-pipeline"))
+		{
+			char *end{};
+			write_pipeline_depth = static_cast<uint32_t>(std::strtoul(argv[i + 1], &end, 10));
+			if (*end != '\0' || write_pipeline_depth == 0)
+			{
+				printf("Invalid buffer count: %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else if (0 == strcmp(argv[i], "--read-ahead"))
+		{
+			char *end{};
+			read_ahead_window = std::strtoull(argv[i + 1], &end, 10);
+			if (*end != '\0')
+			{
+				printf("Invalid read-ahead size: %s\n", argv[i + 1]);
+				return 1;
+			}
+		}
+		else if (0 == strcmp(argv[i], "--profile"))
+		{
+			profile_path = argv[i + 1];
+		}
+		else if (0 == strcmp(argv[i], "--trace"))
+		{
+			trace_path = argv[i + 1];
+		}
+		else if (0 == strcmp(argv[i], "--source-hash-cache"))
+		{
+			hash_cache_path = argv[i + 1];
+		}
+		else
+		{
+			printf("Unexpected option: %s\n", argv[i]);
+			return 1;
+		}
+		i++;
+	}
+
+	if (trace_path && !profile_path)
+	{
+		printf("--trace needs --profile\n");
+		return 1;
+	}
+
+	return apply(
+		argv[1],
+		argv[2],
+		argv[3],
+		write_pipeline_depth,
+		dense_output,
+		read_ahead_window,
+		profile_path,
+		trace_path,
+		hash_cache_path,
+		trust_diff_source_item);
 }
 
-int apply(const char *source, const char *diff, const char *target)
+int apply(
+	const char *source,
+	const char *diff,
+	const char *target,
+	uint32_t write_pipeline_depth,
+	bool dense_output,
+	std::optional<uint64_t> read_ahead_window,
+	const char *profile_path,
+	const char *trace_path,
+	const char *source_hash_cache_path,
+	bool trust_diff_source_item)
 {
 	printf("Applying diff: %s\n", diff);
 	printf("Using source : %s\n", source);
 	printf("To file      : %s\n", target);
+	if (write_pipeline_depth)
+	{
+		printf("Write buffers: %u\n", write_pipeline_depth);
+	}
 
-	auto handle      = adu_diff_apply_create_session();
+	auto handle = adu_diff_apply_create_session();
+	adu_diff_apply_set_write_pipeline_depth(handle, write_pipeline_depth);
+	if (dense_output)
+	{
+		printf("Output       : dense\n");
+		adu_diff_apply_set_dense_output(handle, true);
+	}
+	if (read_ahead_window.has_value())
+	{
+		printf("Read-ahead   : %" PRIu64 " bytes\n", read_ahead_window.value());
+		adu_diff_apply_set_read_ahead_window_size(handle, read_ahead_window.value());
+	}
+	if (profile_path)
+	{
+		printf("Profile      : %s\n", profile_path);
+		adu_diff_apply_set_profile_paths(handle, profile_path, trace_path);
+	}
+	if (source_hash_cache_path)
+	{
+		printf("Hash cache   : %s\n", source_hash_cache_path);
+		adu_diff_apply_set_source_hash_cache_path(handle, source_hash_cache_path);
+	}
+	if (trust_diff_source_item)
+	{
+		printf("Source hash  : taken from the diff\n");
+		adu_diff_apply_set_trust_diff_source_item(handle, true);
+	}
 	auto error_count = adu_diff_apply(handle, source, diff, target);
 
 	int ret = 0;
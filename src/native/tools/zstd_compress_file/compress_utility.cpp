@@ -32,7 +32,10 @@
 #endif
 
 void compress_file(
-	fs::path uncompressed_path, std::shared_ptr<std::vector<char>> &dictionary_data, fs::path compressed_path)
+	fs::path uncompressed_path,
+	std::shared_ptr<std::vector<char>> &dictionary_data,
+	fs::path compressed_path,
+	const archive_diff::io::compressed::zstd_compression_workers &workers)
 {
 	if (!fs::exists(uncompressed_path))
 	{
@@ -55,12 +58,12 @@ void compress_file(
 		archive_diff::io::compressed::compression_dictionary dictionary{dictionary_data};
 
 		writer = std::make_unique<archive_diff::io::compressed::zstd_compression_writer>(
-			sequential_writer, 3, uncompressed_file_size, std::move(dictionary));
+			sequential_writer, c_compression_level, uncompressed_file_size, std::move(dictionary), workers);
 	}
 	else
 	{
 		writer = std::make_unique<archive_diff::io::compressed::zstd_compression_writer>(
-			sequential_writer, 3, uncompressed_file_size);
+			sequential_writer, c_compression_level, uncompressed_file_size, workers);
 	}
 
 	auto reader = archive_diff::io::file::io_device::make_reader(uncompressed_path.string());
@@ -68,13 +71,11 @@ void compress_file(
 	writer->write(reader);
 }
 
-void compress_file(fs::path uncompressed_path, fs::path compressed_path)
-{
-	printf("Compressing %s to %s\n", uncompressed_path.string().c_str(), compressed_path.string().c_str());
-	compress_file(uncompressed_path, L"", compressed_path);
-}
-
-void compress_file(fs::path uncompressed_path, fs::path delta_basis_path, fs::path compressed_path)
+void compress_file(
+	fs::path uncompressed_path,
+	fs::path delta_basis_path,
+	fs::path compressed_path,
+	const archive_diff::io::compressed::zstd_compression_workers &workers)
 {
 	if (!delta_basis_path.empty() && !fs::exists(delta_basis_path))
 	{
@@ -99,7 +100,13 @@ void compress_file(fs::path uncompressed_path, fs::path delta_basis_path, fs::pa
 		delta_basis.read(delta_basis_data->data(), delta_basis_size);
 	}
 
-	compress_file(uncompressed_path, delta_basis_data, compressed_path);
+	printf(
+		"Using %u worker(s), job size: %llu, overlap log: %d\n",
+		workers.m_worker_count,
+		static_cast<unsigned long long>(workers.m_job_size),
+		workers.m_overlap_log);
+
+	compress_file(uncompressed_path, delta_basis_data, compressed_path, workers);
 }
 
 void verify_compression(fs::path uncompressed_path, fs::path *delta_basis_path, fs::path compressed_path)
@@ -10,9 +10,20 @@
 
 #include <language_support/include_filesystem.h>
 
+#include <io/compressed/zstd_compression_writer.h>
+
+const uint64_t c_compression_level = 3;
+
+void compress_file(
+	fs::path uncompressed_path,
+	std::shared_ptr<std::vector<char>> &dictionary_data,
+	fs::path compressed_path,
+	const archive_diff::io::compressed::zstd_compression_workers &workers);
 void compress_file(
-	fs::path uncompressed_path, std::shared_ptr<std::vector<char>> &dictionary_data, fs::path compressed_path);
-void compress_file(fs::path uncompressed_path, fs::path delta_basis_path, fs::path compressed_path);
+	fs::path uncompressed_path,
+	fs::path delta_basis_path,
+	fs::path compressed_path,
+	const archive_diff::io::compressed::zstd_compression_workers &workers);
 
 void verify_compression(fs::path uncompressed_path, fs::path *delta_basis_path, fs::path compressed_path);
 
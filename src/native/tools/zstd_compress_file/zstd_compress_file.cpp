@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
 
 #include "compress_utility.h"
@@ -29,16 +30,19 @@ int parse_command_line(
 	operation *op,
 	fs::path *uncompressed_path,
 	fs::path *compressed_path,
-	fs::path *delta_basis_path);
+	fs::path *delta_basis_path,
+	archive_diff::io::compressed::zstd_compression_workers *workers);
 
 int main(int argc, char **argv)
 {
 	fs::path uncompressed_path;
 	fs::path delta_basis_path;
 	fs::path compressed_path;
+	archive_diff::io::compressed::zstd_compression_workers workers;
 
 	operation op{operation::invalid};
-	int ret = parse_command_line(argc, argv, &op, &uncompressed_path, &compressed_path, &delta_basis_path);
+	int ret =
+		parse_command_line(argc, argv, &op, &uncompressed_path, &compressed_path, &delta_basis_path, &workers);
 
 	if (ret != 0)
 	{
@@ -54,14 +58,14 @@ int main(int argc, char **argv)
 			usage(argv[0]);
 			return -1;
 		case operation::compress:
-			compress_file(uncompressed_path, L"", compressed_path);
+			compress_file(uncompressed_path, L"", compressed_path, workers);
 			verify_compression(uncompressed_path, nullptr, compressed_path);
 			break;
 		case operation::decompress:
 			decompress_file(compressed_path, L"", uncompressed_path);
 			break;
 		case operation::compress_with_basis:
-			compress_file(uncompressed_path, delta_basis_path, compressed_path);
+			compress_file(uncompressed_path, delta_basis_path, compressed_path, workers);
 			verify_compression(uncompressed_path, &delta_basis_path, compressed_path);
 			break;
 		case operation::decompress_with_basis:
@@ -81,6 +85,9 @@ int main(int argc, char **argv)
 }
 
 #define DECOMPRESS_SWITCH "-d"
+#define WORKERS_OPTION "--workers"
+#define JOB_SIZE_OPTION "--job-size"
+#define OVERLAP_LOG_OPTION "--overlap-log"
 
 int parse_command_line(
 	int argc,
@@ -88,8 +95,45 @@ int parse_command_line(
 	operation *op,
 	fs::path *uncompressed_path,
 	fs::path *compressed_path,
-	fs::path *delta_basis_path)
+	fs::path *delta_basis_path,
+	archive_diff::io::compressed::zstd_compression_workers *workers)
 {
+	// Pull out the options first, what remains are the positional arguments.
+	std::vector<char *> positional;
+
+	try
+	{
+		for (int i = 0; i < argc; i++)
+		{
+			bool has_value = (i + 1) < argc;
+
+			if (has_value && (0 == strcmp(argv[i], WORKERS_OPTION)))
+			{
+				workers->m_worker_count = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (has_value && (0 == strcmp(argv[i], JOB_SIZE_OPTION)))
+			{
+				workers->m_job_size = std::stoull(argv[++i]);
+			}
+			else if (has_value && (0 == strcmp(argv[i], OVERLAP_LOG_OPTION)))
+			{
+				workers->m_overlap_log = std::stoi(argv[++i]);
+			}
+			else
+			{
+				positional.push_back(argv[i]);
+			}
+		}
+	}
+	catch (std::exception &)
+	{
+		*op = operation::invalid;
+		return -1;
+	}
+
+	argc = static_cast<int>(positional.size());
+	argv = positional.data();
+
 	switch (argc)
 	{
 	case 3: // <uncompressed> <compressed>
@@ -135,5 +179,11 @@ void usage(char *executable_name)
 	std::cout << "Usage: " << executable_name << " <uncompressed> <compressed>" << std::endl
 			  << "    or " << executable_name << " <uncompressed> <basis> <compressed>" << std::endl
 			  << "    or " << executable_name << " -d <compressed> <uncompressed>" << std::endl
-			  << "    or " << executable_name << " -d <compressed> <basis> <uncompressed>" << std::endl;
+			  << "    or " << executable_name << " -d <compressed> <basis> <uncompressed>" << std::endl
+			  << "Compression options:" << std::endl
+			  << "    " << WORKERS_OPTION << " <count>       zstd worker threads (default: 1)" << std::endl
+			  << "    " << JOB_SIZE_OPTION << " <bytes>     bytes per zstd job (default: chosen by zstd)" << std::endl
+			  << "    " << OVERLAP_LOG_OPTION << " <log>    zstd job overlap log (default: chosen by zstd)" << std::endl
+			  << "Output is the same for any worker count of 1 or more with the same job size and overlap log."
+			  << std::endl;
 }
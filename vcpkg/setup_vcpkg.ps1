@@ -112,6 +112,7 @@ else {
 InstallToVcpkg "zlib"
 InstallToVcpkg "zstd"
 InstallToVcpkg "gtest"
+InstallToVcpkg "benchmark"
 InstallToVcpkg "bzip2"
 InstallToVcpkg "e2fsprogs"
 InstallToVcpkg "jsoncpp"
@@ -94,6 +94,7 @@ vcpkg_install zlib
 vcpkg_install zstd
 vcpkg_install bzip2
 vcpkg_install gtest
+vcpkg_install benchmark
 vcpkg_install openssl
 vcpkg_install e2fsprogs
 vcpkg_install vcpkg-cmake-config